@@ -44,6 +44,32 @@ namespace _config {
  */
 #ifdef _LOADER
 using loader::heap_malloc;
+#elif defined(_TEST)
+/* Tests are single threaded and hand out a fixed size arena. */
+constexpr size_t test_arena_chunk = size_t(1) << 16;
+constexpr size_t test_arena_size = size_t(1) << 28;
+
+inline _namespace(std)::tuple<uintptr_t, size_t*> test_arena() noexcept {
+  alignas(test_arena_chunk) static unsigned char arena[test_arena_size];
+  static size_t used = 0;
+
+  return _namespace(std)::make_tuple(reinterpret_cast<uintptr_t>(&arena[0]),
+                                     &used);
+}
+
+inline _namespace(std)::tuple<void*, size_t> heap_malloc(size_t sz) noexcept {
+  uintptr_t arena_addr;
+  size_t* used;
+  _namespace(std)::tie(arena_addr, used) = test_arena();
+
+  const size_t chunk = test_arena_chunk;
+  sz = (sz + chunk - 1U) & ~(chunk - 1U);
+  if (sz > test_arena_size - *used)
+    return _namespace(std)::make_tuple(nullptr, 0);
+  void* rv = reinterpret_cast<void*>(arena_addr + *used);
+  *used += sz;
+  return _namespace(std)::make_tuple(rv, sz);
+}
 #else
 inline _namespace(std)::tuple<void*, size_t> heap_malloc(size_t) noexcept {
   return _namespace(std)::make_tuple(nullptr, 0);
@@ -73,6 +99,48 @@ inline bool heap_free(void*, size_t) noexcept {
  * End of heap_free.
  */
 
+/*
+ * Heap_resize: change the size of memory previously allocated with
+ * heap_malloc, without moving it.
+ *
+ * The arguments are the address and size of the memory, as returned by
+ * heap_malloc (or a previous call to heap_resize), and the requested size.
+ * On success, the function returns the new size of the memory, which must
+ * be at least the requested size.  Returning 0 indicates failure, in which
+ * case the memory is unchanged.
+ * This function must be thread-safe.
+ *
+ * Only the test configuration implements this function: elsewhere it
+ * always fails, so large allocations are never grown or trimmed in
+ * place, and the span size checks on resized spans only run in tests.
+ *
+ * The code path used in this function may not use exceptions
+ * (no try-catch, for instance).
+ */
+#ifdef _TEST
+inline size_t heap_resize(void* addr, size_t sz, size_t new_sz) noexcept {
+  /* Only the most recently allocated span of the test arena can change. */
+  uintptr_t arena_addr;
+  size_t* used;
+  _namespace(std)::tie(arena_addr, used) = test_arena();
+  const size_t off = reinterpret_cast<uintptr_t>(addr) - arena_addr;
+  if (off + sz != *used) return 0;
+
+  const size_t chunk = test_arena_chunk;
+  new_sz = (new_sz + chunk - 1U) & ~(chunk - 1U);
+  if (new_sz > test_arena_size - off) return 0;
+  *used = off + new_sz;
+  return new_sz;
+}
+#else
+inline size_t heap_resize(void*, size_t, size_t) noexcept {
+  return 0;
+}
+#endif
+/*
+ * End of heap_resize.
+ */
+
 /*
  * Abort: stop execution of the program.
  *
@@ -113,6 +181,20 @@ inline void exit(int) noexcept {
  */
 #ifdef _LOADER
 using loader::panic;
+#elif defined(_TEST)
+/* Tests that provoke a panic install a handler, which may not return. */
+using test_panic_fn = void (*)();
+
+inline test_panic_fn& test_panic_handler() noexcept {
+  static test_panic_fn fn = nullptr;
+  return fn;
+}
+
+inline void panic(const char*, ...) noexcept {
+  const test_panic_fn fn = test_panic_handler();
+  if (fn) (*fn)();
+  abort();
+}
 #else
 inline void panic(const char*, ...) noexcept {
   abort();
@@ -7,12 +7,33 @@ namespace __cxxabiv1 {
 namespace ext {
 
 
+#if __has_include(<ilias/stats.h>)
+inline heap::profile_entry::profile_entry(const void* frame) noexcept
+: outermost_(frame_ == nullptr)
+{
+  if (outermost_) frame_ = frame;
+}
+
+inline heap::profile_entry::~profile_entry() noexcept {
+  if (outermost_) frame_ = nullptr;
+}
+#else
+inline heap::profile_entry::profile_entry(const void*) noexcept {}
+
+inline heap::profile_entry::~profile_entry() noexcept {}
+#endif /* __has_include(<ilias/stats.h>) */
+
 inline auto heap::malloc_result(void* p, size_t sz) noexcept -> void* {
   stats_.malloc_calls.add();
-  if (p)
+  if (p) {
     stats_.malloc_bytes.add(sz);
-  else
+    stats_.live_bytes.add(sz);
+    if (_predict_false(sample_interval_.load(
+            _namespace(std)::memory_order_relaxed) != 0U))
+      sample_(sz);
+  } else {
     stats_.malloc_fail.add();
+  }
   return p;
 }
 
@@ -27,16 +48,22 @@ inline auto heap::resize_result(_namespace(std)::tuple<bool, size_t> rv,
   stats_.resize_calls.add();
   if (!get<0>(rv))
     stats_.resize_fail.add();
-  else if (new_sz > old_sz)
+  else if (new_sz > old_sz) {
     stats_.resize_bytes_up.add(new_sz - old_sz);
-  else if (new_sz < old_sz)
+    stats_.live_bytes.add(new_sz - old_sz);
+  } else if (new_sz < old_sz) {
     stats_.resize_bytes_down.add(old_sz - new_sz);
+    stats_.live_bytes.sub(old_sz - new_sz);
+  }
   return rv;
 }
 
 inline auto heap::free_result(size_t sz, const void* arg) noexcept -> void {
   stats_.free_calls.add();
-  if (arg) stats_.free_bytes.add(sz);
+  if (arg) {
+    stats_.free_bytes.add(sz);
+    stats_.live_bytes.sub(sz);
+  }
 }
 
 
@@ -2,6 +2,9 @@
 #define _ABI_EXT_HEAP_H_
 
 #include <abi/abi.h>
+#include <abi/semaphore.h>
+#include <array>
+#include <atomic>
 #include <string>
 #include <tuple>
 
@@ -14,7 +17,48 @@ namespace ext {
 
 
 class heap {
+ public:
+  /* Number of size classes served by the slab allocator. */
+  static constexpr size_t n_slab_classes = 15;
+  /* Number of log2 buckets in the sampled allocation size histogram. */
+  static constexpr size_t n_size_buckets = 32;
+  /* Number of allocation sites and stack depth kept by the profiler. */
+  static constexpr size_t n_profile_sites = 32;
+  static constexpr size_t profile_depth = 4;
+
  private:
+#if __has_include(<ilias/stats.h>)
+  /*
+   * Allocation sites, recorded by the sampling profiler.
+   *
+   * Each site is identified by the return addresses of its callers.
+   * Once the table is full, samples from new sites are counted as overflow.
+   */
+  class profile_sites
+  : public _namespace(ilias)::stats_leaf
+  {
+   public:
+    profile_sites(_namespace(ilias)::stats_group&,
+                  _namespace(std)::string_ref) noexcept;
+    ~profile_sites() noexcept override;
+
+    void record(const void*const*, size_t) noexcept;
+    void as_properties(_namespace(std)::ostream&) const override;
+
+   private:
+    struct site {
+      const void* trace[profile_depth];
+      uint64_t count;
+      uint64_t bytes;
+    };
+
+    mutable semaphore lock_{ 1U };
+    _namespace(std)::array<site, n_profile_sites> sites_;
+    size_t n_ = 0;
+    uint64_t overflow_ = 0;
+  };
+#endif /* __has_include(<ilias/stats.h>) */
+
   class stats_data {
 #if __has_include(<ilias/stats.h>)
    private:
@@ -34,6 +78,14 @@ class heap {
     stats_counter free_bytes;  // bytes freeed by free()
     stats_counter malloc_fail;  // count: malloc() returned nullptr
     stats_counter resize_fail;  // count: resize() returned false
+    stats_counter live_bytes;  // bytes currently handed out
+    _namespace(ilias)::stats_histogram<n_slab_classes> slab_hit;  // count per
+                                      // size class: served from a slab
+    _namespace(ilias)::stats_histogram<n_slab_classes> slab_miss;  // count per
+                                      // size class: required a new slab
+    _namespace(ilias)::stats_histogram<n_size_buckets> sample_size;  // sampled
+                                      // allocations per log2 of their size
+    profile_sites sample_sites;  // sampled allocations per call site
 #endif /* __has_include(<ilias/stats.h>) */
   };
 
@@ -46,17 +98,44 @@ class heap {
   void* malloc(size_t) noexcept;
   void* malloc(size_t, size_t) noexcept;
   void free(const void*) noexcept;
-  void free(const void* p, size_t) noexcept { free(p); }
+  void free(const void*, size_t) noexcept;
   _namespace(std)::tuple<bool, size_t> resize(const void*, size_t) noexcept;
 
+  void set_sample_interval(unsigned int) noexcept;
+
+  /*
+   * Marks the frame of a public allocation function, such as malloc or
+   * operator new: construct one on entry, from __builtin_frame_address(0).
+   * The profiler attributes samples to the caller of the outermost marked
+   * frame on the stack, skipping all allocator frames below it.
+   */
+  class profile_entry {
+    friend class heap;
+
+   public:
+    explicit profile_entry(const void*) noexcept;
+    profile_entry(const profile_entry&) = delete;
+    profile_entry& operator=(const profile_entry&) = delete;
+    ~profile_entry() noexcept;
+
+#if __has_include(<ilias/stats.h>)
+   private:
+    static thread_local const void* frame_;
+    const bool outermost_;
+#endif /* __has_include(<ilias/stats.h>) */
+  };
+
  private:
   void* malloc_result(void*, size_t) noexcept;
   _namespace(std)::tuple<bool, size_t> resize_result(
       _namespace(std)::tuple<bool, size_t>,
       _namespace(std)::tuple<const void*, size_t>) noexcept;
   void free_result(size_t, const void*) noexcept;
+  void sample_(size_t) noexcept;
 
   stats_data stats_;
+  _namespace(std)::atomic<unsigned int> sample_interval_{ 0U };
+  _namespace(std)::atomic<unsigned int> sample_countdown_{ 0U };
 };
 
 
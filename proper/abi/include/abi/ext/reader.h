@@ -3,6 +3,7 @@
 
 #include <cdecl.h>
 #include <abi/abi.h>
+#include <abi/ext/twoway.h>
 #include <cstdint>
 
 namespace __cxxabiv1 {
@@ -381,11 +382,7 @@ template<typename UInt> const UInt* memfind(const UInt* s_haystack,
                                             size_t n_haystack,
                                             const UInt* s_needle,
                                             size_t n_needle) noexcept {
-  for (; n_haystack >= n_needle; ++s_haystack, --n_haystack) {
-    if (memcmp(s_haystack, s_needle, n_needle) == 0)
-      return s_haystack;
-  }
-  return nullptr;
+  return twoway_find(s_haystack, n_haystack, s_needle, n_needle);
 }
 
 template<typename UInt> const UInt* memrfind(const UInt* s_haystack,
@@ -403,7 +400,8 @@ template<typename UInt> const UInt* memrfind(const UInt* s_haystack,
 
 /*
  * Specialize memfind for small integral type.
- * The function uses a histogram to reduce complexity.
+ * The function skips to the first occurance of the first needle byte,
+ * before starting the two-way search.
  */
 const uint8_t* memfind(const uint8_t*, size_t,
                        const uint8_t*, size_t) noexcept;
@@ -0,0 +1,208 @@
+#ifndef _ABI_EXT_TWOWAY_INL_H_
+#define _ABI_EXT_TWOWAY_INL_H_
+
+#include <abi/ext/twoway.h>
+
+namespace __cxxabiv1 {
+namespace ext {
+
+
+template<typename T>
+constexpr auto twoway_natural_order::eq(const T& a, const T& b) noexcept ->
+    bool {
+  return a == b;
+}
+
+template<typename T>
+constexpr auto twoway_natural_order::lt(const T& a, const T& b) noexcept ->
+    bool {
+  return a < b;
+}
+
+/*
+ * Maximal suffix of needle, using the order (if !reverse) or the
+ * reverse order (if reverse).
+ * Returns the start of the suffix and assigns its period.
+ */
+template<typename Cmp, typename T>
+auto __twoway_max_suffix(const T* needle, size_t n_needle, bool reverse,
+                         size_t* period) noexcept -> size_t {
+  size_t max_suffix = size_t(-1);  // Wraps to 0 when k is added.
+  size_t j = 0;
+  size_t k = 1;
+  size_t p = 1;
+
+  while (j + k < n_needle) {
+    const T& a = needle[j + k];
+    const T& b = needle[max_suffix + k];
+    if (Cmp::eq(a, b)) {
+      if (k != p) {
+        ++k;
+      } else {
+        j += p;
+        k = 1;
+      }
+    } else if (reverse ? Cmp::lt(b, a) : Cmp::lt(a, b)) {
+      j += k;
+      k = 1;
+      p = j - max_suffix;
+    } else {
+      max_suffix = j++;
+      k = p = 1;
+    }
+  }
+
+  *period = p;
+  return max_suffix + 1U;
+}
+
+/*
+ * Critical factorization of needle.
+ * Returns the split position and assigns the period of the needle.
+ */
+template<typename Cmp, typename T>
+auto __twoway_factorize(const T* needle, size_t n_needle, size_t* period)
+    noexcept -> size_t {
+  size_t p_fwd, p_rev;
+  const size_t s_fwd =
+      __twoway_max_suffix<Cmp>(needle, n_needle, false, &p_fwd);
+  const size_t s_rev =
+      __twoway_max_suffix<Cmp>(needle, n_needle, true, &p_rev);
+
+  if (s_fwd > s_rev) {
+    *period = p_fwd;
+    return s_fwd;
+  }
+  *period = p_rev;
+  return s_rev;
+}
+
+template<typename Cmp, typename T>
+auto __twoway_equal(const T* a, const T* b, size_t n) noexcept -> bool {
+  for (size_t i = 0; i < n; ++i)
+    if (!Cmp::eq(a[i], b[i])) return false;
+  return true;
+}
+
+/* Haystack of known length. */
+class __twoway_sized {
+ public:
+  explicit __twoway_sized(size_t n) noexcept : n_(n) {}
+
+  /* Test if the haystack holds at least n elements. */
+  bool avail(size_t n) const noexcept { return n <= n_; }
+
+ private:
+  const size_t n_;
+};
+
+/*
+ * Nul terminated haystack.
+ * Its length is found as the search advances, growing the known length
+ * by at least grow elements at a time.
+ */
+template<typename T>
+class __twoway_cstr {
+ public:
+  __twoway_cstr(const T* s, size_t (*strnlen)(const T*, size_t),
+                size_t grow) noexcept
+  : s_(s),
+    strnlen_(strnlen),
+    grow_(grow)
+  {}
+
+  /* Test if the haystack holds at least n elements. */
+  bool avail(size_t n) noexcept {
+    if (n <= known_) return true;
+    if (ended_) return false;
+
+    const size_t grow = (n - known_ > grow_ ? n - known_ : grow_);
+    const size_t len = strnlen_(s_ + known_, grow);
+    known_ += len;
+    ended_ = (len < grow);
+    return n <= known_;
+  }
+
+ private:
+  const T*const s_;
+  size_t (*const strnlen_)(const T*, size_t);
+  const size_t grow_;
+  size_t known_ = 0;
+  bool ended_ = false;
+};
+
+template<typename Cmp, typename T, typename Haystack>
+auto __twoway_search(const T* haystack, Haystack& hs,
+                     const T* needle, size_t n_needle) noexcept -> const T* {
+  if (n_needle == 0) return haystack;
+  if (!hs.avail(n_needle)) return nullptr;
+
+  size_t period;
+  const size_t suffix = __twoway_factorize<Cmp>(needle, n_needle, &period);
+
+  if (__twoway_equal<Cmp>(needle, needle + period, suffix)) {
+    /*
+     * Periodic needle: after a full match of the right half, the next
+     * candidate is a period ahead and shares all but one period of
+     * the right half with the current one, which is remembered.
+     */
+    size_t memory = 0;
+    for (size_t j = 0; hs.avail(j + n_needle); ) {
+      size_t i = (suffix > memory ? suffix : memory);
+      while (i < n_needle && Cmp::eq(needle[i], haystack[i + j])) ++i;
+      if (i < n_needle) {
+        j += i - suffix + 1U;
+        memory = 0;
+        continue;
+      }
+
+      i = suffix;
+      while (i > memory && Cmp::eq(needle[i - 1U], haystack[i - 1U + j])) --i;
+      if (i <= memory) return haystack + j;
+      j += period;
+      memory = n_needle - period;
+    }
+  } else {
+    /*
+     * The halves of the needle differ, so any mismatch allows
+     * the maximal shift.
+     */
+    period = (suffix > n_needle - suffix ? suffix : n_needle - suffix) + 1U;
+    for (size_t j = 0; hs.avail(j + n_needle); ) {
+      size_t i = suffix;
+      while (i < n_needle && Cmp::eq(needle[i], haystack[i + j])) ++i;
+      if (i < n_needle) {
+        j += i - suffix + 1U;
+        continue;
+      }
+
+      i = suffix;
+      while (i > 0 && Cmp::eq(needle[i - 1U], haystack[i - 1U + j])) --i;
+      if (i == 0) return haystack + j;
+      j += period;
+    }
+  }
+  return nullptr;
+}
+
+template<typename Cmp, typename T>
+auto twoway_find(const T* haystack, size_t n_haystack,
+                 const T* needle, size_t n_needle) noexcept -> const T* {
+  __twoway_sized hs{ n_haystack };
+  return __twoway_search<Cmp>(haystack, hs, needle, n_needle);
+}
+
+template<typename Cmp, typename T>
+auto twoway_find_cstr(const T* haystack,
+                      size_t (*strnlen)(const T*, size_t),
+                      const T* needle, size_t n_needle) noexcept ->
+    const T* {
+  /* Grow by at least a needle length (and at least 64 elements). */
+  __twoway_cstr<T> hs{ haystack, strnlen, n_needle | 63U };
+  return __twoway_search<Cmp>(haystack, hs, needle, n_needle);
+}
+
+
+}} /* namespace __cxxabiv1::ext */
+
+#endif /* _ABI_EXT_TWOWAY_INL_H_ */
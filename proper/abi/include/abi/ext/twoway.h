@@ -0,0 +1,47 @@
+#ifndef _ABI_EXT_TWOWAY_H_
+#define _ABI_EXT_TWOWAY_H_
+
+#include <abi/abi.h>
+
+namespace __cxxabiv1 {
+namespace ext {
+
+
+/*
+ * Comparison for twoway_find, using the natural order of the elements.
+ *
+ * A custom comparison supplies static eq(a, b) and lt(a, b) functions,
+ * which must describe a strict weak order (for instance char_traits).
+ */
+struct twoway_natural_order {
+  template<typename T> static constexpr bool eq(const T&, const T&) noexcept;
+  template<typename T> static constexpr bool lt(const T&, const T&) noexcept;
+};
+
+/*
+ * Substring search, using the Two-Way algorithm (Crochemore, Perrin).
+ *
+ * Finds the first occurance of needle in haystack, in linear time
+ * and constant space.
+ * Returns nullptr if needle does not occur in haystack.
+ */
+template<typename Cmp = twoway_natural_order, typename T>
+const T* twoway_find(const T*, size_t, const T*, size_t) noexcept;
+
+/*
+ * Substring search in a nul terminated haystack, using Two-Way.
+ *
+ * The haystack is only scanned for its terminator as far as the search
+ * gets, using the supplied strnlen, so a match near the start of a long
+ * haystack doesn't pay for the length of the haystack.
+ */
+template<typename Cmp = twoway_natural_order, typename T>
+const T* twoway_find_cstr(const T*, size_t (*)(const T*, size_t),
+                          const T*, size_t) noexcept;
+
+
+}} /* namespace __cxxabiv1::ext */
+
+#include <abi/ext/twoway-inl.h>
+
+#endif /* _ABI_EXT_TWOWAY_H_ */
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <stdimpl/heap_array.h>
 #include <stdimpl/heap_support.h>
+#include <stdimpl/parallel.h>
 
 _namespace_begin(std)
 
@@ -37,6 +38,16 @@ Function for_each(InputIterator b, InputIterator e, Function fun) {
   return fun;
 }
 
+template<typename ExecutionPolicy, typename ForwardIterator, class Function>
+impl::enable_if_execution_policy_t<ExecutionPolicy, void> for_each(
+    ExecutionPolicy&& policy, ForwardIterator b, ForwardIterator e,
+    Function fun) {
+  impl::parallel_for_chunks(policy, b, e,
+                            [&fun](ForwardIterator cb, ForwardIterator ce) {
+                              for_each(cb, ce, ref(fun));
+                            });
+}
+
 template<typename InputIterator, typename T>
 InputIterator find(InputIterator b, InputIterator e, const T& v) {
   using placeholders::_1;
@@ -615,6 +626,24 @@ OutputIterator transform(InputIterator1 b1, InputIterator1 e1,
   return out;
 }
 
+template<typename ExecutionPolicy, typename ForwardIterator1,
+         typename ForwardIterator2, typename UnaryOperation>
+impl::enable_if_execution_policy_t<ExecutionPolicy, ForwardIterator2>
+    transform(ExecutionPolicy&& policy,
+              ForwardIterator1 b, ForwardIterator1 e,
+              ForwardIterator2 out, UnaryOperation operation) {
+  if (!impl::parallel_splittable<ExecutionPolicy,
+                                 ForwardIterator1, ForwardIterator2>::value)
+    return transform(b, e, out, ref(operation));
+
+  impl::parallel_for_chunks(policy, b, e,
+                            [&](ForwardIterator1 cb, ForwardIterator1 ce) {
+                              transform(cb, ce, next(out, distance(b, cb)),
+                                        ref(operation));
+                            });
+  return next(out, distance(b, e));
+}
+
 template<typename ForwardIterator, typename T>
 void replace(ForwardIterator b, ForwardIterator e,
              const T& old_val, const T& new_val) {
@@ -662,6 +691,16 @@ void fill(ForwardIterator b, ForwardIterator e, const T& v) {
   }
 }
 
+template<typename ExecutionPolicy, typename ForwardIterator, typename T>
+impl::enable_if_execution_policy_t<ExecutionPolicy, void> fill(
+    ExecutionPolicy&& policy, ForwardIterator b, ForwardIterator e,
+    const T& v) {
+  impl::parallel_for_chunks(policy, b, e,
+                            [&v](ForwardIterator cb, ForwardIterator ce) {
+                              fill(cb, ce, v);
+                            });
+}
+
 template<typename ForwardIterator, typename Size, typename T>
 ForwardIterator fill_n(ForwardIterator b, Size n, const T& v) {
   while (n > 0) {
@@ -1148,6 +1187,218 @@ ForwardIterator partition_point(ForwardIterator b, ForwardIterator e,
 }
 
 
+namespace impl {
+
+/* Ranges up to this size are sorted using insertion sort. */
+constexpr unsigned int sort_insertion_threshold = 16;
+/* Ranges larger than this use a ninther to select the pivot. */
+constexpr unsigned int sort_ninther_threshold = 128;
+/* Number of swaps after which partial_insertion_sort gives up. */
+constexpr unsigned int sort_partial_insertion_limit = 8;
+
+template<typename RandomAccessIterator, typename Predicate>
+void fix_heap(RandomAccessIterator, RandomAccessIterator,
+              RandomAccessIterator, Predicate);
+
+/*
+ * All element movement in the sort helpers is done using iter_swap,
+ * since elements in b, e may not be copyable (for instance, qsort
+ * uses a proxy reference as its value type).
+ */
+template<typename RandomAccessIterator, typename Predicate>
+void insertion_sort(RandomAccessIterator b, RandomAccessIterator e,
+                    Predicate predicate) {
+  if (b == e) return;
+
+  for (RandomAccessIterator i = next(b); i != e; ++i) {
+    for (RandomAccessIterator j = i;
+         j != b && predicate(*j, *prev(j));
+         --j)
+      iter_swap(j, prev(j));
+  }
+}
+
+/*
+ * Insertion sort, which gives up after sort_partial_insertion_limit swaps.
+ * Returns true if [b, e) is sorted.
+ */
+template<typename RandomAccessIterator, typename Predicate>
+bool partial_insertion_sort(RandomAccessIterator b, RandomAccessIterator e,
+                            Predicate predicate) {
+  if (b == e) return true;
+
+  unsigned int swaps = 0;
+  for (RandomAccessIterator i = next(b); i != e; ++i) {
+    for (RandomAccessIterator j = i;
+         j != b && predicate(*j, *prev(j));
+         --j) {
+      if (swaps++ == sort_partial_insertion_limit) return false;
+      iter_swap(j, prev(j));
+    }
+  }
+  return true;
+}
+
+/* Sort the 3 elements x, y, z. */
+template<typename RandomAccessIterator, typename Predicate>
+void sort3(RandomAccessIterator x, RandomAccessIterator y,
+           RandomAccessIterator z, Predicate predicate) {
+  if (predicate(*y, *x)) iter_swap(x, y);
+  if (predicate(*z, *y)) {
+    iter_swap(y, z);
+    if (predicate(*y, *x)) iter_swap(x, y);
+  }
+}
+
+/*
+ * Select a pivot and move it to b.
+ *
+ * The pivot is the median of the first, middle and last element.
+ * For large ranges, the median of three such medians (the ninther) is used,
+ * which is much harder to defeat with crafted input.
+ */
+template<typename RandomAccessIterator, typename Predicate>
+void sort_select_pivot(RandomAccessIterator b, RandomAccessIterator e,
+                       Predicate predicate) {
+  using _namespace(std)::distance;
+
+  const auto n = distance(b, e);
+  RandomAccessIterator mid = next(b, n / 2);
+  RandomAccessIterator last = prev(e);
+
+  sort3(b, mid, last, ref(predicate));
+  if (n > sort_ninther_threshold) {
+    sort3(next(b), prev(mid), prev(last), ref(predicate));
+    sort3(next(b, 2), next(mid), prev(last, 2), ref(predicate));
+    sort3(prev(mid), mid, next(mid), ref(predicate));
+  }
+  iter_swap(b, mid);
+}
+
+/*
+ * Partition [b, e) around the pivot at b.
+ *
+ * Both scans stop at elements equal to the pivot, so ranges with many
+ * equal elements are split in half, instead of degrading to quadratic time.
+ *
+ * Returns the final position of the pivot, and a boolean indicating
+ * no elements had to be swapped (i.e. the range was already partitioned).
+ */
+template<typename RandomAccessIterator, typename Predicate>
+auto sort_partition(RandomAccessIterator b, RandomAccessIterator e,
+                    Predicate predicate) ->
+    pair<RandomAccessIterator, bool> {
+  RandomAccessIterator lo = next(b);
+  RandomAccessIterator hi = prev(e);
+  bool no_swaps = true;
+
+  for (;;) {
+    while (lo <= hi && predicate(*lo, *b)) ++lo;
+    while (lo <= hi && predicate(*b, *hi)) --hi;
+    if (lo >= hi) break;
+
+    iter_swap(lo, hi);
+    no_swaps = false;
+    ++lo;
+    --hi;
+  }
+
+  /*
+   * Layout:
+   * - pivot = b
+   * - [next(b), hi)   not after pivot
+   * - hi              not after pivot
+   * - (hi, e)         not before pivot
+   */
+  iter_swap(b, hi);
+  return make_pair(hi, no_swaps);
+}
+
+/*
+ * Swap some elements around on both sides of the pivot,
+ * to break up patterns in the input that caused an unbalanced partition.
+ */
+template<typename RandomAccessIterator>
+void sort_break_patterns(RandomAccessIterator b, RandomAccessIterator pivot,
+                         RandomAccessIterator e) {
+  using _namespace(std)::distance;
+
+  const auto l_n = distance(b, pivot);
+  const auto r_n = distance(next(pivot), e);
+
+  if (l_n >= sort_insertion_threshold) {
+    iter_swap(b, next(b, l_n / 4));
+    iter_swap(prev(pivot), prev(pivot, l_n / 4));
+  }
+  if (r_n >= sort_insertion_threshold) {
+    iter_swap(next(pivot), next(pivot, 1 + r_n / 4));
+    iter_swap(prev(e), prev(e, r_n / 4));
+  }
+}
+
+/*
+ * Introsort.
+ *
+ * Quicksort, with insertion sort for small ranges.
+ * Each unbalanced partition uses up one of bad_allowed;
+ * once exhausted, the range is sorted using heap sort instead,
+ * which bounds the worst case to O(n log n).
+ *
+ * If a partition did not swap any elements, the input is likely
+ * (nearly) sorted, in which case a partial insertion sort is attempted
+ * on both partitions, making sorted input linear time.
+ * Unbalanced partitions have some of their elements swapped around,
+ * to break up patterns in the input.
+ *
+ * Only the smaller partition is sorted recursively, so the stack depth
+ * is at most log2(n).
+ */
+template<typename RandomAccessIterator, typename Predicate>
+void introsort(RandomAccessIterator b, RandomAccessIterator e,
+               Predicate predicate, unsigned int bad_allowed) {
+  using _namespace(std)::distance;
+
+  for (;;) {
+    const auto n = distance(b, e);
+    if (n <= sort_insertion_threshold) {
+      insertion_sort(b, e, ref(predicate));
+      return;
+    }
+
+    sort_select_pivot(b, e, ref(predicate));
+    RandomAccessIterator pivot;
+    bool already_partitioned;
+    tie(pivot, already_partitioned) = sort_partition(b, e, ref(predicate));
+
+    const auto l_n = distance(b, pivot);
+    const auto r_n = distance(next(pivot), e);
+
+    if (l_n < n / 8 || r_n < n / 8) {
+      if (bad_allowed-- == 0) {
+        make_heap(b, e, ref(predicate));
+        sort_heap(b, e, ref(predicate));
+        return;
+      }
+
+      sort_break_patterns(b, pivot, e);
+    } else if (already_partitioned &&
+               partial_insertion_sort(b, pivot, ref(predicate)) &&
+               partial_insertion_sort(next(pivot), e, ref(predicate))) {
+      return;
+    }
+
+    if (l_n < r_n) {
+      introsort(b, pivot, ref(predicate), bad_allowed);
+      b = next(pivot);
+    } else {
+      introsort(next(pivot), e, ref(predicate), bad_allowed);
+      e = pivot;
+    }
+  }
+}
+
+} /* namespace std::impl */
+
 template<typename RandomAccessIterator>
 void sort(RandomAccessIterator b, RandomAccessIterator e) {
   sort(b, e, less<void>());
@@ -1156,128 +1407,227 @@ void sort(RandomAccessIterator b, RandomAccessIterator e) {
 template<typename RandomAccessIterator, typename Predicate>
 void sort(RandomAccessIterator b, RandomAccessIterator e,
           Predicate predicate) {
-  using placeholders::_1;
-
   if (b == e || next(b) == e) return;  // Already sorted.
 
-  /*
-   * Elements in b, e may not be copyable, so we can't simply bind an argument
-   * to the predicate and use that to directly partition the collection.
-   * Using a reference to an element in the collection doesn't work either,
-   * since the elements will be shuffled, causing our predicate to change
-   * behind our back.
-   *
-   * Instead, use some song and dance:
-   * - select an element mid as the pivot
-   * - partition the space before and after mid (exclusing mid itself)
-   * - rotate the collection to become correctly ordered
-   * Sort will proceed recursively on the two partitions.
-   */
-  RandomAccessIterator mid =
-      next(b, arc4random_uniform64(distance(b, e)));
-  auto left_mid = partition(
-      b, mid,
-      bind(logical_not<void>(), bind(ref(predicate), ref(*mid), _1)));
-  auto right_mid = partition(next(mid), e,
-                             bind(ref(predicate), _1, ref(*mid)));
+  impl::introsort(b, e, ref(predicate),
+                  abi::ext::log2_down(distance(b, e)));
+}
 
-  /*
-   * Layout:
-   * - [b, left_mid)           before pivot            \o/
-   * - [left_mid, mid)         should be after pivot
-   * - pivot = mid             pivot point
-   * - [next(mid), right_mid)  should be before pivot
-   * - [right_mid, e)          after pivot             \o/
-   */
-  rotate(left_mid, mid, next(mid));
+template<typename ExecutionPolicy, typename RandomAccessIterator>
+impl::enable_if_execution_policy_t<ExecutionPolicy, void> sort(
+    ExecutionPolicy&& policy, RandomAccessIterator b, RandomAccessIterator e) {
+  sort(forward<ExecutionPolicy>(policy), b, e, less<void>());
+}
 
-  /*
-   * Layout:
-   * - [b, left_mid)           before pivot            \o/
-   * - pivot = left_mid        pivot point
-   * - (left_mid, mid]         should be after pivot   \o/
-   * - [next(mid), right_mid)  should be before pivot
-   * - [right_mid, e)          after pivot             \o/
-   */
-  RandomAccessIterator pivot = rotate(left_mid, next(mid), right_mid);
+/*
+ * Parallel sort.
+ *
+ * Each chunk is sorted independently, after which adjacent runs are merged
+ * pairwise, with all merges of a round running in parallel.
+ */
+template<typename ExecutionPolicy, typename RandomAccessIterator,
+         typename Predicate>
+impl::enable_if_execution_policy_t<ExecutionPolicy, void> sort(
+    ExecutionPolicy&&, RandomAccessIterator b, RandomAccessIterator e,
+    Predicate predicate) {
+  const size_t n = distance(b, e);
+  const size_t chunks =
+      (impl::parallel_splittable<ExecutionPolicy, RandomAccessIterator>::value ?
+       impl::parallel_chunks(n) :
+       1U);
+  if (chunks <= 1U) {
+    sort(b, e, ref(predicate));
+    return;
+  }
 
-  /*
-   * This time, use the original names for the segments.
-   * Layout:
-   * - [b, left_mid)                                   \o/
-   * - (mid, right_mid)                                \o/
-   * - pivot
-   * - [left_mid, mid)                                 \o/
-   * - [right_mid, e)                                  \o/
-   */
-  sort(b, pivot, ref(predicate));
-  sort(next(pivot), e, ref(predicate));
+  auto chunk = [b, n, chunks](size_t i) {
+                 return next(b, n * i / chunks);
+               };
+
+  auto sort_job = [&](size_t i) {
+                    sort(chunk(i), chunk(i + 1U), ref(predicate));
+                  };
+  impl::parallel_run(chunks, sort_job);
+
+  for (size_t width = 1; width < chunks; width *= 2U) {
+    auto merge_job = [&](size_t i) {
+                       const size_t lo = 2U * width * i;
+                       const size_t mid = lo + width;
+                       const size_t hi = (mid + width < chunks ?
+                                          mid + width :
+                                          chunks);
+                       if (mid < hi) {
+                         inplace_merge(chunk(lo), chunk(mid), chunk(hi),
+                                       ref(predicate));
+                       }
+                     };
+    impl::parallel_run((chunks + 2U * width - 1U) / (2U * width), merge_job);
+  }
 }
 
+namespace impl {
+
+/*
+ * Merge [b, mid) and [mid, e), using buf as scratch space.
+ *
+ * Only the elements of [b, mid) that need to move are moved into buf,
+ * after which they are merged back into [b, e).
+ * The merge output never overtakes the read position in [mid, e).
+ */
+template<typename RandomAccessIterator, typename T, typename Predicate>
+void buffered_merge(RandomAccessIterator b, RandomAccessIterator mid,
+                    RandomAccessIterator e, heap_array<T>& buf,
+                    Predicate predicate) {
+  /* Elements before the first element in [mid, e) are already in place. */
+  b = upper_bound(b, mid, *mid, ref(predicate));
+  if (b == mid) return;
+
+  buf.clear();
+  move(b, mid, back_inserter(buf));
+
+  auto b1 = buf.begin();
+  auto e1 = buf.end();
+  while (b1 != e1 && mid != e) {
+    /* Take from the right only if strictly less, to keep the sort stable. */
+    if (predicate(*mid, *b1))
+      *b++ = move(*mid++);
+    else
+      *b++ = move(*b1++);
+  }
+  move(b1, e1, b);  // Remainder of [mid, e) is already in place.
+}
+
+/* Merge sort, using buf (which holds at least half the range) to merge. */
+template<typename RandomAccessIterator, typename T, typename Predicate>
+void buffered_merge_sort(RandomAccessIterator b, RandomAccessIterator e,
+                         heap_array<T>& buf, Predicate predicate) {
+  using _namespace(std)::distance;
+
+  const auto n = distance(b, e);
+  if (n <= sort_insertion_threshold) {
+    insertion_sort(b, e, ref(predicate));
+    return;
+  }
+
+  RandomAccessIterator mid = next(b, n / 2);
+  buffered_merge_sort(b, mid, buf, ref(predicate));
+  buffered_merge_sort(mid, e, buf, ref(predicate));
+  if (predicate(*mid, *prev(mid)))
+    buffered_merge(b, mid, e, buf, ref(predicate));
+}
+
+/*
+ * Merge [b, mid) and [mid, e) in place, without using a buffer.
+ *
+ * SymMerge algorithm, by Pok-Son Kim and Arne Kutzner.
+ * Splits both ranges symmetrically around the middle of [b, e),
+ * using a binary search to find the split point, rotates the middle
+ * section into place and recurses on both halves.
+ * Uses O(n log n) element moves and O(log n) stack.
+ */
+template<typename RandomAccessIterator, typename Predicate>
+void symmerge(RandomAccessIterator b, RandomAccessIterator mid,
+              RandomAccessIterator e, Predicate predicate) {
+  using _namespace(std)::distance;
+  using difference_type =
+      typename iterator_traits<RandomAccessIterator>::difference_type;
+
+  const difference_type len = distance(b, e);
+  const difference_type m = distance(b, mid);
+  if (m == 0 || m == len) return;
+
+  /* Single element cases: insert the element using a binary search. */
+  if (m == 1) {
+    rotate(b, mid, lower_bound(mid, e, *b, ref(predicate)));
+    return;
+  }
+  if (m == len - 1) {
+    rotate(upper_bound(b, mid, *mid, ref(predicate)), mid, e);
+    return;
+  }
+
+  const difference_type half = len / 2;
+  const difference_type n = half + m;
+  difference_type start, r;
+  if (m > half) {
+    start = n - len;
+    r = half;
+  } else {
+    start = 0;
+    r = m;
+  }
+
+  const difference_type p = n - 1;
+  while (start < r) {
+    const difference_type c = start + (r - start) / 2;
+    if (!predicate(*next(b, p - c), *next(b, c)))
+      start = c + 1;
+    else
+      r = c;
+  }
+
+  const difference_type end = n - start;
+  if (start < m && m < end)
+    rotate(next(b, start), mid, next(b, end));
+  if (0 < start && start < half)
+    symmerge(b, next(b, start), next(b, half), ref(predicate));
+  if (half < end && end < len)
+    symmerge(next(b, half), next(b, end), e, ref(predicate));
+}
+
+/* Merge sort without a buffer, using symmerge. */
+template<typename RandomAccessIterator, typename Predicate>
+void inplace_merge_sort(RandomAccessIterator b, RandomAccessIterator e,
+                        Predicate predicate) {
+  using _namespace(std)::distance;
+
+  const auto n = distance(b, e);
+  if (n <= sort_insertion_threshold) {
+    insertion_sort(b, e, ref(predicate));
+    return;
+  }
+
+  RandomAccessIterator mid = next(b, n / 2);
+  inplace_merge_sort(b, mid, ref(predicate));
+  inplace_merge_sort(mid, e, ref(predicate));
+  if (predicate(*mid, *prev(mid)))
+    symmerge(b, mid, e, ref(predicate));
+}
+
+} /* namespace std::impl */
+
 template<typename RandomAccessIterator>
 void stable_sort(RandomAccessIterator b, RandomAccessIterator e) {
   stable_sort(b, e, less<void>());
 }
 
-
+/*
+ * Merge sort.
+ *
+ * If a temporary buffer of half the range can be allocated,
+ * merges use the buffer, giving O(n log n) time and sequential access.
+ * Otherwise, merges are done in place using symmerge,
+ * in O(n log^2 n) time.
+ * (insertion_sort only swaps strictly ordered elements, so it is stable.)
+ */
 template<typename RandomAccessIterator, typename Predicate>
 void stable_sort(RandomAccessIterator b, RandomAccessIterator e,
                  Predicate predicate) {
-  using placeholders::_1;
+  using value_type =
+      typename iterator_traits<RandomAccessIterator>::value_type;
 
   if (b == e || next(b) == e) return;  // Already sorted.
 
-  /*
-   * Elements in b, e may not be copyable, so we can't simply bind an argument
-   * to the predicate and use that to directly partition the collection.
-   * Using a reference to an element in the collection doesn't work either,
-   * since the elements will be shuffled, causing our predicate to change
-   * behind our back.
-   *
-   * Instead, use some song and dance:
-   * - select an element mid as the pivot
-   * - partition the space before and after mid (exclusing mid itself)
-   * - rotate the collection to become correctly ordered
-   * Sort will proceed recursively on the two partitions.
-   */
-  RandomAccessIterator mid =
-      next(b, arc4random_uniform64(distance(b, e)));
-  auto left_mid = stable_partition(b, mid,
-      bind(logical_not<void>(), bind(ref(predicate), ref(*mid), _1)));
-  auto right_mid = stable_partition(next(mid), e,
-                                    bind(ref(predicate), _1, ref(*mid)));
-
-  /*
-   * Layout:
-   * - [b, left_mid)           before pivot            \o/
-   * - [left_mid, mid)         should be after pivot
-   * - pivot = mid             pivot point
-   * - [next(mid), right_mid)  should be before pivot
-   * - [right_mid, e)          after pivot             \o/
-   */
-  rotate(left_mid, mid, next(mid));
-
-  /*
-   * Layout:
-   * - [b, left_mid)           before pivot            \o/
-   * - pivot = left_mid        pivot point
-   * - (left_mid, mid]         should be after pivot   \o/
-   * - [next(mid), right_mid)  should be before pivot
-   * - [right_mid, e)          after pivot             \o/
-   */
-  RandomAccessIterator pivot = rotate(left_mid, next(mid), right_mid);
+  if (is_nothrow_move_constructible<value_type>::value &&
+      distance(b, e) > impl::sort_insertion_threshold) {
+    auto buf = impl::heap_array<value_type>((distance(b, e) + 1) / 2);
+    if (_predict_true(buf)) {
+      impl::buffered_merge_sort(b, e, buf, ref(predicate));
+      return;
+    }
+  }
 
-  /*
-   * This time, use the original names for the segments.
-   * Layout:
-   * - [b, left_mid)                                   \o/
-   * - (mid, right_mid)                                \o/
-   * - pivot
-   * - [left_mid, mid)                                 \o/
-   * - [right_mid, e)                                  \o/
-   */
-  stable_sort(b, pivot, ref(predicate));
-  stable_sort(next(pivot), e, ref(predicate));
+  impl::inplace_merge_sort(b, e, ref(predicate));
 }
 
 template<typename RandomAccessIterator>
@@ -1286,34 +1636,25 @@ void partial_sort(RandomAccessIterator b, RandomAccessIterator mid,
   partial_sort(b, mid, e, less<void>());
 }
 
+/*
+ * Keep the smallest mid - b elements in a max-heap in [b, mid):
+ * each element in [mid, e) that is less than the top of the heap
+ * replaces the top.
+ * O(n log k) time, where k = distance(b, mid).
+ */
 template<typename RandomAccessIterator, typename Predicate>
 void partial_sort(RandomAccessIterator b, RandomAccessIterator mid,
                   RandomAccessIterator e, Predicate predicate) {
-  if (_predict_false(mid == e)) {
-    sort(b, e, ref(predicate));
-    return;
-  }
-
-  auto n = distance(b, e);
-  auto mid_n = distance(b, mid);
-  RandomAccessIterator half = next(b, n / 2);
-
-  if (distance(b, half) <= mid_n)
-    sort(b, half, ref(predicate));
-  else
-    partial_sort(b, mid, half, ref(predicate));
+  if (b == mid) return;
 
-  if (distance(half, e) <= mid_n)
-    sort(half, e, ref(predicate));
-  else
-    partial_sort(half, next(half, mid_n), e, ref(predicate));
-
-  /* Merge half, e into mid. */
-  while (half != e &&
-         (b = upper_bound(b, mid, *half, ref(predicate))) != mid) {
-    rotate(b, prev(mid), mid);
-    iter_swap(b, half);
+  make_heap(b, mid, ref(predicate));
+  for (RandomAccessIterator i = mid; i != e; ++i) {
+    if (predicate(*i, *b)) {
+      iter_swap(i, b);
+      impl::fix_heap(b, b, mid, ref(predicate));
+    }
   }
+  sort_heap(b, mid, ref(predicate));
 }
 
 template<typename InputIterator, typename RandomAccessIterator>
@@ -1323,29 +1664,30 @@ RandomAccessIterator partial_sort_copy(InputIterator b, InputIterator e,
   return partial_sort_copy(b, e, out_b, out_e, less<void>());
 }
 
+/* Same as partial_sort, using the output range as the heap. */
 template<typename InputIterator, typename RandomAccessIterator,
          typename Predicate>
 RandomAccessIterator partial_sort_copy(InputIterator b, InputIterator e,
                                        RandomAccessIterator out_b,
                                        RandomAccessIterator out_e,
                                        Predicate predicate) {
-  const auto N = distance(out_b, out_e);
-  InputIterator i = b;
-  /* Advance i up to N positions. */
-  for (auto i_N = N; i_N > 0 && i != e; --i_N) ++i;
-
-  out_e = copy(b, i, out_b);
-  sort(out_b, out_e, ref(predicate));
-
-  while (i != e) {
-    auto out_ipos = upper_bound(out_b, out_e, *i, ref(predicate));
-    if (out_ipos != out_e) {
-      move_backward(out_ipos, prev(out_e), out_e);
-      *out_ipos = *i;
+  RandomAccessIterator out = out_b;
+  while (out != out_e && b != e) {
+    *out = *b;
+    ++out;
+    ++b;
+  }
+  if (out == out_b) return out;
+
+  make_heap(out_b, out, ref(predicate));
+  for (; b != e; ++b) {
+    if (predicate(*b, *out_b)) {
+      *out_b = *b;
+      impl::fix_heap(out_b, out_b, out, ref(predicate));
     }
-    ++i;
   }
-  return out_e;
+  sort_heap(out_b, out, ref(predicate));
+  return out;
 }
 
 template<typename InputIterator>
@@ -1382,40 +1724,83 @@ void nth_element(RandomAccessIterator b, RandomAccessIterator nth,
   nth_element(b, nth, e, less<void>());
 }
 
+namespace impl {
+
+/*
+ * Select a pivot with the median of medians, and move it to b.
+ *
+ * The median of each group of 5 elements is moved to the front of the range,
+ * after which the median of those is selected.
+ * The pivot is guaranteed to have at least 3/10 of the range on either side.
+ */
 template<typename RandomAccessIterator, typename Predicate>
-void nth_element(RandomAccessIterator b, RandomAccessIterator nth,
-                 RandomAccessIterator e, Predicate predicate) {
-  using placeholders::_1;
+void median_of_medians(RandomAccessIterator b, RandomAccessIterator e,
+                       Predicate predicate) {
+  using _namespace(std)::distance;
 
-  assert(b == nth || distance(b, nth) < distance(b, e));
+  RandomAccessIterator medians_end = b;
+  for (RandomAccessIterator i = b; distance(i, e) >= 5; i = next(i, 5)) {
+    insertion_sort(i, next(i, 5), ref(predicate));
+    iter_swap(medians_end++, next(i, 2));
+  }
 
-  /*
-   * Use pivot based selection, as in sort, but only traverse one leg of
-   * the two partitions instead of both.
-   *
-   * Since each stage divides the range in half,
-   * at most 2 * distance(b, e) - 1 invocations of the predicate are required,
-   * given that the pivot is well chosen.
-   */
-  while (b != e && next(b) != e) {
-    RandomAccessIterator mid =
-        next(b, arc4random_uniform64(distance(b, e)));
-    auto left_mid = partition(
-        b, mid,
-        bind(logical_not<void>(), bind(ref(predicate), ref(*mid), _1)));
-    auto right_mid = partition(next(mid), e,
-                               bind(ref(predicate), _1, ref(*mid)));
-
-    rotate(left_mid, mid, next(mid));
-    RandomAccessIterator pivot = rotate(left_mid, next(mid), right_mid);
+  RandomAccessIterator m = next(b, distance(b, medians_end) / 2);
+  nth_element(b, m, medians_end, ref(predicate));
+  iter_swap(b, m);
+}
+
+/*
+ * Introselect.
+ *
+ * Quickselect using the same pivot selection and partitioning as introsort.
+ * Each unbalanced partition uses up one of bad_allowed and has its
+ * elements shuffled, as in introsort;
+ * once exhausted, the pivot is chosen using median of medians,
+ * which bounds the worst case to O(n).
+ */
+template<typename RandomAccessIterator, typename Predicate>
+void introselect(RandomAccessIterator b, RandomAccessIterator nth,
+                 RandomAccessIterator e, Predicate predicate,
+                 unsigned int bad_allowed) {
+  using _namespace(std)::distance;
+
+  while (distance(b, e) > sort_insertion_threshold) {
+    const auto n = distance(b, e);
+
+    if (bad_allowed == 0)
+      median_of_medians(b, e, ref(predicate));
+    else
+      sort_select_pivot(b, e, ref(predicate));
+    RandomAccessIterator pivot = sort_partition(b, e, ref(predicate)).first;
+
+    const auto l_n = distance(b, pivot);
+    const auto r_n = distance(next(pivot), e);
+    if ((l_n < n / 8 || r_n < n / 8) && bad_allowed > 0) {
+      --bad_allowed;
+      sort_break_patterns(b, pivot, e);
+    }
 
     if (pivot < nth)
       b = next(pivot);
-    else if (pivot > nth)
+    else if (nth < pivot)
       e = pivot;
     else
       return;  // pivot == nth, which is partitioned into the right place.
   }
+
+  insertion_sort(b, e, ref(predicate));
+}
+
+} /* namespace std::impl */
+
+template<typename RandomAccessIterator, typename Predicate>
+void nth_element(RandomAccessIterator b, RandomAccessIterator nth,
+                 RandomAccessIterator e, Predicate predicate) {
+  assert(b == nth || distance(b, nth) < distance(b, e));
+
+  if (b == e || nth == e) return;
+  impl::introselect(b, nth, e, ref(predicate),
+                    abi::ext::log2_down(distance(b, e)));
 }
 
 
@@ -1500,11 +1885,12 @@ template<typename InputIterator1, typename InputIterator2,
 OutputIterator merge(InputIterator1 b1, InputIterator1 e1,
                      InputIterator2 b2, InputIterator2 e2,
                      OutputIterator out, Predicate predicate) {
+  /* Take from the second range only if strictly less, so merge is stable. */
   while (b1 != e1 && b2 != e2) {
-    if (predicate(*b1, *b2))
-      *out++ = *b1++;
-    else
+    if (predicate(*b2, *b1))
       *out++ = *b2++;
+    else
+      *out++ = *b1++;
   }
 
   out = copy(b1, e1, out);
@@ -1538,7 +1924,7 @@ void inplace_merge(BidirectionalIterator b, BidirectionalIterator mid,
             make_move_iterator(array1.end()),
             make_move_iterator(array2.begin()),
             make_move_iterator(array2.end()),
-            b);
+            b, ref(predicate));
       return;
     }
   }
@@ -1837,7 +2223,7 @@ void make_heap(RandomAccessIterator b, RandomAccessIterator e) {
 template<typename RandomAccessIterator, typename Predicate>
 void make_heap(RandomAccessIterator b, RandomAccessIterator e,
                Predicate predicate) {
-  if (b == e) return;  // Skip empty set.
+  if (b == e || next(b) == e) return;  // Skip empty and single element set.
 
   /*
    * All leaves are already heaps,
@@ -1846,7 +2232,7 @@ void make_heap(RandomAccessIterator b, RandomAccessIterator e,
   const auto idx = distance(b, e) / 2U - 1U;
   auto i = next(b, idx);
   for (;;) {
-    fix_heap(b, i, e, ref(predicate));
+    impl::fix_heap(b, i, e, ref(predicate));
     if (i == b) break;  // GUARD
     --i;
   }
@@ -11,15 +11,15 @@ _namespace_begin(std)
 namespace impl {
 
 
-template<size_t TSize, size_t TAlign, typename A>
-deque_storage_base<TSize, TAlign, A>::deque_storage_base(
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+deque_storage_base<TSize, TAlign, A, BSize>::deque_storage_base(
     const allocator_type& a)
 : alloc_base(a),
   data_(a)
 {}
 
-template<size_t TSize, size_t TAlign, typename A>
-deque_storage_base<TSize, TAlign, A>::deque_storage_base(
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+deque_storage_base<TSize, TAlign, A, BSize>::deque_storage_base(
     deque_storage_base&& o)
 : alloc_base(move(o)),
   data_(move(o.data_)),
@@ -27,15 +27,15 @@ deque_storage_base<TSize, TAlign, A>::deque_storage_base(
   size_(exchange(o.size_, 0))
 {}
 
-template<size_t TSize, size_t TAlign, typename A>
-deque_storage_base<TSize, TAlign, A>::~deque_storage_base() noexcept {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+deque_storage_base<TSize, TAlign, A, BSize>::~deque_storage_base() noexcept {
   assert(empty());
   for_each(data_ptr_begin(), data_ptr_end(),
            alloc_deleter_visitor(this->get_allocator_()));
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::swap(deque_storage_base& o)
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::swap(deque_storage_base& o)
     noexcept -> void {
   using _namespace(std)::swap;
 
@@ -45,18 +45,21 @@ auto deque_storage_base<TSize, TAlign, A>::swap(deque_storage_base& o)
   swap(off_, o.off_);
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::empty() const noexcept -> bool {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::empty() const noexcept ->
+    bool {
   return size() == 0;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::size() const noexcept -> size_type {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::size() const noexcept ->
+    size_type {
   return size_;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::max_size() const -> size_type {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::max_size() const ->
+    size_type {
   using alloc_traits = allocator_traits<typename alloc_base::allocator_type>;
   using abi::umul_overflow;
 
@@ -84,8 +87,8 @@ auto deque_storage_base<TSize, TAlign, A>::max_size() const -> size_type {
   return data_max_items;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::capacity() const noexcept ->
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::capacity() const noexcept ->
     size_type {
   size_type avail = data_.size() * block_items_();
   size_type maybe_unavail = max(front_avail_() % block_items_(),
@@ -94,8 +97,9 @@ auto deque_storage_base<TSize, TAlign, A>::capacity() const noexcept ->
   return avail - maybe_unavail;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::reserve(size_type rsv) -> void {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::reserve(size_type rsv) ->
+    void {
   void* hint = (data_.empty() ?
                 static_cast<void*>(this) :
                 static_cast<void*>(&data_.back()));
@@ -107,49 +111,49 @@ auto deque_storage_base<TSize, TAlign, A>::reserve(size_type rsv) -> void {
   }
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::shrink_to_fit() -> void {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::shrink_to_fit() -> void {
   shrink_to_fit_before_();
   shrink_to_fit_after_();
   data_.shrink_to_fit();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::front() noexcept ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::front() noexcept ->
     add_lvalue_reference_t<T> {
   assert(!empty());
   return *begin<T>();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::front() const noexcept ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::front() const noexcept ->
     add_lvalue_reference_t<add_const_t<T>> {
   assert(!empty());
   return *begin<T>();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::back() noexcept ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::back() noexcept ->
     add_lvalue_reference_t<T> {
   assert(!empty());
   return *prev(end<T>());
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::back() const noexcept ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::back() const noexcept ->
     add_lvalue_reference_t<add_const_t<T>> {
   assert(!empty());
   return *prev(end<T>());
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T, typename... Args>
-auto deque_storage_base<TSize, TAlign, A>::emplace_front(Args&&... args) ->
-    void {
+auto deque_storage_base<TSize, TAlign, A, BSize>::emplace_front(
+    Args&&... args) -> void {
   static_assert(sizeof(T) <= TSize && TAlign % alignof(T) == 0,
                 "Storage cannot hold instance of this type.");
 
@@ -161,10 +165,10 @@ auto deque_storage_base<TSize, TAlign, A>::emplace_front(Args&&... args) ->
   ++size_;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T, typename... Args>
-auto deque_storage_base<TSize, TAlign, A>::emplace_back(Args&&... args) ->
-    void {
+auto deque_storage_base<TSize, TAlign, A, BSize>::emplace_back(
+    Args&&... args) -> void {
   static_assert(sizeof(T) <= TSize && TAlign % alignof(T) == 0,
                 "Storage cannot hold instance of this type.");
 
@@ -175,11 +179,10 @@ auto deque_storage_base<TSize, TAlign, A>::emplace_back(Args&&... args) ->
   ++size_;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T, typename... Args>
-auto deque_storage_base<TSize, TAlign, A>::emplace(const_iterator<T> pos,
-                                                   Args&&... args) ->
-    iterator<T> {
+auto deque_storage_base<TSize, TAlign, A, BSize>::emplace(
+    const_iterator<T> pos, Args&&... args) -> iterator<T> {
   static_assert(sizeof(T) <= TSize && TAlign % alignof(T) == 0,
                 "Storage cannot hold instance of this type.");
 
@@ -209,10 +212,10 @@ auto deque_storage_base<TSize, TAlign, A>::emplace(const_iterator<T> pos,
 /*
  * Insert: bidirectional iterator code.
  */
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T, typename Iter>
-auto deque_storage_base<TSize, TAlign, A>::insert(const_iterator<T> pos,
-                                                  Iter b, Iter e) ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::insert(
+    const_iterator<T> pos, Iter b, Iter e) ->
     enable_if_t<is_base_of<bidirectional_iterator_tag,
                            typename iterator_traits<Iter>::iterator_category
                           >::value,
@@ -244,10 +247,10 @@ auto deque_storage_base<TSize, TAlign, A>::insert(const_iterator<T> pos,
 /*
  * Insert: generic code.
  */
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T, typename Iter>
-auto deque_storage_base<TSize, TAlign, A>::insert(const_iterator<T> pos,
-                                                  Iter b, Iter e) ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::insert(
+    const_iterator<T> pos, Iter b, Iter e) ->
     enable_if_t<!is_base_of<bidirectional_iterator_tag,
                             typename iterator_traits<Iter>::iterator_category
                            >::value,
@@ -277,11 +280,10 @@ auto deque_storage_base<TSize, TAlign, A>::insert(const_iterator<T> pos,
   }
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::insert_n(const_iterator<T> pos,
-                                                    size_type n, const T& v) ->
-    iterator<T> {
+auto deque_storage_base<TSize, TAlign, A, BSize>::insert_n(
+    const_iterator<T> pos, size_type n, const T& v) -> iterator<T> {
   static_assert(sizeof(T) <= TSize && TAlign % alignof(T) == 0,
                 "Storage cannot hold instance of this type.");
 
@@ -304,9 +306,9 @@ auto deque_storage_base<TSize, TAlign, A>::insert_n(const_iterator<T> pos,
   }
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::pop_front() noexcept -> void {
+auto deque_storage_base<TSize, TAlign, A, BSize>::pop_front() noexcept -> void {
   static_assert(sizeof(T) <= TSize && TAlign % alignof(T) == 0,
                 "Storage cannot hold instance of this type.");
 
@@ -319,9 +321,9 @@ auto deque_storage_base<TSize, TAlign, A>::pop_front() noexcept -> void {
   }
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::pop_back() noexcept -> void {
+auto deque_storage_base<TSize, TAlign, A, BSize>::pop_back() noexcept -> void {
   static_assert(sizeof(T) <= TSize && TAlign % alignof(T) == 0,
                 "Storage cannot hold instance of this type.");
 
@@ -333,9 +335,9 @@ auto deque_storage_base<TSize, TAlign, A>::pop_back() noexcept -> void {
   }
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::erase(const_iterator<T> i)
+auto deque_storage_base<TSize, TAlign, A, BSize>::erase(const_iterator<T> i)
     noexcept -> iterator<T> {
   static_assert(sizeof(T) <= TSize && TAlign % alignof(T) == 0,
                 "Storage cannot hold instance of this type.");
@@ -370,11 +372,10 @@ auto deque_storage_base<TSize, TAlign, A>::erase(const_iterator<T> i)
   return begin<T>() + dist;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::erase(const_iterator<T> b,
-                                                 const_iterator<T> e)
-    noexcept -> iterator<T> {
+auto deque_storage_base<TSize, TAlign, A, BSize>::erase(
+    const_iterator<T> b, const_iterator<T> e) noexcept -> iterator<T> {
   size_type n = e - b;
   assert(n <= size());
 
@@ -515,30 +516,30 @@ auto deque_storage_base<TSize, TAlign, A>::erase(const_iterator<T> b,
   return begin<T>() + dist_b;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::clear() noexcept -> void {
+auto deque_storage_base<TSize, TAlign, A, BSize>::clear() noexcept -> void {
   for_each(begin<T>(), end<T>(),
            [](T& v) { v.~T(); });
   size_ = 0;
   off_ = 0;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::front_avail_() const noexcept ->
-    size_type {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::front_avail_()
+    const noexcept -> size_type {
   return off_;
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::back_avail_() const noexcept ->
-    size_type {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::back_avail_()
+    const noexcept -> size_type {
   return (data_.size() * block_items_()) - (off_ + size_);
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::ensure_front_avail_(size_type n) ->
-    void {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::ensure_front_avail_(
+    size_type n) -> void {
   size_type avail = front_avail_();
   if (avail >= n) return;
 
@@ -564,9 +565,9 @@ auto deque_storage_base<TSize, TAlign, A>::ensure_front_avail_(size_type n) ->
   }
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::ensure_back_avail_(size_type n) ->
-    void {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::ensure_back_avail_(
+    size_type n) -> void {
   size_type avail = back_avail_();
   if (avail >= n) return;
 
@@ -591,27 +592,29 @@ auto deque_storage_base<TSize, TAlign, A>::ensure_back_avail_(size_type n) ->
   }
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::begin() noexcept -> iterator<T> {
+auto deque_storage_base<TSize, TAlign, A, BSize>::begin() noexcept ->
+    iterator<T> {
   using data_iterator = typename defn_::data_iterator;
   using defn_iterator = typename defn_::iterator;
   return iterator<T>(defn_iterator(data_iterator(data_ptr_begin()))) +
          front_avail_();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::end() noexcept -> iterator<T> {
+auto deque_storage_base<TSize, TAlign, A, BSize>::end() noexcept ->
+    iterator<T> {
   using data_iterator = typename defn_::data_iterator;
   using defn_iterator = typename defn_::iterator;
   return iterator<T>(defn_iterator(data_iterator(data_ptr_end()))) -
          back_avail_();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::begin() const noexcept ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::begin() const noexcept ->
     const_iterator<T> {
   using data_iterator = typename defn_::const_data_iterator;
   using defn_iterator = typename defn_::const_iterator;
@@ -619,9 +622,9 @@ auto deque_storage_base<TSize, TAlign, A>::begin() const noexcept ->
          front_avail_();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::end() const noexcept ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::end() const noexcept ->
     const_iterator<T> {
   using data_iterator = typename defn_::const_data_iterator;
   using defn_iterator = typename defn_::const_iterator;
@@ -629,51 +632,51 @@ auto deque_storage_base<TSize, TAlign, A>::end() const noexcept ->
          back_avail_();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::cbegin() const noexcept ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::cbegin() const noexcept ->
     const_iterator<T> {
   return begin<T>();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
 template<typename T>
-auto deque_storage_base<TSize, TAlign, A>::cend() const noexcept ->
+auto deque_storage_base<TSize, TAlign, A, BSize>::cend() const noexcept ->
     const_iterator<T> {
   return end<T>();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::data_ptr_begin() noexcept ->
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::data_ptr_begin() noexcept ->
     typename defn_::data_ptr_iterator {
   using iterator = typename defn_::data_ptr_iterator;
   return iterator(data_.begin());
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::data_ptr_end() noexcept ->
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::data_ptr_end() noexcept ->
     typename defn_::data_ptr_iterator {
   using iterator = typename defn_::data_ptr_iterator;
   return iterator(data_.end());
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::data_ptr_begin() const noexcept ->
-    typename defn_::const_data_ptr_iterator {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::data_ptr_begin()
+    const noexcept -> typename defn_::const_data_ptr_iterator {
   using iterator = typename defn_::const_data_ptr_iterator;
   return iterator(data_.begin());
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::data_ptr_end() const noexcept ->
-    typename defn_::const_data_ptr_iterator {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::data_ptr_end()
+    const noexcept -> typename defn_::const_data_ptr_iterator {
   using iterator = typename defn_::const_data_ptr_iterator;
   return iterator(data_.end());
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::shrink_to_fit_before_() noexcept ->
-    void {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::shrink_to_fit_before_()
+    noexcept -> void {
   using block_iter = typename defn_::data_ptr_iterator;
 
   size_type blocks_over = front_avail_() / block_items_();
@@ -686,9 +689,9 @@ auto deque_storage_base<TSize, TAlign, A>::shrink_to_fit_before_() noexcept ->
   off_ -= blocks_over * block_items_();
 }
 
-template<size_t TSize, size_t TAlign, typename A>
-auto deque_storage_base<TSize, TAlign, A>::shrink_to_fit_after_() noexcept ->
-    void {
+template<size_t TSize, size_t TAlign, typename A, size_t BSize>
+auto deque_storage_base<TSize, TAlign, A, BSize>::shrink_to_fit_after_()
+    noexcept -> void {
   using block_iter = typename defn_::data_ptr_iterator;
 
   size_type blocks_over = back_avail_() / block_items_();
@@ -704,53 +707,53 @@ auto deque_storage_base<TSize, TAlign, A>::shrink_to_fit_after_() noexcept ->
 } /* namespace std::impl */
 
 
-template<typename T, typename A>
-deque<T, A>::deque(const allocator_type& a)
+template<typename T, typename A, size_t B>
+deque<T, A, B>::deque(const allocator_type& a)
 : data_(a)
 {}
 
-template<typename T, typename A>
-deque<T, A>::deque(size_type n)
+template<typename T, typename A, size_t B>
+deque<T, A, B>::deque(size_type n)
 : deque()
 {
   resize(n);
 }
 
-template<typename T, typename A>
-deque<T, A>::deque(size_type n, const_reference v, const allocator_type& a)
+template<typename T, typename A, size_t B>
+deque<T, A, B>::deque(size_type n, const_reference v, const allocator_type& a)
 : deque(a)
 {
   resize(n, v);
 }
 
-template<typename T, typename A>
+template<typename T, typename A, size_t B>
 template<typename InputIter>
-deque<T, A>::deque(InputIter b, InputIter e, const allocator_type& a)
+deque<T, A, B>::deque(InputIter b, InputIter e, const allocator_type& a)
 : deque(a)
 {
   assign(b, e);
 }
 
-template<typename T, typename A>
-deque<T, A>::deque(const deque& o)
+template<typename T, typename A, size_t B>
+deque<T, A, B>::deque(const deque& o)
 : deque(o.begin(), o.end(), o.data_.get_allocator_for_copy_())
 {}
 
-template<typename T, typename A>
-deque<T, A>::deque(deque&& o)
+template<typename T, typename A, size_t B>
+deque<T, A, B>::deque(deque&& o)
     noexcept(is_nothrow_move_constructible<impl::alloc_base<A>>::value)
 : data_(move(o.data_))
 {}
 
-template<typename T, typename A>
-deque<T, A>::deque(const deque& o, const allocator_type& a)
+template<typename T, typename A, size_t B>
+deque<T, A, B>::deque(const deque& o, const allocator_type& a)
 : deque(a)
 {
   *this = o;
 }
 
-template<typename T, typename A>
-deque<T, A>::deque(deque&& o, const allocator_type& a)
+template<typename T, typename A, size_t B>
+deque<T, A, B>::deque(deque&& o, const allocator_type& a)
 : deque(a)
 {
   if (this->data_.get_allocator_() == o.data_.get_allocator_())
@@ -759,130 +762,130 @@ deque<T, A>::deque(deque&& o, const allocator_type& a)
     *this = move(o);
 }
 
-template<typename T, typename A>
-deque<T, A>::deque(initializer_list<value_type> il, const allocator_type& a)
+template<typename T, typename A, size_t B>
+deque<T, A, B>::deque(initializer_list<value_type> il, const allocator_type& a)
 : deque(il.begin(), il.end(), a)
 {}
 
-template<typename T, typename A>
-deque<T, A>::~deque() noexcept {
+template<typename T, typename A, size_t B>
+deque<T, A, B>::~deque() noexcept {
   clear();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::operator=(const deque& o) -> deque& {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::operator=(const deque& o) -> deque& {
   assign(o.begin(), o.end());
   return *this;
 }
 
-template<typename T, typename A>
-auto deque<T, A>::operator=(deque&& o) -> deque& {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::operator=(deque&& o) -> deque& {
   assign(move_iterator<iterator>(o.begin()), move_iterator<iterator>(o.end()));
   o.clear();
   return *this;
 }
 
-template<typename T, typename A>
-auto deque<T, A>::operator=(initializer_list<value_type> il) -> deque& {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::operator=(initializer_list<value_type> il) -> deque& {
   assign(il);
   return *this;
 }
 
-template<typename T, typename A>
+template<typename T, typename A, size_t B>
 template<typename Iter>
-auto deque<T, A>::assign(Iter o_begin, Iter o_end) -> void {
+auto deque<T, A, B>::assign(Iter o_begin, Iter o_end) -> void {
   clear();
   data_.template insert<value_type>(begin(), o_begin, o_end);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::assign(size_type dist, const_reference v) -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::assign(size_type dist, const_reference v) -> void {
   clear();
   insert(begin(), dist, v);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::assign(initializer_list<value_type> il) -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::assign(initializer_list<value_type> il) -> void {
   assign(il.begin(), il.end());
 }
 
-template<typename T, typename A>
-auto deque<T, A>::get_allocator() const -> allocator_type {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::get_allocator() const -> allocator_type {
   return data_.get_allocator();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::begin() noexcept -> iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::begin() noexcept -> iterator {
   return data_.template begin<value_type>();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::begin() const noexcept -> const_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::begin() const noexcept -> const_iterator {
   return data_.template begin<value_type>();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::end() noexcept -> iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::end() noexcept -> iterator {
   return data_.template end<value_type>();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::end() const noexcept -> const_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::end() const noexcept -> const_iterator {
   return data_.template end<value_type>();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::rbegin() noexcept -> reverse_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::rbegin() noexcept -> reverse_iterator {
   return reverse_iterator(end());
 }
 
-template<typename T, typename A>
-auto deque<T, A>::rbegin() const noexcept -> const_reverse_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::rbegin() const noexcept -> const_reverse_iterator {
   return const_reverse_iterator(end());
 }
 
-template<typename T, typename A>
-auto deque<T, A>::rend() noexcept -> reverse_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::rend() noexcept -> reverse_iterator {
   return reverse_iterator(begin());
 }
 
-template<typename T, typename A>
-auto deque<T, A>::rend() const noexcept -> const_reverse_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::rend() const noexcept -> const_reverse_iterator {
   return const_reverse_iterator(begin());
 }
 
-template<typename T, typename A>
-auto deque<T, A>::cbegin() const noexcept -> const_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::cbegin() const noexcept -> const_iterator {
   return begin();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::cend() const noexcept -> const_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::cend() const noexcept -> const_iterator {
   return end();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::crbegin() const noexcept -> const_reverse_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::crbegin() const noexcept -> const_reverse_iterator {
   return rbegin();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::crend() const noexcept -> const_reverse_iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::crend() const noexcept -> const_reverse_iterator {
   return rend();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::size() const noexcept -> size_type {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::size() const noexcept -> size_type {
   return data_.size();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::max_size() const -> size_type {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::max_size() const -> size_type {
   return data_.max_size();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::resize(size_type n) -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::resize(size_type n) -> void {
   if (size() > n) {
     erase(begin() + n, end());
   } else {
@@ -891,8 +894,8 @@ auto deque<T, A>::resize(size_type n) -> void {
   }
 }
 
-template<typename T, typename A>
-auto deque<T, A>::resize(size_type n, const_reference v) -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::resize(size_type n, const_reference v) -> void {
   if (size() > n) {
     erase(next(begin(), n), end());
   } else {
@@ -901,201 +904,204 @@ auto deque<T, A>::resize(size_type n, const_reference v) -> void {
   }
 }
 
-template<typename T, typename A>
-auto deque<T, A>::shrink_to_fit() -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::shrink_to_fit() -> void {
   data_.shrink_to_fit();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::capacity() const noexcept -> size_type {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::capacity() const noexcept -> size_type {
   return data_.capacity();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::reserve(size_type rsv) -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::reserve(size_type rsv) -> void {
   return data_.reserve(rsv);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::empty() const noexcept -> bool {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::empty() const noexcept -> bool {
   return data_.empty();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::operator[](size_type idx) noexcept -> reference {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::operator[](size_type idx) noexcept -> reference {
   assert(idx < size());
   return begin()[idx];
 }
 
-template<typename T, typename A>
-auto deque<T, A>::operator[](size_type idx) const noexcept -> const_reference {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::operator[](size_type idx) const noexcept ->
+    const_reference {
   assert(idx < size());
   return begin()[idx];
 }
 
-template<typename T, typename A>
-auto deque<T, A>::at(size_type idx) -> reference {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::at(size_type idx) -> reference {
   if (idx >= size()) throw out_of_range("deque::at");
   return (*this)[idx];
 }
 
-template<typename T, typename A>
-auto deque<T, A>::at(size_type idx) const -> const_reference {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::at(size_type idx) const -> const_reference {
   if (idx >= size()) throw out_of_range("deque::at");
   return (*this)[idx];
 }
 
-template<typename T, typename A>
-auto deque<T, A>::front() noexcept -> reference {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::front() noexcept -> reference {
   return data_.template front<value_type>();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::front() const noexcept -> const_reference {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::front() const noexcept -> const_reference {
   return data_.template front<value_type>();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::back() noexcept -> reference {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::back() noexcept -> reference {
   return data_.template back<value_type>();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::back() const noexcept -> const_reference {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::back() const noexcept -> const_reference {
   return data_.template back<value_type>();
 }
 
-template<typename T, typename A>
+template<typename T, typename A, size_t B>
 template<typename... Args>
-auto deque<T, A>::emplace_front(Args&&... args) -> void {
+auto deque<T, A, B>::emplace_front(Args&&... args) -> void {
   data_.template emplace_front<value_type>(forward<Args>(args)...);
 }
 
-template<typename T, typename A>
+template<typename T, typename A, size_t B>
 template<typename... Args>
-auto deque<T, A>::emplace_back(Args&&... args) -> void {
+auto deque<T, A, B>::emplace_back(Args&&... args) -> void {
   data_.template emplace_back<value_type>(forward<Args>(args)...);
 }
 
-template<typename T, typename A>
+template<typename T, typename A, size_t B>
 template<typename... Args>
-auto deque<T, A>::emplace(const_iterator pos, Args&&... args) -> iterator {
+auto deque<T, A, B>::emplace(const_iterator pos, Args&&... args) -> iterator {
   return data_.emplace(pos, forward<Args>(args)...);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::push_front(const value_type& v) -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::push_front(const value_type& v) -> void {
   return emplace_front(v);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::push_front(value_type&& v) -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::push_front(value_type&& v) -> void {
   return emplace_front(move(v));
 }
 
-template<typename T, typename A>
-auto deque<T, A>::push_back(const value_type& v) -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::push_back(const value_type& v) -> void {
   return emplace_back(v);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::push_back(value_type&& v) -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::push_back(value_type&& v) -> void {
   return emplace_back(move(v));
 }
 
-template<typename T, typename A>
-auto deque<T, A>::insert(const_iterator pos, const value_type& v) -> iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::insert(const_iterator pos, const value_type& v) ->
+    iterator {
   return data_.template emplace<value_type>(pos, v);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::insert(const_iterator pos, value_type&& v) -> iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::insert(const_iterator pos, value_type&& v) -> iterator {
   return data_.template emplace<value_type>(pos, move(v));
 }
 
-template<typename T, typename A>
-auto deque<T, A>::insert(const_iterator pos, size_type n, const_reference v) ->
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::insert(
+    const_iterator pos, size_type n, const_reference v) ->
     iterator {
   return data_.template insert_n<value_type>(pos, n, v);
 }
 
-template<typename T, typename A>
+template<typename T, typename A, size_t B>
 template<typename InputIter>
-auto deque<T, A>::insert(const_iterator pos, InputIter b, InputIter e) ->
+auto deque<T, A, B>::insert(const_iterator pos, InputIter b, InputIter e) ->
     iterator {
   return data_.template insert<value_type>(pos, b, e);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::insert(const_iterator pos,
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::insert(const_iterator pos,
                          initializer_list<value_type> il) -> iterator {
   return insert(pos, il.begin(), il.end());
 }
 
-template<typename T, typename A>
-auto deque<T, A>::pop_front() noexcept -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::pop_front() noexcept -> void {
   data_.template pop_front<value_type>();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::pop_back() noexcept -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::pop_back() noexcept -> void {
   data_.template pop_back<value_type>();
 }
 
-template<typename T, typename A>
-auto deque<T, A>::erase(const_iterator i) noexcept -> iterator {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::erase(const_iterator i) noexcept -> iterator {
   return data_.template erase<value_type>(i);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::erase(const_iterator b, const_iterator e) noexcept ->
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::erase(const_iterator b, const_iterator e) noexcept ->
     iterator {
   return data_.template erase<value_type>(b, e);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::swap(deque& o) noexcept -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::swap(deque& o) noexcept -> void {
   data_.swap(o.data_);
 }
 
-template<typename T, typename A>
-auto deque<T, A>::clear() noexcept -> void {
+template<typename T, typename A, size_t B>
+auto deque<T, A, B>::clear() noexcept -> void {
   data_.template clear<value_type>();
 }
 
 
-template<typename T, typename A>
-bool operator==(const deque<T, A>& a, const deque<T, A>& b) {
+template<typename T, typename A, size_t B>
+bool operator==(const deque<T, A, B>& a, const deque<T, A, B>& b) {
   return equal(a.begin(), a.end(), b.begin(), b.end());
 }
 
-template<typename T, typename A>
-bool operator!=(const deque<T, A>& a, const deque<T, A>& b) {
+template<typename T, typename A, size_t B>
+bool operator!=(const deque<T, A, B>& a, const deque<T, A, B>& b) {
   return !(a == b);
 }
 
-template<typename T, typename A>
-bool operator<(const deque<T, A>& a, const deque<T, A>& b) {
+template<typename T, typename A, size_t B>
+bool operator<(const deque<T, A, B>& a, const deque<T, A, B>& b) {
   return lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
 }
 
-template<typename T, typename A>
-bool operator>(const deque<T, A>& a, const deque<T, A>& b) {
+template<typename T, typename A, size_t B>
+bool operator>(const deque<T, A, B>& a, const deque<T, A, B>& b) {
   return b < a;
 }
 
-template<typename T, typename A>
-bool operator<=(const deque<T, A>& a, const deque<T, A>& b) {
+template<typename T, typename A, size_t B>
+bool operator<=(const deque<T, A, B>& a, const deque<T, A, B>& b) {
   return !(b < a);
 }
 
-template<typename T, typename A>
-bool operator>=(const deque<T, A>& a, const deque<T, A>& b) {
+template<typename T, typename A, size_t B>
+bool operator>=(const deque<T, A, B>& a, const deque<T, A, B>& b) {
   return !(a < b);
 }
 
-template<typename T, typename A>
-void swap(deque<T, A>& a, deque<T, A>& b) {
+template<typename T, typename A, size_t B>
+void swap(deque<T, A, B>& a, deque<T, A, B>& b) {
   a.swap(b);
 }
 
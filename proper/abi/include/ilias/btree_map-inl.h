@@ -0,0 +1,119 @@
+#ifndef _ILIAS_BTREE_MAP_INL_H_
+#define _ILIAS_BTREE_MAP_INL_H_
+
+#include <ilias/btree_map.h>
+#include <stdexcept>
+#include <tuple>
+
+_namespace_begin(ilias)
+
+
+template<typename Key, typename T, typename Compare, typename A>
+auto btree_map<Key, T, Compare, A>::value_compare::operator()(
+    const value_type& x, const value_type& y) const -> bool {
+  return comp(x.first, y.first);
+}
+
+
+template<typename Key, typename T, typename Compare, typename A>
+auto btree_map<Key, T, Compare, A>::operator[](const key_type& k) ->
+    mapped_type& {
+  return try_emplace_(k).first->second;
+}
+
+template<typename Key, typename T, typename Compare, typename A>
+auto btree_map<Key, T, Compare, A>::operator[](key_type&& k) ->
+    mapped_type& {
+  return try_emplace_(_namespace(std)::move(k)).first->second;
+}
+
+template<typename Key, typename T, typename Compare, typename A>
+auto btree_map<Key, T, Compare, A>::at(const key_type& k) -> mapped_type& {
+  iterator i = this->find(k);
+  if (i == this->end()) throw _namespace(std)::out_of_range("btree_map");
+  return i->second;
+}
+
+template<typename Key, typename T, typename Compare, typename A>
+auto btree_map<Key, T, Compare, A>::at(const key_type& k) const ->
+    const mapped_type& {
+  const_iterator i = this->find(k);
+  if (i == this->end()) throw _namespace(std)::out_of_range("btree_map");
+  return i->second;
+}
+
+template<typename Key, typename T, typename Compare, typename A>
+template<typename... Args>
+auto btree_map<Key, T, Compare, A>::try_emplace(const key_type& k,
+                                                Args&&... args) ->
+    _namespace(std)::pair<iterator, bool> {
+  return try_emplace_(k, _namespace(std)::forward<Args>(args)...);
+}
+
+template<typename Key, typename T, typename Compare, typename A>
+template<typename... Args>
+auto btree_map<Key, T, Compare, A>::try_emplace(key_type&& k,
+                                                Args&&... args) ->
+    _namespace(std)::pair<iterator, bool> {
+  return try_emplace_(_namespace(std)::move(k),
+                      _namespace(std)::forward<Args>(args)...);
+}
+
+template<typename Key, typename T, typename Compare, typename A>
+template<typename M>
+auto btree_map<Key, T, Compare, A>::insert_or_assign(const key_type& k,
+                                                     M&& v) ->
+    _namespace(std)::pair<iterator, bool> {
+  auto rv = try_emplace_(k, _namespace(std)::forward<M>(v));
+  if (!rv.second) rv.first->second = _namespace(std)::forward<M>(v);
+  return rv;
+}
+
+template<typename Key, typename T, typename Compare, typename A>
+template<typename M>
+auto btree_map<Key, T, Compare, A>::insert_or_assign(key_type&& k,
+                                                     M&& v) ->
+    _namespace(std)::pair<iterator, bool> {
+  auto rv = try_emplace_(_namespace(std)::move(k),
+                         _namespace(std)::forward<M>(v));
+  if (!rv.second) rv.first->second = _namespace(std)::forward<M>(v);
+  return rv;
+}
+
+template<typename Key, typename T, typename Compare, typename A>
+auto btree_map<Key, T, Compare, A>::value_comp() const -> value_compare {
+  return value_compare(this->key_comp());
+}
+
+/*
+ * Only construct the element if the key is absent;
+ * the arguments are not touched if the key is present.
+ */
+template<typename Key, typename T, typename Compare, typename A>
+template<typename K, typename... Args>
+auto btree_map<Key, T, Compare, A>::try_emplace_(K&& k, Args&&... args) ->
+    _namespace(std)::pair<iterator, bool> {
+  using _namespace(std)::forward;
+  using _namespace(std)::forward_as_tuple;
+  using _namespace(std)::piecewise_construct;
+
+  const auto pos = this->find_insert_position_(k);
+  if (pos.second) return { pos.first, false };
+  return { this->construct_at_(pos.first,
+                               piecewise_construct,
+                               forward_as_tuple(forward<K>(k)),
+                               forward_as_tuple(forward<Args>(args)...)),
+           true };
+}
+
+
+template<typename Key, typename T, typename Compare, typename A>
+void swap(btree_map<Key, T, Compare, A>& x,
+          btree_map<Key, T, Compare, A>& y) noexcept {
+  x.swap(y);
+}
+
+
+_namespace_end(ilias)
+
+#endif /* _ILIAS_BTREE_MAP_INL_H_ */
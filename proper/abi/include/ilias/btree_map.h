@@ -0,0 +1,125 @@
+#ifndef _ILIAS_BTREE_MAP_H_
+#define _ILIAS_BTREE_MAP_H_
+
+#include <cdecl.h>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <ilias/btree_table.h>
+
+_namespace_begin(ilias)
+namespace impl {
+
+struct btree_map_key {
+  template<typename Pair>
+  auto operator()(const Pair& p) const noexcept -> decltype((p.first)) {
+    return p.first;
+  }
+
+  /*
+   * Move both members: the key is const only to users of the map.
+   * Used on the slots of the tree, never on a value that is observed
+   * afterwards.
+   */
+  template<typename Alloc, typename Pair>
+  static void transfer(Alloc& alloc, Pair* dst, Pair* src) noexcept {
+    using key_type = _namespace(std)::remove_const_t<
+        typename Pair::first_type>;
+    using alloc_traits = _namespace(std)::allocator_traits<Alloc>;
+
+    alloc_traits::construct(
+        alloc, dst,
+        _namespace(std)::move(const_cast<key_type&>(src->first)),
+        _namespace(std)::move(src->second));
+    alloc_traits::destroy(alloc, src);
+  }
+};
+
+} /* namespace ilias::impl */
+
+
+/*
+ * Ordered map, storing elements inline in the nodes of a B-tree.
+ *
+ * Compared to map, a node holds many elements, so lookups touch fewer
+ * cache lines and in-order iteration mostly walks contiguous memory.
+ * In return, inserting and erasing move elements between nodes,
+ * invalidating all iterators and references.  Key and T must be
+ * nothrow move constructible.
+ */
+template<typename Key, typename T,
+         typename Compare = _namespace(std)::less<Key>,
+         typename Allocator =
+             _namespace(std)::allocator<_namespace(std)::pair<const Key, T>>>
+class btree_map
+: public impl::btree_table<Key, _namespace(std)::pair<const Key, T>,
+                           impl::btree_map_key, Compare, Allocator>
+{
+ private:
+  using table = impl::btree_table<Key, _namespace(std)::pair<const Key, T>,
+                                  impl::btree_map_key, Compare, Allocator>;
+
+  static_assert(_namespace(std)::is_nothrow_move_constructible<Key>::value &&
+                _namespace(std)::is_nothrow_move_constructible<T>::value,
+                "btree_map requires nothrow move constructible types");
+
+ public:
+  using mapped_type = T;
+  using typename table::key_type;
+  using typename table::value_type;
+  using typename table::iterator;
+  using typename table::const_iterator;
+
+  class value_compare {
+    friend class btree_map;
+
+   protected:
+    value_compare(Compare c) : comp(c) {}
+
+   public:
+    using result_type = bool;
+    using first_argument_type = value_type;
+    using second_argument_type = value_type;
+
+    bool operator()(const value_type&, const value_type&) const;
+
+   protected:
+    Compare comp;
+  };
+
+  using table::table;
+
+  mapped_type& operator[](const key_type&);
+  mapped_type& operator[](key_type&&);
+  mapped_type& at(const key_type&);
+  const mapped_type& at(const key_type&) const;
+
+  template<typename... Args>
+  _namespace(std)::pair<iterator, bool> try_emplace(const key_type&,
+                                                    Args&&...);
+  template<typename... Args>
+  _namespace(std)::pair<iterator, bool> try_emplace(key_type&&, Args&&...);
+  template<typename M>
+  _namespace(std)::pair<iterator, bool> insert_or_assign(const key_type&,
+                                                         M&&);
+  template<typename M>
+  _namespace(std)::pair<iterator, bool> insert_or_assign(key_type&&, M&&);
+
+  value_compare value_comp() const;
+
+ private:
+  template<typename K, typename... Args>
+  _namespace(std)::pair<iterator, bool> try_emplace_(K&&, Args&&...);
+};
+
+template<typename Key, typename T, typename Compare, typename A>
+void swap(btree_map<Key, T, Compare, A>&,
+          btree_map<Key, T, Compare, A>&) noexcept;
+
+
+_namespace_end(ilias)
+
+#include <ilias/btree_map-inl.h>
+
+#endif /* _ILIAS_BTREE_MAP_H_ */
@@ -0,0 +1,67 @@
+#ifndef _ILIAS_BTREE_SET_H_
+#define _ILIAS_BTREE_SET_H_
+
+#include <cdecl.h>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <ilias/btree_table.h>
+
+_namespace_begin(ilias)
+namespace impl {
+
+struct btree_set_key {
+  template<typename T>
+  auto operator()(const T& v) const noexcept -> const T& {
+    return v;
+  }
+
+  template<typename Alloc, typename T>
+  static void transfer(Alloc& alloc, T* dst, T* src) noexcept {
+    using alloc_traits = _namespace(std)::allocator_traits<Alloc>;
+
+    alloc_traits::construct(alloc, dst, _namespace(std)::move(*src));
+    alloc_traits::destroy(alloc, src);
+  }
+};
+
+} /* namespace ilias::impl */
+
+
+/*
+ * Ordered set, storing elements inline in the nodes of a B-tree.
+ *
+ * See btree_map for the trade-offs against set.
+ */
+template<typename T,
+         typename Compare = _namespace(std)::less<T>,
+         typename Allocator = _namespace(std)::allocator<T>>
+class btree_set
+: public impl::btree_table<T, T, impl::btree_set_key, Compare, Allocator>
+{
+ private:
+  using table =
+      impl::btree_table<T, T, impl::btree_set_key, Compare, Allocator>;
+
+  static_assert(_namespace(std)::is_nothrow_move_constructible<T>::value,
+                "btree_set requires a nothrow move constructible type");
+
+ public:
+  using value_compare = Compare;
+
+  using table::table;
+
+  value_compare value_comp() const { return this->key_comp(); }
+};
+
+template<typename T, typename Compare, typename A>
+void swap(btree_set<T, Compare, A>& x, btree_set<T, Compare, A>& y)
+    noexcept {
+  x.swap(y);
+}
+
+
+_namespace_end(ilias)
+
+#endif /* _ILIAS_BTREE_SET_H_ */
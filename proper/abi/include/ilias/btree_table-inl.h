@@ -0,0 +1,1163 @@
+#ifndef _ILIAS_BTREE_TABLE_INL_H_
+#define _ILIAS_BTREE_TABLE_INL_H_
+
+#include <ilias/btree_table.h>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <new>
+
+_namespace_begin(ilias)
+namespace impl {
+
+
+template<typename Value>
+constexpr size_t btree_node<Value>::max_slots;
+template<typename Value>
+constexpr size_t btree_node<Value>::min_slots;
+
+template<typename Value>
+inline auto btree_node<Value>::value(size_t i) noexcept -> Value* {
+  assert(i <= max_slots);  // One past the end, for ranges.
+  return reinterpret_cast<Value*>(&slots[i]);
+}
+
+template<typename Value>
+inline auto btree_node<Value>::value(size_t i) const noexcept ->
+    const Value* {
+  assert(i <= max_slots);  // One past the end, for ranges.
+  return reinterpret_cast<const Value*>(&slots[i]);
+}
+
+template<typename Value>
+inline auto btree_node<Value>::child(size_t i) noexcept -> btree_node*& {
+  assert(!leaf && i <= max_slots);
+  return static_cast<btree_internal_node<Value>*>(this)->children[i];
+}
+
+template<typename Value>
+inline auto btree_node<Value>::child(size_t i) const noexcept ->
+    btree_node* {
+  assert(!leaf && i <= max_slots);
+  return static_cast<const btree_internal_node<Value>*>(this)->children[i];
+}
+
+
+template<typename Node, typename T>
+template<typename U, typename>
+btree_iterator<Node, T>::btree_iterator(const btree_iterator<Node, U>& o)
+    noexcept
+: node_(o.node_),
+  pos_(o.pos_)
+{}
+
+template<typename Node, typename T>
+btree_iterator<Node, T>::btree_iterator(Node* n, size_t pos) noexcept
+: node_(n),
+  pos_(pos)
+{}
+
+/*
+ * Called when the position is past the last value of a leaf,
+ * or on an internal node.
+ */
+template<typename Node, typename T>
+auto btree_iterator<Node, T>::increment_slow_() noexcept -> void {
+  if (node_->leaf) {
+    /* Climb to the first ancestor that has a value to our right. */
+    const btree_iterator save = *this;
+    while (pos_ == node_->count && node_->parent != nullptr) {
+      pos_ = node_->position;
+      node_ = node_->parent;
+    }
+    if (pos_ == node_->count) *this = save;  // Now at end().
+  } else {
+    node_ = node_->child(pos_ + 1U);
+    while (!node_->leaf) node_ = node_->child(0);
+    pos_ = 0;
+  }
+}
+
+/*
+ * Called when the position is at the first value of a leaf,
+ * or on an internal node.
+ */
+template<typename Node, typename T>
+auto btree_iterator<Node, T>::decrement_slow_() noexcept -> void {
+  if (node_->leaf) {
+    /* Climb to the first ancestor that has a value to our left. */
+    const btree_iterator save = *this;
+    while (pos_ == 0 && node_->parent != nullptr) {
+      pos_ = node_->position;
+      node_ = node_->parent;
+    }
+    if (pos_ == 0)
+      *this = save;  // Decrementing begin() is undefined.
+    else
+      --pos_;
+  } else {
+    node_ = node_->child(pos_);
+    while (!node_->leaf) node_ = node_->child(node_->count);
+    pos_ = node_->count - 1U;
+  }
+}
+
+template<typename Node, typename T>
+auto btree_iterator<Node, T>::operator*() const noexcept -> T& {
+  assert(node_ != nullptr && pos_ < node_->count);
+  return *node_->value(pos_);
+}
+
+template<typename Node, typename T>
+auto btree_iterator<Node, T>::operator->() const noexcept -> T* {
+  return &**this;
+}
+
+template<typename Node, typename T>
+auto btree_iterator<Node, T>::operator++() noexcept -> btree_iterator& {
+  if (!node_->leaf || ++pos_ == node_->count) increment_slow_();
+  return *this;
+}
+
+template<typename Node, typename T>
+auto btree_iterator<Node, T>::operator++(int) noexcept -> btree_iterator {
+  btree_iterator copy = *this;
+  ++*this;
+  return copy;
+}
+
+template<typename Node, typename T>
+auto btree_iterator<Node, T>::operator--() noexcept -> btree_iterator& {
+  if (node_->leaf && pos_ > 0)
+    --pos_;
+  else
+    decrement_slow_();
+  return *this;
+}
+
+template<typename Node, typename T>
+auto btree_iterator<Node, T>::operator--(int) noexcept -> btree_iterator {
+  btree_iterator copy = *this;
+  --*this;
+  return copy;
+}
+
+template<typename Node, typename T>
+template<typename U>
+auto btree_iterator<Node, T>::operator==(const btree_iterator<Node, U>& o)
+    const noexcept -> bool {
+  return node_ == o.node_ && pos_ == o.pos_;
+}
+
+template<typename Node, typename T>
+template<typename U>
+auto btree_iterator<Node, T>::operator!=(const btree_iterator<Node, U>& o)
+    const noexcept -> bool {
+  return !(*this == o);
+}
+
+
+template<typename K, typename V, typename KO, typename C, typename A>
+btree_table<K, V, KO, C, A>::btree_table(const key_compare& cmp,
+                                         const allocator_type& alloc)
+: params_(cmp, alloc)
+{}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+btree_table<K, V, KO, C, A>::btree_table(const allocator_type& alloc)
+: btree_table(key_compare(), alloc)
+{}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename InputIter>
+btree_table<K, V, KO, C, A>::btree_table(InputIter b, InputIter e,
+                                         const key_compare& cmp,
+                                         const allocator_type& alloc)
+: btree_table(cmp, alloc)
+{
+  insert(b, e);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+btree_table<K, V, KO, C, A>::btree_table(
+    _namespace(std)::initializer_list<value_type> il,
+    const key_compare& cmp, const allocator_type& alloc)
+: btree_table(cmp, alloc)
+{
+  insert(il);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+btree_table<K, V, KO, C, A>::btree_table(const btree_table& o)
+: params_(o.params_)
+{
+  /* Values arrive in order, so each is appended to the rightmost leaf. */
+  for (const value_type& v : o) construct_at_(end(), v);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+btree_table<K, V, KO, C, A>::btree_table(btree_table&& o) noexcept
+: root_(_namespace(std)::exchange(o.root_, nullptr)),
+  leftmost_(_namespace(std)::exchange(o.leftmost_, nullptr)),
+  rightmost_(_namespace(std)::exchange(o.rightmost_, nullptr)),
+  size_(_namespace(std)::exchange(o.size_, 0)),
+  params_(_namespace(std)::move(o.params_))
+{}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+btree_table<K, V, KO, C, A>::~btree_table() noexcept {
+  clear();
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::operator=(const btree_table& o) ->
+    btree_table& {
+  if (&o != this) {
+    btree_table copy = o;
+    swap(copy);
+  }
+  return *this;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::operator=(btree_table&& o) noexcept ->
+    btree_table& {
+  btree_table tmp = _namespace(std)::move(o);
+  swap(tmp);
+  return *this;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::operator=(
+    _namespace(std)::initializer_list<value_type> il) -> btree_table& {
+  clear();
+  insert(il);
+  return *this;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::begin() noexcept -> iterator {
+  return iterator(leftmost_, 0);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::begin() const noexcept -> const_iterator {
+  return const_iterator(leftmost_, 0);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::cbegin() const noexcept -> const_iterator {
+  return begin();
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::end() noexcept -> iterator {
+  return iterator(rightmost_, (rightmost_ == nullptr ? 0 : rightmost_->count));
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::end() const noexcept -> const_iterator {
+  return const_iterator(rightmost_,
+                        (rightmost_ == nullptr ? 0 : rightmost_->count));
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::cend() const noexcept -> const_iterator {
+  return end();
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::rbegin() noexcept -> reverse_iterator {
+  return reverse_iterator(end());
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::rbegin() const noexcept ->
+    const_reverse_iterator {
+  return const_reverse_iterator(end());
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::crbegin() const noexcept ->
+    const_reverse_iterator {
+  return rbegin();
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::rend() noexcept -> reverse_iterator {
+  return reverse_iterator(begin());
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::rend() const noexcept ->
+    const_reverse_iterator {
+  return const_reverse_iterator(begin());
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::crend() const noexcept ->
+    const_reverse_iterator {
+  return rend();
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::empty() const noexcept -> bool {
+  return size_ == 0;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::size() const noexcept -> size_type {
+  return size_;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::max_size() const noexcept -> size_type {
+  return _namespace(std)::numeric_limits<size_type>::max() /
+         sizeof(value_type);
+}
+
+/* Number of levels in the tree; 0 if the tree is empty. */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::height() const noexcept -> size_type {
+  size_type h = 0;
+  for (const node* n = leftmost_; n != nullptr; n = n->parent) ++h;
+  return h;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::clear() noexcept -> void {
+  if (root_ != nullptr) destroy_(root_);
+  root_ = leftmost_ = rightmost_ = nullptr;
+  size_ = 0;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::insert(const value_type& v) ->
+    _namespace(std)::pair<iterator, bool> {
+  const auto pos = find_insert_position_(KO()(v));
+  if (pos.second) return { pos.first, false };
+  return { construct_at_(pos.first, v), true };
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::insert(value_type&& v) ->
+    _namespace(std)::pair<iterator, bool> {
+  const auto pos = find_insert_position_(KO()(v));
+  if (pos.second) return { pos.first, false };
+  return { construct_at_(pos.first, _namespace(std)::move(v)), true };
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::insert(const_iterator hint,
+                                         const value_type& v) -> iterator {
+  if (hint_fits_(hint, KO()(v))) return construct_at_(mutable_(hint), v);
+  return insert(v).first;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::insert(const_iterator hint,
+                                         value_type&& v) -> iterator {
+  if (hint_fits_(hint, KO()(v)))
+    return construct_at_(mutable_(hint), _namespace(std)::move(v));
+  return insert(_namespace(std)::move(v)).first;
+}
+
+/*
+ * Each value is inserted with end() as hint.  If the input is sorted,
+ * every value is appended to the rightmost leaf without a search,
+ * and leaves are split so they end up full: a bulk load in linear time.
+ */
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename InputIter>
+auto btree_table<K, V, KO, C, A>::insert(InputIter b, InputIter e) -> void {
+  while (b != e) {
+    emplace_hint(cend(), *b);
+    ++b;
+  }
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::insert(
+    _namespace(std)::initializer_list<value_type> il) -> void {
+  insert(il.begin(), il.end());
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename... Args>
+auto btree_table<K, V, KO, C, A>::emplace(Args&&... args) ->
+    _namespace(std)::pair<iterator, bool> {
+  /*
+   * The key is only known once the value is constructed,
+   * so construct it on the stack and transfer it in place.
+   */
+  struct tmp_destroy {
+    ~tmp_destroy() noexcept {
+      if (p != nullptr) slot_alloc_traits::destroy(alloc, p);
+    }
+
+    slot_alloc& alloc;
+    value_type* p;
+  };
+
+  slot_alloc alloc = _namespace(std)::get<1>(params_);
+  _namespace(std)::aligned_storage_t<sizeof(value_type),
+                                     alignof(value_type)> tmp;
+  value_type* p = reinterpret_cast<value_type*>(&tmp);
+  slot_alloc_traits::construct(alloc, p,
+                               _namespace(std)::forward<Args>(args)...);
+  tmp_destroy guard{ alloc, p };
+
+  const auto pos = find_insert_position_(KO()(*p));
+  if (pos.second) return { pos.first, false };
+  guard.p = nullptr;
+  return { transfer_in_(pos.first, p), true };
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename... Args>
+auto btree_table<K, V, KO, C, A>::emplace_hint(const_iterator hint,
+                                               Args&&... args) ->
+    iterator {
+  struct tmp_destroy {
+    ~tmp_destroy() noexcept {
+      if (p != nullptr) slot_alloc_traits::destroy(alloc, p);
+    }
+
+    slot_alloc& alloc;
+    value_type* p;
+  };
+
+  slot_alloc alloc = _namespace(std)::get<1>(params_);
+  _namespace(std)::aligned_storage_t<sizeof(value_type),
+                                     alignof(value_type)> tmp;
+  value_type* p = reinterpret_cast<value_type*>(&tmp);
+  slot_alloc_traits::construct(alloc, p,
+                               _namespace(std)::forward<Args>(args)...);
+  tmp_destroy guard{ alloc, p };
+
+  iterator pos = mutable_(hint);
+  if (!hint_fits_(hint, KO()(*p))) {
+    const auto found = find_insert_position_(KO()(*p));
+    if (found.second) return found.first;
+    pos = found.first;
+  }
+  guard.p = nullptr;
+  return transfer_in_(pos, p);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::erase(const_iterator pos) noexcept ->
+    iterator {
+  slot_alloc alloc = _namespace(std)::get<1>(params_);
+  node* n = pos.node_;
+  const size_t i = pos.pos_;
+  iterator rv;
+
+  assert(n != nullptr && i < n->count);
+  slot_alloc_traits::destroy(alloc, n->value(i));
+  const bool internal = !n->leaf;
+  if (internal) {
+    /*
+     * Replace the value with its predecessor, the last value in the
+     * rightmost leaf of the left subtree, and erase that one instead.
+     */
+    node* l = n->child(i);
+    while (!l->leaf) l = l->child(l->count);
+    transfer_(n->value(i), l->value(l->count - 1U));
+    --l->count;
+    rv = iterator(l, l->count);
+  } else {
+    transfer_n_(n->value(i), n->value(i + 1U), n->count - i - 1U);
+    --n->count;
+    rv = iterator(n, i);
+  }
+  --size_;
+
+  /*
+   * rv is the position of the value following the removed slot,
+   * which is tracked through rebalancing.  For an internal node,
+   * that value is the predecessor, which took the place of the
+   * erased value.
+   */
+  rebalance_after_erase_(rv);
+  rv = mutable_(normalize_(rv));
+  if (internal) ++rv;
+  return rv;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Iter, typename>
+auto btree_table<K, V, KO, C, A>::erase(Iter i) noexcept -> iterator {
+  return erase(const_iterator(i));
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::erase(const_iterator b, const_iterator e)
+    noexcept -> iterator {
+  if (b == cbegin() && e == cend()) {
+    clear();
+    return end();
+  }
+
+  /* Erase invalidates e, so count the values instead. */
+  iterator i = mutable_(b);
+  for (auto n = _namespace(std)::distance(b, e); n > 0; --n) i = erase(i);
+  return i;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key, typename>
+auto btree_table<K, V, KO, C, A>::erase(const Key& k) -> size_type {
+  const const_iterator i = find_(k);
+  if (i == end()) return 0;
+  erase(i);
+  return 1;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::find(const Key& k) -> iterator {
+  return mutable_(find_(k));
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::find(const Key& k) const ->
+    const_iterator {
+  return find_(k);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::count(const Key& k) const -> size_type {
+  return (find_(k) == end() ? 0U : 1U);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::lower_bound(const Key& k) -> iterator {
+  return mutable_(lower_bound_(k));
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::lower_bound(const Key& k) const ->
+    const_iterator {
+  return lower_bound_(k);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::upper_bound(const Key& k) -> iterator {
+  return mutable_(upper_bound_(k));
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::upper_bound(const Key& k) const ->
+    const_iterator {
+  return upper_bound_(k);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::equal_range(const Key& k) ->
+    _namespace(std)::pair<iterator, iterator> {
+  return { lower_bound(k), upper_bound(k) };
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::equal_range(const Key& k) const ->
+    _namespace(std)::pair<const_iterator, const_iterator> {
+  return { lower_bound(k), upper_bound(k) };
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::swap(btree_table& o) noexcept -> void {
+  using _namespace(std)::swap;
+
+  swap(root_, o.root_);
+  swap(leftmost_, o.leftmost_);
+  swap(rightmost_, o.rightmost_);
+  swap(size_, o.size_);
+  swap(params_, o.params_);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::key_comp() const -> key_compare {
+  return _namespace(std)::get<0>(params_);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::get_allocator() const -> allocator_type {
+  return _namespace(std)::get<1>(params_);
+}
+
+/*
+ * Find the value with key k, or the leaf position at which to insert it.
+ * Returns the position and whether the key was found.
+ * If the key was not found, the position may only be passed to
+ * construct_at_(), before any other modification of the tree.
+ */
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::find_insert_position_(const Key& k) ->
+    _namespace(std)::pair<iterator, bool> {
+  node* n = root_;
+  if (n == nullptr) return { end(), false };
+
+  for (;;) {
+    const size_t i = lower_in_node_(n, k);
+    if (i < n->count && !less_(k, KO()(*n->value(i))))
+      return { iterator(n, i), true };
+    if (n->leaf) return { iterator(n, i), false };
+    n = n->child(i);
+  }
+}
+
+/*
+ * Construct a value in front of pos.
+ * The caller ensures the key orders between those of the neighbouring
+ * values.  If construction throws, the tree contents are unchanged.
+ */
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename... Args>
+auto btree_table<K, V, KO, C, A>::construct_at_(iterator pos,
+                                                Args&&... args) -> iterator {
+  slot_alloc alloc = _namespace(std)::get<1>(params_);
+  const iterator rv = make_room_(insert_position_(pos));
+  try {
+    slot_alloc_traits::construct(alloc, rv.node_->value(rv.pos_),
+                                 _namespace(std)::forward<Args>(args)...);
+  } catch (...) {
+    close_room_(rv);
+    throw;
+  }
+  ++size_;
+  return rv;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename X, typename Y>
+auto btree_table<K, V, KO, C, A>::less_(const X& x, const Y& y) const ->
+    bool {
+  return _namespace(std)::get<0>(params_)(x, y);
+}
+
+/* Index of the first value in n with a key that is not less than k. */
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::lower_in_node_(const node* n,
+                                                 const Key& k) const ->
+    size_t {
+  size_t lo = 0, hi = n->count;
+  while (lo < hi) {
+    const size_t mid = (lo + hi) / 2U;
+    if (less_(KO()(*n->value(mid)), k))
+      lo = mid + 1U;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Index of the first value in n with a key that is greater than k. */
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::upper_in_node_(const node* n,
+                                                 const Key& k) const ->
+    size_t {
+  size_t lo = 0, hi = n->count;
+  while (lo < hi) {
+    const size_t mid = (lo + hi) / 2U;
+    if (less_(k, KO()(*n->value(mid))))
+      hi = mid;
+    else
+      lo = mid + 1U;
+  }
+  return lo;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::find_(const Key& k) const ->
+    const_iterator {
+  node* n = root_;
+  while (n != nullptr) {
+    const size_t i = lower_in_node_(n, k);
+    if (i < n->count && !less_(k, KO()(*n->value(i))))
+      return const_iterator(n, i);
+    n = (n->leaf ? nullptr : n->child(i));
+  }
+  return end();
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::lower_bound_(const Key& k) const ->
+    const_iterator {
+  node* n = root_;
+  if (n == nullptr) return end();
+
+  for (;;) {
+    const size_t i = lower_in_node_(n, k);
+    if (n->leaf) return normalize_(const_iterator(n, i));
+    n = n->child(i);
+  }
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::upper_bound_(const Key& k) const ->
+    const_iterator {
+  node* n = root_;
+  if (n == nullptr) return end();
+
+  for (;;) {
+    const size_t i = upper_in_node_(n, k);
+    if (n->leaf) return normalize_(const_iterator(n, i));
+    n = n->child(i);
+  }
+}
+
+/*
+ * A position past the last value of a node refers to the separator
+ * following that node in its ancestors; or end(), if there is none.
+ */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::normalize_(const_iterator i)
+    const noexcept -> const_iterator {
+  node* n = i.node_;
+  size_t pos = i.pos_;
+  if (n == nullptr) return end();
+
+  while (pos == n->count) {
+    if (n->parent == nullptr) return end();
+    pos = n->position;
+    n = n->parent;
+  }
+  return const_iterator(n, pos);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::mutable_(const_iterator i) noexcept ->
+    iterator {
+  return iterator(i.node_, i.pos_);
+}
+
+/* Move the value at src to dst, which is uninitialized. */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::transfer_(value_type* dst,
+                                            value_type* src) noexcept ->
+    void {
+  slot_alloc alloc = _namespace(std)::get<1>(params_);
+  KO::transfer(alloc, dst, src);
+}
+
+/* Transfer n values, front to back.  Use when dst precedes src. */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::transfer_n_(value_type* dst,
+                                              value_type* src,
+                                              size_t n) noexcept -> void {
+  for (size_t i = 0; i < n; ++i) transfer_(dst + i, src + i);
+}
+
+/* Transfer n values, back to front.  Use when dst follows src. */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::transfer_n_backward_(value_type* dst,
+                                                       value_type* src,
+                                                       size_t n)
+    noexcept -> void {
+  while (n-- > 0) transfer_(dst + n, src + n);
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::set_child_(node* p, size_t i, node* c)
+    noexcept -> void {
+  p->child(i) = c;
+  c->parent = p;
+  c->position = uint8_t(i);
+}
+
+/* Move n children from src, starting at spos, to dst at dpos. */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::move_children_(node* dst, size_t dpos,
+                                                 node* src, size_t spos,
+                                                 size_t n) noexcept -> void {
+  assert(dst != src);
+  for (size_t i = 0; i < n; ++i) set_child_(dst, dpos + i, src->child(spos + i));
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::new_node_(bool leaf) -> node* {
+  node* n;
+  if (leaf) {
+    leaf_alloc alloc = _namespace(std)::get<1>(params_);
+    n = ::new (static_cast<void*>(leaf_alloc_traits::allocate(alloc, 1)))
+        node;
+  } else {
+    internal_alloc alloc = _namespace(std)::get<1>(params_);
+    n = ::new (static_cast<void*>(internal_alloc_traits::allocate(alloc, 1)))
+        internal_node;
+  }
+
+  n->parent = nullptr;
+  n->position = 0;
+  n->count = 0;
+  n->leaf = leaf;
+  return n;
+}
+
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::delete_node_(node* n) noexcept -> void {
+  if (n->leaf) {
+    leaf_alloc alloc = _namespace(std)::get<1>(params_);
+    leaf_alloc_traits::deallocate(alloc, n, 1);
+  } else {
+    internal_alloc alloc = _namespace(std)::get<1>(params_);
+    internal_alloc_traits::deallocate(alloc,
+                                      static_cast<internal_node*>(n), 1);
+  }
+}
+
+/* Destroy all values in the subtree at n and free its nodes. */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::destroy_(node* n) noexcept -> void {
+  slot_alloc alloc = _namespace(std)::get<1>(params_);
+
+  if (!n->leaf) {
+    for (size_t i = 0; i <= n->count; ++i) destroy_(n->child(i));
+  }
+  for (size_t i = 0; i < n->count; ++i)
+    slot_alloc_traits::destroy(alloc, n->value(i));
+  delete_node_(n);
+}
+
+/* Test if a value with key k may be inserted in front of hint. */
+template<typename K, typename V, typename KO, typename C, typename A>
+template<typename Key>
+auto btree_table<K, V, KO, C, A>::hint_fits_(const_iterator hint,
+                                             const Key& k) const -> bool {
+  if (hint != end() && !less_(k, KO()(*hint))) return false;
+  return hint == begin() || less_(KO()(*_namespace(std)::prev(hint)), k);
+}
+
+/*
+ * Insertion always happens in a leaf.  In front of a value in an
+ * internal node is the position past its predecessor.
+ */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::insert_position_(const_iterator pos)
+    noexcept -> iterator {
+  node* n = pos.node_;
+  size_t i = pos.pos_;
+
+  if (n != nullptr && !n->leaf) {
+    n = n->child(i);
+    while (!n->leaf) n = n->child(n->count);
+    i = n->count;
+  }
+  return iterator(n, i);
+}
+
+/*
+ * Open an uninitialized slot at leaf position pos.
+ * Returns the position of the slot, which differs from pos
+ * if the leaf was split.
+ */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::make_room_(iterator pos) -> iterator {
+  node* n = pos.node_;
+  size_t i = pos.pos_;
+
+  if (n == nullptr) {
+    n = root_ = leftmost_ = rightmost_ = new_node_(true);
+    i = 0;
+  } else if (n->count == node::max_slots) {
+    split_(n, i);
+  }
+
+  assert(n->leaf && i <= n->count);
+  transfer_n_backward_(n->value(i + 1U), n->value(i), n->count - i);
+  ++n->count;
+  return iterator(n, i);
+}
+
+/* Undo make_room_(). */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::close_room_(iterator pos) noexcept ->
+    void {
+  node* n = pos.node_;
+  const size_t i = pos.pos_;
+
+  transfer_n_(n->value(i), n->value(i + 1U), n->count - i - 1U);
+  --n->count;
+  if (n->count == 0 && n == root_) {
+    delete_node_(n);
+    root_ = leftmost_ = rightmost_ = nullptr;
+  }
+}
+
+/*
+ * Split the full node n, moving its upper values to a new right sibling
+ * and the median to the parent.  Full ancestors are split first.
+ * On return, n and i are updated to the node and index where a value
+ * that was to be inserted at index i now goes.
+ *
+ * Inserting at either end of a node moves all but one value to one
+ * side, so sorted insertion (in either direction) leaves full nodes
+ * behind instead of half full ones.
+ */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::split_(node*& n, size_t& i) -> void {
+  assert(n->count == node::max_slots);
+
+  if (n->parent != nullptr && n->parent->count == node::max_slots) {
+    node* p = n->parent;
+    size_t ppos = n->position;
+    split_(p, ppos);
+  }
+
+  node* s = new_node_(n->leaf);
+  if (n->parent == nullptr) {
+    node* r;
+    try {
+      r = new_node_(false);
+    } catch (...) {
+      delete_node_(s);
+      throw;
+    }
+    set_child_(r, 0, n);
+    root_ = r;
+  }
+
+  node* p = n->parent;
+  const size_t ppos = n->position;
+  const size_t count = n->count;
+  const size_t nmove = (i == count ? 0U :
+                        i == 0 ? count - 1U :
+                        count / 2U);
+  const size_t median = count - nmove - 1U;
+
+  /* Upper values go to the sibling. */
+  transfer_n_(s->value(0), n->value(median + 1U), nmove);
+  s->count = uint8_t(nmove);
+  if (!n->leaf) move_children_(s, 0, n, median + 1U, nmove + 1U);
+
+  /* The median goes to the parent, with the sibling to its right. */
+  transfer_n_backward_(p->value(ppos + 1U), p->value(ppos), p->count - ppos);
+  for (size_t j = p->count; j > ppos; --j) set_child_(p, j + 1U, p->child(j));
+  transfer_(p->value(ppos), n->value(median));
+  set_child_(p, ppos + 1U, s);
+  ++p->count;
+  n->count = uint8_t(median);
+
+  if (n == rightmost_) rightmost_ = s;
+  if (i > median) {
+    i -= median + 1U;
+    n = s;
+  }
+}
+
+/* Insert the value at src in front of pos, destroying src. */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::transfer_in_(iterator pos,
+                                               value_type* src) -> iterator {
+  /* If allocation fails, src is still destroyed. */
+  struct src_destroy {
+    ~src_destroy() noexcept {
+      if (p != nullptr) slot_alloc_traits::destroy(alloc, p);
+    }
+
+    slot_alloc alloc;
+    value_type* p;
+  };
+
+  src_destroy guard{ _namespace(std)::get<1>(params_), src };
+  const iterator rv = make_room_(insert_position_(pos));
+  guard.p = nullptr;
+  transfer_(rv.node_->value(rv.pos_), src);
+  ++size_;
+  return rv;
+}
+
+/*
+ * Merge r, and the separator between l and r, into l.
+ * r is freed.
+ */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::merge_(node* l, node* r) noexcept ->
+    void {
+  node* p = l->parent;
+  const size_t pos = l->position;
+  const size_t lc = l->count;
+
+  assert(r->parent == p && r->position == pos + 1U);
+  assert(lc + 1U + r->count <= node::max_slots);
+
+  transfer_(l->value(lc), p->value(pos));
+  transfer_n_(l->value(lc + 1U), r->value(0), r->count);
+  if (!l->leaf) move_children_(l, lc + 1U, r, 0, r->count + 1U);
+  l->count = uint8_t(lc + 1U + r->count);
+
+  transfer_n_(p->value(pos), p->value(pos + 1U), p->count - pos - 1U);
+  for (size_t j = pos + 1U; j < p->count; ++j)
+    set_child_(p, j, p->child(j + 1U));
+  --p->count;
+
+  if (r == rightmost_) rightmost_ = l;
+  delete_node_(r);
+}
+
+/* Move k values from r to its left sibling l, through the separator. */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::rotate_left_(node* l, node* r, size_t k)
+    noexcept -> void {
+  node* p = l->parent;
+  const size_t pos = l->position;
+  const size_t lc = l->count;
+
+  assert(k > 0 && k < r->count && lc + k <= node::max_slots);
+
+  transfer_(l->value(lc), p->value(pos));
+  transfer_n_(l->value(lc + 1U), r->value(0), k - 1U);
+  transfer_(p->value(pos), r->value(k - 1U));
+  transfer_n_(r->value(0), r->value(k), r->count - k);
+  if (!l->leaf) {
+    move_children_(l, lc + 1U, r, 0, k);
+    for (size_t j = 0; j + k <= r->count; ++j)
+      set_child_(r, j, r->child(j + k));
+  }
+  l->count = uint8_t(lc + k);
+  r->count = uint8_t(r->count - k);
+}
+
+/* Move k values from l to its right sibling r, through the separator. */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::rotate_right_(node* l, node* r, size_t k)
+    noexcept -> void {
+  node* p = l->parent;
+  const size_t pos = l->position;
+  const size_t lc = l->count;
+  const size_t rc = r->count;
+
+  assert(k > 0 && k < lc && rc + k <= node::max_slots);
+
+  transfer_n_backward_(r->value(k), r->value(0), rc);
+  transfer_(r->value(k - 1U), p->value(pos));
+  transfer_n_(r->value(0), l->value(lc - k + 1U), k - 1U);
+  transfer_(p->value(pos), l->value(lc - k));
+  if (!l->leaf) {
+    for (size_t j = rc + 1U; j-- > 0; ) set_child_(r, j + k, r->child(j));
+    move_children_(r, 0, l, lc - k + 1U, k);
+  }
+  l->count = uint8_t(lc - k);
+  r->count = uint8_t(rc + k);
+}
+
+/*
+ * Restore the minimum fill of the leaf at pos, after a value was removed
+ * from it, merging or rotating nodes up towards the root.
+ *
+ * pos is updated to keep referring to the same place in the sequence.
+ * Only the leaf's values move between nodes when pos is involved:
+ * a merge or rotation higher up only moves internal values and
+ * whole subtrees.
+ */
+template<typename K, typename V, typename KO, typename C, typename A>
+auto btree_table<K, V, KO, C, A>::rebalance_after_erase_(iterator& pos)
+    noexcept -> void {
+  node* n = pos.node_;
+
+  for (;;) {
+    if (n == root_) {
+      if (n->count == 0) {
+        if (n->leaf) {
+          delete_node_(n);
+          root_ = leftmost_ = rightmost_ = nullptr;
+          pos = end();
+        } else {
+          root_ = n->child(0);
+          root_->parent = nullptr;
+          root_->position = 0;
+          delete_node_(n);
+        }
+      }
+      return;
+    }
+    if (n->count >= node::min_slots) return;
+
+    node* p = n->parent;
+    const size_t i = n->position;
+    node* l = (i > 0 ? p->child(i - 1U) : nullptr);
+    node* r = (i < p->count ? p->child(i + 1U) : nullptr);
+
+    if (l != nullptr && l->count + 1U + n->count <= node::max_slots) {
+      if (pos.node_ == n) pos = iterator(l, l->count + 1U + pos.pos_);
+      merge_(l, n);
+    } else if (r != nullptr && n->count + 1U + r->count <= node::max_slots) {
+      merge_(n, r);
+    } else if (r != nullptr) {
+      rotate_left_(n, r, (r->count - n->count) / 2U);
+      return;
+    } else {
+      const size_t k = (l->count - n->count) / 2U;
+      rotate_right_(l, n, k);
+      if (pos.node_ == n) pos.pos_ += k;
+      return;
+    }
+    n = p;
+  }
+}
+
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator==(const btree_table<Key, Value, KeyOf, Compare, Alloc>& x,
+                const btree_table<Key, Value, KeyOf, Compare, Alloc>& y) {
+  return x.size() == y.size() &&
+         _namespace(std)::equal(x.begin(), x.end(), y.begin());
+}
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator!=(const btree_table<Key, Value, KeyOf, Compare, Alloc>& x,
+                const btree_table<Key, Value, KeyOf, Compare, Alloc>& y) {
+  return !(x == y);
+}
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator<(const btree_table<Key, Value, KeyOf, Compare, Alloc>& x,
+               const btree_table<Key, Value, KeyOf, Compare, Alloc>& y) {
+  return _namespace(std)::lexicographical_compare(x.begin(), x.end(),
+                                                  y.begin(), y.end());
+}
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator>(const btree_table<Key, Value, KeyOf, Compare, Alloc>& x,
+               const btree_table<Key, Value, KeyOf, Compare, Alloc>& y) {
+  return y < x;
+}
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator<=(const btree_table<Key, Value, KeyOf, Compare, Alloc>& x,
+                const btree_table<Key, Value, KeyOf, Compare, Alloc>& y) {
+  return !(y < x);
+}
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator>=(const btree_table<Key, Value, KeyOf, Compare, Alloc>& x,
+                const btree_table<Key, Value, KeyOf, Compare, Alloc>& y) {
+  return !(x < y);
+}
+
+
+} /* namespace ilias::impl */
+_namespace_end(ilias)
+
+#endif /* _ILIAS_BTREE_TABLE_INL_H_ */
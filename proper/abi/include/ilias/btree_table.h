@@ -0,0 +1,326 @@
+#ifndef _ILIAS_BTREE_TABLE_H_
+#define _ILIAS_BTREE_TABLE_H_
+
+#include <cdecl.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+_namespace_begin(ilias)
+namespace impl {
+
+/*
+ * B-tree node.
+ *
+ * Each node holds up to max_slots values, in order.  Internal nodes
+ * additionally hold count + 1 children; all values in children[i] order
+ * between values i - 1 and i of the node.  Leaf nodes have no children
+ * array, which makes them smaller than internal nodes.
+ *
+ * max_slots is chosen so a leaf node is about target_size bytes:
+ * a few cache lines, searched with a binary search.
+ */
+template<typename Value>
+struct btree_node {
+  static constexpr size_t target_size = 256;
+  static constexpr size_t header_size = sizeof(void*) + 4U;
+  static constexpr size_t max_slots =
+      ((target_size - header_size) / sizeof(Value) < 3U ?
+       3U :
+       ((target_size - header_size) / sizeof(Value) > 255U ?
+        255U :
+        (target_size - header_size) / sizeof(Value)));
+  /* Nodes other than the root hold at least min_slots values. */
+  static constexpr size_t min_slots = max_slots / 2U;
+
+  btree_node* parent;
+  uint8_t position;  // Index in parent->children.
+  uint8_t count;
+  bool leaf;
+  _namespace(std)::aligned_storage_t<sizeof(Value), alignof(Value)>
+      slots[max_slots];
+
+  Value* value(size_t) noexcept;
+  const Value* value(size_t) const noexcept;
+  btree_node*& child(size_t) noexcept;
+  btree_node* child(size_t) const noexcept;
+};
+
+template<typename Value>
+struct btree_internal_node
+: btree_node<Value>
+{
+  btree_node<Value>* children[btree_node<Value>::max_slots + 1U];
+};
+
+
+template<typename, typename, typename, typename, typename>
+class btree_table;
+
+/*
+ * Iterator, a node and a position in the node.
+ *
+ * The end iterator is the position past the last value in the
+ * rightmost leaf.
+ */
+template<typename Node, typename T>
+class btree_iterator
+: public _namespace(std)::iterator<_namespace(std)::bidirectional_iterator_tag,
+                                   _namespace(std)::remove_const_t<T>>
+{
+  template<typename, typename, typename, typename, typename>
+      friend class btree_table;
+  template<typename, typename> friend class btree_iterator;
+
+ public:
+  using reference = T&;
+  using pointer = T*;
+
+  btree_iterator() noexcept = default;
+  btree_iterator(const btree_iterator&) noexcept = default;
+  btree_iterator& operator=(const btree_iterator&) noexcept = default;
+  template<typename U, typename =
+      _namespace(std)::enable_if_t<
+          _namespace(std)::is_same<const U, T>::value>>
+  btree_iterator(const btree_iterator<Node, U>&) noexcept;
+
+ private:
+  btree_iterator(Node*, size_t) noexcept;
+
+  void increment_slow_() noexcept;
+  void decrement_slow_() noexcept;
+
+ public:
+  T& operator*() const noexcept;
+  T* operator->() const noexcept;
+
+  btree_iterator& operator++() noexcept;
+  btree_iterator operator++(int) noexcept;
+  btree_iterator& operator--() noexcept;
+  btree_iterator operator--(int) noexcept;
+
+  template<typename U> bool operator==(const btree_iterator<Node, U>&)
+      const noexcept;
+  template<typename U> bool operator!=(const btree_iterator<Node, U>&)
+      const noexcept;
+
+ private:
+  Node* node_ = nullptr;
+  size_t pos_ = 0;
+};
+
+
+/*
+ * Type shared by btree_map and btree_set.
+ *
+ * KeyOf extracts the key from a value, and transfers values between
+ * slots when nodes are split, merged or rebalanced.
+ * If Key and Value are the same type, iterators are constant.
+ *
+ * Unlike the node based ordered containers, values are stored inline
+ * in their node, so inserting or erasing invalidates all iterators and
+ * references.
+ */
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+class btree_table {
+ private:
+  using node = btree_node<Value>;
+  using internal_node = btree_internal_node<Value>;
+  using alloc_traits = _namespace(std)::allocator_traits<Alloc>;
+  using slot_alloc = typename alloc_traits::template rebind_alloc<Value>;
+  using slot_alloc_traits = _namespace(std)::allocator_traits<slot_alloc>;
+  using leaf_alloc = typename alloc_traits::template rebind_alloc<node>;
+  using leaf_alloc_traits = _namespace(std)::allocator_traits<leaf_alloc>;
+  using internal_alloc =
+      typename alloc_traits::template rebind_alloc<internal_node>;
+  using internal_alloc_traits =
+      _namespace(std)::allocator_traits<internal_alloc>;
+
+  static_assert(_namespace(std)::is_pointer<
+                    typename leaf_alloc_traits::pointer>::value &&
+                _namespace(std)::is_pointer<
+                    typename internal_alloc_traits::pointer>::value,
+                "btree_table requires an allocator with plain pointers");
+
+ public:
+  using key_type = Key;
+  using value_type = Value;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using key_compare = Compare;
+  using allocator_type = Alloc;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+
+  using iterator = btree_iterator<
+      node,
+      _namespace(std)::conditional_t<
+          _namespace(std)::is_same<Key, Value>::value,
+          const value_type, value_type>>;
+  using const_iterator = btree_iterator<node, const value_type>;
+  using reverse_iterator = _namespace(std)::reverse_iterator<iterator>;
+  using const_reverse_iterator =
+      _namespace(std)::reverse_iterator<const_iterator>;
+
+  explicit btree_table(const key_compare& = key_compare(),
+                       const allocator_type& = allocator_type());
+  explicit btree_table(const allocator_type&);
+  template<typename InputIter>
+  btree_table(InputIter, InputIter,
+              const key_compare& = key_compare(),
+              const allocator_type& = allocator_type());
+  btree_table(_namespace(std)::initializer_list<value_type>,
+              const key_compare& = key_compare(),
+              const allocator_type& = allocator_type());
+  btree_table(const btree_table&);
+  btree_table(btree_table&&) noexcept;
+  ~btree_table() noexcept;
+
+  btree_table& operator=(const btree_table&);
+  btree_table& operator=(btree_table&&) noexcept;
+  btree_table& operator=(_namespace(std)::initializer_list<value_type>);
+
+  iterator begin() noexcept;
+  const_iterator begin() const noexcept;
+  const_iterator cbegin() const noexcept;
+  iterator end() noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cend() const noexcept;
+  reverse_iterator rbegin() noexcept;
+  const_reverse_iterator rbegin() const noexcept;
+  const_reverse_iterator crbegin() const noexcept;
+  reverse_iterator rend() noexcept;
+  const_reverse_iterator rend() const noexcept;
+  const_reverse_iterator crend() const noexcept;
+
+  bool empty() const noexcept;
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  size_type height() const noexcept;
+
+  void clear() noexcept;
+
+  _namespace(std)::pair<iterator, bool> insert(const value_type&);
+  _namespace(std)::pair<iterator, bool> insert(value_type&&);
+  iterator insert(const_iterator, const value_type&);
+  iterator insert(const_iterator, value_type&&);
+  template<typename InputIter> void insert(InputIter, InputIter);
+  void insert(_namespace(std)::initializer_list<value_type>);
+  template<typename... Args>
+  _namespace(std)::pair<iterator, bool> emplace(Args&&...);
+  template<typename... Args>
+  iterator emplace_hint(const_iterator, Args&&...);
+
+  iterator erase(const_iterator) noexcept;
+  template<typename Iter, typename = _namespace(std)::enable_if_t<
+      _namespace(std)::is_same<Iter, iterator>::value>>
+  iterator erase(Iter) noexcept;
+  iterator erase(const_iterator, const_iterator) noexcept;
+  template<typename K, typename = _namespace(std)::enable_if_t<
+      !_namespace(std)::is_same<K, iterator>::value &&
+      !_namespace(std)::is_same<K, const_iterator>::value>>
+  size_type erase(const K&);
+
+  template<typename K> iterator find(const K&);
+  template<typename K> const_iterator find(const K&) const;
+  template<typename K> size_type count(const K&) const;
+  template<typename K> iterator lower_bound(const K&);
+  template<typename K> const_iterator lower_bound(const K&) const;
+  template<typename K> iterator upper_bound(const K&);
+  template<typename K> const_iterator upper_bound(const K&) const;
+  template<typename K> _namespace(std)::pair<iterator, iterator>
+      equal_range(const K&);
+  template<typename K> _namespace(std)::pair<const_iterator, const_iterator>
+      equal_range(const K&) const;
+
+  void swap(btree_table&) noexcept;
+
+  key_compare key_comp() const;
+  allocator_type get_allocator() const;
+
+ protected:
+  template<typename K>
+  _namespace(std)::pair<iterator, bool> find_insert_position_(const K&);
+  template<typename... Args>
+  iterator construct_at_(iterator, Args&&...);
+  template<typename A, typename B> bool less_(const A&, const B&) const;
+
+ private:
+  template<typename K> size_t lower_in_node_(const node*, const K&) const;
+  template<typename K> size_t upper_in_node_(const node*, const K&) const;
+  template<typename K> const_iterator find_(const K&) const;
+  template<typename K> const_iterator lower_bound_(const K&) const;
+  template<typename K> const_iterator upper_bound_(const K&) const;
+  const_iterator normalize_(const_iterator) const noexcept;
+  iterator mutable_(const_iterator) noexcept;
+
+  void transfer_(value_type*, value_type*) noexcept;
+  void transfer_n_(value_type*, value_type*, size_t) noexcept;
+  void transfer_n_backward_(value_type*, value_type*, size_t) noexcept;
+  void set_child_(node*, size_t, node*) noexcept;
+  void move_children_(node*, size_t, node*, size_t, size_t) noexcept;
+
+  node* new_node_(bool);
+  void delete_node_(node*) noexcept;
+  void destroy_(node*) noexcept;
+
+  template<typename K> bool hint_fits_(const_iterator, const K&) const;
+  iterator insert_position_(const_iterator) noexcept;
+  iterator make_room_(iterator);
+  void close_room_(iterator) noexcept;
+  void split_(node*&, size_t&);
+  iterator transfer_in_(iterator, value_type*);
+
+  void merge_(node*, node*) noexcept;
+  void rotate_left_(node*, node*, size_t) noexcept;
+  void rotate_right_(node*, node*, size_t) noexcept;
+  void rebalance_after_erase_(iterator&) noexcept;
+
+  node* root_ = nullptr;
+  node* leftmost_ = nullptr;
+  node* rightmost_ = nullptr;
+  size_type size_ = 0;
+  _namespace(std)::tuple<key_compare, allocator_type> params_;
+};
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator==(const btree_table<Key, Value, KeyOf, Compare, Alloc>&,
+                const btree_table<Key, Value, KeyOf, Compare, Alloc>&);
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator!=(const btree_table<Key, Value, KeyOf, Compare, Alloc>&,
+                const btree_table<Key, Value, KeyOf, Compare, Alloc>&);
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator<(const btree_table<Key, Value, KeyOf, Compare, Alloc>&,
+               const btree_table<Key, Value, KeyOf, Compare, Alloc>&);
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator>(const btree_table<Key, Value, KeyOf, Compare, Alloc>&,
+               const btree_table<Key, Value, KeyOf, Compare, Alloc>&);
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator<=(const btree_table<Key, Value, KeyOf, Compare, Alloc>&,
+                const btree_table<Key, Value, KeyOf, Compare, Alloc>&);
+template<typename Key, typename Value, typename KeyOf,
+         typename Compare, typename Alloc>
+bool operator>=(const btree_table<Key, Value, KeyOf, Compare, Alloc>&,
+                const btree_table<Key, Value, KeyOf, Compare, Alloc>&);
+
+
+} /* namespace ilias::impl */
+_namespace_end(ilias)
+
+#include <ilias/btree_table-inl.h>
+
+#endif /* _ILIAS_BTREE_TABLE_H_ */
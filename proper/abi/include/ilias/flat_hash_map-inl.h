@@ -0,0 +1,111 @@
+#ifndef _ILIAS_FLAT_HASH_MAP_INL_H_
+#define _ILIAS_FLAT_HASH_MAP_INL_H_
+
+#include <ilias/flat_hash_map.h>
+#include <stdexcept>
+#include <tuple>
+
+_namespace_begin(ilias)
+
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+auto flat_hash_map<Key, T, Hash, Pred, A>::operator[](const key_type& k) ->
+    mapped_type& {
+  return try_emplace_(k).first->second;
+}
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+auto flat_hash_map<Key, T, Hash, Pred, A>::operator[](key_type&& k) ->
+    mapped_type& {
+  return try_emplace_(_namespace(std)::move(k)).first->second;
+}
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+auto flat_hash_map<Key, T, Hash, Pred, A>::at(const key_type& k) ->
+    mapped_type& {
+  iterator i = this->find(k);
+  if (i == this->end()) throw _namespace(std)::out_of_range("flat_hash_map");
+  return i->second;
+}
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+auto flat_hash_map<Key, T, Hash, Pred, A>::at(const key_type& k) const ->
+    const mapped_type& {
+  const_iterator i = this->find(k);
+  if (i == this->end()) throw _namespace(std)::out_of_range("flat_hash_map");
+  return i->second;
+}
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+template<typename... Args>
+auto flat_hash_map<Key, T, Hash, Pred, A>::try_emplace(const key_type& k,
+                                                       Args&&... args) ->
+    _namespace(std)::pair<iterator, bool> {
+  return try_emplace_(k, _namespace(std)::forward<Args>(args)...);
+}
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+template<typename... Args>
+auto flat_hash_map<Key, T, Hash, Pred, A>::try_emplace(key_type&& k,
+                                                       Args&&... args) ->
+    _namespace(std)::pair<iterator, bool> {
+  return try_emplace_(_namespace(std)::move(k),
+                      _namespace(std)::forward<Args>(args)...);
+}
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+template<typename M>
+auto flat_hash_map<Key, T, Hash, Pred, A>::insert_or_assign(const key_type& k,
+                                                            M&& v) ->
+    _namespace(std)::pair<iterator, bool> {
+  auto rv = try_emplace_(k, _namespace(std)::forward<M>(v));
+  if (!rv.second) rv.first->second = _namespace(std)::forward<M>(v);
+  return rv;
+}
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+template<typename M>
+auto flat_hash_map<Key, T, Hash, Pred, A>::insert_or_assign(key_type&& k,
+                                                            M&& v) ->
+    _namespace(std)::pair<iterator, bool> {
+  auto rv = try_emplace_(_namespace(std)::move(k),
+                         _namespace(std)::forward<M>(v));
+  if (!rv.second) rv.first->second = _namespace(std)::forward<M>(v);
+  return rv;
+}
+
+/*
+ * Only construct the element if the key is absent;
+ * the arguments are not touched if the key is present.
+ */
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+template<typename K, typename... Args>
+auto flat_hash_map<Key, T, Hash, Pred, A>::try_emplace_(K&& k,
+                                                        Args&&... args) ->
+    _namespace(std)::pair<iterator, bool> {
+  using _namespace(std)::forward;
+  using _namespace(std)::forward_as_tuple;
+  using _namespace(std)::piecewise_construct;
+
+  const size_t hash = this->hash_(k);
+  const auto pos = this->find_or_prepare_insert_(k, hash);
+  if (!pos.second) {
+    this->construct_at_(pos.first, hash,
+                        piecewise_construct,
+                        forward_as_tuple(forward<K>(k)),
+                        forward_as_tuple(forward<Args>(args)...));
+  }
+  return { this->iterator_at_(pos.first), !pos.second };
+}
+
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+void swap(flat_hash_map<Key, T, Hash, Pred, A>& x,
+          flat_hash_map<Key, T, Hash, Pred, A>& y) noexcept {
+  x.swap(y);
+}
+
+
+_namespace_end(ilias)
+
+#endif /* _ILIAS_FLAT_HASH_MAP_INL_H_ */
@@ -0,0 +1,85 @@
+#ifndef _ILIAS_FLAT_HASH_MAP_H_
+#define _ILIAS_FLAT_HASH_MAP_H_
+
+#include <cdecl.h>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <ilias/flat_hash_table.h>
+
+_namespace_begin(ilias)
+namespace impl {
+
+struct flat_hash_map_key {
+  template<typename Pair>
+  auto operator()(const Pair& p) const noexcept -> decltype((p.first)) {
+    return p.first;
+  }
+};
+
+} /* namespace ilias::impl */
+
+
+/*
+ * Hash map, storing elements inline in an open addressing table.
+ *
+ * Compared to unordered_map, inserting does not allocate a node and
+ * lookups don't chase pointers.  In return, a rehash moves all elements,
+ * invalidating references to them, and key_type must be copy
+ * constructible.
+ */
+template<typename Key, typename T,
+         typename Hash = _namespace(std)::hash<Key>,
+         typename Pred = _namespace(std)::equal_to<Key>,
+         typename Allocator =
+             _namespace(std)::allocator<_namespace(std)::pair<const Key, T>>>
+class flat_hash_map
+: public impl::flat_hash_table<Key, _namespace(std)::pair<const Key, T>,
+                               impl::flat_hash_map_key,
+                               Hash, Pred, Allocator>
+{
+ private:
+  using table = impl::flat_hash_table<Key, _namespace(std)::pair<const Key, T>,
+                                      impl::flat_hash_map_key,
+                                      Hash, Pred, Allocator>;
+
+ public:
+  using mapped_type = T;
+  using typename table::key_type;
+  using typename table::value_type;
+  using typename table::iterator;
+  using typename table::const_iterator;
+
+  using table::table;
+
+  mapped_type& operator[](const key_type&);
+  mapped_type& operator[](key_type&&);
+  mapped_type& at(const key_type&);
+  const mapped_type& at(const key_type&) const;
+
+  template<typename... Args>
+  _namespace(std)::pair<iterator, bool> try_emplace(const key_type&,
+                                                    Args&&...);
+  template<typename... Args>
+  _namespace(std)::pair<iterator, bool> try_emplace(key_type&&, Args&&...);
+  template<typename M>
+  _namespace(std)::pair<iterator, bool> insert_or_assign(const key_type&,
+                                                         M&&);
+  template<typename M>
+  _namespace(std)::pair<iterator, bool> insert_or_assign(key_type&&, M&&);
+
+ private:
+  template<typename K, typename... Args>
+  _namespace(std)::pair<iterator, bool> try_emplace_(K&&, Args&&...);
+};
+
+template<typename Key, typename T, typename Hash, typename Pred, typename A>
+void swap(flat_hash_map<Key, T, Hash, Pred, A>&,
+          flat_hash_map<Key, T, Hash, Pred, A>&) noexcept;
+
+
+_namespace_end(ilias)
+
+#include <ilias/flat_hash_map-inl.h>
+
+#endif /* _ILIAS_FLAT_HASH_MAP_H_ */
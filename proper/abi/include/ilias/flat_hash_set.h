@@ -0,0 +1,52 @@
+#ifndef _ILIAS_FLAT_HASH_SET_H_
+#define _ILIAS_FLAT_HASH_SET_H_
+
+#include <cdecl.h>
+#include <functional>
+#include <memory>
+#include <ilias/flat_hash_table.h>
+
+_namespace_begin(ilias)
+namespace impl {
+
+struct flat_hash_set_key {
+  template<typename T>
+  auto operator()(const T& v) const noexcept -> const T& {
+    return v;
+  }
+};
+
+} /* namespace ilias::impl */
+
+
+/*
+ * Hash set, storing elements inline in an open addressing table.
+ *
+ * See flat_hash_map for the trade-offs against unordered_set.
+ */
+template<typename T,
+         typename Hash = _namespace(std)::hash<T>,
+         typename Pred = _namespace(std)::equal_to<T>,
+         typename Allocator = _namespace(std)::allocator<T>>
+class flat_hash_set
+: public impl::flat_hash_table<T, T, impl::flat_hash_set_key,
+                               Hash, Pred, Allocator>
+{
+ private:
+  using table = impl::flat_hash_table<T, T, impl::flat_hash_set_key,
+                                      Hash, Pred, Allocator>;
+
+ public:
+  using table::table;
+};
+
+template<typename T, typename Hash, typename Pred, typename A>
+void swap(flat_hash_set<T, Hash, Pred, A>& x,
+          flat_hash_set<T, Hash, Pred, A>& y) noexcept {
+  x.swap(y);
+}
+
+
+_namespace_end(ilias)
+
+#endif /* _ILIAS_FLAT_HASH_SET_H_ */
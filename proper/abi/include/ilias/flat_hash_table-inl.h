@@ -0,0 +1,983 @@
+#ifndef _ILIAS_FLAT_HASH_TABLE_INL_H_
+#define _ILIAS_FLAT_HASH_TABLE_INL_H_
+
+#include <ilias/flat_hash_table.h>
+#include <abi/abi.h>
+#include <abi/misc_int.h>
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <new>
+#include <stdexcept>
+
+_namespace_begin(ilias)
+namespace impl {
+
+
+/*
+ * Multiply by the golden ratio and fold the high half into the low half,
+ * so both the probe position and the 7 bit control hash depend on
+ * all bits of the hash.  Hash specializations for integers and pointers
+ * are the identity, which would put sequential keys in the same group
+ * and give aligned pointers the same control hash.
+ */
+inline auto flat_hash_mix(size_t h) noexcept -> size_t {
+  constexpr size_t k = (sizeof(size_t) > 4U ?
+                        size_t(0x9e3779b97f4a7c15ULL) :
+                        size_t(0x9e3779b9UL));
+  h *= k;
+  return h ^ (h >> (sizeof(size_t) * 4U));
+}
+
+
+#if defined(__amd64__) || defined(__x86_64__)
+inline flat_hash_group::flat_hash_group(const flat_hash_ctrl_t* p) noexcept {
+  struct __attribute__((__packed__, __may_alias__)) unaligned {
+    vec_t v;
+  };
+
+  ctrl_ = reinterpret_cast<const unaligned*>(p)->v;
+}
+
+inline auto flat_hash_group::movemask_(vec_t v) noexcept -> mask_type {
+  typedef char vec16c_t __attribute__((__vector_size__(16)));
+  return mask_type(__builtin_ia32_pmovmskb128((vec16c_t)v)) & 0xffffU;
+}
+
+inline auto flat_hash_group::splat_(flat_hash_ctrl_t c) noexcept -> vec_t {
+  vec_t v;
+  for (unsigned int i = 0; i < sizeof(vec_t); ++i) v[i] = c;
+  return v;
+}
+
+inline auto flat_hash_group::match(flat_hash_ctrl_t h2) const noexcept ->
+    mask_type {
+  return movemask_((vec_t)(ctrl_ == splat_(h2)));
+}
+
+inline auto flat_hash_group::match_empty() const noexcept -> mask_type {
+  return movemask_((vec_t)(ctrl_ == splat_(flat_hash_empty)));
+}
+
+inline auto flat_hash_group::match_empty_or_deleted() const noexcept ->
+    mask_type {
+  return movemask_((vec_t)(ctrl_ < splat_(flat_hash_sentinel)));
+}
+
+inline auto flat_hash_group::count_leading_empty_or_deleted() const noexcept ->
+    size_t {
+  return abi::ctz(match_empty_or_deleted() + 1U);
+}
+
+inline auto flat_hash_group::leading_slots(mask_type m) noexcept -> size_t {
+  return size_t(abi::clz(static_cast<unsigned short>(m)));
+}
+#else
+inline flat_hash_group::flat_hash_group(const flat_hash_ctrl_t* p) noexcept {
+  struct __attribute__((__packed__, __may_alias__)) unaligned {
+    uint64_t v;
+  };
+
+  ctrl_ = reinterpret_cast<const unaligned*>(p)->v;
+}
+
+/*
+ * May report false positives, but only for full slots following a
+ * slot that matches.  The caller compares keys anyway.
+ */
+inline auto flat_hash_group::match(flat_hash_ctrl_t h2) const noexcept ->
+    mask_type {
+  const uint64_t x = ctrl_ ^ (lsbs * uint8_t(h2));
+  return (x - lsbs) & ~x & msbs;
+}
+
+inline auto flat_hash_group::match_empty() const noexcept -> mask_type {
+  /* Empty is the only control byte with bit 7 set and bit 1 clear. */
+  return (ctrl_ & ~(ctrl_ << 6)) & msbs;
+}
+
+inline auto flat_hash_group::match_empty_or_deleted() const noexcept ->
+    mask_type {
+  /* Sentinel is the only control byte with both bit 7 and bit 0 set. */
+  return (ctrl_ & ~(ctrl_ << 7)) & msbs;
+}
+
+inline auto flat_hash_group::count_leading_empty_or_deleted() const noexcept ->
+    size_t {
+  return size_t(abi::ctzll((match_empty_or_deleted() | ~msbs) + 1U)) >> 3;
+}
+
+inline auto flat_hash_group::leading_slots(mask_type m) noexcept -> size_t {
+  return size_t(abi::clzll(m)) >> 3;
+}
+#endif
+
+inline auto flat_hash_group::lowest(mask_type m) noexcept -> size_t {
+  assert(m != 0U);
+  return size_t(__builtin_ctzll(m)) >> shift;
+}
+
+inline auto flat_hash_group::trailing_slots(mask_type m) noexcept -> size_t {
+  return (m == 0U ? width : lowest(m));
+}
+
+
+template<typename T>
+template<typename U, typename>
+flat_hash_iterator<T>::flat_hash_iterator(const flat_hash_iterator<U>& o)
+    noexcept
+: ctrl_(o.ctrl_),
+  slot_(o.slot_)
+{}
+
+template<typename T>
+flat_hash_iterator<T>::flat_hash_iterator(const flat_hash_ctrl_t* ctrl,
+                                          T* slot) noexcept
+: ctrl_(ctrl),
+  slot_(slot)
+{}
+
+template<typename T>
+auto flat_hash_iterator<T>::skip_empty_or_deleted_() noexcept -> void {
+  /* The sentinel is neither empty nor deleted, so this stops at end(). */
+  while (*ctrl_ < flat_hash_sentinel) {
+    const size_t shift = flat_hash_group(ctrl_).
+        count_leading_empty_or_deleted();
+    ctrl_ += shift;
+    slot_ += shift;
+  }
+}
+
+template<typename T>
+auto flat_hash_iterator<T>::operator*() const noexcept -> T& {
+  assert(*ctrl_ >= 0);
+  return *slot_;
+}
+
+template<typename T>
+auto flat_hash_iterator<T>::operator->() const noexcept -> T* {
+  return &**this;
+}
+
+template<typename T>
+auto flat_hash_iterator<T>::operator++() noexcept -> flat_hash_iterator& {
+  assert(*ctrl_ >= 0);
+  ++ctrl_;
+  ++slot_;
+  skip_empty_or_deleted_();
+  return *this;
+}
+
+template<typename T>
+auto flat_hash_iterator<T>::operator++(int) noexcept -> flat_hash_iterator {
+  flat_hash_iterator copy = *this;
+  ++*this;
+  return copy;
+}
+
+template<typename T>
+template<typename U>
+auto flat_hash_iterator<T>::operator==(const flat_hash_iterator<U>& o)
+    const noexcept -> bool {
+  return ctrl_ == o.ctrl_;
+}
+
+template<typename T>
+template<typename U>
+auto flat_hash_iterator<T>::operator!=(const flat_hash_iterator<U>& o)
+    const noexcept -> bool {
+  return !(*this == o);
+}
+
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+flat_hash_table<K, V, KO, H, P, A>::flat_hash_table(
+    size_type n, const hasher& hash, const key_equal& eq,
+    const allocator_type& alloc)
+: params_(hash, eq, alloc)
+{
+  if (n != 0) resize_(normalize_capacity_(n));
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+flat_hash_table<K, V, KO, H, P, A>::flat_hash_table(
+    const allocator_type& alloc)
+: flat_hash_table(0, hasher(), key_equal(), alloc)
+{}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename InputIter>
+flat_hash_table<K, V, KO, H, P, A>::flat_hash_table(
+    InputIter b, InputIter e, size_type n, const hasher& hash,
+    const key_equal& eq, const allocator_type& alloc)
+: flat_hash_table(n, hash, eq, alloc)
+{
+  insert(b, e);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+flat_hash_table<K, V, KO, H, P, A>::flat_hash_table(
+    _namespace(std)::initializer_list<value_type> il, size_type n,
+    const hasher& hash, const key_equal& eq, const allocator_type& alloc)
+: flat_hash_table(n, hash, eq, alloc)
+{
+  insert(il);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+flat_hash_table<K, V, KO, H, P, A>::flat_hash_table(
+    const flat_hash_table& o)
+: params_(o.params_)
+{
+  reserve(o.size());
+  for (const value_type& v : o) {
+    const size_t hash = hash_(KO()(v));
+    construct_at_(prepare_insert_(hash), hash, v);
+  }
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+flat_hash_table<K, V, KO, H, P, A>::flat_hash_table(flat_hash_table&& o)
+    noexcept
+: ctrl_(_namespace(std)::exchange(
+      o.ctrl_, const_cast<flat_hash_ctrl_t*>(&flat_hash_empty_group[0]))),
+  slots_(_namespace(std)::exchange(o.slots_, nullptr)),
+  capacity_(_namespace(std)::exchange(o.capacity_, 0)),
+  size_(_namespace(std)::exchange(o.size_, 0)),
+  growth_left_(_namespace(std)::exchange(o.growth_left_, 0)),
+  params_(_namespace(std)::move(o.params_))
+{}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+flat_hash_table<K, V, KO, H, P, A>::~flat_hash_table() noexcept {
+  destroy_slots_();
+  deallocate_();
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::operator=(const flat_hash_table& o)
+    -> flat_hash_table& {
+  if (&o != this) {
+    flat_hash_table copy = o;
+    swap(copy);
+  }
+  return *this;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::operator=(flat_hash_table&& o)
+    noexcept -> flat_hash_table& {
+  flat_hash_table tmp = _namespace(std)::move(o);
+  swap(tmp);
+  return *this;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::operator=(
+    _namespace(std)::initializer_list<value_type> il) -> flat_hash_table& {
+  clear();
+  insert(il);
+  return *this;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::begin() noexcept -> iterator {
+  iterator rv = iterator_at_(0);
+  rv.skip_empty_or_deleted_();
+  return rv;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::begin() const noexcept ->
+    const_iterator {
+  const_iterator rv = iterator_at_(0);
+  rv.skip_empty_or_deleted_();
+  return rv;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::cbegin() const noexcept ->
+    const_iterator {
+  return begin();
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::end() noexcept -> iterator {
+  return iterator_at_(capacity_);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::end() const noexcept ->
+    const_iterator {
+  return iterator_at_(capacity_);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::cend() const noexcept ->
+    const_iterator {
+  return end();
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::empty() const noexcept -> bool {
+  return size_ == 0;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::size() const noexcept ->
+    size_type {
+  return size_;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::max_size() const noexcept ->
+    size_type {
+  return capacity_to_growth_(
+      normalize_capacity_(_namespace(std)::numeric_limits<size_type>::max() /
+                          (sizeof(value_type) + 1U) / 2U));
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::capacity() const noexcept ->
+    size_type {
+  return capacity_;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::bucket_count() const noexcept ->
+    size_type {
+  return capacity_;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::load_factor() const noexcept ->
+    float {
+  return (capacity_ == 0 ? 0.0f : float(size_) / float(capacity_));
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::max_load_factor() const noexcept ->
+    float {
+  return 7.0f / 8.0f;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::clear() noexcept -> void {
+  destroy_slots_();
+  if (capacity_ != 0) {
+    _namespace(std)::fill_n(ctrl_, capacity_ + group::width,
+                            flat_hash_empty);
+    ctrl_[capacity_] = flat_hash_sentinel;
+  }
+  size_ = 0;
+  growth_left_ = capacity_to_growth_(capacity_);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::reserve(size_type n) -> void {
+  if (n > size_ + growth_left_)
+    resize_(normalize_capacity_(growth_to_capacity_(n)));
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::rehash(size_type n) -> void {
+  if (n == 0 && size_ == 0) {
+    deallocate_();
+    return;
+  }
+
+  const size_type cap = normalize_capacity_(
+      _namespace(std)::max(n, growth_to_capacity_(size_)));
+  if (cap != capacity_) resize_(cap);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::insert(const value_type& v) ->
+    _namespace(std)::pair<iterator, bool> {
+  const size_t hash = hash_(KO()(v));
+  const auto pos = find_or_prepare_insert_(KO()(v), hash);
+  if (!pos.second) construct_at_(pos.first, hash, v);
+  return { iterator_at_(pos.first), !pos.second };
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::insert(value_type&& v) ->
+    _namespace(std)::pair<iterator, bool> {
+  const size_t hash = hash_(KO()(v));
+  const auto pos = find_or_prepare_insert_(KO()(v), hash);
+  if (!pos.second) construct_at_(pos.first, hash, _namespace(std)::move(v));
+  return { iterator_at_(pos.first), !pos.second };
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::insert(const_iterator,
+                                                const value_type& v) ->
+    iterator {
+  return insert(v).first;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::insert(const_iterator,
+                                                value_type&& v) ->
+    iterator {
+  return insert(_namespace(std)::move(v)).first;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename InputIter>
+auto flat_hash_table<K, V, KO, H, P, A>::insert(InputIter b, InputIter e) ->
+    void {
+  while (b != e) {
+    emplace(*b);
+    ++b;
+  }
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::insert(
+    _namespace(std)::initializer_list<value_type> il) -> void {
+  reserve(size_ + il.size());
+  insert(il.begin(), il.end());
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename... Args>
+auto flat_hash_table<K, V, KO, H, P, A>::emplace(Args&&... args) ->
+    _namespace(std)::pair<iterator, bool> {
+  /*
+   * The key is only known once the value is constructed,
+   * so construct it on the stack and move it in place.
+   */
+  struct tmp_destroy {
+    ~tmp_destroy() noexcept {
+      slot_alloc_traits::destroy(alloc, p);
+    }
+
+    slot_alloc& alloc;
+    value_type* p;
+  };
+
+  slot_alloc alloc = _namespace(std)::get<2>(params_);
+  _namespace(std)::aligned_storage_t<sizeof(value_type),
+                                     alignof(value_type)> tmp;
+  value_type* p = reinterpret_cast<value_type*>(&tmp);
+  slot_alloc_traits::construct(alloc, p,
+                               _namespace(std)::forward<Args>(args)...);
+  tmp_destroy guard{ alloc, p };
+
+  const size_t hash = hash_(KO()(*p));
+  const auto pos = find_or_prepare_insert_(KO()(*p), hash);
+  if (!pos.second) construct_at_(pos.first, hash, _namespace(std)::move(*p));
+  return { iterator_at_(pos.first), !pos.second };
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename... Args>
+auto flat_hash_table<K, V, KO, H, P, A>::emplace_hint(const_iterator,
+                                                      Args&&... args) ->
+    iterator {
+  return emplace(_namespace(std)::forward<Args>(args)...).first;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::erase(const_iterator i) noexcept ->
+    iterator {
+  const size_type idx = size_type(i.ctrl_ - ctrl_);
+  assert(idx < capacity_ && is_full_(ctrl_[idx]));
+
+  erase_at_(idx);
+  iterator rv = iterator_at_(idx);
+  rv.skip_empty_or_deleted_();
+  return rv;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Iter, typename>
+auto flat_hash_table<K, V, KO, H, P, A>::erase(Iter i) noexcept ->
+    iterator {
+  return erase(const_iterator(i));
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::erase(const_iterator b,
+                                               const_iterator e) noexcept ->
+    iterator {
+  if (b == cbegin() && e == cend()) {
+    clear();
+    return end();
+  }
+
+  while (b != e) b = erase(b);
+  return iterator_at_(size_type(e.ctrl_ - ctrl_));
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Key, typename>
+auto flat_hash_table<K, V, KO, H, P, A>::erase(const Key& k) -> size_type {
+  const size_type idx = find_index_(k, hash_(k));
+  if (idx == capacity_) return 0;
+  erase_at_(idx);
+  return 1;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Key>
+auto flat_hash_table<K, V, KO, H, P, A>::find(const Key& k) -> iterator {
+  return iterator_at_(find_index_(k, hash_(k)));
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Key>
+auto flat_hash_table<K, V, KO, H, P, A>::find(const Key& k) const ->
+    const_iterator {
+  return iterator_at_(find_index_(k, hash_(k)));
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Key>
+auto flat_hash_table<K, V, KO, H, P, A>::count(const Key& k) const ->
+    size_type {
+  return (find_index_(k, hash_(k)) == capacity_ ? 0U : 1U);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Key>
+auto flat_hash_table<K, V, KO, H, P, A>::equal_range(const Key& k) ->
+    _namespace(std)::pair<iterator, iterator> {
+  iterator b = find(k);
+  iterator e = b;
+  if (e != end()) ++e;
+  return { b, e };
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Key>
+auto flat_hash_table<K, V, KO, H, P, A>::equal_range(const Key& k) const ->
+    _namespace(std)::pair<const_iterator, const_iterator> {
+  const_iterator b = find(k);
+  const_iterator e = b;
+  if (e != end()) ++e;
+  return { b, e };
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::swap(flat_hash_table& o) noexcept ->
+    void {
+  using _namespace(std)::swap;
+
+  swap(ctrl_, o.ctrl_);
+  swap(slots_, o.slots_);
+  swap(capacity_, o.capacity_);
+  swap(size_, o.size_);
+  swap(growth_left_, o.growth_left_);
+  swap(params_, o.params_);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::hash_function() const -> hasher {
+  return _namespace(std)::get<0>(params_);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::key_eq() const -> key_equal {
+  return _namespace(std)::get<1>(params_);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::get_allocator() const ->
+    allocator_type {
+  return _namespace(std)::get<2>(params_);
+}
+
+/*
+ * Find the slot holding key k, or prepare a slot for inserting it.
+ * Returns the slot index and whether the key was found.
+ * If the key was not found, the caller must construct the value using
+ * construct_at_(), before any other modification of the table.
+ */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Key>
+auto flat_hash_table<K, V, KO, H, P, A>::find_or_prepare_insert_(
+    const Key& k, size_t hash) -> _namespace(std)::pair<size_type, bool> {
+  const size_type idx = find_index_(k, hash);
+  if (idx != capacity_) return { idx, true };
+  return { prepare_insert_(hash), false };
+}
+
+/*
+ * Construct the value in the slot returned by prepare_insert_()
+ * and mark the slot as full.
+ * If construction throws, the table is unchanged.
+ */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename... Args>
+auto flat_hash_table<K, V, KO, H, P, A>::construct_at_(size_type i,
+                                                       size_t hash,
+                                                       Args&&... args) ->
+    void {
+  slot_alloc alloc = _namespace(std)::get<2>(params_);
+  slot_alloc_traits::construct(alloc, &slots_[i],
+                               _namespace(std)::forward<Args>(args)...);
+  commit_insert_(i, hash);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::iterator_at_(size_type i) noexcept ->
+    iterator {
+  return iterator(ctrl_ + i, slots_ + i);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::iterator_at_(size_type i)
+    const noexcept -> const_iterator {
+  return const_iterator(ctrl_ + i, slots_ + i);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::h1_(size_t hash) noexcept ->
+    size_type {
+  return hash >> 7;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::h2_(size_t hash) noexcept ->
+    flat_hash_ctrl_t {
+  return flat_hash_ctrl_t(hash & 0x7fU);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::is_full_(flat_hash_ctrl_t c)
+    noexcept -> bool {
+  return c >= 0;
+}
+
+/* Round n up to a power of 2 minus 1. */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::normalize_capacity_(size_type n)
+    noexcept -> size_type {
+  if (n <= 1U) return 1U;
+  return ~size_type(0) >> abi::clzl(n);
+}
+
+/*
+ * Number of elements that fit in a table of the given capacity,
+ * at a maximum load factor of 7/8.
+ * A group probe needs an empty slot to terminate, so a table whose
+ * capacity fills exactly one group (and has no cloned empty bytes)
+ * must keep one slot free.
+ */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::capacity_to_growth_(size_type cap)
+    noexcept -> size_type {
+  if (cap == group::width - 1U) return cap - 1U;
+  return cap - cap / 8U;
+}
+
+/* Smallest capacity for which capacity_to_growth_() >= n. */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::growth_to_capacity_(size_type n)
+    noexcept -> size_type {
+  if (n == group::width - 1U) return n + 1U;
+  return n + (n == 0 ? 0 : (n - 1U) / 7U);
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Key>
+auto flat_hash_table<K, V, KO, H, P, A>::hash_(const Key& k) const ->
+    size_t {
+  return flat_hash_mix(_namespace(std)::get<0>(params_)(k));
+}
+
+/* Returns the index of the slot holding k, or capacity_ if absent. */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+template<typename Key>
+auto flat_hash_table<K, V, KO, H, P, A>::find_index_(const Key& k,
+                                                     size_t hash) const ->
+    size_type {
+  const flat_hash_ctrl_t h2 = h2_(hash);
+  size_type offset = h1_(hash) & capacity_;
+  size_type step = 0;
+
+  /* Triangular probing visits every group, since capacity_ + 1 is
+   * a power of 2. */
+  for (;;) {
+    const group g(ctrl_ + offset);
+    for (auto m = g.match(h2); m != 0U; m &= m - 1U) {
+      const size_type i = (offset + group::lowest(m)) & capacity_;
+      if (_namespace(std)::get<1>(params_)(KO()(slots_[i]), k)) return i;
+    }
+    if (g.match_empty() != 0U) return capacity_;
+
+    step += group::width;
+    offset = (offset + step) & capacity_;
+    assert(step <= capacity_ + group::width);
+  }
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::find_first_non_full_(size_t hash)
+    const noexcept -> size_type {
+  size_type offset = h1_(hash) & capacity_;
+  size_type step = 0;
+
+  for (;;) {
+    const auto m = group(ctrl_ + offset).match_empty_or_deleted();
+    if (m != 0U) return (offset + group::lowest(m)) & capacity_;
+
+    step += group::width;
+    offset = (offset + step) & capacity_;
+    assert(step <= capacity_ + group::width);
+  }
+}
+
+/* Find a slot for an element with the given hash, growing if required. */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::prepare_insert_(size_t hash) ->
+    size_type {
+  if (capacity_ == 0) {
+    resize_(1);
+    return find_first_non_full_(hash);
+  }
+
+  size_type i = find_first_non_full_(hash);
+  if (_predict_false(growth_left_ == 0 && ctrl_[i] != flat_hash_deleted)) {
+    rehash_and_grow_if_necessary_();
+    i = find_first_non_full_(hash);
+  }
+  return i;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::commit_insert_(size_type i,
+                                                        size_t hash)
+    noexcept -> void {
+  assert(!is_full_(ctrl_[i]));
+
+  if (ctrl_[i] == flat_hash_empty) {
+    assert(growth_left_ > 0);
+    --growth_left_;
+  }
+  ++size_;
+  set_ctrl_(i, h2_(hash));
+}
+
+/* Set control byte i, and its clone past the sentinel. */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::set_ctrl_(size_type i,
+                                                   flat_hash_ctrl_t c)
+    noexcept -> void {
+  constexpr size_type cloned = group::width - 1U;
+
+  assert(i < capacity_);
+  ctrl_[i] = c;
+  ctrl_[((i - cloned) & capacity_) + (cloned & capacity_)] = c;
+}
+
+/*
+ * Erase the element in slot i.
+ *
+ * If no probe sequence can have passed the slot while it was full,
+ * it is marked empty.  That is the case if the run of non-empty slots
+ * around it is shorter than a group: any group containing the slot
+ * would then also contain an empty slot.  Otherwise the slot is marked
+ * deleted, so probes don't stop early.
+ */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::erase_at_(size_type i) noexcept ->
+    void {
+  assert(i < capacity_ && is_full_(ctrl_[i]));
+
+  slot_alloc alloc = _namespace(std)::get<2>(params_);
+  slot_alloc_traits::destroy(alloc, &slots_[i]);
+
+  const size_type before = (i - group::width) & capacity_;
+  const auto empty_after = group(ctrl_ + i).match_empty();
+  const auto empty_before = group(ctrl_ + before).match_empty();
+  const bool was_never_full =
+      empty_before != 0U && empty_after != 0U &&
+      (group::trailing_slots(empty_after) +
+       group::leading_slots(empty_before)) < group::width;
+
+  set_ctrl_(i, (was_never_full ? flat_hash_empty : flat_hash_deleted));
+  if (was_never_full) ++growth_left_;
+  --size_;
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::destroy_slots_() noexcept -> void {
+  if (_namespace(std)::is_trivially_destructible<value_type>::value ||
+      size_ == 0)
+    return;
+
+  slot_alloc alloc = _namespace(std)::get<2>(params_);
+  for (size_type i = 0; i < capacity_; ++i) {
+    if (is_full_(ctrl_[i]))
+      slot_alloc_traits::destroy(alloc, &slots_[i]);
+  }
+}
+
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::deallocate_() noexcept -> void {
+  if (capacity_ == 0) return;
+
+  slot_alloc s_alloc = _namespace(std)::get<2>(params_);
+  ctrl_alloc c_alloc = _namespace(std)::get<2>(params_);
+  slot_alloc_traits::deallocate(s_alloc, slots_, capacity_);
+  ctrl_alloc_traits::deallocate(c_alloc, ctrl_, capacity_ + group::width);
+
+  ctrl_ = const_cast<flat_hash_ctrl_t*>(&flat_hash_empty_group[0]);
+  slots_ = nullptr;
+  capacity_ = 0;
+  growth_left_ = 0;
+}
+
+/*
+ * Move all elements into a table of capacity cap.
+ * Elements are copied if their move constructor may throw,
+ * so on exception the table is unchanged.
+ */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::resize_(size_type cap) -> void {
+  assert(cap != 0 && ((cap + 1U) & cap) == 0);
+  assert(capacity_to_growth_(cap) >= size_);
+
+  slot_alloc s_alloc = _namespace(std)::get<2>(params_);
+  ctrl_alloc c_alloc = _namespace(std)::get<2>(params_);
+
+  flat_hash_table tmp(0, hash_function(), key_eq(), get_allocator());
+  tmp.ctrl_ = ctrl_alloc_traits::allocate(c_alloc, cap + group::width);
+  try {
+    tmp.slots_ = slot_alloc_traits::allocate(s_alloc, cap);
+  } catch (...) {
+    ctrl_alloc_traits::deallocate(c_alloc, tmp.ctrl_, cap + group::width);
+    tmp.ctrl_ = const_cast<flat_hash_ctrl_t*>(&flat_hash_empty_group[0]);
+    throw;
+  }
+  tmp.capacity_ = cap;
+  tmp.clear();
+
+  /* On exception, tmp destroys the elements copied so far. */
+  for (size_type i = 0; i < capacity_; ++i) {
+    if (!is_full_(ctrl_[i])) continue;
+
+    const size_t hash = hash_(KO()(slots_[i]));
+    const size_type j = tmp.find_first_non_full_(hash);
+    slot_alloc_traits::construct(s_alloc, &tmp.slots_[j],
+                                 _namespace(std)::move_if_noexcept(
+                                     slots_[i]));
+    tmp.commit_insert_(j, hash);
+  }
+
+  swap(tmp);
+}
+
+/*
+ * Called when an insert finds no room.
+ * If many slots hold deleted markers, rebuild the table at the same
+ * capacity (into a new allocation), which drops the markers.
+ * Otherwise double the capacity.
+ */
+template<typename K, typename V, typename KO, typename H, typename P,
+         typename A>
+auto flat_hash_table<K, V, KO, H, P, A>::rehash_and_grow_if_necessary_() ->
+    void {
+  if (capacity_ > group::width && size_ * 32U <= capacity_ * 25U)
+    resize_(capacity_);
+  else
+    resize_(capacity_ * 2U + 1U);
+}
+
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Hash, typename Pred, typename Alloc>
+bool operator==(
+    const flat_hash_table<Key, Value, KeyOf, Hash, Pred, Alloc>& x,
+    const flat_hash_table<Key, Value, KeyOf, Hash, Pred, Alloc>& y) {
+  if (x.size() != y.size()) return false;
+  for (const auto& v : x) {
+    auto y_iter = y.find(KeyOf()(v));
+    if (y_iter == y.end() || !(*y_iter == v)) return false;
+  }
+  return true;
+}
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Hash, typename Pred, typename Alloc>
+bool operator!=(
+    const flat_hash_table<Key, Value, KeyOf, Hash, Pred, Alloc>& x,
+    const flat_hash_table<Key, Value, KeyOf, Hash, Pred, Alloc>& y) {
+  return !(x == y);
+}
+
+
+} /* namespace ilias::impl */
+_namespace_end(ilias)
+
+#endif /* _ILIAS_FLAT_HASH_TABLE_INL_H_ */
@@ -0,0 +1,324 @@
+#ifndef _ILIAS_FLAT_HASH_TABLE_H_
+#define _ILIAS_FLAT_HASH_TABLE_H_
+
+#include <cdecl.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+_namespace_begin(ilias)
+namespace impl {
+
+/*
+ * Open addressing hash table, with one control byte per slot.
+ *
+ * A control byte is one of:
+ * - flat_hash_empty: the slot was never used,
+ * - flat_hash_deleted: the slot held an element that was erased,
+ * - flat_hash_sentinel: marks the end of the table, for iteration,
+ * - 0..127: the slot holds an element, the low 7 bits of its hash.
+ *
+ * Lookups probe a group of control bytes at a time, comparing all of them
+ * against the 7 bit hash in parallel.  Only slots with a matching control
+ * byte have their key compared.  A probe ends at the first group that
+ * contains an empty slot.
+ *
+ * The control bytes array holds capacity + group width bytes: the
+ * sentinel follows the last slot, and after it the first
+ * (group width - 1) control bytes are repeated, so a group can be loaded
+ * at any slot without wrapping around.
+ */
+using flat_hash_ctrl_t = int8_t;
+constexpr flat_hash_ctrl_t flat_hash_empty = -128;
+constexpr flat_hash_ctrl_t flat_hash_deleted = -2;
+constexpr flat_hash_ctrl_t flat_hash_sentinel = -1;
+
+/*
+ * Control bytes of a table with no slots.
+ * Contains a sentinel followed by empty control bytes, so lookups
+ * in an empty table terminate after a single group.
+ */
+extern const flat_hash_ctrl_t flat_hash_empty_group[16];
+
+size_t flat_hash_mix(size_t) noexcept;
+
+/*
+ * Group of control bytes, compared in parallel.
+ *
+ * On amd64, a group is 16 control bytes, compared using SSE2.
+ * Elsewhere, a group is 8 control bytes, compared as a 64-bit integer.
+ * Masks have one bit set per matching control byte;
+ * shift converts a bit position in a mask to a control byte offset.
+ */
+class flat_hash_group {
+ public:
+#if defined(__amd64__) || defined(__x86_64__)
+  using mask_type = uint32_t;
+  static constexpr size_t width = 16;
+  static constexpr unsigned int shift = 0;
+#else
+  using mask_type = uint64_t;
+  static constexpr size_t width = 8;
+  static constexpr unsigned int shift = 3;
+#endif
+
+  explicit flat_hash_group(const flat_hash_ctrl_t*) noexcept;
+
+  mask_type match(flat_hash_ctrl_t) const noexcept;
+  mask_type match_empty() const noexcept;
+  mask_type match_empty_or_deleted() const noexcept;
+  size_t count_leading_empty_or_deleted() const noexcept;
+
+  static size_t lowest(mask_type) noexcept;
+  static size_t trailing_slots(mask_type) noexcept;
+  static size_t leading_slots(mask_type) noexcept;
+
+ private:
+#if defined(__amd64__) || defined(__x86_64__)
+  typedef signed char vec_t __attribute__((__vector_size__(16)));
+
+  static mask_type movemask_(vec_t) noexcept;
+  static vec_t splat_(flat_hash_ctrl_t) noexcept;
+
+  vec_t ctrl_;
+#else
+  static constexpr uint64_t lsbs = 0x0101010101010101ULL;
+  static constexpr uint64_t msbs = 0x8080808080808080ULL;
+
+  uint64_t ctrl_;
+#endif
+};
+
+
+template<typename, typename, typename, typename, typename, typename>
+class flat_hash_table;
+
+template<typename T>
+class flat_hash_iterator
+: public _namespace(std)::iterator<_namespace(std)::forward_iterator_tag,
+                                   _namespace(std)::remove_const_t<T>>
+{
+  template<typename, typename, typename, typename, typename, typename>
+      friend class flat_hash_table;
+  template<typename> friend class flat_hash_iterator;
+
+ public:
+  using reference = T&;
+  using pointer = T*;
+
+  flat_hash_iterator() noexcept = default;
+  flat_hash_iterator(const flat_hash_iterator&) noexcept = default;
+  flat_hash_iterator& operator=(const flat_hash_iterator&) noexcept = default;
+  template<typename U, typename =
+      _namespace(std)::enable_if_t<
+          _namespace(std)::is_same<const U, T>::value>>
+  flat_hash_iterator(const flat_hash_iterator<U>&) noexcept;
+
+ private:
+  flat_hash_iterator(const flat_hash_ctrl_t*, T*) noexcept;
+
+  void skip_empty_or_deleted_() noexcept;
+
+ public:
+  T& operator*() const noexcept;
+  T* operator->() const noexcept;
+
+  flat_hash_iterator& operator++() noexcept;
+  flat_hash_iterator operator++(int) noexcept;
+
+  template<typename U> bool operator==(const flat_hash_iterator<U>&)
+      const noexcept;
+  template<typename U> bool operator!=(const flat_hash_iterator<U>&)
+      const noexcept;
+
+ private:
+  const flat_hash_ctrl_t* ctrl_ = nullptr;
+  T* slot_ = nullptr;
+};
+
+
+/*
+ * Type shared by flat_hash_map and flat_hash_set.
+ *
+ * KeyOf extracts the key from a value.
+ * If Key and Value are the same type, iterators are constant.
+ *
+ * Unlike the node based unordered containers, elements are stored inline,
+ * so inserting or erasing invalidates iterators and references
+ * if the table is rehashed.
+ */
+template<typename Key, typename Value, typename KeyOf,
+         typename Hash, typename Pred, typename Alloc>
+class flat_hash_table {
+ private:
+  using alloc_traits = _namespace(std)::allocator_traits<Alloc>;
+  using slot_alloc = typename alloc_traits::template rebind_alloc<Value>;
+  using slot_alloc_traits = _namespace(std)::allocator_traits<slot_alloc>;
+  using ctrl_alloc =
+      typename alloc_traits::template rebind_alloc<flat_hash_ctrl_t>;
+  using ctrl_alloc_traits = _namespace(std)::allocator_traits<ctrl_alloc>;
+  using group = flat_hash_group;
+
+  static_assert(_namespace(std)::is_pointer<
+                    typename slot_alloc_traits::pointer>::value &&
+                _namespace(std)::is_pointer<
+                    typename ctrl_alloc_traits::pointer>::value,
+                "flat_hash_table requires an allocator with plain pointers");
+
+ public:
+  using key_type = Key;
+  using value_type = Value;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using hasher = Hash;
+  using key_equal = Pred;
+  using allocator_type = Alloc;
+  using reference = value_type&;
+  using const_reference = const value_type&;
+  using pointer = value_type*;
+  using const_pointer = const value_type*;
+
+  using iterator = flat_hash_iterator<
+      _namespace(std)::conditional_t<
+          _namespace(std)::is_same<Key, Value>::value,
+          const value_type, value_type>>;
+  using const_iterator = flat_hash_iterator<const value_type>;
+
+  explicit flat_hash_table(size_type = 0,
+                           const hasher& = hasher(),
+                           const key_equal& = key_equal(),
+                           const allocator_type& = allocator_type());
+  explicit flat_hash_table(const allocator_type&);
+  template<typename InputIter>
+  flat_hash_table(InputIter, InputIter, size_type = 0,
+                  const hasher& = hasher(),
+                  const key_equal& = key_equal(),
+                  const allocator_type& = allocator_type());
+  flat_hash_table(_namespace(std)::initializer_list<value_type>,
+                  size_type = 0,
+                  const hasher& = hasher(),
+                  const key_equal& = key_equal(),
+                  const allocator_type& = allocator_type());
+  flat_hash_table(const flat_hash_table&);
+  flat_hash_table(flat_hash_table&&) noexcept;
+  ~flat_hash_table() noexcept;
+
+  flat_hash_table& operator=(const flat_hash_table&);
+  flat_hash_table& operator=(flat_hash_table&&) noexcept;
+  flat_hash_table& operator=(_namespace(std)::initializer_list<value_type>);
+
+  iterator begin() noexcept;
+  const_iterator begin() const noexcept;
+  const_iterator cbegin() const noexcept;
+  iterator end() noexcept;
+  const_iterator end() const noexcept;
+  const_iterator cend() const noexcept;
+
+  bool empty() const noexcept;
+  size_type size() const noexcept;
+  size_type max_size() const noexcept;
+  size_type capacity() const noexcept;
+  size_type bucket_count() const noexcept;
+  float load_factor() const noexcept;
+  float max_load_factor() const noexcept;
+
+  void clear() noexcept;
+  void reserve(size_type);
+  void rehash(size_type);
+
+  _namespace(std)::pair<iterator, bool> insert(const value_type&);
+  _namespace(std)::pair<iterator, bool> insert(value_type&&);
+  iterator insert(const_iterator, const value_type&);
+  iterator insert(const_iterator, value_type&&);
+  template<typename InputIter> void insert(InputIter, InputIter);
+  void insert(_namespace(std)::initializer_list<value_type>);
+  template<typename... Args>
+  _namespace(std)::pair<iterator, bool> emplace(Args&&...);
+  template<typename... Args>
+  iterator emplace_hint(const_iterator, Args&&...);
+
+  iterator erase(const_iterator) noexcept;
+  template<typename Iter, typename = _namespace(std)::enable_if_t<
+      _namespace(std)::is_same<Iter, iterator>::value>>
+  iterator erase(Iter) noexcept;
+  iterator erase(const_iterator, const_iterator) noexcept;
+  template<typename K, typename = _namespace(std)::enable_if_t<
+      !_namespace(std)::is_same<K, iterator>::value &&
+      !_namespace(std)::is_same<K, const_iterator>::value>>
+  size_type erase(const K&);
+
+  template<typename K> iterator find(const K&);
+  template<typename K> const_iterator find(const K&) const;
+  template<typename K> size_type count(const K&) const;
+  template<typename K> _namespace(std)::pair<iterator, iterator>
+      equal_range(const K&);
+  template<typename K> _namespace(std)::pair<const_iterator, const_iterator>
+      equal_range(const K&) const;
+
+  void swap(flat_hash_table&) noexcept;
+
+  hasher hash_function() const;
+  key_equal key_eq() const;
+  allocator_type get_allocator() const;
+
+ protected:
+  template<typename K>
+  _namespace(std)::pair<size_type, bool> find_or_prepare_insert_(const K&,
+                                                                 size_t);
+  template<typename... Args>
+  void construct_at_(size_type, size_t, Args&&...);
+  template<typename K> size_t hash_(const K&) const;
+
+  iterator iterator_at_(size_type) noexcept;
+  const_iterator iterator_at_(size_type) const noexcept;
+
+ private:
+  static size_type h1_(size_t) noexcept;
+  static flat_hash_ctrl_t h2_(size_t) noexcept;
+  static bool is_full_(flat_hash_ctrl_t) noexcept;
+  static size_type normalize_capacity_(size_type) noexcept;
+  static size_type capacity_to_growth_(size_type) noexcept;
+  static size_type growth_to_capacity_(size_type) noexcept;
+
+  template<typename K> size_type find_index_(const K&, size_t) const;
+  size_type find_first_non_full_(size_t) const noexcept;
+  size_type prepare_insert_(size_t);
+  void commit_insert_(size_type, size_t) noexcept;
+  void set_ctrl_(size_type, flat_hash_ctrl_t) noexcept;
+  void erase_at_(size_type) noexcept;
+  void destroy_slots_() noexcept;
+  void deallocate_() noexcept;
+  void resize_(size_type);
+  void rehash_and_grow_if_necessary_();
+
+  flat_hash_ctrl_t* ctrl_ = const_cast<flat_hash_ctrl_t*>(
+      &flat_hash_empty_group[0]);
+  value_type* slots_ = nullptr;
+  size_type capacity_ = 0;  // Zero, or a power of 2 minus 1.
+  size_type size_ = 0;
+  size_type growth_left_ = 0;  // Inserts into empty slots before rehash.
+  _namespace(std)::tuple<hasher, key_equal, allocator_type> params_;
+};
+
+template<typename Key, typename Value, typename KeyOf,
+         typename Hash, typename Pred, typename Alloc>
+bool operator==(const flat_hash_table<Key, Value, KeyOf, Hash, Pred, Alloc>&,
+                const flat_hash_table<Key, Value, KeyOf, Hash, Pred, Alloc>&);
+template<typename Key, typename Value, typename KeyOf,
+         typename Hash, typename Pred, typename Alloc>
+bool operator!=(const flat_hash_table<Key, Value, KeyOf, Hash, Pred, Alloc>&,
+                const flat_hash_table<Key, Value, KeyOf, Hash, Pred, Alloc>&);
+
+
+} /* namespace ilias::impl */
+_namespace_end(ilias)
+
+#include <ilias/flat_hash_table-inl.h>
+
+#endif /* _ILIAS_FLAT_HASH_TABLE_H_ */
@@ -316,9 +316,11 @@ auto linked_list<T, Tag>::merge(const_iterator b1, const_iterator e1,
     /* Find b2_e, such that [b2..b2_e) < b1 && !(b2_e < b1). */
     const_iterator b2_e = find_if_not(next(b2), e2,
                                       bind(ref(compare), _1, ref(*b1)));
+    /* If [b2..e2) follows [b1..e1) directly, e1 moves with b2. */
+    if (e1 == b2) e1 = b2_e;
     /* Splice [b2..b2_e) into list, before b1. */
     splice(b1, b2, b2_e);
-    if (b2 == b2_e) return;  // Last merge completed.
+    if (b2_e == e2) return;  // Last merge completed.
 
     b2 = b2_e;  // Update b2, everything before b2_e now lives before b1.
 
@@ -330,8 +332,9 @@ auto linked_list<T, Tag>::merge(const_iterator b1, const_iterator e1,
   /*
    * b1 == e1  -- because loop guard
    * b2 != e2  -- because if b2 == e2, the code above forces an early return
+   * If b1 == b2, [b2..e2) already follows [b1..e1).
    */
-  splice(b1, b2, e2);
+  if (b1 != b2) splice(b1, b2, e2);
 }
 
 template<typename T, class Tag>
@@ -341,6 +344,7 @@ auto linked_list<T, Tag>::sort(const_iterator b, const_iterator e,
   using _namespace(std)::ref;
   using _namespace(std)::distance;
   using _namespace(std)::next;
+  using _namespace(std)::prev;
 
   if (dist < 2) {
     assert(dist == size_t(distance(b, e)));
@@ -350,8 +354,17 @@ auto linked_list<T, Tag>::sort(const_iterator b, const_iterator e,
   size_t half_dist = dist / 2;
   const_iterator halfway_point = next(b, half_dist);
 
+  /*
+   * Sorting moves the elements b and halfway_point,
+   * so each half is found again from its predecessor.
+   */
+  const const_iterator b_pred = prev(b);
   sort(b, halfway_point, ref(compare), half_dist);
+  const const_iterator halfway_pred = prev(halfway_point);
   sort(halfway_point, e, ref(compare), dist - half_dist);
+
+  b = next(b_pred);
+  halfway_point = next(halfway_pred);
   merge(b, halfway_point, halfway_point, e, ref(compare));
 }
 
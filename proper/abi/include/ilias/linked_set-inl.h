@@ -346,6 +346,8 @@ auto basic_linked_set::link_fixup_(element* elem, Augments&&... augments)
 
       auto subtree_root = rotate_(pp, 1 - ppidx);
       assert(subtree_root == p);
+      toggle_color(p);
+      toggle_color(pp);
       apply_augmentations_(pp, ref(augments)...);
 
       do {
@@ -363,104 +365,282 @@ auto basic_linked_set::link_fixup_(element* elem, Augments&&... augments)
   return;
 }
 
-inline auto basic_linked_set::node_swap_(element* x, element* y) noexcept ->
-    void {
-  using _namespace(std)::swap;
-
-  swap(x->parent_, y->parent_);  // Color swap is required here.
-  swap(x->children_, y->children_);
-}
-
+/*
+ * Remove leaf elem from the tree and restore the red-black properties.
+ *
+ * Removing a black leaf leaves its former position one black short;
+ * the deficit is either resolved locally by recoloring and rotating
+ * around the sibling, or moved up to the parent.
+ */
 template<typename... Augments>
 auto basic_linked_set::unlink_fixup_(element* elem, Augments&&... augments)
     noexcept -> void {
   using _namespace(std)::none_of;
-  using _namespace(std)::all_of;
   using _namespace(std)::ref;
 
   assert(none_of(elem->children_.begin(),
                  elem->children_.end(),
                  [](element* p) { return p != nullptr; }));
-  element* n = elem;
-  if (n->red()) return;
   element* p = elem->parent();
   if (p == nullptr) {
-    assert(root_ == n);
+    assert(root_ == elem);
     root_ = nullptr;
-    n->parent_ = 0;
-    return;
-  } else if (p->red()) {
-    toggle_color(p);
-    p->children_[n->pidx_()] = nullptr;
-    n->parent_ = 0;
-    do {
-      apply_augmentations_(p, ref(augments)...);
-      p = p->parent();
-    } while (p != nullptr);
+    elem->parent_ = 0;
     return;
   }
-  p->children_[n->pidx_()] = nullptr;
-  n->parent_ = 0;
-  n = p;
-
-  for (;;) {
-    apply_augmentations_(n, ref(augments)...);
-    p = n->parent();
-
-    if (p != nullptr) {
-      element* s = n->sibling();
-      assert(s != nullptr);
-      if (s->red()) {
-        assert(s == n->sibling());
-        element* pp = rotate_(p, n->pidx_());
-        assert(s == pp);
-        toggle_color(p);
-        toggle_color(pp);
-        s = n->sibling();
-      }
-      if (p->black() && s->black() &&
-          all_of(s->children_.begin(), s->children_.end(),
-                 [](element* p) { return p == nullptr || p->black(); })) {
-        assert(s == n->sibling());
-        toggle_color(s);
-        apply_augmentations_(n, ref(augments)...);
-        n = p;
-        continue;  // RECURSE
-      } else if (p->red() &&
-                 all_of(s->children_.begin(), s->children_.end(),
-                        [](element* p) {
-                          return p == nullptr || p->black();
-                        })) {
-        assert(s == n->sibling());
-        toggle_color(s);
+
+  const bool deficit = elem->black();
+  unsigned int idx = elem->pidx_();
+  p->children_[idx] = nullptr;
+  elem->parent_ = 0;
+
+  /* Subtree p->child(idx) is one black short. */
+  while (deficit) {
+    element* s = p->child(1U - idx);
+    assert(s != nullptr);
+    if (s->red()) {
+      rotate_(p, idx);
+      toggle_color(s);
+      toggle_color(p);
+      s = p->child(1U - idx);
+      assert(s != nullptr && s->black());
+    }
+
+    element* near = s->child(idx);
+    element* far = s->child(1U - idx);
+    if ((near == nullptr || near->black()) &&
+        (far == nullptr || far->black())) {
+      toggle_color(s);
+      if (p->red()) {
         toggle_color(p);
-      } else {
-        if (s->children_[n->pidx_()]->red()) {
-          assert(s == n->sibling());
-          toggle_color(s->children_[n->pidx_()]);
-          toggle_color(s);
-          rotate_(s, 1 - n->pidx_());
-          apply_augmentations_(s, ref(augments)...);
-          apply_augmentations_(s->parent(), ref(augments)...);
-          s = n->sibling();
-        }
-
-        assert(s == n->sibling());
-        set_color(s, p->rb_flag_());
-        set_color(p, BLACK);
-        set_color(s->children_[1 - n->pidx_()], BLACK);
-        rotate_(p, n->pidx_());
+        break;
       }
+
+      /* Move the deficit up. */
+      apply_augmentations_(p, ref(augments)...);
+      element*const pp = p->parent();
+      if (pp == nullptr) break;
+      idx = p->pidx_();
+      p = pp;
+      continue;  // RECURSE
     }
 
+    if (far == nullptr || far->black()) {
+      rotate_(s, 1U - idx);
+      toggle_color(near);
+      toggle_color(s);
+      apply_augmentations_(s, ref(augments)...);
+      far = s;
+      s = near;
+    }
+
+    set_color(s, p->rb_flag_());
+    set_color(p, BLACK);
+    set_color(far, BLACK);
+    rotate_(p, idx);
     break;  // GUARD
   }
 
-  p = n;
-  while ((p = p->parent()) != nullptr)
+  for (; p != nullptr; p = p->parent())
     apply_augmentations_(p, ref(augments)...);
 }
 
+/*
+ * Link n elements, produced in order by gen, into an empty set.
+ *
+ * The tree is built top down by splitting each range at its middle,
+ * so every level except the deepest is complete.  Elements on the
+ * deepest, incomplete level are colored red, all others black.
+ * Since the tree is built without any rotations, this takes O(n) time.
+ */
+template<typename Gen, typename... Augments>
+auto basic_linked_set::link_sorted(size_t n, Gen gen, Augments&&... augments)
+    noexcept -> void {
+  assert_msg(root_ == nullptr, "link_sorted requires an empty set");
+
+  unsigned int red_depth = 0;
+  for (size_t i = n + 1U; i > 1U; i >>= 1) ++red_depth;
+  root_ = build_(n, 0, red_depth, gen, augments...);
+}
+
+/*
+ * Unlink all elements in the range [b, e), invoking visitor on each.
+ *
+ * The range is split off and the remaining parts joined together,
+ * so only the visitor is invoked per element.
+ */
+template<typename Visitor, typename... Augments>
+auto basic_linked_set::unlink_range(iterator b, iterator e, Visitor visitor,
+                                    Augments&&... augments) noexcept -> void {
+  using _namespace(std)::move;
+
+  assert(b.set_ == this && e.set_ == this);
+  if (b == e) return;
+
+  basic_linked_set mid = split(b, augments...);
+  basic_linked_set tail = mid.split(iterator(&mid, e.elem_), augments...);
+  join(move(tail), augments...);
+  mid.unlink_all(move(visitor));
+}
+
+/*
+ * Split the set at pos.
+ *
+ * Elements before pos stay in this set, the returned set holds pos and
+ * all elements after it.
+ *
+ * Walks from pos to the root, joining each ancestor and its other
+ * subtree to the left or right result.  Takes O(log^2 n) time.
+ */
+template<typename... Augments>
+auto basic_linked_set::split(iterator pos, Augments&&... augments) noexcept ->
+    basic_linked_set {
+  basic_linked_set rv;
+  element*const x = pos.elem_;
+  assert(pos.set_ == this);
+  if (x == nullptr) return rv;
+
+  unsigned int h = black_height_(x);
+  element* p = x->parent();
+  unsigned int idx = (p != nullptr ? x->pidx_() : 0U);
+  unsigned int l_bh = h - (x->black() ? 1U : 0U);
+  unsigned int r_bh = l_bh;
+  element* l = x->children_[0];
+  element* r = x->children_[1];
+
+  x->children_[0] = x->children_[1] = nullptr;
+  x->parent_ = 0;
+  r = join_(nullptr, 0, x, r, r_bh, r_bh, augments...);
+
+  while (p != nullptr) {
+    element*const pp = p->parent();
+    const unsigned int pidx = (pp != nullptr ? p->pidx_() : 0U);
+    element*const s = p->children_[1U - idx];
+    const unsigned int p_h = h + (p->black() ? 1U : 0U);
+
+    /* s has the same black height as the subtree that held x. */
+    if (idx == 1U)
+      l = join_(s, h, p, l, l_bh, l_bh, augments...);
+    else
+      r = join_(r, r_bh, p, s, h, r_bh, augments...);
+
+    h = p_h;
+    p = pp;
+    idx = pidx;
+  }
+
+  root_ = detach_(l, l_bh);
+  rv.root_ = detach_(r, r_bh);
+  return rv;
+}
+
+/*
+ * Append all elements in o to this set.
+ *
+ * All elements in o must order at or after all elements in this set.
+ * The first element of o is used as the pivot to join both trees.
+ */
+template<typename... Augments>
+auto basic_linked_set::join(basic_linked_set&& o, Augments&&... augments)
+    noexcept -> void {
+  using _namespace(std)::exchange;
+
+  if (o.root_ == nullptr) return;
+  if (root_ == nullptr) {
+    swap(o);
+    return;
+  }
+
+  element*const k = o.unlink(o.begin(), augments...);
+  const unsigned int l_bh = black_height_(root_);
+  const unsigned int r_bh = black_height_(o.root_);
+  unsigned int bh;
+  root_ = join_(root_, l_bh, k, exchange(o.root_, nullptr), r_bh, bh,
+                augments...);
+}
+
+template<typename Gen, typename... Augments>
+auto basic_linked_set::build_(size_t n, unsigned int depth,
+                              unsigned int red_depth, Gen& gen,
+                              Augments&... augments) noexcept -> element* {
+  using _namespace(std)::ref;
+
+  if (n == 0) return nullptr;
+
+  const size_t n_left = (n - 1U) / 2U;
+  element*const l = build_(n_left, depth + 1U, red_depth, gen, augments...);
+  element*const e = gen();
+  assert(e->parent_ == 0 &&
+         e->children_[0] == nullptr && e->children_[1] == nullptr);
+  element*const r = build_(n - 1U - n_left, depth + 1U, red_depth, gen,
+                           augments...);
+
+  e->children_[0] = l;
+  e->children_[1] = r;
+  e->parent_ = (depth == red_depth ? RED : BLACK);
+  if (l) l->parent_ = l->rb_flag_() | reinterpret_cast<uintptr_t>(e);
+  if (r) r->parent_ = r->rb_flag_() | reinterpret_cast<uintptr_t>(e);
+  apply_augmentations_(e, ref(augments)...);
+  return e;
+}
+
+/*
+ * Join trees l and r, with pivot k in between.
+ *
+ * l_bh and r_bh are the black heights of l and r, including their roots.
+ * The root of the shorter tree is attached, together with k, along the
+ * inner spine of the taller tree, at a black node of equal black height.
+ * The insert fixup then restores the red-black properties.
+ *
+ * Returns the root of the joined tree, and its black height in bh.
+ */
+template<typename... Augments>
+auto basic_linked_set::join_(element* l, unsigned int l_bh, element* k,
+                             element* r, unsigned int r_bh, unsigned int& bh,
+                             Augments&&... augments) noexcept -> element* {
+  l = detach_(l, l_bh);
+  r = detach_(r, r_bh);
+
+  if (l_bh == r_bh) {
+    k->children_[0] = l;
+    k->children_[1] = r;
+    k->parent_ = BLACK;
+    if (l) l->parent_ = reinterpret_cast<uintptr_t>(k);
+    if (r) r->parent_ = reinterpret_cast<uintptr_t>(k);
+    apply_augmentations_(k, _namespace(std)::ref(augments)...);
+    bh = l_bh + 1U;
+    return k;
+  }
+
+  /* Descend along spine i of the taller tree. */
+  const unsigned int i = (l_bh > r_bh ? 1U : 0U);
+  element*const tall = (i == 1U ? l : r);
+  element*const shrt = (i == 1U ? r : l);
+  const unsigned int shrt_bh = (i == 1U ? r_bh : l_bh);
+  unsigned int h = (i == 1U ? l_bh : r_bh);
+  element* p = nullptr;
+  element* c = tall;
+  while (h > shrt_bh || (c != nullptr && c->red())) {
+    if (c->black()) --h;
+    p = c;
+    c = c->child(i);
+  }
+  assert(p != nullptr);
+
+  k->children_[1U - i] = c;
+  k->children_[i] = shrt;
+  if (c) c->parent_ = c->rb_flag_() | reinterpret_cast<uintptr_t>(k);
+  if (shrt) shrt->parent_ = reinterpret_cast<uintptr_t>(k);
+  p->children_[i] = k;
+  k->parent_ = reinterpret_cast<uintptr_t>(p) | RED;
+
+  basic_linked_set tmp;
+  tmp.root_ = tall;
+  tmp.link_fixup_(k, augments...);
+  bh = black_height_(tmp.root_);
+  return _namespace(std)::exchange(tmp.root_, nullptr);
+}
+
 template<typename Augment0, typename... Augment>
 auto basic_linked_set::apply_augmentations_(element* e, Augment0 augment0,
                                             Augment&&... augments)
@@ -542,7 +722,7 @@ inline auto basic_linked_set::iterator::operator++() noexcept -> iterator& {
     elem_ = elem_->succ();
   } else if (set_ != nullptr) {
     elem_ = set_->root_;
-    while (elem_) elem_ = elem_->left();
+    while (elem_ && elem_->left()) elem_ = elem_->left();
   }
   return *this;
 }
@@ -558,7 +738,7 @@ inline auto basic_linked_set::iterator::operator--() noexcept -> iterator& {
     elem_ = elem_->pred();
   } else if (set_ != nullptr) {
     elem_ = set_->root_;
-    while (elem_) elem_ = elem_->right();
+    while (elem_ && elem_->right()) elem_ = elem_->right();
   }
   return *this;
 }
@@ -583,21 +763,21 @@ inline auto basic_linked_set::iterator::operator->() const noexcept ->
 template<typename Derived, class Tag>
 auto linked_set_element<Derived, Tag>::parent() const noexcept ->
     const Derived* {
-  return static_cast<Derived>(static_cast<linked_set_element>(
+  return static_cast<const Derived*>(static_cast<const linked_set_element*>(
       basic_linked_set::element::parent()));
 }
 
 template<typename Derived, class Tag>
 auto linked_set_element<Derived, Tag>::left() const noexcept ->
     const Derived* {
-  return static_cast<Derived>(static_cast<linked_set_element>(
+  return static_cast<const Derived*>(static_cast<const linked_set_element*>(
       basic_linked_set::element::left()));
 }
 
 template<typename Derived, class Tag>
 auto linked_set_element<Derived, Tag>::right() const noexcept ->
     const Derived* {
-  return static_cast<Derived>(static_cast<linked_set_element>(
+  return static_cast<const Derived*>(static_cast<const linked_set_element*>(
       basic_linked_set::element::right()));
 }
 
@@ -669,6 +849,43 @@ auto linked_set<T, Tag, Cmp, Augments...>::unlink_all(Visitor v) -> void {
                                });
 }
 
+template<typename T, class Tag, typename Cmp, typename... Augments>
+template<typename Iter>
+auto linked_set<T, Tag, Cmp, Augments...>::link_sorted(Iter b, Iter e)
+    noexcept -> void {
+  link_sorted_(b, e, _namespace(std)::index_sequence_for<Augments...>());
+}
+
+template<typename T, class Tag, typename Cmp, typename... Augments>
+auto linked_set<T, Tag, Cmp, Augments...>::unlink(const_iterator b,
+                                                  const_iterator e)
+    noexcept -> void {
+  unlink_range_(b, e, [](pointer) { /* SKIP */ },
+                _namespace(std)::index_sequence_for<Augments...>());
+}
+
+template<typename T, class Tag, typename Cmp, typename... Augments>
+template<typename Visitor>
+auto linked_set<T, Tag, Cmp, Augments...>::unlink(const_iterator b,
+                                                  const_iterator e,
+                                                  Visitor v) -> void {
+  unlink_range_(b, e, _namespace(std)::move(v),
+                _namespace(std)::index_sequence_for<Augments...>());
+}
+
+template<typename T, class Tag, typename Cmp, typename... Augments>
+auto linked_set<T, Tag, Cmp, Augments...>::split(const_iterator pos)
+    noexcept -> linked_set {
+  return split_(pos, _namespace(std)::index_sequence_for<Augments...>());
+}
+
+template<typename T, class Tag, typename Cmp, typename... Augments>
+auto linked_set<T, Tag, Cmp, Augments...>::join(linked_set&& o) noexcept ->
+    void {
+  join_(_namespace(std)::move(o),
+        _namespace(std)::index_sequence_for<Augments...>());
+}
+
 template<typename T, class Tag, typename Cmp, typename... Augments>
 auto linked_set<T, Tag, Cmp, Augments...>::root() noexcept ->
     iterator {
@@ -714,7 +931,7 @@ auto linked_set<T, Tag, Cmp, Augments...>::begin() const noexcept ->
 template<typename T, class Tag, typename Cmp, typename... Augments>
 auto linked_set<T, Tag, Cmp, Augments...>::end() const noexcept ->
     const_iterator {
-  return const_iterator(basic_linked_set::begin());
+  return const_iterator(basic_linked_set::end());
 }
 
 template<typename T, class Tag, typename Cmp, typename... Augments>
@@ -924,6 +1141,75 @@ auto linked_set<T, Tag, Cmp, Augments...>::unlink_(
       bind(&invoke_augment_<Augments>, cref(get<Idx>(augments_)), _1)...));
 }
 
+template<typename T, class Tag, typename Cmp, typename... Augments>
+template<typename Iter, size_t... Idx>
+auto linked_set<T, Tag, Cmp, Augments...>::link_sorted_(
+    Iter b, Iter e, _namespace(std)::index_sequence<Idx...>) noexcept ->
+    void {
+  using _namespace(std)::bind;
+  using _namespace(std)::placeholders::_1;
+  using _namespace(std)::cref;
+  using _namespace(std)::get;
+
+  assert(_namespace(std)::is_sorted(b, e, cref(cmp_.impl)));
+
+  basic_linked_set::link_sorted(
+      _namespace(std)::distance(b, e),
+      [&b]() -> element* { return down_cast_(&*b++); },
+      bind(&invoke_augment_<Augments>, cref(get<Idx>(augments_)), _1)...);
+}
+
+template<typename T, class Tag, typename Cmp, typename... Augments>
+template<typename Visitor, size_t... Idx>
+auto linked_set<T, Tag, Cmp, Augments...>::unlink_range_(
+    const_iterator b, const_iterator e, Visitor v,
+    _namespace(std)::index_sequence<Idx...>) -> void {
+  using _namespace(std)::bind;
+  using _namespace(std)::placeholders::_1;
+  using _namespace(std)::cref;
+  using _namespace(std)::get;
+
+  basic_linked_set::unlink_range(
+      b.impl_, e.impl_,
+      [&v](element* x) { v(up_cast_(x)); },
+      bind(&invoke_augment_<Augments>, cref(get<Idx>(augments_)), _1)...);
+}
+
+template<typename T, class Tag, typename Cmp, typename... Augments>
+template<size_t... Idx>
+auto linked_set<T, Tag, Cmp, Augments...>::split_(
+    const_iterator pos, _namespace(std)::index_sequence<Idx...>) noexcept ->
+    linked_set {
+  using _namespace(std)::bind;
+  using _namespace(std)::placeholders::_1;
+  using _namespace(std)::cref;
+  using _namespace(std)::get;
+
+  linked_set rv(cmp_.impl);
+  rv.augments_ = augments_;
+  static_cast<basic_linked_set&>(rv) = basic_linked_set::split(
+      pos.impl_,
+      bind(&invoke_augment_<Augments>, cref(get<Idx>(augments_)), _1)...);
+  return rv;
+}
+
+template<typename T, class Tag, typename Cmp, typename... Augments>
+template<size_t... Idx>
+auto linked_set<T, Tag, Cmp, Augments...>::join_(
+    linked_set&& o, _namespace(std)::index_sequence<Idx...>) noexcept ->
+    void {
+  using _namespace(std)::bind;
+  using _namespace(std)::placeholders::_1;
+  using _namespace(std)::cref;
+  using _namespace(std)::get;
+
+  assert(empty() || o.empty() || !cmp_.impl(*o.begin(), *rbegin()));
+
+  basic_linked_set::join(
+      static_cast<basic_linked_set&&>(o),
+      bind(&invoke_augment_<Augments>, cref(get<Idx>(augments_)), _1)...);
+}
+
 template<typename T, class Tag, typename Cmp, typename... Augments>
 auto linked_set<T, Tag, Cmp, Augments...>::down_cast_(pointer p)
     noexcept -> element* {
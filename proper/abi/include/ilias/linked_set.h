@@ -71,10 +71,22 @@ class basic_linked_set {
   template<typename... Augments>
   element* unlink(iterator, Augments&&...) noexcept;
 
+  /* Bulk operations. */
+  template<typename Gen, typename... Augments>
+  void link_sorted(size_t, Gen, Augments&&...) noexcept;
+  template<typename Visitor, typename... Augments>
+  void unlink_range(iterator, iterator, Visitor, Augments&&...) noexcept;
+  template<typename... Augments>
+  basic_linked_set split(iterator, Augments&&...) noexcept;
+  template<typename... Augments>
+  void join(basic_linked_set&&, Augments&&...) noexcept;
+
   iterator root() const noexcept;
   iterator begin() const noexcept;
   iterator end() const noexcept;
 
+  bool verify() const noexcept;
+
   template<typename T, typename Comparator>
   iterator find(const T&, Comparator) const;
   template<typename T, typename Comparator>
@@ -106,6 +118,18 @@ class basic_linked_set {
   /* Rotation operation. */
   element* rotate_(element*, unsigned int) noexcept;
 
+  /* Bulk operation support functions. */
+  template<typename Gen, typename... Augments>
+  static element* build_(size_t, unsigned int, unsigned int, Gen&,
+                         Augments&...) noexcept;
+  static unsigned int black_height_(const element*) noexcept;
+  static unsigned int verify_(const element*) noexcept;
+  static element* detach_(element*, unsigned int&) noexcept;
+  template<typename... Augments>
+  static element* join_(element*, unsigned int, element*,
+                        element*, unsigned int, unsigned int&,
+                        Augments&&...) noexcept;
+
   /* Augmentation operation. */
   static void apply_augmentations_(element*) noexcept {}
   template<typename Augment0, typename... Augment>
@@ -226,8 +250,15 @@ class linked_set
   pointer unlink(const_pointer) noexcept;
   void unlink_all() noexcept;
   template<typename Visitor> void unlink_all(Visitor);
+  template<typename Iter> void link_sorted(Iter, Iter) noexcept;
+  void unlink(const_iterator, const_iterator) noexcept;
+  template<typename Visitor> void unlink(const_iterator, const_iterator,
+                                         Visitor);
+  linked_set split(const_iterator) noexcept;
+  void join(linked_set&&) noexcept;
 
   using basic_linked_set::empty;
+  using basic_linked_set::verify;
 
   iterator root() noexcept;
   const_iterator root() const noexcept;
@@ -278,6 +309,17 @@ class linked_set
   template<size_t... Idx>
   pointer unlink_(
       const_pointer, _namespace(std)::index_sequence<Idx...>) noexcept;
+  template<typename Iter, size_t... Idx>
+  void link_sorted_(Iter, Iter, _namespace(std)::index_sequence<Idx...>)
+      noexcept;
+  template<typename Visitor, size_t... Idx>
+  void unlink_range_(const_iterator, const_iterator, Visitor,
+                     _namespace(std)::index_sequence<Idx...>);
+  template<size_t... Idx>
+  linked_set split_(const_iterator, _namespace(std)::index_sequence<Idx...>)
+      noexcept;
+  template<size_t... Idx>
+  void join_(linked_set&&, _namespace(std)::index_sequence<Idx...>) noexcept;
 
   static element* down_cast_(pointer) noexcept;
   static element* down_cast_(const_pointer) noexcept;
@@ -8,6 +8,7 @@ _namespace_begin(ilias)
 class stats_group;
 struct global_stats_group;
 class stats_counter;
+class stats_gauge;
 
 _namespace_end(ilias)
 
@@ -46,6 +46,22 @@ inline auto stats_counter::sub(uint64_t n) noexcept -> void {
 }
 
 
+inline stats_gauge::stats_gauge(stats_group& parent,
+                                _namespace(std)::string_ref name,
+                                function_type fn, const void* arg) noexcept
+: stats_leaf(parent, name),
+  fn_(fn),
+  arg_(arg)
+{
+  assert(fn_ != nullptr);
+  init();
+}
+
+inline auto stats_gauge::get() const noexcept -> uint64_t {
+  return (*fn_)(arg_);
+}
+
+
 template<size_t N>
 stats_histogram<N>::stats_histogram(stats_group& parent,
                                     _namespace(std)::string_ref name) noexcept
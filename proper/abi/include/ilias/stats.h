@@ -128,6 +128,30 @@ class stats_counter final
   _namespace(std)::atomic<uint64_t> counter_;
 };
 
+/*
+ * Unsigned 64-bit value, computed by a function when the statistic is read.
+ *
+ * The function must not block on locks that may be held while allocating
+ * memory, as printing the statistic may allocate.
+ */
+class stats_gauge final
+: public stats_leaf
+{
+ public:
+  using function_type = uint64_t (*)(const void*);
+
+  stats_gauge(stats_group&, _namespace(std)::string_ref,
+              function_type, const void*) noexcept;
+  ~stats_gauge() noexcept override;
+
+  uint64_t get() const noexcept;
+  void as_properties(_namespace(std)::ostream&) const override;
+
+ private:
+  const function_type fn_;
+  const void*const arg_;
+};
+
 template<size_t N>
 class stats_histogram final
 : public stats_leaf
@@ -0,0 +1,109 @@
+#ifndef _NUMERIC_INL_H_
+#define _NUMERIC_INL_H_
+
+#include <numeric>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
+#include <stdimpl/parallel.h>
+
+_namespace_begin(std)
+
+
+template<typename InputIterator, typename T>
+T accumulate(InputIterator b, InputIterator e, T init) {
+  return accumulate(b, e, move(init), plus<void>());
+}
+
+template<typename InputIterator, typename T, typename BinaryOperation>
+T accumulate(InputIterator b, InputIterator e, T init,
+             BinaryOperation operation) {
+  while (b != e) {
+    init = operation(move(init), *b);
+    ++b;
+  }
+  return init;
+}
+
+template<typename InputIterator>
+typename iterator_traits<InputIterator>::value_type reduce(InputIterator b,
+                                                           InputIterator e) {
+  using value_type = typename iterator_traits<InputIterator>::value_type;
+
+  return reduce(b, e, value_type(), plus<void>());
+}
+
+template<typename InputIterator, typename T>
+T reduce(InputIterator b, InputIterator e, T init) {
+  return reduce(b, e, move(init), plus<void>());
+}
+
+template<typename InputIterator, typename T, typename BinaryOperation>
+T reduce(InputIterator b, InputIterator e, T init,
+         BinaryOperation operation) {
+  return accumulate(b, e, move(init), ref(operation));
+}
+
+template<typename ExecutionPolicy, typename ForwardIterator>
+impl::enable_if_execution_policy_t<
+    ExecutionPolicy,
+    typename iterator_traits<ForwardIterator>::value_type>
+    reduce(ExecutionPolicy&& policy, ForwardIterator b, ForwardIterator e) {
+  using value_type = typename iterator_traits<ForwardIterator>::value_type;
+
+  return reduce(forward<ExecutionPolicy>(policy), b, e,
+                value_type(), plus<void>());
+}
+
+template<typename ExecutionPolicy, typename ForwardIterator, typename T>
+impl::enable_if_execution_policy_t<ExecutionPolicy, T> reduce(
+    ExecutionPolicy&& policy, ForwardIterator b, ForwardIterator e, T init) {
+  return reduce(forward<ExecutionPolicy>(policy), b, e,
+                move(init), plus<void>());
+}
+
+/*
+ * Parallel reduce.
+ *
+ * Each chunk is reduced into a partial result in a temporary buffer,
+ * after which the partial results are combined with init, in order.
+ * Chunks hold at least parallel_min_chunk elements, so none are empty.
+ */
+template<typename ExecutionPolicy, typename ForwardIterator, typename T,
+         typename BinaryOperation>
+impl::enable_if_execution_policy_t<ExecutionPolicy, T> reduce(
+    ExecutionPolicy&&, ForwardIterator b, ForwardIterator e, T init,
+    BinaryOperation operation) {
+  const size_t n = distance(b, e);
+  const size_t chunks =
+      (impl::parallel_splittable<ExecutionPolicy, ForwardIterator>::value ?
+       impl::parallel_chunks(n) :
+       1U);
+  if (chunks <= 1U) return reduce(b, e, move(init), ref(operation));
+
+  T* partial = get<0>(get_temporary_buffer<T>(chunks));
+  if (_predict_false(partial == nullptr))
+    return reduce(b, e, move(init), ref(operation));
+
+  auto job = [&](size_t i) {
+               ForwardIterator cb = next(b, n * i / chunks);
+               ForwardIterator ce = next(b, n * (i + 1U) / chunks);
+               T acc = *cb;
+               while (++cb != ce) acc = operation(move(acc), *cb);
+               new (&partial[i]) T(move(acc));
+             };
+  impl::parallel_run(chunks, job);
+
+  for (size_t i = 0; i < chunks; ++i) {
+    init = operation(move(init), move(partial[i]));
+    partial[i].~T();
+  }
+  return_temporary_buffer(partial);
+  return init;
+}
+
+
+_namespace_end(std)
+
+#endif /* _NUMERIC_INL_H_ */
@@ -1,6 +1,8 @@
 #ifndef _IMPL_CHAR_TRAITS_H_
 #define _IMPL_CHAR_TRAITS_H_
 
+#include <abi/ext/twoway.h>
+
 _namespace_begin(std)
 namespace impl {
 
@@ -178,12 +180,7 @@ struct traits_tester {
                       no)
       noexcept ->
       const typename CharT::char_type* {
-    using char_type = const typename CharT::char_type;
-
-    if (nlen > hlen) return nullptr;
-    for (char_type* i = h; i + nlen != h + hlen; ++i)
-      if (CharT::compare(i, n, nlen) == 0) return i;
-    return nullptr;
+    return abi::ext::twoway_find<CharT>(h, hlen, n, nlen);
   }
 
   /* strrfind selector implementation. */
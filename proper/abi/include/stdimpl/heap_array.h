@@ -77,6 +77,14 @@ class heap_array {
     return begin()[size_];
   }
 
+  void clear() noexcept {
+    if (!is_trivially_destructible<value_type>::value) {
+      while (size_ > 0)
+        ptr_[--size_].~value_type();
+    }
+    size_ = 0;
+  }
+
   void push_back(const value_type& v) { emplace_back(v); }
   void push_back(value_type&& v) { emplace_back(move(v)); }
 
@@ -0,0 +1,127 @@
+#ifndef _STDIMPL_PARALLEL_H_
+#define _STDIMPL_PARALLEL_H_
+
+#include <cdecl.h>
+#include <cstddef>
+#include <execution>
+#include <iterator>
+#include <type_traits>
+
+_namespace_begin(std)
+namespace impl {
+
+
+/*
+ * Backend that runs the chunks of parallel algorithms.
+ *
+ * The kernel installs a backend once it can run work on multiple CPUs.
+ * Until then (and if the backend reports a concurrency of 1),
+ * algorithms with a parallel execution policy run sequentially.
+ */
+class parallel_backend {
+ public:
+  using job_fn = void (*)(void*, size_t);
+
+  virtual ~parallel_backend() noexcept;
+
+  /* Number of CPUs the backend can run chunks on. */
+  virtual auto concurrency() const noexcept -> unsigned int = 0;
+
+  /*
+   * Invoke fn(arg, i) for each i in [0, n).
+   * Returns once all invocations have completed.
+   */
+  virtual void run(size_t n, job_fn fn, void* arg) noexcept = 0;
+};
+
+auto get_parallel_backend() noexcept -> parallel_backend*;
+auto set_parallel_backend(parallel_backend*) noexcept -> parallel_backend*;
+
+/*
+ * Number of CPUs in the system, recorded by the kernel during startup.
+ * This is 1 until recorded.
+ */
+auto get_cpu_count() noexcept -> unsigned int;
+void set_cpu_count(unsigned int) noexcept;
+
+/* Ranges with fewer elements per chunk than this aren't split up. */
+constexpr size_t parallel_min_chunk = 2048;
+
+/* Number of chunks to split a range of n elements into. */
+inline auto parallel_chunks(size_t n) noexcept -> size_t {
+  const parallel_backend* be = get_parallel_backend();
+  const size_t conc = (be == nullptr ? 1U : be->concurrency());
+  if (conc <= 1U) return 1;
+
+  /* Over-split, so a slow CPU doesn't hold up the others. */
+  size_t chunks = n / parallel_min_chunk;
+  if (chunks > 4U * conc) chunks = 4U * conc;
+  return (chunks == 0 ? 1 : chunks);
+}
+
+/*
+ * Invoke fn(i) for each i in [0, n), in parallel if possible.
+ * As per the standard, an exception escaping fn calls terminate().
+ */
+template<typename Fn>
+void parallel_run(size_t n, Fn& fn) noexcept {
+  parallel_backend* be = get_parallel_backend();
+
+  if (n <= 1U || be == nullptr || be->concurrency() <= 1U) {
+    for (size_t i = 0; i < n; ++i) fn(i);
+    return;
+  }
+  be->run(n,
+          [](void* arg, size_t i) { (*static_cast<Fn*>(arg))(i); },
+          &fn);
+}
+
+/* Test if all iterators are random access iterators. */
+template<typename... Iter> struct all_random_access;
+template<> struct all_random_access<> : true_type {};
+template<typename Iter, typename... Tail>
+struct all_random_access<Iter, Tail...>
+: integral_constant<bool,
+    is_base_of<random_access_iterator_tag,
+               typename iterator_traits<Iter>::iterator_category>::value &&
+    all_random_access<Tail...>::value>
+{};
+
+/*
+ * Test if ExecutionPolicy allows splitting ranges of Iter into chunks,
+ * for parallel processing.
+ */
+template<typename ExecutionPolicy, typename... Iter>
+struct parallel_splittable
+: integral_constant<bool,
+    is_parallel_policy<ExecutionPolicy>::value &&
+    all_random_access<Iter...>::value>
+{};
+
+/*
+ * Invoke fn(chunk_b, chunk_e) for consecutive chunks of [b, e).
+ * Only splits the range if the ExecutionPolicy permits it and
+ * the iterator is random access.
+ */
+template<typename ExecutionPolicy, typename Iter, typename Fn>
+void parallel_for_chunks(const ExecutionPolicy&, Iter b, Iter e, Fn fn) {
+  using _namespace(std)::distance;
+
+  if (!parallel_splittable<ExecutionPolicy, Iter>::value) {
+    fn(b, e);
+    return;
+  }
+
+  const size_t n = distance(b, e);
+  const size_t chunks = parallel_chunks(n);
+  auto job = [&](size_t i) {
+               fn(next(b, n * i / chunks), next(b, n * (i + 1U) / chunks));
+             };
+  parallel_run(chunks, job);
+}
+
+
+} /* namespace std::impl */
+_namespace_end(std)
+
+#endif /* _STDIMPL_PARALLEL_H_ */
@@ -301,9 +301,7 @@ inline constexpr auto char_traits<char32_t>::eq_int_type(
 template<typename Char, typename Traits, typename Alloc>
 basic_string<Char, Traits, Alloc>::basic_string(const allocator_type& alloc)
 : impl::alloc_base<Alloc>(alloc)
-{
-  reserve(1);
-}
+{}
 
 template<typename Char, typename Traits, typename Alloc>
 basic_string<Char, Traits, Alloc>::basic_string(const basic_string& s)
@@ -342,8 +340,8 @@ basic_string<Char, Traits, Alloc>::basic_string(size_type n, char_type c,
 : basic_string(alloc)
 {
   reserve(n);
-  len_ = n;
   traits_type::assign(begin(), n, c);
+  set_size_(n);
 }
 
 template<typename Char, typename Traits, typename Alloc>
@@ -386,16 +384,16 @@ basic_string<Char, Traits, Alloc>::basic_string(
 : basic_string(alloc)
 {
   reserve(s.size());
-  len_ = s.size();
   traits_type::copy(begin(), s.data(), s.size());
+  set_size_(s.size());
 }
 
 template<typename Char, typename Traits, typename Alloc>
 basic_string<Char, Traits, Alloc>::~basic_string() noexcept {
   if (use_external_()) {
     allocator_traits<allocator_type>::deallocate(this->get_allocator_(),
-                                                 data_.s, avail_);
-    data_.s.~pointer();
+                                                 data_.ext.s, avail_());
+    data_.ext.~ext_t();
   }
 }
 
@@ -422,7 +420,7 @@ auto basic_string<Char, Traits, Alloc>::operator=(char_type c) ->
     basic_string& {
   reserve(1U);
   traits_type::assign((*this)[0], c);
-  len_ = 1U;
+  set_size_(1U);
   return *this;
 }
 
@@ -443,14 +441,14 @@ template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::operator=(
     basic_string_ref<Char, Traits> s) -> basic_string& {
   reserve(s.size());
-  len_ = s.size();
   traits_type::copy(begin(), s.data(), s.size());
+  set_size_(s.size());
   return *this;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::begin() noexcept -> iterator {
-  return (use_external_() ? &*data_.s : &data_.immed[0]);
+  return (use_external_() ? &*data_.ext.s : &data_.immed[0]);
 }
 
 template<typename Char, typename Traits, typename Alloc>
@@ -461,7 +459,7 @@ auto basic_string<Char, Traits, Alloc>::end() noexcept -> iterator {
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::begin() const noexcept ->
     const_iterator {
-  return (use_external_() ? &*data_.s : &data_.immed[0]);
+  return (use_external_() ? &*data_.ext.s : &data_.immed[0]);
 }
 
 template<typename Char, typename Traits, typename Alloc>
@@ -518,7 +516,8 @@ auto basic_string<Char, Traits, Alloc>::crend() const noexcept ->
 
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::size() const noexcept -> size_type {
-  return len_;
+  if (use_external_()) return data_.ext.len;
+  return immed_cap - size_type(data_.immed[immed_cap]);
 }
 
 template<typename Char, typename Traits, typename Alloc>
@@ -529,9 +528,13 @@ auto basic_string<Char, Traits, Alloc>::length() const noexcept -> size_type {
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::max_size() const noexcept ->
     size_type {
-  /* Subtract 1, since we need to keep a nul character at the end. */
-  return allocator_traits<allocator_type>::max_size(this->get_allocator_()) -
-         1U;
+  /*
+   * Subtract 1, since we need to keep a nul character at the end.
+   * The allocated length must also leave external_flag clear.
+   */
+  return min(allocator_traits<allocator_type>::max_size(
+                 this->get_allocator_()),
+             external_flag - 1U) - 1U;
 }
 
 template<typename Char, typename Traits, typename Alloc>
@@ -542,45 +545,51 @@ auto basic_string<Char, Traits, Alloc>::resize(size_type sz) -> void {
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::resize(size_type sz, char_type c) ->
     void {
-  if (len_ >= sz) {
-    len_ = sz;
-    return;
+  const size_type len = size();
+  if (len < sz) {
+    reserve(sz);
+    traits_type::assign(begin() + len, sz - len, c);
   }
-
-  reserve(sz);
-  traits_type::assign(begin() + len_, sz - len_, c);
-  len_ = sz;
+  set_size_(sz);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::capacity() const noexcept ->
     size_type {
-  return avail_ - 1U;
+  return avail_() - 1U;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::reserve(size_type sz) -> void {
-  assert(avail_ >= immed_size);
+  assert(avail_() >= immed_size);
   assert(size() <= capacity());
-  assert(avail_ != 0);
 
   if (capacity() >= sz) return;
-
-  /* Try to double capacity if possible. */
-  size_type alloc_sz = max(sz + 1U, min(max_size(), 2U * size()));
+  if (_predict_false(sz > max_size()))
+    throw length_error("basic_string::reserve");
+
+  /*
+   * Grow by at least a factor 2 of the current allocation, so repeated
+   * appends are amortized constant time.
+   */
+  const size_type limit = max_size() + 1U;
+  size_type alloc_sz = (avail_() > limit / 2U ? limit : 2U * avail_());
+  alloc_sz = max(alloc_sz, sz + 1U);
+  alloc_sz = min(limit,
+                 (alloc_sz + alloc_granule - 1U) & ~(alloc_granule - 1U));
 
   /* Try to use resize (saves us a copy instruction). */
   if (use_external_()) {
     if (allocator_traits<allocator_type>::resize(this->get_allocator_(),
-                                                 data_.s, avail_,
+                                                 data_.ext.s, avail_(),
                                                  alloc_sz)) {
-      avail_ = alloc_sz;
+      data_.ext.avail = alloc_sz | external_flag;
       return;
     } else if (alloc_sz > sz + 1U &&
                allocator_traits<allocator_type>::resize(this->get_allocator_(),
-                                                        data_.s, avail_,
+                                                        data_.ext.s, avail_(),
                                                         sz + 1U)) {
-      avail_ = sz + 1U;
+      data_.ext.avail = (sz + 1U) | external_flag;
       return;
     }
   }
@@ -597,49 +606,54 @@ auto basic_string<Char, Traits, Alloc>::reserve(size_type sz) -> void {
                                                    alloc_sz);
   }
 
-  traits_type::copy(&*s, data(), size());
+  const size_type len = size();
+  traits_type::copy(&*s, data(), len);
   if (use_external_()) {
     allocator_traits<allocator_type>::deallocate(this->get_allocator_(),
-                                                 data_.s, avail_ + 1U);
-    data_.s = s;
+                                                 data_.ext.s, avail_());
+    data_.ext.s = s;
+    data_.ext.avail = alloc_sz | external_flag;
   } else {
-    new (static_cast<void*>(&data_.s)) pointer(s);
+    new (static_cast<void*>(&data_.ext)) ext_t{
+      move(s), len, alloc_sz | external_flag
+    };
   }
-  avail_ = alloc_sz;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::clear() noexcept -> void {
-  len_ = 0U;
+  set_size_(0U);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::empty() const noexcept -> bool {
-  return len_ > 0U;
+  return size() == 0U;
 }
 
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::shrink_to_fit() -> void {
-  assert(avail_ >= immed_size);
+  assert(avail_() >= immed_size);
   assert(size() <= capacity());
 
   if (!use_external_()) return;
 
-  if (size() < immed_size) {
+  const size_type len = size();
+  if (len <= immed_cap) {
     /* Switch over to storing string in immed. */
-    char_type tmp[immed_size];
-    traits_type::copy(&tmp[0], begin(), size());
+    pointer s = move(data_.ext.s);
+    const size_type avail = avail_();
+    data_.ext.~ext_t();
 
+    traits_type::copy(&data_.immed[0], &*s, len);
+    data_.immed[immed_cap] = char_type(immed_cap - len);
     allocator_traits<allocator_type>::deallocate(this->get_allocator_(),
-                                                 data_.s, avail_);
-    avail_ = immed_size;
-    traits_type::copy(begin(), &tmp[0], size());
-  } else if (avail_ > size() + 1U) {
+                                                 s, avail);
+  } else if (avail_() > len + 1U) {
     /* Try to use resize. */
     if (allocator_traits<allocator_type>::resize(this->get_allocator_(),
-                                                 data_.s, avail_,
-                                                 size() + 1U)) {
-      avail_ = size() + 1U;
+                                                 data_.ext.s, avail_(),
+                                                 len + 1U)) {
+      data_.ext.avail = (len + 1U) | external_flag;
       return;
     }
 
@@ -647,16 +661,16 @@ auto basic_string<Char, Traits, Alloc>::shrink_to_fit() -> void {
     pointer s;
     try {
       s = allocator_traits<allocator_type>::allocate(this->get_allocator_(),
-                                                     size() + 1U, this);
+                                                     len + 1U, this);
     } catch (const bad_alloc&) {
       return;
     }
 
-    traits_type::copy(s, data(), size());
+    traits_type::copy(&*s, data(), len);
     allocator_traits<allocator_type>::deallocate(this->get_allocator_(),
-                                                 data_.s, avail_);
-    avail_ = size() + 1U;
-    data_.s = s;
+                                                 data_.ext.s, avail_());
+    data_.ext.s = s;
+    data_.ext.avail = (len + 1U) | external_flag;
   }
 }
 
@@ -674,7 +688,7 @@ auto basic_string<Char, Traits, Alloc>::operator[](size_type i)
 
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::at(size_type i) -> reference {
-  if (_predict_false(i < 0 || i >= len_))
+  if (_predict_false(i < 0 || i >= size()))
     throw out_of_range("basic_string::at");
   return (*this)[i];
 }
@@ -682,7 +696,7 @@ auto basic_string<Char, Traits, Alloc>::at(size_type i) -> reference {
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::at(size_type i) const ->
     const_reference {
-  if (_predict_false(i < 0 || i >= len_))
+  if (_predict_false(i < 0 || i >= size()))
     throw out_of_range("basic_string::at");
   return (*this)[i];
 }
@@ -724,8 +738,10 @@ auto basic_string<Char, Traits, Alloc>::operator+=(const char_type* s) ->
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::operator+=(char_type c) ->
     basic_string& {
-  reserve(len_ + 1U);
-  traits_type::assign((*this)[len_++], c);
+  const size_type len = size();
+  reserve(len + 1U);
+  traits_type::assign((*this)[len], c);
+  set_size_(len + 1U);
   return *this;
 }
 
@@ -739,8 +755,8 @@ template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::operator+=(
     basic_string_ref<Char, Traits> s) -> basic_string& {
   reserve(size() + s.size());
-  traits_type::copy(begin() + len_, s.data(), s.size());
-  len_ += s.size();
+  traits_type::copy(begin() + size(), s.data(), s.size());
+  set_size_(size() + s.size());
   return *this;
 }
 
@@ -775,7 +791,7 @@ auto basic_string<Char, Traits, Alloc>::append(size_type n, char_type c) ->
     basic_string& {
   reserve(size() + n);
   traits_type::assign(begin() + size(), n, c);
-  len_ += n;
+  set_size_(size() + n);
   return *this;
 }
 
@@ -838,7 +854,7 @@ auto basic_string<Char, Traits, Alloc>::assign(size_type n, char_type c) ->
     basic_string& {
   reserve(n);
   traits_type::assign(begin(), n, c);
-  len_ = n;
+  set_size_(n);
   return *this;
 }
 
@@ -860,7 +876,7 @@ auto basic_string<Char, Traits, Alloc>::assign(
     basic_string_ref<Char, Traits> s) -> basic_string& {
   reserve(s.size());
   traits_type::copy(begin(), s.data(), s.size());
-  len_ = s.size();
+  set_size_(s.size());
   return *this;
 }
 
@@ -904,7 +920,7 @@ auto basic_string<Char, Traits, Alloc>::insert(
   traits_type::move(begin() + pos + s.size(), begin() + pos,
                     size() - pos);
   traits_type::copy(begin() + pos, s.data(), s.size());
-  len_ += s.size();
+  set_size_(size() + s.size());
   return *this;
 }
 
@@ -928,7 +944,7 @@ auto basic_string<Char, Traits, Alloc>::insert(size_type pos,
   reserve(size() + n);
   traits_type::move(begin() + pos + n, begin() + pos, size() - pos);
   traits_type::assign(begin() + pos, n, c);
-  len_ += n;
+  set_size_(size() + n);
   return *this;
 }
 
@@ -941,7 +957,7 @@ auto basic_string<Char, Traits, Alloc>::insert(const_iterator p,
   reserve(size() + n);
   traits_type::move(begin() + (p - begin()) + n, p, end() - p);
   traits_type::assign(begin() + (p - begin()), n, c);
-  len_ += n;
+  set_size_(size() + n);
   return begin() + (p - begin());
 }
 
@@ -975,7 +991,7 @@ auto basic_string<Char, Traits, Alloc>::insert(
   reserve(size() + s.size());
   traits_type::move(begin() + (p - begin()) + s.size(), p, end() - p);
   traits_type::copy(begin() + (p - begin()), s.data(), s.size());
-  len_ += s.size();
+  set_size_(size() + s.size());
   return begin() + (p - begin());
 }
 
@@ -988,7 +1004,7 @@ auto basic_string<Char, Traits, Alloc>::erase(size_type pos, size_type len) ->
   len = min(size() - pos, len);
   size_type pl = pos + len;
   traits_type::move(begin() + pos, begin() + pl, size() - pl);
-  len_ -= len;
+  set_size_(size() - len);
   return *this;
 }
 
@@ -997,7 +1013,7 @@ auto basic_string<Char, Traits, Alloc>::erase(const_iterator p) -> iterator {
   assert(p >= begin() && p < end());
 
   traits_type::move(begin() + (p - begin()), p + 1U, end() - (p + 1U));
-  --len_;
+  set_size_(size() - 1U);
   return begin() + (p - begin());
 }
 
@@ -1007,7 +1023,7 @@ auto basic_string<Char, Traits, Alloc>::erase(const_iterator b,
   assert(begin() <= b && b <= e && e <= end());
 
   traits_type::move(begin() + (b - begin()), e, end() - e);
-  len_ -= (e - b);
+  set_size_(size() - (e - b));
   return begin() + (b - begin());
 }
 
@@ -1071,7 +1087,7 @@ auto basic_string<Char, Traits, Alloc>::replace(
   reserve(size() - (e - b) + s.size());
   traits_type::move(begin() + (b - begin()) + s.size(), e, end() - e);
   traits_type::copy(begin() + (b - begin()), s.data(), s.size());
-  len_ = len_ - (e - b) + s.size();
+  set_size_(size() - (e - b) + s.size());
   return *this;
 }
 
@@ -1114,7 +1130,7 @@ auto basic_string<Char, Traits, Alloc>::replace(const_iterator b,
   reserve(size() - (e - b) + n);
   traits_type::move(begin() + (b - begin()) + n, e, end() - e);
   traits_type::assign(begin() + (b - begin()), n, c);
-  len_ = len_ - (e - b) + n;
+  set_size_(size() - (e - b) + n);
   return *this;
 }
 
@@ -1144,27 +1160,27 @@ auto basic_string<Char, Traits, Alloc>::swap(basic_string& other) -> void {
   if (!use_external_() && !other.use_external_()) {
     swap(data_.immed, other.data_.immed);
   } else if (use_external_() && other.use_external_()) {
-    swap(data_.s, other.data_.s);
-  } else if (!use_external_()) {  // other.use_external_() == true
-    pointer s = move_if_noexcept(other.data_.s);
-    other.data_.s.~pointer();
-    traits_type::copy(&other.data_.immed[0], data(), size());
-    new (static_cast<void*>(&data_.s)) pointer(move_if_noexcept(s));
-  } else {  // use_external_() == true && other.use_external_() == false
-    pointer s = move_if_noexcept(data_.s);
-    data_.s.~pointer();
-    traits_type::copy(&data_.immed[0], other.data(), other.size());
-    new (static_cast<void*>(&other.data_.s)) pointer(move_if_noexcept(s));
+    swap(data_.ext.s, other.data_.ext.s);
+    swap(data_.ext.len, other.data_.ext.len);
+    swap(data_.ext.avail, other.data_.ext.avail);
+  } else {
+    basic_string& e = (use_external_() ? *this : other);
+    basic_string& i = (use_external_() ? other : *this);
+
+    ext_t tmp{ move_if_noexcept(e.data_.ext.s),
+               e.data_.ext.len, e.data_.ext.avail };
+    e.data_.ext.~ext_t();
+    traits_type::copy(&e.data_.immed[0], &i.data_.immed[0], immed_size);
+    new (static_cast<void*>(&i.data_.ext)) ext_t{
+      move_if_noexcept(tmp.s), tmp.len, tmp.avail
+    };
   }
-
-  swap(len_, other.len_);
-  swap(avail_, other.avail_);
 }
 
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::pop_back() noexcept -> void {
   assert(size() > 0);
-  if (size() > 0) --len_;
+  if (size() > 0) set_size_(size() - 1U);
 }
 
 template<typename Char, typename Traits, typename Alloc>
@@ -1177,7 +1193,24 @@ auto basic_string<Char, Traits, Alloc>::c_str() const noexcept ->
 template<typename Char, typename Traits, typename Alloc>
 auto basic_string<Char, Traits, Alloc>::data() const noexcept ->
     const char_type* {
-  return (use_external_() ? &*data_.s : &data_.immed[0]);
+  return (use_external_() ? &*data_.ext.s : &data_.immed[0]);
+}
+
+template<typename Char, typename Traits, typename Alloc>
+auto basic_string<Char, Traits, Alloc>::avail_() const noexcept -> size_type {
+  if (use_external_()) return data_.ext.avail & ~external_flag;
+  return immed_size;
+}
+
+template<typename Char, typename Traits, typename Alloc>
+auto basic_string<Char, Traits, Alloc>::set_size_(size_type n) noexcept ->
+    void {
+  assert(n <= capacity());
+
+  if (use_external_())
+    data_.ext.len = n;
+  else
+    data_.immed[immed_cap] = char_type(immed_cap - n);
 }
 
 template<typename Char, typename Traits, typename Alloc>
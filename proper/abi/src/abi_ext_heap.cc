@@ -1,14 +1,19 @@
 #include <abi/ext/heap.h>
-#include <abi/ext/hash_set.h>
+#include <abi/ext/list.h>
 #include <abi/semaphore.h>
 #include <abi/ext/log2.h>
+#include <abi/misc_int.h>
 #include <abi/panic.h>
+#include <ilias/linked_set.h>
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <mutex>
 #include <new>
 
 #if __has_include(<ilias/stats.h>)
 # include <ilias/stats.h>
+# include <ostream>
 #endif
 
 namespace __cxxabiv1 {
@@ -16,12 +21,20 @@ namespace ext {
 namespace {
 
 
+#if __has_include(<ilias/stats.h>)
+_namespace(ilias)::global_stats_group heap_group{
+  &abi_ext_group, "heap", {}, {}
+};
+_namespace(ilias)::global_stats_group global_heap_group{
+  &heap_group, "global", {}, {}
+};
+#endif
+
+
 class global_heap {
  private:
-  struct used_tag {};
   struct chain_tag {};
   struct free_tag {};
-  static constexpr unsigned int n_used_buckets = 256;
 
   global_heap() = default;
   global_heap(const global_heap&) = delete;
@@ -30,9 +43,16 @@ class global_heap {
  public:
   using span = _namespace(std)::tuple<const void*, size_t>;
 
+  /*
+   * Memory segment header.
+   *
+   * An allocation always starts directly after the header of the segment
+   * that tracks it, so the header is found by subtracting
+   * memory_alloc_space from the allocation address.
+   * The cookie is used to verify that such an address holds a header.
+   */
   class memory
-  : public list_elem<used_tag>,
-    public list_elem<chain_tag>,
+  : public list_elem<chain_tag>,
     public list_elem<free_tag>
   {
    public:
@@ -40,7 +60,7 @@ class global_heap {
     memory(const memory&) = delete;
     memory& operator=(const memory&) = delete;
 
-    memory(size_t, bool) noexcept;
+    memory(size_t, bool, bool = false) noexcept;
     ~memory() noexcept;
 
     span get_span_space() const noexcept;
@@ -49,6 +69,8 @@ class global_heap {
     span get_free_space() const noexcept;
     bool has_used() const noexcept { return used_; }
     bool is_root() const noexcept { return root_; }
+    bool is_large() const noexcept { return large_; }
+    bool is_valid() const noexcept { return cookie_ == cookie(this); }
 
     bool try_claim(const void*, size_t) noexcept;
     bool try_claim(uintptr_t, size_t) noexcept;
@@ -56,17 +78,59 @@ class global_heap {
     memory* try_split(uintptr_t, size_t) noexcept;
     void release() noexcept;
     bool resize(size_t) noexcept;
+    void set_span_size(size_t) noexcept;
     static bool pred_merge(memory*, memory*) noexcept;
 
     static constexpr unsigned int used_bits = 30;
+    static constexpr unsigned int free_bits = 31;
     static constexpr size_t max_alloc_size = (size_t(1) << used_bits) - 1U;
+    /* Largest span a segment can describe, limited by bytes_free_. */
+    static constexpr size_t max_span_size = (size_t(1) << free_bits) - 1U;
 
    private:
+    static uintptr_t cookie(const memory*) noexcept;
+
+    uintptr_t cookie_;
     const bool root_ : 1;
+    const bool large_ : 1;  // Sole user of a heap_malloc span.
     bool used_ : 1;  // Keep track of allocation:
                      // bytes_used_ will be 0 for 0-sized allocations.
     size_t bytes_used_ : used_bits;
-    size_t bytes_free_ : 32;
+    size_t bytes_free_ : free_bits;
+  };
+
+  /*
+   * Memory obtained from heap_malloc.
+   *
+   * Each region starts with this header, followed by the root memory
+   * segment.  Live regions are indexed by address, so a lookup verifies
+   * that an address lies in memory owned by the heap before reading
+   * the segment header in front of it.
+   */
+  class region
+  : public _namespace(ilias)::linked_set_element<region>
+  {
+   public:
+    explicit region(size_t sz) noexcept : size(sz) {}
+
+    uintptr_t addr() const noexcept {
+      return reinterpret_cast<uintptr_t>(this);
+    }
+    memory* root() noexcept;
+
+    size_t size;  // Bytes obtained from heap_malloc, including this header.
+  };
+
+  struct region_less {
+    bool operator()(const region& x, const region& y) const noexcept {
+      return x.addr() < y.addr();
+    }
+    bool operator()(const region& x, uintptr_t y) const noexcept {
+      return x.addr() < y;
+    }
+    bool operator()(uintptr_t x, const region& y) const noexcept {
+      return x < y.addr();
+    }
   };
 
   /* Fix alignment of address. */
@@ -77,6 +141,13 @@ class global_heap {
   /* Size and alignment of memory unit. */
   static constexpr size_t memory_align = alignof(memory);
   static const size_t memory_alloc_space;
+  static const size_t region_alloc_space;
+
+  /*
+   * Allocations of at least large_threshold bytes get a heap_malloc span
+   * of their own, which can be resized using heap_resize.
+   */
+  static constexpr size_t large_threshold = size_t(1) << 18;
 
   void* allocate(size_t, size_t) noexcept;
   _namespace(std)::tuple<bool, size_t> free(const void*) noexcept;
@@ -87,44 +158,206 @@ class global_heap {
  private:
   const memory* lookup_used_addr_(const void*) const noexcept;
   memory* lookup_used_addr_(const void*) noexcept;
+  const region* find_region_(uintptr_t) const noexcept;
+  static region* region_of_(memory*) noexcept;
+  memory* new_region_(void*, size_t, bool) noexcept;
   const memory* try_claim_(memory*, size_t, size_t) noexcept;
   const memory* allocate_from_free_(size_t, size_t) noexcept;
+  void* allocate_large_(size_t) noexcept;
+  bool resize_large_(semlock&, memory*, size_t) noexcept;
 
-  using used_set = hash_set<memory, n_used_buckets, used_tag>;
   using chain = list<memory, chain_tag>;
   using free_set = list<memory, free_tag>;
+  using region_set = _namespace(ilias)::linked_set<region, void, region_less>;
+
+  /*
+   * Segregated free index.
+   *
+   * Memory segments that can satisfy an allocation are kept in bins,
+   * bin i holding segments with [2^i, 2^(i+1)) bytes of free space.
+   * A bitmap of non-empty bins allows finding a bin in constant time.
+   *
+   * The bin of a segment is derived from its free space, so a segment
+   * must be unlinked using the amount of free space it had when linked.
+   */
+  class free_index {
+   public:
+    using iterator = free_set::iterator;
+    static constexpr unsigned int n_bins = memory::free_bits;
+
+    static unsigned int bin(size_t) noexcept;
+    void link(memory*) noexcept;
+    void unlink(memory*, size_t) noexcept;
+    unsigned int next_bin(unsigned int) const noexcept;
+    iterator begin(unsigned int b) noexcept { return bins_[b].begin(); }
+    iterator end(unsigned int b) noexcept { return bins_[b].end(); }
+    size_t free_bytes() const noexcept { return free_bytes_; }
+    size_t largest() const noexcept;
+
+   private:
+    free_set bins_[n_bins];
+    uint64_t nonempty_ = 0;
+    size_t free_bytes_ = 0;  // Sum of free space of linked segments.
+  };
+
+  /* Attempts per bin that may not fit, before trying a fitting bin. */
+  static constexpr unsigned int bin_scan_limit = 8;
 
   semaphore lock_{ 1U };
-  used_set used_;
   chain chain_;
-  free_set free_;
+  free_index free_;
+  region_set regions_;
+  _namespace(std)::atomic<size_t> managed_bytes_{ 0U };  // Sum of all spans.
+
+#if __has_include(<ilias/stats.h>)
+  static uint64_t stat_managed_bytes_(const void*) noexcept;
+  static uint64_t stat_free_bytes_(const void*) noexcept;
+  static uint64_t stat_fragmentation_(const void*) noexcept;
+
+  _namespace(ilias)::stats_gauge managed_bytes_stat_{
+    global_heap_group, "managed_bytes", &stat_managed_bytes_, this
+  };
+  _namespace(ilias)::stats_gauge free_bytes_stat_{
+    global_heap_group, "free_bytes", &stat_free_bytes_, this
+  };
+  _namespace(ilias)::stats_gauge fragmentation_stat_{
+    global_heap_group, "fragmentation_permille", &stat_fragmentation_, this
+  };
+#endif
 };
 
 
-inline size_t hash_code(const global_heap::memory& m) noexcept {
-  using _namespace(std)::hash;
-  using _namespace(std)::get;
+/*
+ * Slab allocator for small objects.
+ *
+ * Small allocations are rounded up to a size class.  Each size class keeps
+ * a number of slabs: fixed size, naturally aligned blocks of memory taken
+ * from the global heap, that are carved up into equally sized objects.
+ * Allocation is a pop from the freelist of a slab with free objects,
+ * the common case thus avoids the global heap entirely.
+ *
+ * Slabs are aligned to slab_bytes, so the slab holding an object is found
+ * by masking its address.  Since a masked address may point into memory
+ * not managed by the slab allocator, slabs are registered in a lookup set
+ * which is consulted before the slab header is used.
+ * The lookup set is split into buckets by slab address, each with its own
+ * lock, so concurrent frees rarely contend.
+ */
+class slab_heap {
+ private:
+  struct partial_tag {};
+  struct lookup_tag {};
+  static constexpr unsigned int n_lookup_buckets = 64;
 
-  auto addr = get<0>(m.get_used_space());
-  return hash<decltype(addr)>()(addr);
-}
+  slab_heap() = default;
+  slab_heap(const slab_heap&) = delete;
+  slab_heap& operator=(const slab_heap&) = delete;
+
+ public:
+  static constexpr unsigned int n_classes = heap::n_slab_classes;
+  static constexpr size_t slab_bytes = 16384;
+  static constexpr size_t max_size = 2048;
+  static constexpr size_t max_obj_align = 64;
+
+  class slab
+  : public list_elem<partial_tag>,
+    public list_elem<lookup_tag>
+  {
+   public:
+    slab() = delete;
+    slab(const slab&) = delete;
+    slab& operator=(const slab&) = delete;
 
+    explicit slab(unsigned int) noexcept;
+    ~slab() noexcept;
+
+    unsigned int size_class() const noexcept { return cls_; }
+    bool is_full() const noexcept { return n_free_ == 0; }
+    bool is_empty() const noexcept { return n_free_ == n_objs_; }
+
+    void* pop() noexcept;
+    void push(const void*) noexcept;
+
+    static slab* from_addr(const void*) noexcept;
+    static const size_t objs_offset;
+
+   private:
+    struct free_obj {
+      free_obj* next;
+    };
+
+    const unsigned int cls_;
+    const unsigned int n_objs_;
+    unsigned int n_free_;
+    uintptr_t bump_;  // Start of objects that have never been handed out.
+    free_obj* free_ = nullptr;
+  };
+
+  static constexpr size_t class_size(unsigned int) noexcept;
+  static constexpr size_t class_align(unsigned int) noexcept;
+  static unsigned int size_class(size_t) noexcept;
+  static bool eligible(size_t, size_t) noexcept;
+
+  _namespace(std)::tuple<void*, bool> allocate(unsigned int) noexcept;
+  _namespace(std)::tuple<unsigned int, bool> allocate_batch(
+      unsigned int, void**, unsigned int) noexcept;
+  void free_batch(unsigned int, void*const*, unsigned int) noexcept;
+  const slab* lookup(const void*) const noexcept;
+
+  static slab_heap& get_singleton() noexcept;
+
+ private:
+  using partial_list = list<slab, partial_tag>;
+  using lookup_list = list<slab, lookup_tag>;
 
-global_heap::memory::memory(size_t span_bytes, bool root) noexcept
-: root_(root),
+  struct size_class_data {
+    semaphore lock{ 1U };
+    partial_list partial;  // Slabs with at least one free object.
+  };
+
+  struct lookup_bucket {
+    mutable semaphore lock{ 1U };
+    lookup_list slabs;
+  };
+
+  slab* new_slab_(unsigned int) noexcept;
+  void release_slab_(slab*) noexcept;
+
+  lookup_bucket& lookup_bucket_(const slab*) noexcept;
+  const lookup_bucket& lookup_bucket_(const slab*) const noexcept;
+
+  size_class_data classes_[n_classes];
+  lookup_bucket lookup_[n_lookup_buckets];
+};
+
+
+global_heap::memory::memory(size_t span_bytes, bool root, bool large)
+    noexcept
+: cookie_(cookie(this)),
+  root_(root),
+  large_(large),
   used_(false),
   bytes_used_(0),
   bytes_free_(span_bytes - memory_alloc_space)
 {
   assert(span_bytes >= memory_alloc_space);
+  assert(root || !large);
+  if (_predict_false(span_bytes > max_span_size)) {
+    panic("global_heap: span of %zu bytes exceeds maximum span size %zu",
+          span_bytes, max_span_size);
+  }
 }
 
 global_heap::memory::~memory() noexcept {
   assert(!has_used());
   assert(bytes_used_ == 0);
   assert(!chain::is_linked(this));
-  assert(!used_set::is_linked(this));
   assert(!free_set::is_linked(this));
+  cookie_ = 0;
+}
+
+auto global_heap::memory::cookie(const memory* m) noexcept -> uintptr_t {
+  return reinterpret_cast<uintptr_t>(m) ^ uintptr_t(0x6d656d6f72795f5aULL);
 }
 
 auto global_heap::memory::get_span_space() const noexcept -> span {
@@ -251,6 +484,17 @@ auto global_heap::memory::resize(size_t nsz) noexcept -> bool {
   return false;
 }
 
+/* Change the size of the span, by changing the size of the free space. */
+auto global_heap::memory::set_span_size(size_t span_bytes) noexcept -> void {
+  assert(span_bytes >= memory_alloc_space + bytes_used_);
+  if (_predict_false(span_bytes > max_span_size)) {
+    panic("global_heap: span of %zu bytes exceeds maximum span size %zu",
+          span_bytes, max_span_size);
+  }
+
+  bytes_free_ = span_bytes - memory_alloc_space - bytes_used_;
+}
+
 auto global_heap::memory::pred_merge(memory* p, memory* s) noexcept -> bool {
   using _namespace(std)::tie;
   using _namespace(std)::ignore;
@@ -259,6 +503,7 @@ auto global_heap::memory::pred_merge(memory* p, memory* s) noexcept -> bool {
   assert(p != nullptr || s->is_root());
   if (s->has_used()) return false;
   if (s->is_root()) return false;
+  assert(!p->is_large());
 
   const void* p_addr;
   size_t p_size;
@@ -275,6 +520,61 @@ auto global_heap::memory::pred_merge(memory* p, memory* s) noexcept -> bool {
 }
 
 
+auto global_heap::free_index::bin(size_t free_bytes) noexcept ->
+    unsigned int {
+  return log2_down(free_bytes);
+}
+
+auto global_heap::free_index::link(memory* m) noexcept -> void {
+  using _namespace(std)::get;
+
+  /*
+   * A segment with an allocation can only be used by splitting it,
+   * for which it requires space for a memory header.
+   */
+  const size_t free_bytes = get<1>(m->get_free_space());
+  if (free_bytes == 0) return;
+  if (m->has_used() && free_bytes <= memory_alloc_space) return;
+
+  const unsigned int b = bin(free_bytes);
+  bins_[b].link_front(m);
+  nonempty_ |= uint64_t(1) << b;
+  free_bytes_ += free_bytes;
+}
+
+auto global_heap::free_index::unlink(memory* m, size_t free_bytes) noexcept ->
+    void {
+  if (!free_set::is_linked(m)) return;
+
+  const unsigned int b = bin(free_bytes);
+  bool succes = bins_[b].unlink(m);
+  assert(succes);
+  if (bins_[b].empty()) nonempty_ &= ~(uint64_t(1) << b);
+  free_bytes_ -= free_bytes;
+}
+
+/* Returns the first non-empty bin at or above b, or n_bins if none. */
+auto global_heap::free_index::next_bin(unsigned int b) const noexcept ->
+    unsigned int {
+  if (b >= n_bins) return n_bins;
+  const unsigned int rv = ctzll(nonempty_ & ~((uint64_t(1) << b) - 1U));
+  return (rv > n_bins ? n_bins : rv);
+}
+
+/* Returns the free space of the largest segment in the index. */
+auto global_heap::free_index::largest() const noexcept -> size_t {
+  using _namespace(std)::get;
+
+  if (nonempty_ == 0) return 0;
+  const unsigned int b = 63U - clzll(nonempty_);
+
+  size_t rv = 0;
+  for (const memory& m : bins_[b])
+    rv = _namespace(std)::max(rv, get<1>(m.get_free_space()));
+  return rv;
+}
+
+
 auto global_heap::align(uintptr_t addr, size_t alignment) noexcept ->
     uintptr_t {
   assert(is_pow2(alignment));
@@ -300,6 +600,14 @@ auto global_heap::allocate(size_t sz, size_t alignment) noexcept -> void* {
 
   if (sz > memory::max_alloc_size) return nullptr;  // Too large.
 
+  /* Large allocations use their own span, if alignment permits. */
+  if (sz >= large_threshold && alignment <= alignof(max_align_t) &&
+      (alignment == 0U ||
+       (region_alloc_space + memory_alloc_space) % alignment == 0U)) {
+    void* rv = allocate_large_(sz);
+    if (rv) return rv;
+  }
+
   semlock l{ lock_ };
 
   for (;;) {
@@ -310,7 +618,8 @@ auto global_heap::allocate(size_t sz, size_t alignment) noexcept -> void* {
     }
 
     /* Ask for more memory from the heap allocator. */
-    const size_t request_h_size = align(memory_alloc_space + sz, alignment);
+    const size_t request_h_size =
+        align(region_alloc_space + memory_alloc_space + sz, alignment);
     void* h_addr;
     size_t h_size;
     tie(h_addr, h_size) = l.do_unlocked(&_config::heap_malloc, request_h_size);
@@ -322,12 +631,14 @@ auto global_heap::allocate(size_t sz, size_t alignment) noexcept -> void* {
 
     /*
      * Link memory into global heap;
-     * note that we link at the front of the free list,
-     * so the second iteration of this loop will succeed quickly.
+     * note that the new memory is large enough to be found by the
+     * fitting bin search, so the second iteration of this loop will
+     * succeed quickly.
      */
-    memory* new_mem = new (h_addr) memory(h_size, true);
+    memory* new_mem = new_region_(h_addr, h_size, false);
     chain_.link_back(new_mem);
-    free_.link_front(new_mem);
+    free_.link(new_mem);
+    managed_bytes_.fetch_add(h_size, _namespace(std)::memory_order_relaxed);
   }
   /* UNREACHABLE */
 }
@@ -336,6 +647,7 @@ auto global_heap::free(const void* p) noexcept ->
     _namespace(std)::tuple<bool, size_t> {
   using _namespace(std)::make_tuple;
   using _namespace(std)::tie;
+  using _namespace(std)::get;
 
   semlock l{ lock_ };
 
@@ -350,21 +662,46 @@ auto global_heap::free(const void* p) noexcept ->
   tie(u_addr, u_size) = m->get_used_space();
   assert(u_addr == p);
 
+  /* Large allocations hand back their region. */
+  if (m->is_large()) {
+    region* r = region_of_(m);
+    const size_t span_size = r->size;
+    m->release();
+    m->~memory();
+    regions_.unlink(r);
+    r->~region();
+    if (l.do_unlocked(&_config::heap_free, static_cast<void*>(r),
+                      span_size)) {
+      managed_bytes_.fetch_sub(span_size,
+                               _namespace(std)::memory_order_relaxed);
+    } else {
+      /* Region can't be released, use it as ordinary heap memory instead. */
+      memory* new_mem = new_region_(r, span_size, false);
+      chain_.link_back(new_mem);
+      free_.link(new_mem);
+    }
+    return make_tuple(true, u_size);
+  }
+
   /* Lookup predecessor of m. */
   auto m_iter = chain_.iterator_to(m);
   auto p_iter = _namespace(std)::prev(m_iter);
   memory* predecessor = (m_iter == chain_.begin() ? nullptr : &*p_iter);
 
   /* Release memory and try to merge it with its predecessor. */
+  const size_t m_free = get<1>(m->get_free_space());
+  const size_t p_free = (predecessor ?
+                         get<1>(predecessor->get_free_space()) :
+                         0U);
+  free_.unlink(m, m_free);
   m->release();
   if (memory::pred_merge(predecessor, m)) {
     chain_.unlink(m);
-    used_.unlink(m);
-    free_.unlink(m);
     m->~memory();
-    free_.link_front(predecessor);
+    free_.unlink(predecessor, p_free);
+    free_.link(predecessor);
   } else {
-    free_.link_front(m);
+    free_.link(m);
   }
   return make_tuple(true, u_size);
 }
@@ -388,12 +725,14 @@ auto global_heap::resize(const void* p, size_t nsz) noexcept ->
   tie(u_addr, osz) = m->get_used_space();
   assert(u_addr == p);
 
+  /* Large allocations may resize their span. */
+  if (m->is_large()) return make_tuple(resize_large_(l, m, nsz), osz);
+
   /* Try to resize m. */
+  const size_t m_free = get<1>(m->get_free_space());
   if (m->resize(nsz)) {
-    if (get<1>(m->get_free_space()) >= memory_alloc_space)
-      free_.link_back(m);
-    else
-      free_.unlink(m);
+    free_.unlink(m, m_free);
+    free_.link(m);
     return make_tuple(true, osz);
   }
   return make_tuple(false, osz);
@@ -411,15 +750,38 @@ auto global_heap::get_singleton() noexcept -> global_heap& {
   return *static_cast<global_heap*>(data_ptr);
 }
 
+/*
+ * Find the header of the allocation at p.
+ *
+ * Returns nullptr if p can't be an allocation: misaligned, or its header
+ * doesn't lie within a live region of the heap (this includes regions
+ * that have been handed back).  Otherwise, the header must be valid and
+ * describe an allocation at p; if it doesn't, p is not an allocation
+ * (or was already freed) or the header was overwritten, and the heap
+ * panics instead of trusting it.
+ */
 auto global_heap::lookup_used_addr_(const void* p) const noexcept ->
     const memory* {
-  using _namespace(std)::hash;
   using _namespace(std)::get;
 
-  for (const auto& i :
-       used_.get_bucket(used_set::hashcode_2_bucket(hash<const void*>()(p))))
-    if (get<0>(i.get_used_space()) == p) return &i;
-  return nullptr;
+  const uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+  if (addr % memory_align != 0U || addr < memory_alloc_space) return nullptr;
+
+  const uintptr_t m_addr = addr - memory_alloc_space;
+  const region* r = find_region_(m_addr);
+  if (r == nullptr || m_addr < r->addr() + region_alloc_space ||
+      addr - r->addr() > r->size)
+    return nullptr;
+
+  const memory* m = reinterpret_cast<const memory*>(m_addr);
+  if (_predict_false(!m->is_valid()))
+    panic("global_heap: no valid header for %p (bad pointer or corrupt)", p);
+  if (_predict_false(!m->has_used()))
+    panic("global_heap: %p is not allocated (double free?)", p);
+  if (_predict_false(get<0>(m->get_used_space()) != p))
+    panic("global_heap: header for %p describes %p", p,
+          get<0>(m->get_used_space()));
+  return m;
 }
 
 auto global_heap::lookup_used_addr_(const void* p) noexcept ->
@@ -428,6 +790,38 @@ auto global_heap::lookup_used_addr_(const void* p) noexcept ->
   return const_cast<memory*>(self.lookup_used_addr_(p));
 }
 
+/* Find the live region containing addr. */
+auto global_heap::find_region_(uintptr_t addr) const noexcept ->
+    const region* {
+  auto i = regions_.upper_bound(addr);
+  if (i == regions_.begin()) return nullptr;
+  --i;
+  if (addr - i->addr() >= i->size) return nullptr;
+  return &*i;
+}
+
+/* Find the region of a root memory segment. */
+auto global_heap::region_of_(memory* m) noexcept -> region* {
+  assert(m->is_root());
+  return reinterpret_cast<region*>(
+      reinterpret_cast<uintptr_t>(m) - region_alloc_space);
+}
+
+/*
+ * Set up a region of sz bytes at addr, and index it.
+ * Returns its root memory segment, which the caller must link.
+ */
+auto global_heap::new_region_(void* addr, size_t sz, bool large) noexcept ->
+    memory* {
+  assert(sz >= region_alloc_space + memory_alloc_space);
+
+  region* r = new (addr) region(sz);
+  if (_predict_false(!regions_.link(r, false).second))
+    panic("global_heap: region at %p is already in use", addr);
+  return new (static_cast<void*>(r->root()))
+      memory(sz - region_alloc_space, true, large);
+}
+
 auto global_heap::try_claim_(memory* m, size_t sz, size_t alignment)
     noexcept -> const memory* {
   using _namespace(std)::tie;
@@ -451,8 +845,8 @@ auto global_heap::try_claim_(memory* m, size_t sz, size_t alignment)
 
   /* Try to make memory argument handle the space directly. */
   if (m->try_claim(alloc_addr, sz)) {
-    used_.link_front(m);
-    if (get<1>(m->get_free_space()) <= memory_alloc_space) free_.unlink(m);
+    free_.unlink(m, fp_size);
+    free_.link(m);
     return m;
   }
 
@@ -473,30 +867,582 @@ auto global_heap::try_claim_(memory* m, size_t sz, size_t alignment)
     assert(get<0>(mm->get_used_space()) ==
            reinterpret_cast<const void*>(alloc_addr));
     chain_.link_after(mm, chain_.iterator_to(m));
-    used_.link_front(mm);
-    if (get<1>(mm->get_free_space()) >= memory_alloc_space)
-      free_.link_front(mm);
+    free_.link(mm);
 
-    /* Unlink m from free list if it is no longer suitable for allocation. */
-    if (get<1>(m->get_free_space()) < memory_alloc_space ||
-        (m->has_used() && get<1>(m->get_free_space()) == memory_alloc_space))
-      free_.unlink(m);
+    /* Move m to the bin matching its reduced free space. */
+    free_.unlink(m, fp_size);
+    free_.link(m);
   }
   return mm;
 }
 
+/*
+ * Find free space for an allocation.
+ *
+ * Segments in bins at or above the fitting bin are guaranteed to be able to
+ * hold the allocation, regardless of the alignment of their free space.
+ * Lower bins may hold a fit, which is preferred to limit fragmentation,
+ * but only a limited number of those are tried before using a fitting bin.
+ * Only if no fitting bin has any segments, are lower bins scanned entirely.
+ */
 auto global_heap::allocate_from_free_(size_t sz, size_t alignment) noexcept ->
     const memory* {
-  for (auto& m : free_) {
-    const memory* mm = try_claim_(&m, sz, alignment);
+  using _namespace(std)::max;
+
+  if (alignment == 0) alignment = 1;
+  const size_t worst = sz + memory_alloc_space +
+                       (memory_align - 1U) + (max(alignment, memory_align) - 1U);
+  const unsigned int lo = free_index::bin(sz);
+  const unsigned int fit = log2_up(worst);
+
+  /* Try a limited number of segments in the lower bins. */
+  for (unsigned int b = free_.next_bin(lo);
+       b < fit && b < free_index::n_bins;
+       b = free_.next_bin(b + 1U)) {
+    unsigned int attempts = 0;
+    for (auto i = free_.begin(b);
+         i != free_.end(b) && attempts < bin_scan_limit;
+         ++i, ++attempts) {
+      const memory* mm = try_claim_(&*i, sz, alignment);
+      if (mm) return mm;
+    }
+  }
+
+  /* Any segment in a fitting bin will do. */
+  const unsigned int b = free_.next_bin(fit);
+  if (b < free_index::n_bins) {
+    const memory* mm = try_claim_(&*free_.begin(b), sz, alignment);
+    assert(mm != nullptr);
     if (mm) return mm;
   }
+
+  /* Exhaustive search of the lower bins. */
+  for (unsigned int b = free_.next_bin(lo);
+       b < fit && b < free_index::n_bins;
+       b = free_.next_bin(b + 1U)) {
+    for (auto i = free_.begin(b); i != free_.end(b); ++i) {
+      const memory* mm = try_claim_(&*i, sz, alignment);
+      if (mm) return mm;
+    }
+  }
   return nullptr;
 }
 
+/*
+ * Allocate a span for a single, large allocation.
+ * The memory is not linked into the chain or the free index.
+ */
+auto global_heap::allocate_large_(size_t sz) noexcept -> void* {
+  using _namespace(std)::tie;
+  using _namespace(std)::get;
+
+  void* h_addr;
+  size_t h_size;
+  const size_t request_h_size = region_alloc_space + memory_alloc_space + sz;
+  tie(h_addr, h_size) = _config::heap_malloc(request_h_size);
+  if (!h_addr) return nullptr;
+  if (h_size < request_h_size) {
+    panic("abi::_config::heap_malloc yields less space (%zu) "
+          "than requested (%zu)", h_size, request_h_size);
+  }
+
+  semlock l{ lock_ };
+  memory* m = new_region_(h_addr, h_size, true);
+  bool succes = m->try_claim(get<0>(m->get_free_space()), sz);
+  assert(succes);
+  managed_bytes_.fetch_add(h_size, _namespace(std)::memory_order_relaxed);
+  return const_cast<void*>(get<0>(m->get_used_space()));
+}
+
+/*
+ * Resize a large allocation.
+ *
+ * If the span can't hold the new size, it is extended in place using
+ * heap_resize, instead of having the caller copy the data.
+ * When shrinking leaves a lot of unused space, the span is trimmed.
+ */
+auto global_heap::resize_large_(semlock& l, memory* m, size_t nsz) noexcept ->
+    bool {
+  using _namespace(std)::tie;
+  using _namespace(std)::get;
+
+  assert(m->is_large());
+  if (nsz > memory::max_alloc_size) return false;
+
+  region* r = region_of_(m);
+  void* span_addr = r;
+  const size_t span_size = r->size;
+  const size_t request = region_alloc_space + memory_alloc_space + nsz;
+
+  if (!m->resize(nsz)) {
+    const size_t new_span = l.do_unlocked(&_config::heap_resize, span_addr,
+                                          span_size, request);
+    if (new_span == 0) return false;
+    if (new_span < request) {
+      panic("abi::_config::heap_resize yields less space (%zu) "
+            "than requested (%zu)", new_span, request);
+    }
+    m->set_span_size(new_span - region_alloc_space);
+    r->size = new_span;
+    managed_bytes_.fetch_add(new_span - span_size,
+                             _namespace(std)::memory_order_relaxed);
+    bool succes = m->resize(nsz);
+    assert(succes);
+    return true;
+  }
+
+  if (get<1>(m->get_free_space()) >= large_threshold) {
+    const size_t new_span = l.do_unlocked(&_config::heap_resize, span_addr,
+                                          span_size, request);
+    if (new_span != 0) {
+      m->set_span_size(new_span - region_alloc_space);
+      r->size = new_span;
+      managed_bytes_.fetch_sub(span_size - new_span,
+                               _namespace(std)::memory_order_relaxed);
+    }
+  }
+  return true;
+}
+
 const size_t global_heap::memory_alloc_space =
     global_heap::align(sizeof(global_heap::memory), global_heap::memory_align);
+const size_t global_heap::region_alloc_space =
+    global_heap::align(sizeof(global_heap::region), global_heap::memory_align);
+
+auto global_heap::region::root() noexcept -> memory* {
+  return reinterpret_cast<memory*>(addr() + region_alloc_space);
+}
+
+/*
+ * The span for the largest allocation must fit in a segment.
+ * Spans are only merged within the span obtained from heap_malloc,
+ * so checking the size of those spans suffices.
+ */
+static_assert(global_heap::memory::max_alloc_size +
+              sizeof(global_heap::memory) + alignof(global_heap::memory) <=
+              global_heap::memory::max_span_size,
+              "bytes_free_ can't describe the span of the largest allocation");
+
+#if __has_include(<ilias/stats.h>)
+auto global_heap::stat_managed_bytes_(const void* arg) noexcept -> uint64_t {
+  const global_heap& self = *static_cast<const global_heap*>(arg);
+  return self.managed_bytes_.load(_namespace(std)::memory_order_relaxed);
+}
+
+auto global_heap::stat_free_bytes_(const void* arg) noexcept -> uint64_t {
+  global_heap& self =
+      const_cast<global_heap&>(*static_cast<const global_heap*>(arg));
+  semlock l{ self.lock_ };
+  return self.free_.free_bytes();
+}
+
+/*
+ * Fragmentation of the free space, in permille:
+ * 0 if all free space is in a single segment, approaching 1000 as
+ * the free space is spread over ever smaller segments.
+ */
+auto global_heap::stat_fragmentation_(const void* arg) noexcept -> uint64_t {
+  global_heap& self =
+      const_cast<global_heap&>(*static_cast<const global_heap*>(arg));
+  size_t total, largest;
+  {
+    semlock l{ self.lock_ };
+    total = self.free_.free_bytes();
+    largest = self.free_.largest();
+  }
+
+  if (total == 0) return 0;
+  return 1000U - uint64_t(largest) * 1000U / total;
+}
+#endif
+
+
+slab_heap::slab::slab(unsigned int cls) noexcept
+: cls_(cls),
+  n_objs_((slab_bytes - objs_offset) / class_size(cls)),
+  n_free_(n_objs_),
+  bump_(reinterpret_cast<uintptr_t>(this) + objs_offset)
+{
+  assert(cls < n_classes);
+  assert(reinterpret_cast<uintptr_t>(this) % slab_bytes == 0);
+}
+
+slab_heap::slab::~slab() noexcept {
+  assert(is_empty());
+  assert(!partial_list::is_linked(this));
+  assert(!lookup_list::is_linked(this));
+}
+
+auto slab_heap::slab::pop() noexcept -> void* {
+  assert(!is_full());
+
+  void* rv;
+  if (free_ != nullptr) {
+    rv = free_;
+    free_ = free_->next;
+  } else {
+    /* Hand out memory that was never used before. */
+    rv = reinterpret_cast<void*>(bump_);
+    bump_ += class_size(cls_);
+    assert(bump_ <= reinterpret_cast<uintptr_t>(this) + slab_bytes);
+  }
+  --n_free_;
+  return rv;
+}
+
+auto slab_heap::slab::push(const void* p) noexcept -> void {
+  assert(!is_empty());
+  assert(from_addr(p) == this);
+  assert((reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(this) -
+          objs_offset) % class_size(cls_) == 0);
+
+  free_obj* fo = new (const_cast<void*>(p)) free_obj;
+  fo->next = free_;
+  free_ = fo;
+  ++n_free_;
+}
+
+auto slab_heap::slab::from_addr(const void* p) noexcept -> slab* {
+  return reinterpret_cast<slab*>(reinterpret_cast<uintptr_t>(p) &
+                                 ~uintptr_t(slab_bytes - 1U));
+}
+
+const size_t slab_heap::slab::objs_offset =
+    (sizeof(slab_heap::slab) + slab_heap::max_obj_align - 1U) &
+    ~(slab_heap::max_obj_align - 1U);
+
+/*
+ * Size classes: 8, 16, 32, 48, 64, 96, ..., 1536, 2048.
+ * Above 16 bytes, there are two classes per power of 2.
+ */
+constexpr auto slab_heap::class_size(unsigned int cls) noexcept -> size_t {
+  return (cls < 2U ?
+          size_t(8) << cls :
+          (cls % 2U == 0U ?
+           size_t(1) << (cls / 2U + 4U) :
+           size_t(3) << (cls / 2U + 3U)));
+}
+
+/* Objects are placed at multiples of their size from a 64-byte boundary. */
+constexpr auto slab_heap::class_align(unsigned int cls) noexcept -> size_t {
+  return (class_size(cls) & -class_size(cls)) < max_obj_align ?
+         class_size(cls) & -class_size(cls) :
+         max_obj_align;
+}
+
+auto slab_heap::size_class(size_t sz) noexcept -> unsigned int {
+  assert(sz <= max_size);
+
+  if (sz <= class_size(0)) return 0;
+  if (sz <= class_size(1)) return 1;
+
+  /* sz is in range (2^(l-1), 2^l]. */
+  const unsigned int l = log2_up(sz);
+  const unsigned int pow2_cls = 2U * (l - 5U) + 2U;
+  return (sz <= class_size(pow2_cls - 1U) ? pow2_cls - 1U : pow2_cls);
+}
+
+auto slab_heap::eligible(size_t sz, size_t alignment) noexcept -> bool {
+  return sz <= max_size && alignment <= class_align(size_class(sz));
+}
+
+auto slab_heap::allocate(unsigned int cls) noexcept ->
+    _namespace(std)::tuple<void*, bool> {
+  using _namespace(std)::tie;
+  using _namespace(std)::make_tuple;
+
+  void* rv;
+  unsigned int n;
+  bool hit;
+  tie(n, hit) = allocate_batch(cls, &rv, 1);
+  if (n == 0) return make_tuple(nullptr, false);
+  return make_tuple(rv, hit);
+}
+
+/*
+ * Allocate up to n objects of the given size class,
+ * using a single acquisition of the size class lock.
+ *
+ * Returns the number of objects allocated and
+ * true iff no new slab had to be created.
+ */
+auto slab_heap::allocate_batch(unsigned int cls, void** objs, unsigned int n)
+    noexcept -> _namespace(std)::tuple<unsigned int, bool> {
+  using _namespace(std)::make_tuple;
+
+  assert(cls < n_classes);
+  size_class_data& c = classes_[cls];
+  semlock l{ c.lock };
+
+  bool hit = true;
+  unsigned int i = 0;
+  while (i < n) {
+    if (c.partial.empty()) {
+      /* Only create a new slab if nothing was allocated yet. */
+      if (i > 0) break;
+      hit = false;
+      slab* s = new_slab_(cls);
+      if (s == nullptr) break;
+      c.partial.link_front(s);
+    }
+
+    slab* s = &*c.partial.begin();
+    while (i < n && !s->is_full()) objs[i++] = s->pop();
+    if (s->is_full()) c.partial.unlink(s);
+  }
+  return make_tuple(i, hit);
+}
+
+/*
+ * Release n objects of the given size class,
+ * using a single acquisition of the size class lock.
+ */
+auto slab_heap::free_batch(unsigned int cls, void*const* objs, unsigned int n)
+    noexcept -> void {
+  assert(cls < n_classes);
+  size_class_data& c = classes_[cls];
+  semlock l{ c.lock };
+
+  for (void*const* i = objs; i != objs + n; ++i) {
+    slab* s = slab::from_addr(*i);
+    assert(s->size_class() == cls);
+
+    const bool was_full = s->is_full();
+    s->push(*i);
+    if (was_full) c.partial.link_front(s);
+
+    /* Keep at most one empty slab around, to prevent thrashing. */
+    if (s->is_empty() &&
+        _namespace(std)::next(c.partial.begin()) != c.partial.end()) {
+      c.partial.unlink(s);
+      release_slab_(s);
+    }
+  }
+}
+
+auto slab_heap::lookup(const void* p) const noexcept -> const slab* {
+  const slab* s = slab::from_addr(p);
+  if (reinterpret_cast<uintptr_t>(p) - reinterpret_cast<uintptr_t>(s) <
+      slab::objs_offset)
+    return nullptr;  // Pointer into slab header can't be an object.
+
+  const lookup_bucket& b = lookup_bucket_(s);
+  semlock l{ b.lock };
+  for (const auto& i : b.slabs)
+    if (&i == s) return s;
+  return nullptr;
+}
+
+auto slab_heap::get_singleton() noexcept -> slab_heap& {
+  static _namespace(std)::once_flag guard;
+  static _namespace(std)::aligned_storage_t<sizeof(slab_heap),
+                                            alignof(slab_heap)> data;
+
+  void* data_ptr = reinterpret_cast<void*>(&data);
+  _namespace(std)::call_once(guard,
+                             [](void* ptr) { new (ptr) slab_heap; },
+                             data_ptr);
+  return *static_cast<slab_heap*>(data_ptr);
+}
+
+auto slab_heap::new_slab_(unsigned int cls) noexcept -> slab* {
+  void* addr = global_heap::get_singleton().allocate(slab_bytes, slab_bytes);
+  if (addr == nullptr) return nullptr;
+
+  slab* s = new (addr) slab(cls);
+  lookup_bucket& b = lookup_bucket_(s);
+  semlock l{ b.lock };
+  b.slabs.link_front(s);
+  return s;
+}
+
+auto slab_heap::release_slab_(slab* s) noexcept -> void {
+  {
+    lookup_bucket& b = lookup_bucket_(s);
+    semlock l{ b.lock };
+    b.slabs.unlink(s);
+  }
+  s->~slab();
+
+  bool succes;
+  _namespace(std)::tie(succes, _namespace(std)::ignore) =
+      global_heap::get_singleton().free(s);
+  assert(succes);
+}
+
+/* Slabs are aligned, so consecutive slabs land in consecutive buckets. */
+auto slab_heap::lookup_bucket_(const slab* s) noexcept -> lookup_bucket& {
+  const slab_heap& self = *this;
+  return const_cast<lookup_bucket&>(self.lookup_bucket_(s));
+}
+
+auto slab_heap::lookup_bucket_(const slab* s) const noexcept ->
+    const lookup_bucket& {
+  return lookup_[reinterpret_cast<uintptr_t>(s) / slab_bytes %
+                 n_lookup_buckets];
+}
+
+
+#if __has_include(<ilias/stats.h>)
+_namespace(ilias)::global_stats_group thread_cache_group{
+  &heap_group, "thread_cache", {}, {}
+};
+#endif
+
+/*
+ * Per-thread cache of slab objects.
+ *
+ * Each thread keeps a magazine of recently freed objects per size class.
+ * Allocation and deallocation operate on the magazine, which is refilled
+ * from or drained into the slab heap in batches, so the size class lock
+ * is only taken once per batch.
+ */
+class thread_cache {
+ public:
+  static constexpr unsigned int magazine_max = 32;
+
+  thread_cache() noexcept;
+  thread_cache(const thread_cache&) = delete;
+  thread_cache& operator=(const thread_cache&) = delete;
+  ~thread_cache() noexcept;
+
+  _namespace(std)::tuple<void*, bool> allocate(unsigned int) noexcept;
+  void free(unsigned int, const void*) noexcept;
+
+  static thread_cache* get() noexcept;
+
+ private:
+  struct magazine {
+    unsigned int n = 0;
+    void* objs[magazine_max];
+  };
+
+  static constexpr unsigned int capacity(unsigned int) noexcept;
+  void drain_(unsigned int, unsigned int) noexcept;
+
+  bool active_ = true;
+  magazine mags_[slab_heap::n_classes];
+
+#if __has_include(<ilias/stats.h>)
+  char name_[sizeof("thread_") + 3 * sizeof(unsigned long)];
+  _namespace(ilias)::stats_group group_;
+  _namespace(ilias)::stats_counter hit_;
+  _namespace(ilias)::stats_counter miss_;
+  _namespace(ilias)::stats_counter flush_;
+
+  static _namespace(std)::string_ref make_name_(char*, size_t) noexcept;
+#endif
+};
+
+
+thread_cache::thread_cache() noexcept
+#if __has_include(<ilias/stats.h>)
+: group_(thread_cache_group, make_name_(name_, sizeof(name_))),
+  hit_(group_, "hit"),
+  miss_(group_, "miss"),
+  flush_(group_, "flush")
+#endif
+{}
+
+thread_cache::~thread_cache() noexcept {
+  for (unsigned int cls = 0; cls < slab_heap::n_classes; ++cls)
+    drain_(cls, mags_[cls].n);
+  active_ = false;
+}
+
+auto thread_cache::allocate(unsigned int cls) noexcept ->
+    _namespace(std)::tuple<void*, bool> {
+  using _namespace(std)::tie;
+  using _namespace(std)::make_tuple;
 
+  magazine& m = mags_[cls];
+  bool hit = true;
+
+  if (m.n == 0) {
+    /* Refill half the magazine, keeping room for frees. */
+#if __has_include(<ilias/stats.h>)
+    miss_.add();
+#endif
+    tie(m.n, hit) = slab_heap::get_singleton().allocate_batch(
+        cls, m.objs, (capacity(cls) + 1U) / 2U);
+    if (m.n == 0) return make_tuple(nullptr, false);
+  } else {
+#if __has_include(<ilias/stats.h>)
+    hit_.add();
+#endif
+  }
+
+  return make_tuple(m.objs[--m.n], hit);
+}
+
+auto thread_cache::free(unsigned int cls, const void* p) noexcept -> void {
+  magazine& m = mags_[cls];
+
+  if (m.n == capacity(cls)) drain_(cls, capacity(cls) / 2U);
+  m.objs[m.n++] = const_cast<void*>(p);
+}
+
+auto thread_cache::get() noexcept -> thread_cache* {
+  static thread_local thread_cache impl;
+  return (impl.active_ ? &impl : nullptr);
+}
+
+/* Limit the number of bytes held per size class. */
+constexpr auto thread_cache::capacity(unsigned int cls) noexcept ->
+    unsigned int {
+  return (slab_heap::class_size(cls) <= 8192U / magazine_max ?
+          magazine_max :
+          (8192U / slab_heap::class_size(cls) < 4U ?
+           4U :
+           8192U / slab_heap::class_size(cls)));
+}
+
+/* Hand back the n least recently freed objects to the slab heap. */
+auto thread_cache::drain_(unsigned int cls, unsigned int n) noexcept -> void {
+  magazine& m = mags_[cls];
+  assert(n <= m.n);
+  if (n == 0) return;
+
+#if __has_include(<ilias/stats.h>)
+  flush_.add();
+#endif
+  slab_heap::get_singleton().free_batch(cls, m.objs, n);
+  _namespace(std)::copy(m.objs + n, m.objs + m.n, m.objs);
+  m.n -= n;
+}
+
+#if __has_include(<ilias/stats.h>)
+auto thread_cache::make_name_(char* buf, size_t len) noexcept ->
+    _namespace(std)::string_ref {
+  static _namespace(std)::atomic<unsigned long> seq{ 0 };
+
+  unsigned long id = seq.fetch_add(1U, _namespace(std)::memory_order_relaxed);
+  char digits[3 * sizeof(unsigned long)];
+  char* d = digits;
+  do {
+    *d++ = '0' + id % 10U;
+    id /= 10U;
+  } while (id != 0);
+
+  const char prefix[] = "thread_";
+  char* out = _namespace(std)::copy(prefix, prefix + sizeof(prefix) - 1U, buf);
+  while (d != digits) *out++ = *--d;
+  assert(out <= buf + len);
+  return _namespace(std)::string_ref(buf, out - buf);
+}
+#endif
+
+
+/* Release a slab object, via the thread cache if possible. */
+void slab_free(unsigned int cls, const void* p) noexcept {
+  thread_cache* tc = thread_cache::get();
+  if (tc) {
+    tc->free(cls, p);
+  } else {
+    void* obj = const_cast<void*>(p);
+    slab_heap::get_singleton().free_batch(cls, &obj, 1);
+  }
+}
 
 } /* namespace __cxxabiv1::ext::<unnamed> */
 
@@ -508,7 +1454,21 @@ heap::heap(_namespace(std)::string_ref name) noexcept
 heap::~heap() noexcept {}
 
 auto heap::malloc(size_t sz, size_t align) noexcept -> void* {
-  using _namespace(std)::min;
+  using _namespace(std)::tie;
+
+  const profile_entry entry{ __builtin_frame_address(0) };
+  if (slab_heap::eligible(sz, align)) {
+    const unsigned int cls = slab_heap::size_class(sz);
+    void* rv;
+    bool hit;
+    thread_cache* tc = thread_cache::get();
+    if (tc)
+      tie(rv, hit) = tc->allocate(cls);
+    else
+      tie(rv, hit) = slab_heap::get_singleton().allocate(cls);
+    if (rv) (hit ? stats_.slab_hit : stats_.slab_miss).add(cls);
+    return malloc_result(rv, slab_heap::class_size(cls));
+  }
 
   const size_t args = sz;
   void*const rv = global_heap::get_singleton().allocate(sz, align);
@@ -516,6 +1476,7 @@ auto heap::malloc(size_t sz, size_t align) noexcept -> void* {
 }
 
 auto heap::malloc(size_t sz) noexcept -> void* {
+  const profile_entry entry{ __builtin_frame_address(0) };
   size_t align = _namespace(std)::min(size_t(1) << log2_down(sz),
                                       alignof(max_align_t));
   return malloc(sz, align);
@@ -530,30 +1491,198 @@ auto heap::free(const void* p) noexcept -> void {
     return;
   }
 
-  bool succes;
   size_t size;
-  tie(succes, size) = global_heap::get_singleton().free(p);
-  if (!succes) panic("heap::free for %p, which is not allocated.", args);
+  const slab_heap::slab* s = slab_heap::get_singleton().lookup(p);
+  if (s != nullptr) {
+    const unsigned int cls = s->size_class();
+    slab_free(cls, p);
+    size = slab_heap::class_size(cls);
+  } else {
+    bool succes;
+    tie(succes, size) = global_heap::get_singleton().free(p);
+    if (!succes) panic("heap::free for %p, which is not allocated.", args);
+  }
   free_result(size, args);
 }
 
+/*
+ * Sized free.
+ *
+ * Contract: p must have been returned by malloc(size_t) with size sz,
+ * and may not have been resized since.  Small allocations made that way
+ * are always served by the slab heap (malloc(size_t) never asks for more
+ * than the alignment of the size class), so the size class follows from
+ * the size and the slab lookup can be skipped.
+ * Memory from malloc(size_t, size_t) must be released using free(p).
+ *
+ * The contract is verified in debug builds only: the lookup is exactly
+ * the cost this function exists to avoid.
+ */
+auto heap::free(const void* p, size_t sz) noexcept -> void {
+  if (_predict_false(p == nullptr) || sz > slab_heap::max_size) {
+    free(p);
+    return;
+  }
+
+  const unsigned int cls = slab_heap::size_class(sz);
+  assert(slab_heap::eligible(sz, _namespace(std)::min(
+      size_t(1) << log2_down(sz), alignof(max_align_t))));
+  assert(slab_heap::get_singleton().lookup(p) != nullptr &&
+         slab_heap::get_singleton().lookup(p)->size_class() == cls);
+  slab_free(cls, p);
+  free_result(slab_heap::class_size(cls), p);
+}
+
 auto heap::resize(const void* p, size_t nsz) noexcept ->
     _namespace(std)::tuple<bool, size_t> {
   using _namespace(std)::make_tuple;
 
   const auto args = make_tuple(p, nsz);
+
+  /* Slab objects can change size only within their size class. */
+  const slab_heap::slab* s = slab_heap::get_singleton().lookup(p);
+  if (s != nullptr) {
+    const size_t osz = slab_heap::class_size(s->size_class());
+    return resize_result(make_tuple(nsz <= osz, osz), make_tuple(p, osz));
+  }
+
   return resize_result(global_heap::get_singleton().resize(p, nsz), args);
 }
 
+/*
+ * Enable sampling of allocations.
+ *
+ * Every n-th allocation is recorded in the sampled size histogram and
+ * the allocation site table.  An interval of 0 disables sampling.
+ */
+auto heap::set_sample_interval(unsigned int n) noexcept -> void {
+  using _namespace(std)::memory_order_relaxed;
+
+  sample_countdown_.store(n, memory_order_relaxed);
+  sample_interval_.store(n, memory_order_relaxed);
+}
+
+auto heap::sample_(size_t sz) noexcept -> void {
+  using _namespace(std)::memory_order_relaxed;
+
+  const unsigned int interval = sample_interval_.load(memory_order_relaxed);
+  if (interval == 0U) return;
+  if (sample_countdown_.fetch_sub(1U, memory_order_relaxed) != 1U) return;
+  sample_countdown_.fetch_add(interval, memory_order_relaxed);
 
 #if __has_include(<ilias/stats.h>)
-namespace {
+  stats_.sample_size.add(_namespace(std)::min(size_t(log2_up(sz)),
+                                              n_size_buckets - 1U));
 
-_namespace(ilias)::global_stats_group heap_group{
-  &abi_ext_group, "heap", {}, {}
-};
+  /*
+   * Walk the frame pointer chain to find the allocation site.
+   * Frames up to the outermost profile_entry belong to the allocator and
+   * are skipped; the return address in that frame is the first frame of
+   * the allocation site.
+   * A frame is only followed if it lies above the current one,
+   * which stops the walk at the bottom of the stack.
+   */
+  const void*const entry = profile_entry::frame_;
+  const void* trace[profile_depth] = {};
+  size_t depth = 0;
+  const void*const* fp =
+      static_cast<const void*const*>(__builtin_frame_address(0));
+  for (bool skip = true; fp != nullptr && depth < profile_depth; ) {
+    const void*const* next = static_cast<const void*const*>(fp[0]);
+    if (fp == entry) skip = false;
+    if (!skip) trace[depth++] = fp[1];
+    if (next <= fp) break;
+    fp = next;
+  }
+
+  stats_.sample_sites.record(trace, sz);
+#endif /* __has_include(<ilias/stats.h>) */
+}
+
+
+#if __has_include(<ilias/stats.h>)
+thread_local const void* heap::profile_entry::frame_ = nullptr;
+
+heap::profile_sites::profile_sites(_namespace(ilias)::stats_group& parent,
+                                   _namespace(std)::string_ref name) noexcept
+: stats_leaf(parent, name)
+{
+  init();
+}
+
+heap::profile_sites::~profile_sites() noexcept {
+  deinit();
+}
+
+auto heap::profile_sites::record(const void*const* trace, size_t sz)
+    noexcept -> void {
+  using _namespace(std)::begin;
+  using _namespace(std)::end;
+  using _namespace(std)::equal;
+  using _namespace(std)::copy_n;
+
+  semlock l{ lock_ };
+
+  auto sites_end = sites_.begin() + n_;
+  auto i = _namespace(std)::find_if(sites_.begin(), sites_end,
+                                    [trace](const site& s) {
+                                      return equal(begin(s.trace),
+                                                   end(s.trace), trace);
+                                    });
+  if (i == sites_end) {
+    if (n_ == sites_.size()) {
+      ++overflow_;
+      return;
+    }
+    ++n_;
+    copy_n(trace, profile_depth, begin(i->trace));
+    i->count = 0;
+    i->bytes = 0;
+  }
+  ++i->count;
+  i->bytes += sz;
+}
+
+auto heap::profile_sites::as_properties(_namespace(std)::ostream& out) const ->
+    void {
+  using _namespace(std)::string_ref;
+
+  /* Copy the table, printing may allocate memory. */
+  _namespace(std)::array<site, n_profile_sites> sites;
+  size_t n;
+  uint64_t overflow;
+  {
+    semlock l{ lock_ };
+    sites = sites_;
+    n = n_;
+    overflow = overflow_;
+  }
+
+  bool first = true;
+  for (string_ref path_elem : path()) {
+    if (first)
+      first = false;
+    else
+      out << ".";
+    out << path_elem;
+  }
+
+  out << " = [ ";
+  for (size_t i = 0; i < n; ++i) {
+    if (i != 0) out << ", ";
+    for (size_t d = 0; d < profile_depth && sites[i].trace[d]; ++d) {
+      if (d != 0) out << "/";
+      out << sites[i].trace[d];
+    }
+    out << ": " << sites[i].count << "/" << sites[i].bytes;
+  }
+  if (overflow != 0) {
+    if (n != 0) out << ", ";
+    out << "overflow: " << overflow;
+  }
+  out << " ]";
+}
 
-} /* namespace abi::ext::<unnamed> */
 
 heap::stats_data::stats_data(_namespace(std)::string_ref name) noexcept
 : group(heap_group, name),
@@ -565,7 +1694,12 @@ heap::stats_data::stats_data(_namespace(std)::string_ref name) noexcept
   resize_bytes_down(group, "resize_bytes_down"),
   free_bytes(group, "free_bytes"),
   malloc_fail(group, "malloc_fail"),
-  resize_fail(group, "resize_fail")
+  resize_fail(group, "resize_fail"),
+  live_bytes(group, "live_bytes"),
+  slab_hit(group, "slab_hit"),
+  slab_miss(group, "slab_miss"),
+  sample_size(group, "sample_size"),
+  sample_sites(group, "sample_sites")
 {}
 #endif /* __has_include(<ilias/stats.h>) */
 
@@ -240,6 +240,7 @@ int at_quick_exit(void (*fn)()) noexcept {
 
 
 void* __attribute__((weak)) malloc(size_t sz) noexcept {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   try {
     return c_malloc_heap().malloc(max(sz, size_t(1)));
   } catch (...) {
@@ -249,6 +250,7 @@ void* __attribute__((weak)) malloc(size_t sz) noexcept {
 }
 
 void* __attribute__((weak)) calloc(size_t nmemb, size_t sz) noexcept {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   using abi::umul_overflow;
 
   try {
@@ -271,6 +273,7 @@ void __attribute__((weak)) free(void* p) noexcept {
 }
 
 void* __attribute__((weak)) realloc(void* p, size_t sz) noexcept {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   if (_predict_false(sz == 0)) {
     free(p);
     return nullptr;
@@ -299,6 +302,7 @@ void* __attribute__((weak)) realloc(void* p, size_t sz) noexcept {
 
 void* __attribute__((weak)) reallocarray(void* p, size_t nmemb, size_t sz)
     noexcept {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   using abi::umul_overflow;
 
   try {
@@ -377,12 +381,9 @@ class stride_iterator
   }
 
   stride_iterator operator++(int) noexcept {
-#if 0
     stride_iterator clone = *this;
     ++*this;
     return clone;
-#endif
-    return *this;
   }
 
   stride_iterator operator--(int) noexcept {
@@ -392,7 +393,7 @@ class stride_iterator
   }
 
   difference_type operator-(const stride_iterator& other) const noexcept {
-    return (other.ref_.addr_ - ref_.addr_) / ref_.stride_;
+    return (ref_.addr_ - other.ref_.addr_) / difference_type(ref_.stride_);
   }
 
   stride_iterator& operator+=(difference_type n) noexcept {
@@ -429,24 +430,22 @@ stride_iterator stride_reference::operator&() const noexcept {
 }
 
 void iter_swap(stride_iterator x, stride_iterator y) noexcept {
-  using _namespace(std)::swap;
-
-  assert(x.get_addr() == y.get_addr());
   assert(x.get_stride() == y.get_stride());
 
   size_t stride = x.get_stride();
   uint8_t* x_i = static_cast<uint8_t*>(x.get_addr());
   uint8_t* y_i = static_cast<uint8_t*>(y.get_addr());
 
-  auto tmp = unique_ptr<uint8_t, decltype(&return_temporary_buffer<uint8_t>)>(
-      get<0>(get_temporary_buffer<uint8_t>(stride)),
-      &return_temporary_buffer<uint8_t>);
-  if (_predict_true(tmp)) {
-    memcpy(tmp.get(), x_i, stride);
-    memcpy(x_i, y_i, stride);
-    memcpy(y_i, tmp.get(), stride);
-  } else {
-    while (stride-- > 0) swap(*x_i++, *y_i++);
+  /* Swap in chunks, instead of allocating a buffer for each swap. */
+  uint8_t tmp[64];
+  while (stride > 0) {
+    const size_t n = min(stride, sizeof(tmp));
+    memcpy(tmp, x_i, n);
+    memcpy(x_i, y_i, n);
+    memcpy(y_i, tmp, n);
+    x_i += n;
+    y_i += n;
+    stride -= n;
   }
 }
 
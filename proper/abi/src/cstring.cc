@@ -1,6 +1,8 @@
 #include <abi/ext/reader.h>
 #include <abi/errno.h>
 #include <abi/memory.h>
+#include <abi/misc_int.h>
+#include <ilias/cpuid.h>
 #include <cstring>
 #include <sstream>
 #include <cstdint>
@@ -9,6 +11,7 @@
 #include <locale>
 #include <type_traits>
 #include <algorithm>
+#include <atomic>
 #include <stdimpl/exc_errno.h>
 #include <stdimpl/locale_catalogs.h>
 
@@ -147,10 +150,6 @@ size_t strxfrm_l(char*__restrict a, const char*__restrict b, size_t n,
 }
 
 
-size_t strlen(const char* s) noexcept {
-  return abi::ext::strlen(s);
-}
-
 int strcmp(const char* a, const char* b) noexcept {
   auto ra = reader<DIR_FORWARD, uint8_t>(a);
   auto rb = reader<DIR_FORWARD, uint8_t>(b);
@@ -191,8 +190,10 @@ int memcmp(const void* a, const void* b, size_t len) noexcept {
                           len);
 }
 
-void* memcpy(void*__restrict dst, const void*__restrict src, size_t len)
-    noexcept {
+namespace {
+
+void* memcpy_generic(void*__restrict dst, const void*__restrict src,
+                     size_t len) noexcept {
   if (len == 0) return dst;  // Reader needs at least 1 readable byte.
   void*const orig_dst = dst;
   auto r = reader<DIR_FORWARD, uint8_t>(src, len);
@@ -227,7 +228,7 @@ void* memcpy(void*__restrict dst, const void*__restrict src, size_t len)
   return orig_dst;
 }
 
-void* memmove(void* dst, const void* src, size_t len) noexcept {
+void* memmove_generic(void* dst, const void* src, size_t len) noexcept {
   if (len == 0 || dst == src) return dst;  // Reader needs at least 1 byte.
   void*const orig_dst = dst;
 
@@ -307,15 +308,7 @@ void* memmove(void* dst, const void* src, size_t len) noexcept {
   return orig_dst;
 }
 
-void bcopy(const void* src, void* dst, size_t len) noexcept {
-  memmove(dst, src, len);
-}
-
-void bzero(void* p, size_t len) noexcept {
-  abi::memzero(p, len);
-}
-
-void* memset(void* p, int c, size_t len) noexcept {
+void* memset_generic(void* p, int c, size_t len) noexcept {
   /* Repeating pattern of byte c. */
   const align_t cc = repeat(align_t(c & 0xff), 8);
 
@@ -352,14 +345,689 @@ void* memset(void* p, int c, size_t len) noexcept {
   return p;
 }
 
-const void* memchr(const void* p, int c, size_t len) noexcept {
+/*
+ * CPU dispatched kernels for memcpy, memmove, memset and the scanning
+ * functions strlen, strchr, strnlen, memchr and memrchr.
+ *
+ * The kernels are selected on first use, using cpuid:
+ * - AVX2: 32 byte vector loads and stores,
+ *   provided the OS saves the ymm registers.
+ * - SSE2: 16 byte vector loads and stores (always present on amd64).
+ * - ERMS: large forward copies and fills use rep movsb/rep stosb.
+ * If none apply, the generic, word-at-a-time functions are used.
+ */
+using move_fn = void* (*)(void*, const void*, size_t);
+using set_fn = void* (*)(void*, int, size_t);
+using strlen_fn = size_t (*)(const char*);
+using strchr_fn = const char* (*)(const char*, int);
+using strnlen_fn = size_t (*)(const char*, size_t);
+using memchr_fn = const void* (*)(const void*, int, size_t);
+
+#if defined(__i386__) || defined(__amd64__) || defined(__x86_64__)
+/* Copies and fills of at least this many bytes use ERMS. */
+constexpr size_t erms_threshold = 2048;
+
+struct cpu_features {
+  bool sse2 = false;
+  bool avx2 = false;
+  bool erms = false;
+};
+
+cpu_features cstring_cpu_features() noexcept {
+  using namespace ::ilias::cpuid_feature_const;
+  using ::ilias::cpuid_feature_present;
+
+  cpu_features rv;
+  const uint32_t max_fn = ::ilias::cpuid_max_fn();
+  if (max_fn < 1U) return rv;
+
+  const auto features = ::ilias::cpuid_features();
+  rv.sse2 = cpuid_feature_present(sse2, features);
+
+  /* AVX is usable only if the OS saves the xmm and ymm state (XCR0). */
+  const bool ymm_state = cpuid_feature_present(osxsave, features) &&
+                         cpuid_feature_present(avx, features) &&
+                         (::ilias::xgetbv(0) & 0x6U) == 0x6U;
+  if (max_fn < 7U) return rv;
+
+  const uint32_t b = get<1>(::ilias::cpuid(7, 0));
+  rv.avx2 = ymm_state && (b & (1U << 5)) != 0U;
+  rv.erms = (b & (1U << 9)) != 0U;
+  return rv;
+}
+
+inline void rep_movsb(void* dst, const void* src, size_t len) noexcept {
+  asm volatile("rep movsb"
+  :            "+D"(dst), "+S"(src), "+c"(len)
+  :
+  :            "memory");
+}
+
+inline void rep_stosb(void* dst, int c, size_t len) noexcept {
+  asm volatile("rep stosb"
+  :            "+D"(dst), "+c"(len)
+  :            "a"(c)
+  :            "memory");
+}
+#endif /* x86 */
+
+#if defined(__i386__)
+void* memcpy_erms(void*__restrict dst, const void*__restrict src, size_t len)
+    noexcept {
+  if (len < erms_threshold) return memcpy_generic(dst, src, len);
+  rep_movsb(dst, src, len);
+  return dst;
+}
+
+void* memset_erms(void* p, int c, size_t len) noexcept {
+  if (len < erms_threshold) return memset_generic(p, c, len);
+  rep_stosb(p, c, len);
+  return p;
+}
+#endif /* __i386__ */
+
+#if defined(__amd64__) || defined(__x86_64__)
+/* Vector types, used by the vector kernels. */
+typedef uint8_t vec16_t __attribute__((__vector_size__(16)));
+typedef uint8_t vec32_t __attribute__((__vector_size__(32)));
+
+/* Wrapper for unaligned access. */
+template<typename T>
+struct __attribute__((__packed__, __may_alias__)) unaligned {
+  T v;
+};
+
+template<typename T>
+inline __attribute__((__always_inline__))
+auto load(const uint8_t* p) noexcept -> T {
+  return reinterpret_cast<const unaligned<T>*>(p)->v;
+}
+
+template<typename T>
+inline __attribute__((__always_inline__))
+auto store(uint8_t* p, T v) noexcept -> void {
+  reinterpret_cast<unaligned<T>*>(p)->v = v;
+}
+
+template<typename V>
+inline __attribute__((__always_inline__))
+auto splat(uint8_t c) noexcept -> V {
+  V v;
+  for (unsigned int i = 0; i < sizeof(V); ++i) v[i] = c;
+  return v;
+}
+
+/*
+ * Copy len < 16 bytes.
+ * All loads happen before the stores, so src and dst may overlap.
+ */
+inline __attribute__((__always_inline__))
+auto move_small(uint8_t* d, const uint8_t* s, size_t len) noexcept -> void {
+  if (len >= 8) {
+    const uint64_t head = load<uint64_t>(s);
+    const uint64_t tail = load<uint64_t>(s + len - 8U);
+    store<uint64_t>(d, head);
+    store<uint64_t>(d + len - 8U, tail);
+  } else if (len >= 4) {
+    const uint32_t head = load<uint32_t>(s);
+    const uint32_t tail = load<uint32_t>(s + len - 4U);
+    store<uint32_t>(d, head);
+    store<uint32_t>(d + len - 4U, tail);
+  } else if (len >= 2) {
+    const uint16_t head = load<uint16_t>(s);
+    const uint16_t tail = load<uint16_t>(s + len - 2U);
+    store<uint16_t>(d, head);
+    store<uint16_t>(d + len - 2U, tail);
+  } else if (len == 1) {
+    *d = *s;
+  }
+}
+
+/*
+ * Copy using vectors of type V, handles overlapping src and dst.
+ *
+ * The first and last vector of the source are loaded up front and
+ * stored last, using unaligned stores; the bytes in between are copied
+ * using stores aligned to the vector size.
+ * Every vector is loaded before the vectors overlapping it are stored,
+ * which makes the copy safe for overlap, if it runs forward when
+ * dst < src and backward when dst > src.
+ */
+template<typename V, bool Erms>
+inline __attribute__((__always_inline__))
+auto move_vec(void* dst, const void* src, size_t len) noexcept -> void* {
+  constexpr size_t W = sizeof(V);
+  uint8_t* d = static_cast<uint8_t*>(dst);
+  const uint8_t* s = static_cast<const uint8_t*>(src);
+
+  if (len < 16U) {
+    move_small(d, s, len);
+    return dst;
+  }
+  if (len <= 32U) {
+    const vec16_t head = load<vec16_t>(s);
+    const vec16_t tail = load<vec16_t>(s + len - 16U);
+    store<vec16_t>(d, head);
+    store<vec16_t>(d + len - 16U, tail);
+    return dst;
+  }
+  if (len <= 2U * W) {
+    const V head = load<V>(s);
+    const V tail = load<V>(s + len - W);
+    store<V>(d, head);
+    store<V>(d + len - W, tail);
+    return dst;
+  }
+
+  if (Erms && len >= erms_threshold && (d + len <= s || s + len <= d)) {
+    rep_movsb(d, s, len);
+    return dst;
+  }
+
+  const V head = load<V>(s);
+  const V tail = load<V>(s + len - W);
+  if (d <= s || d >= s + len) {
+    size_t i = W - (reinterpret_cast<uintptr_t>(d) & (W - 1U));
+    for (; i + 4U * W <= len - W; i += 4U * W) {
+      const V v0 = load<V>(s + i);
+      const V v1 = load<V>(s + i + W);
+      const V v2 = load<V>(s + i + 2U * W);
+      const V v3 = load<V>(s + i + 3U * W);
+      store<V>(d + i, v0);
+      store<V>(d + i + W, v1);
+      store<V>(d + i + 2U * W, v2);
+      store<V>(d + i + 3U * W, v3);
+    }
+    for (; i < len - W; i += W) store<V>(d + i, load<V>(s + i));
+  } else {
+    size_t j = (reinterpret_cast<uintptr_t>(d + len) & ~uintptr_t(W - 1U)) -
+               reinterpret_cast<uintptr_t>(d);
+    for (; j >= 5U * W; j -= 4U * W) {
+      const V v3 = load<V>(s + j - W);
+      const V v2 = load<V>(s + j - 2U * W);
+      const V v1 = load<V>(s + j - 3U * W);
+      const V v0 = load<V>(s + j - 4U * W);
+      store<V>(d + j - W, v3);
+      store<V>(d + j - 2U * W, v2);
+      store<V>(d + j - 3U * W, v1);
+      store<V>(d + j - 4U * W, v0);
+    }
+    for (; j > W; j -= W) store<V>(d + j - W, load<V>(s + j - W));
+  }
+  store<V>(d, head);
+  store<V>(d + len - W, tail);
+  return dst;
+}
+
+/* Fill using vectors of type V. */
+template<typename V, bool Erms>
+inline __attribute__((__always_inline__))
+auto set_vec(void* p, int c, size_t len) noexcept -> void* {
+  constexpr size_t W = sizeof(V);
+  uint8_t* d = static_cast<uint8_t*>(p);
+
+  if (len < 16U) {
+    const uint64_t cc = uint64_t(uint8_t(c)) * 0x0101010101010101ULL;
+    if (len >= 8) {
+      store<uint64_t>(d, cc);
+      store<uint64_t>(d + len - 8U, cc);
+    } else if (len >= 4) {
+      store<uint32_t>(d, uint32_t(cc));
+      store<uint32_t>(d + len - 4U, uint32_t(cc));
+    } else if (len >= 2) {
+      store<uint16_t>(d, uint16_t(cc));
+      store<uint16_t>(d + len - 2U, uint16_t(cc));
+    } else if (len == 1) {
+      *d = uint8_t(c);
+    }
+    return p;
+  }
+  if (len <= 32U) {
+    const vec16_t v = splat<vec16_t>(c);
+    store<vec16_t>(d, v);
+    store<vec16_t>(d + len - 16U, v);
+    return p;
+  }
+
+  if (Erms && len >= erms_threshold) {
+    rep_stosb(p, c, len);
+    return p;
+  }
+
+  const V v = splat<V>(c);
+  store<V>(d, v);
+  if (len > W) {
+    size_t i = W - (reinterpret_cast<uintptr_t>(d) & (W - 1U));
+    for (; i + 4U * W <= len - W; i += 4U * W) {
+      store<V>(d + i, v);
+      store<V>(d + i + W, v);
+      store<V>(d + i + 2U * W, v);
+      store<V>(d + i + 3U * W, v);
+    }
+    for (; i < len - W; i += W) store<V>(d + i, v);
+  }
+  store<V>(d + len - W, v);
+  return p;
+}
+
+void* memmove_sse2(void* dst, const void* src, size_t len) noexcept {
+  return move_vec<vec16_t, false>(dst, src, len);
+}
+
+void* memmove_sse2_erms(void* dst, const void* src, size_t len) noexcept {
+  return move_vec<vec16_t, true>(dst, src, len);
+}
+
+__attribute__((__target__("avx2")))
+void* memmove_avx2(void* dst, const void* src, size_t len) noexcept {
+  return move_vec<vec32_t, false>(dst, src, len);
+}
+
+__attribute__((__target__("avx2")))
+void* memmove_avx2_erms(void* dst, const void* src, size_t len) noexcept {
+  return move_vec<vec32_t, true>(dst, src, len);
+}
+
+void* memset_sse2(void* p, int c, size_t len) noexcept {
+  return set_vec<vec16_t, false>(p, c, len);
+}
+
+void* memset_sse2_erms(void* p, int c, size_t len) noexcept {
+  return set_vec<vec16_t, true>(p, c, len);
+}
+
+__attribute__((__target__("avx2")))
+void* memset_avx2(void* p, int c, size_t len) noexcept {
+  return set_vec<vec32_t, false>(p, c, len);
+}
+
+__attribute__((__target__("avx2")))
+void* memset_avx2_erms(void* p, int c, size_t len) noexcept {
+  return set_vec<vec32_t, true>(p, c, len);
+}
+
+/*
+ * Scan kernels for strlen, strchr, strnlen, memchr and memrchr.
+ *
+ * These only load aligned vectors: the start of the range is rounded
+ * down to the vector size and bytes outside the range are masked off.
+ * An aligned vector never crosses a page boundary, so reading outside
+ * the range can't fault.
+ */
+inline __attribute__((__always_inline__))
+auto movemask(vec16_t v) noexcept -> uint32_t {
+  typedef char vec16c_t __attribute__((__vector_size__(16)));
+  return uint32_t(__builtin_ia32_pmovmskb128((vec16c_t)v)) & 0xffffU;
+}
+
+/*
+ * Computed on the 128-bit halves, so this function doesn't require
+ * AVX2 itself.  Inlined into an AVX2 kernel, the compare is still
+ * done on the full vector.
+ */
+inline __attribute__((__always_inline__))
+auto movemask(vec32_t v) noexcept -> uint32_t {
+  union {
+    vec32_t v;
+    vec16_t h[2];
+  } u;
+  u.v = v;
+  return movemask(u.h[0]) | (movemask(u.h[1]) << 16);
+}
+
+/* Bitmask of bytes in the aligned vector at p, that equal c. */
+template<typename V>
+inline __attribute__((__always_inline__))
+auto eq_mask(const uint8_t* p, uint8_t c) noexcept -> uint32_t {
+  const V v = load<V>(p);
+  return movemask((V)(v == splat<V>(c)));
+}
+
+/* Bitmask of bytes in the aligned vector at p, that equal c or 0. */
+template<typename V>
+inline __attribute__((__always_inline__))
+auto eq0_mask(const uint8_t* p, uint8_t c) noexcept -> uint32_t {
+  const V v = load<V>(p);
+  return movemask((V)((v == splat<V>(c)) | (v == splat<V>(0))));
+}
+
+/* Bitmask with the low n bits set, n <= 32. */
+inline __attribute__((__always_inline__))
+auto low_bits(size_t n) noexcept -> uint32_t {
+  return uint32_t((uint64_t(1) << n) - 1U);
+}
+
+template<typename V>
+inline __attribute__((__always_inline__))
+auto align_down(const void* p) noexcept -> const uint8_t* {
+  return reinterpret_cast<const uint8_t*>(
+      reinterpret_cast<uintptr_t>(p) & ~uintptr_t(sizeof(V) - 1U));
+}
+
+template<typename V>
+inline __attribute__((__always_inline__))
+auto strlen_vec(const char* s) noexcept -> size_t {
+  const uint8_t* p = align_down<V>(s);
+  uint32_t m = eq_mask<V>(p, 0) >> (reinterpret_cast<const uint8_t*>(s) - p);
+  if (m != 0U) return abi::ctz(m);
+
+  for (;;) {
+    p += sizeof(V);
+    m = eq_mask<V>(p, 0);
+    if (m != 0U) return reinterpret_cast<const char*>(p) + abi::ctz(m) - s;
+  }
+}
+
+template<typename V>
+inline __attribute__((__always_inline__))
+auto strchr_vec(const char* s, int c) noexcept -> const char* {
+  const uint8_t cc = uint8_t(c);
+  const uint8_t* p = align_down<V>(s);
+  uint32_t m = eq0_mask<V>(p, cc) >> (reinterpret_cast<const uint8_t*>(s) - p);
+  if (m != 0U) p = reinterpret_cast<const uint8_t*>(s);
+
+  while (m == 0U) {
+    p += sizeof(V);
+    m = eq0_mask<V>(p, cc);
+  }
+  p += abi::ctz(m);
+  return (*p == cc ? reinterpret_cast<const char*>(p) : nullptr);
+}
+
+template<typename V>
+inline __attribute__((__always_inline__))
+auto memchr_vec(const void* b, int c, size_t len) noexcept -> const void* {
+  const uint8_t cc = uint8_t(c);
+  if (len == 0) return nullptr;
+
+  const uint8_t* p = align_down<V>(b);
+  const size_t off = static_cast<const uint8_t*>(b) - p;
+  uint32_t m = eq_mask<V>(p, cc) >> off;
+  if (len <= sizeof(V) - off) {
+    m &= low_bits(len);
+    return (m != 0U ? static_cast<const uint8_t*>(b) + abi::ctz(m) : nullptr);
+  }
+  if (m != 0U) return static_cast<const uint8_t*>(b) + abi::ctz(m);
+  len -= sizeof(V) - off;
+
+  for (p += sizeof(V); len >= sizeof(V); p += sizeof(V), len -= sizeof(V)) {
+    m = eq_mask<V>(p, cc);
+    if (m != 0U) return p + abi::ctz(m);
+  }
+  if (len == 0) return nullptr;
+  m = eq_mask<V>(p, cc) & low_bits(len);
+  return (m != 0U ? p + abi::ctz(m) : nullptr);
+}
+
+template<typename V>
+inline __attribute__((__always_inline__))
+auto memrchr_vec(const void* b, int c, size_t len) noexcept -> const void* {
+  const uint8_t cc = uint8_t(c);
+  if (len == 0) return nullptr;
+
+  const uint8_t* begin = static_cast<const uint8_t*>(b);
+  const uint8_t* end = begin + len;
+  const uint8_t* p = align_down<V>(end - 1);
+  uint32_t m = eq_mask<V>(p, cc) & low_bits(end - p);
+  while (p > begin) {
+    if (m != 0U) return p + 31 - abi::clz(m);
+    p -= sizeof(V);
+    m = eq_mask<V>(p, cc);
+  }
+
+  m &= ~low_bits(begin - p);
+  return (m != 0U ? p + 31 - abi::clz(m) : nullptr);
+}
+
+template<typename V>
+inline __attribute__((__always_inline__))
+auto strnlen_vec(const char* s, size_t len) noexcept -> size_t {
+  const void* z = memchr_vec<V>(s, 0, len);
+  return (z != nullptr ? static_cast<const char*>(z) - s : len);
+}
+
+size_t strlen_sse2(const char* s) noexcept {
+  return strlen_vec<vec16_t>(s);
+}
+
+const char* strchr_sse2(const char* s, int c) noexcept {
+  return strchr_vec<vec16_t>(s, c);
+}
+
+const void* memchr_sse2(const void* p, int c, size_t len) noexcept {
+  return memchr_vec<vec16_t>(p, c, len);
+}
+
+const void* memrchr_sse2(const void* p, int c, size_t len) noexcept {
+  return memrchr_vec<vec16_t>(p, c, len);
+}
+
+size_t strnlen_sse2(const char* s, size_t len) noexcept {
+  return strnlen_vec<vec16_t>(s, len);
+}
+
+__attribute__((__target__("avx2")))
+size_t strlen_avx2(const char* s) noexcept {
+  return strlen_vec<vec32_t>(s);
+}
+
+__attribute__((__target__("avx2")))
+const char* strchr_avx2(const char* s, int c) noexcept {
+  return strchr_vec<vec32_t>(s, c);
+}
+
+__attribute__((__target__("avx2")))
+const void* memchr_avx2(const void* p, int c, size_t len) noexcept {
+  return memchr_vec<vec32_t>(p, c, len);
+}
+
+__attribute__((__target__("avx2")))
+const void* memrchr_avx2(const void* p, int c, size_t len) noexcept {
+  return memrchr_vec<vec32_t>(p, c, len);
+}
+
+__attribute__((__target__("avx2")))
+size_t strnlen_avx2(const char* s, size_t len) noexcept {
+  return strnlen_vec<vec32_t>(s, len);
+}
+#endif /* amd64 */
+
+size_t strlen_generic(const char*) noexcept;
+const char* strchr_generic(const char*, int) noexcept;
+size_t strnlen_generic(const char*, size_t) noexcept;
+const void* memchr_generic(const void*, int, size_t) noexcept;
+const void* memrchr_generic(const void*, int, size_t) noexcept;
+
+void* memcpy_select(void*__restrict, const void*__restrict, size_t) noexcept;
+void* memmove_select(void*, const void*, size_t) noexcept;
+void* memset_select(void*, int, size_t) noexcept;
+size_t strlen_select(const char*) noexcept;
+const char* strchr_select(const char*, int) noexcept;
+size_t strnlen_select(const char*, size_t) noexcept;
+const void* memchr_select(const void*, int, size_t) noexcept;
+const void* memrchr_select(const void*, int, size_t) noexcept;
+
+atomic<move_fn> memcpy_kernel{ &memcpy_select };
+atomic<move_fn> memmove_kernel{ &memmove_select };
+atomic<set_fn> memset_kernel{ &memset_select };
+atomic<strlen_fn> strlen_kernel{ &strlen_select };
+atomic<strchr_fn> strchr_kernel{ &strchr_select };
+atomic<strnlen_fn> strnlen_kernel{ &strnlen_select };
+atomic<memchr_fn> memchr_kernel{ &memchr_select };
+atomic<memchr_fn> memrchr_kernel{ &memrchr_select };
+
+/*
+ * Select the kernels for this cpu.
+ * Selection is idempotent, so concurrent first calls are harmless.
+ */
+void select_kernels() noexcept {
+  move_fn cpy = &memcpy_generic;
+  move_fn mov = &memmove_generic;
+  set_fn set = &memset_generic;
+  strlen_fn slen = &strlen_generic;
+  strchr_fn schr = &strchr_generic;
+  strnlen_fn snlen = &strnlen_generic;
+  memchr_fn mchr = &memchr_generic;
+  memchr_fn mrchr = &memrchr_generic;
+
+#if defined(__amd64__) || defined(__x86_64__)
+  const cpu_features f = cstring_cpu_features();
+  if (f.avx2) {
+    cpy = mov = (f.erms ? &memmove_avx2_erms : &memmove_avx2);
+    set = (f.erms ? &memset_avx2_erms : &memset_avx2);
+    slen = &strlen_avx2;
+    schr = &strchr_avx2;
+    snlen = &strnlen_avx2;
+    mchr = &memchr_avx2;
+    mrchr = &memrchr_avx2;
+  } else if (f.sse2) {
+    cpy = mov = (f.erms ? &memmove_sse2_erms : &memmove_sse2);
+    set = (f.erms ? &memset_sse2_erms : &memset_sse2);
+    slen = &strlen_sse2;
+    schr = &strchr_sse2;
+    snlen = &strnlen_sse2;
+    mchr = &memchr_sse2;
+    mrchr = &memrchr_sse2;
+  }
+#elif defined(__i386__)
+  const cpu_features f = cstring_cpu_features();
+  if (f.erms) {
+    cpy = &memcpy_erms;
+    set = &memset_erms;
+  }
+#endif
+
+  memcpy_kernel.store(cpy, memory_order_relaxed);
+  memmove_kernel.store(mov, memory_order_relaxed);
+  memset_kernel.store(set, memory_order_relaxed);
+  strlen_kernel.store(slen, memory_order_relaxed);
+  strchr_kernel.store(schr, memory_order_relaxed);
+  strnlen_kernel.store(snlen, memory_order_relaxed);
+  memchr_kernel.store(mchr, memory_order_relaxed);
+  memrchr_kernel.store(mrchr, memory_order_relaxed);
+}
+
+void* memcpy_select(void*__restrict dst, const void*__restrict src,
+                    size_t len) noexcept {
+  select_kernels();
+  return memcpy_kernel.load(memory_order_relaxed)(dst, src, len);
+}
+
+void* memmove_select(void* dst, const void* src, size_t len) noexcept {
+  select_kernels();
+  return memmove_kernel.load(memory_order_relaxed)(dst, src, len);
+}
+
+void* memset_select(void* p, int c, size_t len) noexcept {
+  select_kernels();
+  return memset_kernel.load(memory_order_relaxed)(p, c, len);
+}
+
+size_t strlen_select(const char* s) noexcept {
+  select_kernels();
+  return strlen_kernel.load(memory_order_relaxed)(s);
+}
+
+const char* strchr_select(const char* s, int c) noexcept {
+  select_kernels();
+  return strchr_kernel.load(memory_order_relaxed)(s, c);
+}
+
+size_t strnlen_select(const char* s, size_t len) noexcept {
+  select_kernels();
+  return strnlen_kernel.load(memory_order_relaxed)(s, len);
+}
+
+const void* memchr_select(const void* p, int c, size_t len) noexcept {
+  select_kernels();
+  return memchr_kernel.load(memory_order_relaxed)(p, c, len);
+}
+
+const void* memrchr_select(const void* p, int c, size_t len) noexcept {
+  select_kernels();
+  return memrchr_kernel.load(memory_order_relaxed)(p, c, len);
+}
+
+size_t strlen_generic(const char* s) noexcept {
+  return abi::ext::strlen(s);
+}
+
+const void* memchr_generic(const void* p, int c, size_t len) noexcept {
   return abi::ext::memchr(static_cast<const char*>(p), len, char(c));
 }
 
-const void* memrchr(const void* p, int c, size_t len) noexcept {
+const void* memrchr_generic(const void* p, int c, size_t len) noexcept {
   return abi::ext::memrchr(static_cast<const char*>(p), len, char(c));
 }
 
+} /* namespace std::<unnamed> */
+
+#ifdef _TEST
+/*
+ * Test support: store the memmove kernels this cpu can run in kernels,
+ * and their names in names.  Returns the number of kernels (at most 5).
+ */
+size_t memmove_test_kernels(move_fn* kernels, const char** names) noexcept {
+  size_t n = 0;
+  kernels[n] = &memmove_generic;
+  names[n++] = "generic";
+
+#if defined(__amd64__) || defined(__x86_64__)
+  const cpu_features f = cstring_cpu_features();
+  if (f.sse2) {
+    kernels[n] = &memmove_sse2;
+    names[n++] = "sse2";
+    if (f.erms) {
+      kernels[n] = &memmove_sse2_erms;
+      names[n++] = "sse2+erms";
+    }
+  }
+  if (f.avx2) {
+    kernels[n] = &memmove_avx2;
+    names[n++] = "avx2";
+    if (f.erms) {
+      kernels[n] = &memmove_avx2_erms;
+      names[n++] = "avx2+erms";
+    }
+  }
+#endif
+  return n;
+}
+#endif
+
+void* memcpy(void*__restrict dst, const void*__restrict src, size_t len)
+    noexcept {
+  return memcpy_kernel.load(memory_order_relaxed)(dst, src, len);
+}
+
+void* memmove(void* dst, const void* src, size_t len) noexcept {
+  return memmove_kernel.load(memory_order_relaxed)(dst, src, len);
+}
+
+size_t strlen(const char* s) noexcept {
+  return strlen_kernel.load(memory_order_relaxed)(s);
+}
+
+void bcopy(const void* src, void* dst, size_t len) noexcept {
+  memmove(dst, src, len);
+}
+
+void bzero(void* p, size_t len) noexcept {
+  abi::memzero(p, len);
+}
+
+void* memset(void* p, int c, size_t len) noexcept {
+  return memset_kernel.load(memory_order_relaxed)(p, c, len);
+}
+
+const void* memchr(const void* p, int c, size_t len) noexcept {
+  return memchr_kernel.load(memory_order_relaxed)(p, c, len);
+}
+
+const void* memrchr(const void* p, int c, size_t len) noexcept {
+  return memrchr_kernel.load(memory_order_relaxed)(p, c, len);
+}
+
 void* memccpy(void*__restrict dst, const void*__restrict src, int c,
     size_t len) noexcept {
   c &= 0xff;
@@ -531,7 +1199,9 @@ size_t strlcat(char*__restrict dst, const char*__restrict src, size_t len)
   return dst_len + strlcpy(dst + dst_len, src, len - dst_len);
 }
 
-const char* strchr(const char* s, int c) noexcept {
+namespace {
+
+const char* strchr_generic(const char* s, int c) noexcept {
   c &= 0xff;
   auto r = reader<DIR_FORWARD, uint8_t>(s);
 
@@ -558,6 +1228,12 @@ const char* strchr(const char* s, int c) noexcept {
   }
 }
 
+} /* namespace std::<unnamed> */
+
+const char* strchr(const char* s, int c) noexcept {
+  return strchr_kernel.load(memory_order_relaxed)(s, c);
+}
+
 char* strcpy(char*__restrict dst, const char*__restrict src) noexcept {
   stpcpy(dst, src);
   return dst;
@@ -700,7 +1376,9 @@ char* strndup(const char* s, size_t len) noexcept {
   return reinterpret_cast<char*>(dup);
 }
 
-size_t strnlen(const char* s, size_t len) noexcept {
+namespace {
+
+size_t strnlen_generic(const char* s, size_t len) noexcept {
   auto r = reader<DIR_FORWARD, uint8_t>(s);
   const size_t orig_len = len;
 
@@ -727,6 +1405,12 @@ size_t strnlen(const char* s, size_t len) noexcept {
   }
 }
 
+} /* namespace std::<unnamed> */
+
+size_t strnlen(const char* s, size_t len) noexcept {
+  return strnlen_kernel.load(memory_order_relaxed)(s, len);
+}
+
 const char* strpbrk(const char* s, const char* set) noexcept {
   auto r = reader<DIR_FORWARD, uint8_t>(s);
 
@@ -757,79 +1441,21 @@ size_t strspn(const char* s, const char* set) noexcept {
   return r.addr<char>() - 1 - s;
 }
 
+/*
+ * Substring search.
+ *
+ * Skips to the first occurance of the first needle character,
+ * then uses the linear time two-way search on the remaining haystack.
+ * The haystack is scanned for its end only as far as the search gets.
+ */
 const char* strstr(const char* haystack, const char* needle) noexcept {
-  constexpr size_t histogram_sz = UINT8_MAX + 1U;
-  ssize_t histogram[histogram_sz];
-  size_t needle_len = 0;  // Length of needle, for backtracking.
-  unsigned int nz = 0;  // # of non-zero histogram entries.
-
-  for (auto& i : histogram) i = 0;
-
-  /* Fill histogram, by subtracting needle. */
-  {
-    auto r = reader<DIR_FORWARD, uint8_t>(needle);
-    for (auto c = r.read8(); c != CHAR_ZERO; c = r.read8()) {
-      ++needle_len;
-      if (histogram[c]-- == 0) ++nz;
-    }
-  }
+  if (needle[0] == '\0') return haystack;
 
-  /* Pre-read needle_len bytes from haystack. */
-  auto head = reader<DIR_FORWARD, uint8_t>(haystack);
-  auto tail = head;
-  while (needle_len > 0) {
-    auto c = head.read8();
-    if (c == CHAR_ZERO) return nullptr;
-    switch (histogram[c]++) {
-    default:
-      break;
-    case 0:
-      ++nz;
-      break;
-    case -1:
-      --nz;
-      break;
-    }
+  haystack = strchr(haystack, needle[0]);
+  if (haystack == nullptr) return nullptr;
 
-    --needle_len;
-  }
-
-  /* Walk window, described by [tail - head) through histogram. */
-  for (;;) {
-    /* GUARD: tail points at string equal to needle. */
-    if (nz == 0 &&
-        memcmp(tail.addr<void>(), needle,
-               head.addr<uint8_t>() - tail.addr<uint8_t>()) == 0)
-      return tail.addr<char>();
-
-    const auto head_c = head.read8();
-    if (head_c == CHAR_ZERO) return nullptr;
-    const auto tail_c = tail.read8();
-
-    /* Add head character to histogram. */
-    switch (histogram[head_c]++) {
-    default:
-      break;
-    case 0:
-      ++nz;
-      break;
-    case -1:
-      --nz;
-      break;
-    }
-
-    /* Remove tail character from histogram. */
-    switch (histogram[tail_c]--) {
-    default:
-      break;
-    case 0:
-      ++nz;
-      break;
-    case 1:
-      --nz;
-      break;
-    }
-  }
+  return abi::ext::twoway_find_cstr(haystack, &strnlen,
+                                    needle, strlen(needle));
 }
 
 char* strtok(char*__restrict s, const char*__restrict sep) noexcept {
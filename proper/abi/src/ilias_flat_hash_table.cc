@@ -0,0 +1,16 @@
+#include <ilias/flat_hash_table.h>
+
+_namespace_begin(ilias)
+namespace impl {
+
+
+alignas(16) const flat_hash_ctrl_t flat_hash_empty_group[16] = {
+  flat_hash_sentinel, flat_hash_empty, flat_hash_empty, flat_hash_empty,
+  flat_hash_empty,    flat_hash_empty, flat_hash_empty, flat_hash_empty,
+  flat_hash_empty,    flat_hash_empty, flat_hash_empty, flat_hash_empty,
+  flat_hash_empty,    flat_hash_empty, flat_hash_empty, flat_hash_empty
+};
+
+
+} /* namespace ilias::impl */
+_namespace_end(ilias)
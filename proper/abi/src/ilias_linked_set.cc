@@ -42,20 +42,54 @@ auto basic_linked_set::begin() const noexcept -> iterator {
   return iterator(this, first);
 }
 
+/*
+ * Move e down the tree until it is a leaf,
+ * by exchanging it with its successor and then with its only child.
+ */
 auto basic_linked_set::unlink_to_leaf_(element* e) noexcept -> void {
-  using _namespace(std)::any_of;
   using _namespace(std)::all_of;
 
-  element* s = e;
-  while (s->left()) s = s->left();
-  assert(any_of(s->children_.begin(), s->children_.end(),
+  if (e->left() && e->right()) {
+    element* s = e->right();
+    while (s->left()) s = s->left();
+    node_swap_(e, s);
+  }
+  if (element*const c = (e->left() ? e->left() : e->right()))
+    node_swap_(e, c);
+
+  assert(all_of(e->children_.begin(), e->children_.end(),
                 [](element* p) { return p == nullptr; }));
-  node_swap_(e, s);
-  if (e->right()) {
-    node_swap_(e, e->right());
-    assert(all_of(s->children_.begin(), s->children_.end(),
-                  [](element* p) { return p == nullptr; }));
+}
+
+/*
+ * Exchange the positions (and colors) of x and y in the tree.
+ */
+auto basic_linked_set::node_swap_(element* x, element* y) noexcept -> void {
+  using _namespace(std)::swap;
+
+  if (x->parent() == y) swap(x, y);
+  element*const xp = x->parent();
+  element*const yp = y->parent();
+  element**const x_slot = (xp ? &xp->children_[x->pidx_()] : &root_);
+  element**const y_slot = (yp ? &yp->children_[y->pidx_()] : &root_);
+
+  swap(x->parent_, y->parent_);  // Color swap is required here.
+  swap(x->children_, y->children_);
+  if (yp == x) {
+    /* y was a child of x. */
+    for (element*& c : y->children_)
+      if (c == y) c = x;
+    x->parent_ = x->rb_flag_() | reinterpret_cast<uintptr_t>(y);
+    *x_slot = y;
+  } else {
+    *x_slot = y;
+    *y_slot = x;
   }
+
+  for (element* c : x->children_)
+    if (c) c->parent_ = c->rb_flag_() | reinterpret_cast<uintptr_t>(x);
+  for (element* c : y->children_)
+    if (c) c->parent_ = c->rb_flag_() | reinterpret_cast<uintptr_t>(y);
 }
 
 auto basic_linked_set::rotate_(element* q, unsigned int i)
@@ -67,9 +101,9 @@ auto basic_linked_set::rotate_(element* q, unsigned int i)
 
   element** parent_ptr;
   element*const p = q->child(1 - i);
+  assert(p != nullptr);
   element*const b = p->child(i);
   element*const q_parent = q->parent();
-  assert(p != nullptr);
 
   /* Figure out the parent pointer that needs updating. */
   if (q_parent) {
@@ -85,10 +119,60 @@ auto basic_linked_set::rotate_(element* q, unsigned int i)
   q->children_[1 - i] = b;
   p->parent_ = p->rb_flag_() | (q->parent_ & PTR_MASK);
   q->parent_ = q->rb_flag_() | reinterpret_cast<uintptr_t>(p);
-  b->parent_ = b->rb_flag_() | reinterpret_cast<uintptr_t>(q);
+  if (b) b->parent_ = b->rb_flag_() | reinterpret_cast<uintptr_t>(q);
 
   return p;
 }
 
+auto basic_linked_set::black_height_(const element* e) noexcept ->
+    unsigned int {
+  unsigned int h = 0;
+  for (; e != nullptr; e = e->left())
+    if (e->black()) ++h;
+  return h;
+}
+
+/*
+ * Verify the red-black tree invariants, for use by tests:
+ * - child and parent links agree, and the root has no parent,
+ * - the root is black, and red elements have no red children,
+ * - all paths from the root to a leaf hold the same number of black
+ *   elements.
+ */
+auto basic_linked_set::verify() const noexcept -> bool {
+  if (root_ == nullptr) return true;
+  if (root_->parent() != nullptr || root_->red()) return false;
+  return verify_(root_) != ~0U;
+}
+
+/* Verify subtree e, returning its black height, or ~0U if it's invalid. */
+auto basic_linked_set::verify_(const element* e) noexcept -> unsigned int {
+  if (e == nullptr) return 0;
+
+  unsigned int bh[2];
+  for (unsigned int i = 0; i < 2U; ++i) {
+    const element* c = e->child(i);
+    if (c != nullptr && (c->parent() != e || (e->red() && c->red())))
+      return ~0U;
+    bh[i] = verify_(c);
+    if (bh[i] == ~0U) return ~0U;
+  }
+  if (bh[0] != bh[1]) return ~0U;
+  return bh[0] + (e->black() ? 1U : 0U);
+}
+
+/*
+ * Turn subtree e into a tree of its own.
+ * Its root is colored black, which increments the black height bh
+ * if the root was red.
+ */
+auto basic_linked_set::detach_(element* e, unsigned int& bh) noexcept ->
+    element* {
+  if (e == nullptr) return nullptr;
+  if (e->red()) ++bh;
+  e->parent_ = 0;
+  return e;
+}
+
 
 _namespace_end(ilias)
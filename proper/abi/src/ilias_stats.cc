@@ -47,11 +47,14 @@ stats_leaf::~stats_leaf() noexcept {}
 
 auto stats_leaf::path() const ->
     _namespace(std)::vector<_namespace(std)::string_ref> {
-  _namespace(std)::vector<_namespace(std)::string_ref> rv;
+  size_t depth = 0;
+  for (const basic_stats* i = this; i != nullptr; i = i->parent())
+    ++depth;
 
+  /* Fill back to front, so the vector is allocated exactly once. */
+  _namespace(std)::vector<_namespace(std)::string_ref> rv(depth);
   for (const basic_stats* i = this; i != nullptr; i = i->parent())
-    rv.push_back(i->name());
-  _namespace(std)::reverse(rv.begin(), rv.end());
+    rv[--depth] = i->name();
   return rv;
 }
 
@@ -143,4 +146,25 @@ auto stats_counter::as_properties(_namespace(std)::ostream& out) const ->
 }
 
 
+stats_gauge::~stats_gauge() noexcept {
+  deinit();
+}
+
+auto stats_gauge::as_properties(_namespace(std)::ostream& out) const -> void {
+  using _namespace(std)::string_ref;
+
+  const uint64_t v = get();
+
+  bool first = true;
+  for (string_ref path_elem : path()) {
+    if (first)
+      first = false;
+    else
+      out << ".";
+    out << path_elem;
+  }
+  out << " = " << v;
+}
+
+
 _namespace_end(ilias)
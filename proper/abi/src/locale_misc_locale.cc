@@ -267,9 +267,8 @@ facet_vector_map_ptr::~facet_vector_map_ptr() noexcept {
   if (refcounter && refcounter->fetch_sub(1U, memory_order_release) == 1U) {
     for (auto i = begin(*ptr_); i != end(*ptr_); ++i)
       i->~facet_vector_map_value_type();
-    locale_heap().free(ptr_,
-                       facet_vector_map_bytes(facet_vector_map_size(ptr_),
-                                              facet_vector_map_name(ptr_)));
+    /* Allocated with an explicit alignment, so sized free doesn't apply. */
+    locale_heap().free(ptr_);
   }
 }
 
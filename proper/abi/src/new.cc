@@ -97,10 +97,16 @@ abi::big_heap& no_throw_array_heap() noexcept {
 }
 
 
-void* new_impl(abi::big_heap& heap, size_t sz,
-               size_t align = alignof(_TYPES(max_align_t))) {
+/*
+ * Allocate memory for operator new.
+ * An alignment of 0 selects the natural alignment for sz, which is what
+ * sized operator delete depends on.
+ */
+void* new_impl(abi::big_heap& heap, size_t sz, size_t align = 0) {
   void* p;
-  for (p = heap.malloc(sz); _predict_false(!p); p = heap.malloc(sz, align)) {
+  while (_predict_false((p = (align == 0 ?
+                              heap.malloc(sz) :
+                              heap.malloc(sz, align))) == nullptr)) {
     _namespace(std)::new_handler nh = _namespace(std)::get_new_handler();
     if (!nh) _namespace(std)::__throw_bad_alloc();
     try {
@@ -117,7 +123,7 @@ void* new_impl(abi::big_heap& heap, size_t sz,
 }
 
 void* new_impl_nothrow(abi::big_heap& heap, size_t sz,
-                       size_t align = alignof(_TYPES(max_align_t))) noexcept {
+                       size_t align = 0) noexcept {
   try {
     return new_impl(heap, sz, align);
   } catch (const _namespace(std)::bad_alloc&) {
@@ -129,22 +135,26 @@ void* new_impl_nothrow(abi::big_heap& heap, size_t sz,
 
 
 void* __attribute__((weak)) operator new(size_t sz) {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   return new_impl(throwing_heap(), sz);
 }
 
 void* __attribute__((weak)) operator new(
     size_t sz, const _namespace(std)::nothrow_t&) noexcept {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   return new_impl_nothrow(no_throw_heap(), sz);
 }
 
 void* __attribute__((weak)) operator new(
     size_t sz, _namespace(std)::align_val_t align) {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   return new_impl(throwing_heap(), sz, static_cast<size_t>(align));
 }
 
 void* __attribute__((weak)) operator new(
     size_t sz, _namespace(std)::align_val_t align,
     const _namespace(std)::nothrow_t&) noexcept {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   return new_impl_nothrow(no_throw_heap(), sz, static_cast<size_t>(align));
 }
 
@@ -168,6 +178,11 @@ void __attribute__((weak)) operator delete(
   if (p) no_throw_heap().free(p);
 }
 
+/*
+ * Sized delete lets the heap skip the lookup of the allocation.
+ * Over-aligned allocations may not be in the size class implied by their
+ * size, so they use the unsized path.
+ */
 void __attribute__((weak)) operator delete(void* p, size_t sz) noexcept {
   if (p) throwing_heap().free(p, sz);
 }
@@ -178,34 +193,38 @@ void __attribute__((weak)) operator delete(
 }
 
 void __attribute__((weak)) operator delete(
-    void* p, size_t sz, _namespace(std)::align_val_t) noexcept {
-  if (p) throwing_heap().free(p, sz);
+    void* p, size_t, _namespace(std)::align_val_t) noexcept {
+  if (p) throwing_heap().free(p);
 }
 
 void __attribute__((weak)) operator delete(
-    void* p, size_t sz, _namespace(std)::align_val_t,
+    void* p, size_t, _namespace(std)::align_val_t,
     const _namespace(std)::nothrow_t&) noexcept {
-  if (p) no_throw_heap().free(p, sz);
+  if (p) no_throw_heap().free(p);
 }
 
 
 void* __attribute__((weak)) operator new[](size_t sz) {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   return new_impl(throwing_array_heap(), sz);
 }
 
 void* __attribute__((weak)) operator new[](
     size_t sz, const _namespace(std)::nothrow_t&) noexcept {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   return new_impl_nothrow(no_throw_array_heap(), sz);
 }
 
 void* __attribute__((weak)) operator new[](
     size_t sz, _namespace(std)::align_val_t align) {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   return new_impl(throwing_array_heap(), sz, static_cast<size_t>(align));
 }
 
 void* __attribute__((weak)) operator new[](
     size_t sz, _namespace(std)::align_val_t align,
     const _namespace(std)::nothrow_t&) noexcept {
+  const abi::big_heap::profile_entry entry{ __builtin_frame_address(0) };
   return new_impl_nothrow(no_throw_array_heap(),
                           sz, static_cast<size_t>(align));
 }
@@ -240,14 +259,14 @@ void __attribute__((weak)) operator delete[](
 }
 
 void __attribute__((weak)) operator delete[](
-    void* p, size_t sz, _namespace(std)::align_val_t) noexcept {
-  if (p) throwing_array_heap().free(p, sz);
+    void* p, size_t, _namespace(std)::align_val_t) noexcept {
+  if (p) throwing_array_heap().free(p);
 }
 
 void __attribute__((weak)) operator delete[](
-    void* p, size_t sz, _namespace(std)::align_val_t,
+    void* p, size_t, _namespace(std)::align_val_t,
     const _namespace(std)::nothrow_t&) noexcept {
-  if (p) no_throw_array_heap().free(p, sz);
+  if (p) no_throw_array_heap().free(p);
 }
 
 
@@ -0,0 +1,35 @@
+#include <stdimpl/parallel.h>
+#include <atomic>
+
+_namespace_begin(std)
+namespace impl {
+namespace {
+
+atomic<parallel_backend*> backend{ nullptr };
+atomic<unsigned int> cpu_count{ 1U };
+
+} /* namespace std::impl::<unnamed> */
+
+
+parallel_backend::~parallel_backend() noexcept {}
+
+auto get_parallel_backend() noexcept -> parallel_backend* {
+  return backend.load(memory_order_acquire);
+}
+
+auto set_parallel_backend(parallel_backend* be) noexcept ->
+    parallel_backend* {
+  return backend.exchange(be, memory_order_acq_rel);
+}
+
+auto get_cpu_count() noexcept -> unsigned int {
+  return cpu_count.load(memory_order_relaxed);
+}
+
+void set_cpu_count(unsigned int n) noexcept {
+  cpu_count.store((n == 0U ? 1U : n), memory_order_relaxed);
+}
+
+
+} /* namespace std::impl */
+_namespace_end(std)
@@ -1,4 +1,5 @@
 #include <string>
+#include <cstdlib>
 #include <abi/ext/reader.h>
 
 
@@ -440,186 +441,155 @@ template class basic_string<char16_t>;
 template class basic_string<char32_t>;
 
 
-namespace {
-
-template<typename InputIterator>
-auto read_size_t(InputIterator b, InputIterator e) noexcept ->
-    enable_if_t<sizeof(typename iterator_traits<InputIterator>::value_type) >=
-                sizeof(size_t),
-                tuple<typename iterator_traits<InputIterator>::value_type,
-                      InputIterator>> {
-  assert(b != e);
-  typename iterator_traits<InputIterator>::value_type v = *b;
-  ++b;
-  return make_tuple(move(v), move(b));
-}
-
-template<typename InputIterator>
-auto read_size_t(InputIterator b, InputIterator e) noexcept ->
-    enable_if_t<sizeof(typename iterator_traits<InputIterator>::value_type) <
-                sizeof(size_t),
-                tuple<size_t,
-                      InputIterator>> {
-  assert(b != e);
-  size_t v = 0;
-  for (unsigned int i = 0;
-       b != e &&
-       i < sizeof(size_t) /
-           sizeof(typename iterator_traits<InputIterator>::value_type);
-       ++i) {
-    v <<= CHAR_BIT *
-          sizeof(typename iterator_traits<InputIterator>::value_type);
-    v |= *b;
-    ++b;
-  }
-  return make_tuple(move(v), move(b));
-}
-
-/* Murmur hash. */
-template<typename InputIterator, typename N = size_t>
-auto hash_impl(InputIterator b, InputIterator e) noexcept ->
-    enable_if_t<sizeof(N) == 4, N> {
-  uint32_t c1 = 0xcc9e2d51;
-  uint32_t c2 = 0x1b873593;
-  uint32_t r1 = 15;
-  uint32_t r2 = 13;
-  uint32_t m = 5;
-  uint32_t n = 0xe6546b64;
-
-  /* Seed. */
-  uint32_t hash =
-      17 * sizeof(typename iterator_traits<InputIterator>::value_type);
-  if (b == e) return hash;
-
-  auto n_b = read_size_t(b, e);
-  auto n_ = get<0>(n_b);
-  b = get<1>(n_b);
-  unsigned int shift = (sizeof(n_) + sizeof(N) - 1) / sizeof(N);
-
-  uint32_t k = get<0>(n_b);
-  k *= c1;
-  k = (k << r1) | (k >> (32 - r1));
-  k *= c2;
-  hash ^= k;
-  hash = (hash << r2) | (hash >> (32 - r2));
-  hash = hash * m + n;
-
-  for (unsigned int i = 1; i < shift; ++i) {
-    get<0>(n_b) >>= (sizeof(n_) <= 4 ? 0 : 32);
-    uint32_t rb = n_;
-    rb *= c1;
-    rb = (rb << r1) | (rb >> (32 - r1));
-    rb *= c2;
-    hash ^= rb;
-  }
+/*
+ * Weak reference: arc4random64 is provided by the kernel,
+ * but not every program linking the abi has it.
+ */
+uint64_t arc4random64() noexcept __attribute__((__weak__));
 
-  uint32_t count = 1;
-  while (b != e) {
-    tie(n_, b) = read_size_t(b, e);
-    for (unsigned int i = 1; i < shift; ++i) {
-      n_ >>= (sizeof(n_) <= 4 ? 0 : 32);  // Shift, silence compiler warning.
-      uint32_t rb = n_;
-      rb *= c1;
-      rb = (rb << r1) | (rb >> (32 - r1));
-      rb *= c2;
-      hash ^= rb;
-    }
-    ++count;
-  }
 
-  /* hash ^= len. */
-  hash ^=
-      count * sizeof(typename iterator_traits<InputIterator>::value_type);
-
-  hash ^= (hash >> 16);
-  hash *= 0x85ebca6b;
-  hash ^= (hash >> 13);
-  hash *= 0xc2b2ae35;
-  hash ^= (hash >> 16);
-
-  return hash;
-}
-
-template<typename InputIterator, typename N = size_t>
-auto hash_impl(InputIterator b, InputIterator e) noexcept ->
-    enable_if_t<sizeof(N) == 8, N> {
-  uint64_t c1 = 0xc6a4a7935bd1e995ULL;
-  uint64_t c2 = 0xcc9e2d511b873593ULL;
-  uint64_t r1 = 47;
-  uint64_t r2 = 13;
-  uint64_t m = 5;
-  uint64_t n = 0xe6546b64;
-
-  /* Fixed seed. */
-  uint64_t hash =
-      17 * sizeof(typename iterator_traits<InputIterator>::value_type);
-  if (b == e) return hash;
-
-  auto n_b = read_size_t(b, e);
-  auto n_ = get<0>(n_b);
-  b = get<1>(n_b);
-  unsigned int shift = (sizeof(n_) + sizeof(N) - 1) / sizeof(N);
-
-  uint64_t k = n_;
-  k *= c1;
-  k = (k << r1) | (k >> (64 - r1));
-  k *= c2;
-  hash ^= k;
-  hash = (hash << r2) | (hash >> (64 - r2));
-  hash = hash * m + n;
-
-  for (unsigned int i = 1; i < shift; ++i) {
-    n_ >>= (sizeof(n_) <= 8 ? 0 : 64);  // Shift, but silence compiler warning.
-    uint64_t rb = n_;
-    rb *= c1;
-    rb = (rb << r1) | (rb >> (64 - r1));
-    rb *= c2;
-    hash ^= rb;
-  }
+namespace {
 
-  uint64_t count = 1;
-  while (++b != e) {
-    tie(n_, b) = read_size_t(b, e);
-    for (unsigned int i = 1; i < shift; ++i) {
-      n_ >>= (sizeof(n_) <= 4 ? 0 : 32);  // Shift, silence compiler warning.
-      uint32_t rb = n_;
-      rb *= c1;
-      rb = (rb << r1) | (rb >> (32 - r1));
-      rb *= c2;
-      hash ^= rb;
+/*
+ * String hashing: wyhash (final version 4).
+ *
+ * Reads the string as bytes, 8 at a time.  Long strings are consumed
+ * 48 bytes per round, in three independent multiply lanes, so the
+ * multiplies of consecutive lanes overlap in the pipeline.
+ * Strings up to 16 bytes take a single multiply, using overlapping
+ * loads instead of a loop.
+ */
+constexpr uint64_t hash_secret[4] = {
+  0x2d358dccaa6c78a5ULL,
+  0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL,
+  0x4d5a2da51de1aa47ULL
+};
+
+inline auto hash_read8(const uint8_t* p) noexcept -> uint64_t {
+  uint64_t v;
+  __builtin_memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline auto hash_read4(const uint8_t* p) noexcept -> uint64_t {
+  uint32_t v;
+  __builtin_memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+/* Read 1 to 3 bytes. */
+inline auto hash_read3(const uint8_t* p, size_t len) noexcept -> uint64_t {
+  return (uint64_t(p[0]) << 16) | (uint64_t(p[len >> 1]) << 8) | p[len - 1U];
+}
+
+/* Full 128-bit product of a and b: a receives the low, b the high half. */
+inline auto hash_mum(uint64_t& a, uint64_t& b) noexcept -> void {
+#if _USE_INT128
+  const _TYPES(uint128_t) r = _TYPES(uint128_t)(a) * b;
+  a = uint64_t(r);
+  b = uint64_t(r >> 64);
+#else
+  const uint64_t ha = a >> 32, hb = b >> 32;
+  const uint64_t la = uint32_t(a), lb = uint32_t(b);
+  const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  const uint64_t t = rl + (rm0 << 32);
+  uint64_t c = (t < rl);
+  const uint64_t lo = t + (rm1 << 32);
+  c += (lo < t);
+  a = lo;
+  b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+inline auto hash_mix(uint64_t a, uint64_t b) noexcept -> uint64_t {
+  hash_mum(a, b);
+  return a ^ b;
+}
+
+auto hash_bytes(const void* key, size_t len, uint64_t seed) noexcept ->
+    uint64_t {
+  const uint8_t* p = static_cast<const uint8_t*>(key);
+  uint64_t a, b;
+
+  seed ^= hash_mix(seed ^ hash_secret[0], hash_secret[1]);
+  if (_predict_true(len <= 16U)) {
+    if (len >= 4U) {
+      const size_t off = (len >> 3) << 2;
+      a = (hash_read4(p) << 32) | hash_read4(p + off);
+      b = (hash_read4(p + len - 4U) << 32) | hash_read4(p + len - 4U - off);
+    } else if (len > 0U) {
+      a = hash_read3(p, len);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (_predict_false(i > 48U)) {
+      uint64_t see1 = seed, see2 = seed;
+      do {
+        seed = hash_mix(hash_read8(p) ^ hash_secret[1],
+                        hash_read8(p + 8) ^ seed);
+        see1 = hash_mix(hash_read8(p + 16) ^ hash_secret[2],
+                        hash_read8(p + 24) ^ see1);
+        see2 = hash_mix(hash_read8(p + 32) ^ hash_secret[3],
+                        hash_read8(p + 40) ^ see2);
+        p += 48;
+        i -= 48U;
+      } while (_predict_true(i > 48U));
+      seed ^= see1 ^ see2;
     }
-    ++count;
+    while (_predict_false(i > 16U)) {
+      seed = hash_mix(hash_read8(p) ^ hash_secret[1],
+                      hash_read8(p + 8) ^ seed);
+      p += 16;
+      i -= 16U;
+    }
+    a = hash_read8(p + i - 16U);
+    b = hash_read8(p + i - 8U);
   }
 
-  /* hash ^= len. */
-  hash ^=
-      count * sizeof(typename iterator_traits<InputIterator>::value_type);
+  a ^= hash_secret[1];
+  b ^= seed;
+  hash_mum(a, b);
+  return hash_mix(a ^ hash_secret[0] ^ len, b ^ hash_secret[1]);
+}
 
-  hash ^= (hash >> 33);
-  hash *= 0xff51afd7ed558ccdULL;
-  hash ^= (hash >> 33);
-  hash *= 0xc4ceb9fe1a85ec53ULL;
-  hash ^= (hash >> 33);
+/*
+ * Seed for string hashes.
+ *
+ * If the program provides arc4random64 (the kernel does), the seed is
+ * randomized on first use, so it differs between boots and inputs
+ * that collide can't be precomputed.  Otherwise a fixed seed is used.
+ */
+auto hash_seed() noexcept -> uint64_t {
+  static const uint64_t seed =
+      (&arc4random64 != nullptr ? arc4random64() : hash_secret[3]);
+  return seed;
+}
 
-  return hash;
+template<typename Char, typename Traits>
+auto hash_impl(basic_string_ref<Char, Traits> s) noexcept -> size_t {
+  return hash_bytes(s.data(), s.size() * sizeof(Char), hash_seed());
 }
 
 } /* namespace std::<unnamed> */
 
 size_t hash<string_ref>::operator()(string_ref s) const noexcept {
-  return hash_impl(s.begin(), s.end());
+  return hash_impl(s);
 }
 
 size_t hash<u16string_ref>::operator()(u16string_ref s) const noexcept {
-  return hash_impl(s.begin(), s.end());
+  return hash_impl(s);
 }
 
 size_t hash<u32string_ref>::operator()(u32string_ref s) const noexcept {
-  return hash_impl(s.begin(), s.end());
+  return hash_impl(s);
 }
 
 size_t hash<wstring_ref>::operator()(wstring_ref s) const noexcept {
-  return hash_impl(s.begin(), s.end());
+  return hash_impl(s);
 }
 
 
@@ -0,0 +1,19 @@
+#include <thread>
+#include <stdimpl/parallel.h>
+
+_namespace_begin(std)
+namespace thread {
+
+
+/*
+ * Report the CPUs the parallel backend runs on, or if none is installed
+ * (yet), the number of CPUs the kernel found.
+ */
+unsigned int hardware_concurrency() noexcept {
+  const impl::parallel_backend* be = impl::get_parallel_backend();
+  return (be == nullptr ? impl::get_cpu_count() : be->concurrency());
+}
+
+
+} /* namespace std::thread */
+_namespace_end(std)
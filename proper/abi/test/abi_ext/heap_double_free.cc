@@ -0,0 +1,49 @@
+#include <abi/ext/heap.h>
+#include <abi/_config.h>
+#include <cstddef>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+
+extern "C" void _exit(int) __attribute__((__noreturn__));
+
+/*
+ * Test: freeing a large allocation twice.
+ *
+ * Large allocations get a region of their own, which is handed back (or
+ * reused as ordinary heap memory) when they are freed.  The second free
+ * must be rejected with a panic, rather than trusting whatever is left
+ * at the address of the old header.
+ */
+constexpr size_t LARGE = size_t(1) << 20;
+
+bool expect_panic = false;
+
+void on_panic() {
+  if (!expect_panic) {
+    fprintf(stderr, "unexpected panic\n");
+    _exit(1);
+  }
+  fprintf(stderr, "  %s\n", "\\o/");
+  _exit(0);
+}
+
+int main() {
+  abi::_config::test_panic_handler() = &on_panic;
+  abi::ext::heap h{ "heap_double_free" };
+
+  fprintf(stderr, "Testing double free of a large allocation...");
+  void* p = h.malloc(LARGE);
+  void* q = h.malloc(LARGE);
+  if (p == nullptr || q == nullptr) {
+    fprintf(stderr, "malloc failed\n");
+    return 1;
+  }
+  h.free(p);
+  h.free(q);
+
+  expect_panic = true;
+  h.free(p);
+  fprintf(stderr, "second free of %p was accepted\n", p);
+  return 1;
+}
@@ -0,0 +1,58 @@
+#include <abi/ext/heap.h>
+#include <cstddef>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+
+/*
+ * Benchmark: cost of heap::free() as the number of live objects grows.
+ *
+ * Objects are over-aligned, so they bypass the slab allocator and
+ * are handled by the global heap.
+ */
+constexpr size_t OBJ_SIZE = 8;
+constexpr size_t OBJ_ALIGN = 64;
+constexpr size_t MIN_LIVE = 1000;
+constexpr size_t MAX_LIVE = 1000000;
+constexpr size_t SAMPLE = 1000;
+
+void* live[MAX_LIVE];
+
+inline unsigned long long cycles() noexcept {
+  return __builtin_ia32_rdtsc();
+}
+
+int main() {
+  abi::ext::heap h{ "heap_free" };
+  size_t n = 0;
+
+  for (size_t target = MIN_LIVE; target <= MAX_LIVE; target *= 10) {
+    for (; n < target; ++n) {
+      live[n] = h.malloc(OBJ_SIZE, OBJ_ALIGN);
+      if (live[n] == nullptr) {
+        fprintf(stderr, "malloc failed with %zu live objects\n", n);
+        return 1;
+      }
+    }
+
+    /* Free and reallocate objects spread over the live set. */
+    unsigned long long t_free = 0;
+    for (size_t i = 0; i < SAMPLE; ++i) {
+      const size_t idx = (i * 7919U) % n;
+
+      const unsigned long long t0 = cycles();
+      h.free(live[idx]);
+      t_free += cycles() - t0;
+
+      live[idx] = h.malloc(OBJ_SIZE, OBJ_ALIGN);
+      if (live[idx] == nullptr) {
+        fprintf(stderr, "malloc failed after free\n");
+        return 2;
+      }
+    }
+    fprintf(stderr, "%8zu live objects: %llu cycles per free()\n",
+            n, t_free / SAMPLE);
+  }
+
+  for (size_t i = 0; i < n; ++i) h.free(live[i]);
+}
@@ -0,0 +1,157 @@
+#include <abi/ext/heap.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <tuple>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint32_t;
+using _namespace(std)::uintptr_t;
+
+/*
+ * Test: slab lookup while slabs are created and released.
+ *
+ * Several workers allocate and free objects in a pseudo random order:
+ * small objects (served by slabs), over-aligned small objects and large
+ * objects (both served by the global heap).  Workers periodically free
+ * everything they hold, so slabs are emptied and released, while other
+ * workers keep allocating new ones.  There are many more slabs than
+ * lookup buckets, so each bucket holds several slabs at a time.
+ *
+ * Test builds are single threaded, so the workers are interleaved step
+ * by step instead of running on threads of their own.
+ *
+ * Each object is filled with its own byte, which must be intact when the
+ * object is freed; an object handed out twice overwrites it.  Before the
+ * free, resize() must report the size class of slab objects and the
+ * exact size of other objects, showing the lookup classified it right.
+ */
+constexpr unsigned int N_WORKERS = 4;
+constexpr size_t MAX_LIVE = 1024;  // Objects per worker.
+constexpr unsigned int STEPS = 400000;
+constexpr unsigned int PHASE = 25000;  // Steps between full releases.
+constexpr size_t SLAB_MAX = 2048;  // Largest object served by slabs.
+constexpr size_t OVER_ALIGN = 128;
+
+struct object {
+  unsigned char* p;
+  size_t sz;
+  bool slab;
+  bool sized;  // Allocated by malloc(size_t), may use sized free.
+  unsigned char fill;
+};
+
+struct worker {
+  object live[MAX_LIVE];
+  size_t n = 0;
+};
+
+worker workers[N_WORKERS];
+unsigned char next_fill = 0;
+
+/* Deterministic pseudo random sequence. */
+uint32_t next_rand(uint32_t& state) noexcept {
+  state = state * 1103515245U + 12345U;
+  return state >> 8;
+}
+
+bool allocate(abi::ext::heap& h, worker& w, uint32_t& rnd) {
+  object& o = w.live[w.n];
+  const uint32_t kind = next_rand(rnd) % 16U;
+  size_t align = 0;
+
+  if (kind < 13U) {
+    o.sz = next_rand(rnd) % SLAB_MAX + 1U;
+    o.slab = true;
+  } else if (kind < 15U) {
+    o.sz = next_rand(rnd) % 64U + 1U;
+    o.slab = false;
+    align = OVER_ALIGN;
+  } else {
+    o.sz = SLAB_MAX + 1U + next_rand(rnd) % 8192U;
+    o.slab = false;
+  }
+
+  o.sized = (align == 0);
+  o.p = static_cast<unsigned char*>(o.sized ?
+                                    h.malloc(o.sz) :
+                                    h.malloc(o.sz, align));
+  if (o.p == nullptr) {
+    fprintf(stderr, "malloc(%zu) failed\n", o.sz);
+    return false;
+  }
+  if (align != 0 && reinterpret_cast<uintptr_t>(o.p) % align != 0U) {
+    fprintf(stderr, "malloc(%zu, %zu) returned misaligned %p\n",
+            o.sz, align, static_cast<void*>(o.p));
+    return false;
+  }
+
+  o.fill = next_fill = (next_fill == 255U ? 1U : next_fill + 1U);
+  for (size_t i = 0; i < o.sz; ++i) o.p[i] = o.fill;
+  ++w.n;
+  return true;
+}
+
+bool release(abi::ext::heap& h, worker& w, size_t idx) {
+  using _namespace(std)::get;
+
+  const object o = w.live[idx];
+  w.live[idx] = w.live[--w.n];
+
+  for (size_t i = 0; i < o.sz; ++i) {
+    if (o.p[i] != o.fill) {
+      fprintf(stderr, "object %p (%zu bytes) overwritten at offset %zu\n",
+              static_cast<void*>(o.p), o.sz, i);
+      return false;
+    }
+  }
+
+  if (o.slab) {
+    /* Slab objects can't grow beyond their size class. */
+    const auto r = h.resize(o.p, SLAB_MAX + 1U);
+    if (get<0>(r) || get<1>(r) < o.sz || get<1>(r) > SLAB_MAX) {
+      fprintf(stderr, "slab object %p (%zu bytes) not found by lookup\n",
+              static_cast<void*>(o.p), o.sz);
+      return false;
+    }
+  } else {
+    const auto r = h.resize(o.p, o.sz);
+    if (!get<0>(r) || get<1>(r) != o.sz) {
+      fprintf(stderr, "heap object %p (%zu bytes) mistaken for slab object\n",
+              static_cast<void*>(o.p), o.sz);
+      return false;
+    }
+  }
+
+  if (o.sized && (o.fill % 2U) == 0U)
+    h.free(o.p, o.sz);
+  else
+    h.free(o.p);
+  return true;
+}
+
+int main() {
+  abi::ext::heap h{ "heap_slab_lookup" };
+  uint32_t rnd = 1;
+
+  fprintf(stderr, "Testing slab lookup with %u interleaved workers...",
+          N_WORKERS);
+  for (unsigned int step = 0; step < STEPS; ++step) {
+    worker& w = workers[next_rand(rnd) % N_WORKERS];
+
+    if (step % PHASE == PHASE - 1U) {
+      while (w.n > 0)
+        if (!release(h, w, w.n - 1U)) return 1;
+    } else if (w.n == 0 || (w.n < MAX_LIVE && next_rand(rnd) % 8U < 5U)) {
+      if (!allocate(h, w, rnd)) return 1;
+    } else {
+      if (!release(h, w, next_rand(rnd) % w.n)) return 1;
+    }
+  }
+
+  for (worker& w : workers) {
+    while (w.n > 0)
+      if (!release(h, w, w.n - 1U)) return 1;
+  }
+  fprintf(stderr, "  %s\n", "\\o/");
+}
@@ -0,0 +1,157 @@
+#include <abi/ext/heap.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint32_t;
+
+/*
+ * Test: thread cache flush.
+ *
+ * Freed slab objects are kept in a per thread magazine, which hands
+ * back its oldest half to the slab heap when it fills up.  Objects of
+ * 64 bytes are cached up to 32 at a time, so after any number of frees
+ * at least the 17 most recently freed objects are still cached, and they
+ * are handed out again most recent first.
+ *
+ * Objects must never be handed out twice: after each flush, all live
+ * objects must be distinct and their contents intact.  This is checked
+ * for a size class with a large and one with a small magazine.
+ */
+constexpr size_t SMALL = 64;
+constexpr size_t LARGE = 1536;
+constexpr unsigned int CACHED = 17;
+constexpr size_t N = 1000;
+constexpr unsigned int ROUNDS = 50;
+
+unsigned char* objs[N];
+unsigned char* sorted[N];
+
+/* Deterministic pseudo random sequence. */
+uint32_t next_rand(uint32_t& state) noexcept {
+  state = state * 1103515245U + 12345U;
+  return state >> 8;
+}
+
+inline unsigned char fill(size_t i) noexcept {
+  return static_cast<unsigned char>(i % 251U + 1U);
+}
+
+/* Verify the first n objects are intact and don't overlap. */
+bool verify(const char* what, size_t n, size_t sz) {
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < sz; ++j) {
+      if (objs[i][j] != fill(i)) {
+        fprintf(stderr, "%s: object %zu (%p) overwritten at offset %zu\n",
+                what, i, static_cast<void*>(objs[i]), j);
+        return false;
+      }
+    }
+  }
+
+  _namespace(std)::copy(objs, objs + n, sorted);
+  _namespace(std)::sort(sorted, sorted + n);
+  for (size_t i = 1; i < n; ++i) {
+    if (sorted[i - 1] + sz > sorted[i]) {
+      fprintf(stderr, "%s: objects %p and %p overlap\n",
+              what, static_cast<void*>(sorted[i - 1]),
+              static_cast<void*>(sorted[i]));
+      return false;
+    }
+  }
+  return true;
+}
+
+bool allocate(abi::ext::heap& h, size_t i, size_t sz) {
+  objs[i] = static_cast<unsigned char*>(h.malloc(sz));
+  if (objs[i] == nullptr) {
+    fprintf(stderr, "malloc(%zu) failed\n", sz);
+    return false;
+  }
+  for (size_t j = 0; j < sz; ++j) objs[i][j] = fill(i);
+  return true;
+}
+
+void release(abi::ext::heap& h, size_t i, size_t sz) {
+  if (i % 2U == 0U)
+    h.free(objs[i], sz);
+  else
+    h.free(objs[i]);
+}
+
+bool test_lifo(abi::ext::heap& h) {
+  constexpr size_t M = 101;  // Several flushes worth of objects.
+
+  for (size_t i = 0; i < M; ++i)
+    if (!allocate(h, i, SMALL)) return false;
+  if (!verify("allocate", M, SMALL)) return false;
+
+  unsigned char* freed[M];
+  _namespace(std)::copy(objs, objs + M, freed);
+  for (size_t i = 0; i < M; ++i) release(h, i, SMALL);
+
+  /* The most recently freed objects come back first. */
+  for (size_t i = 0; i < CACHED; ++i) {
+    if (!allocate(h, i, SMALL)) return false;
+    if (objs[i] != freed[M - 1U - i]) {
+      fprintf(stderr, "allocation %zu returned %p, expected %p\n",
+              i, static_cast<void*>(objs[i]),
+              static_cast<void*>(freed[M - 1U - i]));
+      return false;
+    }
+  }
+
+  /* The flushed objects are handed out once only. */
+  for (size_t i = CACHED; i < M; ++i)
+    if (!allocate(h, i, SMALL)) return false;
+  if (!verify("reallocate", M, SMALL)) return false;
+
+  for (size_t i = 0; i < M; ++i) release(h, i, SMALL);
+  return true;
+}
+
+bool test_churn(abi::ext::heap& h, size_t sz) {
+  uint32_t rnd = 1;
+  size_t n = 0;
+
+  for (unsigned int round = 0; round < ROUNDS; ++round) {
+    for (; n < N; ++n)
+      if (!allocate(h, n, sz)) return false;
+    if (!verify("churn", n, sz)) return false;
+
+    /* Free a random subset, in random order. */
+    const size_t keep = next_rand(rnd) % (N / 4U);
+    while (n > keep) {
+      const size_t i = next_rand(rnd) % n;
+      release(h, i, sz);
+      --n;
+      if (i != n) {
+        /* Move the last object into the hole, along with its contents. */
+        objs[i] = objs[n];
+        for (size_t j = 0; j < sz; ++j) objs[i][j] = fill(i);
+      }
+    }
+    if (!verify("churn after free", n, sz)) return false;
+  }
+
+  while (n > 0) release(h, --n, sz);
+  return true;
+}
+
+int main() {
+  abi::ext::heap h{ "heap_thread_cache" };
+
+  fprintf(stderr, "Testing thread cache order across flushes...");
+  if (!test_lifo(h)) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  fprintf(stderr, "Testing thread cache churn (%zu bytes)...", SMALL);
+  if (!test_churn(h, SMALL)) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  fprintf(stderr, "Testing thread cache churn (%zu bytes)...", LARGE);
+  if (!test_churn(h, LARGE)) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+}
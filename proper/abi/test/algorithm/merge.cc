@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+using _namespace(std)::size_t;
+using _namespace(std)::vector;
+
+/*
+ * Test: merge and inplace_merge are stable.
+ *
+ * Elements compare by key only.  Each element records the range it came
+ * from and its position within it, so the merged output reveals whether
+ * equivalent elements kept their relative order, with elements from the
+ * first range preceding equivalent elements from the second.
+ * inplace_merge is also run with a descending predicate, which it must
+ * use instead of operator<.
+ */
+struct elem {
+  unsigned int key;
+  unsigned int origin;  /* 0 = first range, 1 = second range. */
+  unsigned int seq;
+};
+
+bool operator<(const elem& x, const elem& y) noexcept {
+  return x.key < y.key;
+}
+
+struct key_greater {
+  bool operator()(const elem& x, const elem& y) const noexcept {
+    return x.key > y.key;
+  }
+};
+
+/* Build a sorted range of n elements with many duplicate keys. */
+template<typename Predicate>
+vector<elem> make_range(size_t n, unsigned int origin, Predicate predicate) {
+  vector<elem> v;
+  for (size_t i = 0; i < n; ++i) v.push_back(elem{ unsigned(i / 3U), 0, 0 });
+  _namespace(std)::stable_sort(v.begin(), v.end(), predicate);
+  for (size_t i = 0; i < n; ++i) {
+    v[i].origin = origin;
+    v[i].seq = i;
+  }
+  return v;
+}
+
+/*
+ * Verify v is sorted according to predicate,
+ * and equivalent elements are ordered by (origin, seq).
+ */
+template<typename Predicate>
+bool verify(const vector<elem>& v, Predicate predicate) {
+  for (size_t i = 1; i < v.size(); ++i) {
+    if (predicate(v[i], v[i - 1U])) return false;
+    if (predicate(v[i - 1U], v[i])) continue;
+    if (v[i - 1U].origin > v[i].origin) return false;
+    if (v[i - 1U].origin == v[i].origin && v[i - 1U].seq >= v[i].seq)
+      return false;
+  }
+  return true;
+}
+
+template<typename Predicate>
+bool test(size_t n1, size_t n2, Predicate predicate) {
+  const vector<elem> a = make_range(n1, 0, predicate);
+  const vector<elem> b = make_range(n2, 1, predicate);
+
+  vector<elem> out(n1 + n2);
+  auto out_e = _namespace(std)::merge(a.begin(), a.end(),
+                                      b.begin(), b.end(),
+                                      out.begin(), predicate);
+  if (out_e != out.end() || !verify(out, predicate)) {
+    fprintf(stderr, "merge(%zu, %zu) is not stable\n", n1, n2);
+    return false;
+  }
+
+  vector<elem> v = a;
+  v.insert(v.end(), b.begin(), b.end());
+  _namespace(std)::inplace_merge(v.begin(), v.begin() + n1, v.end(),
+                                 predicate);
+  if (!verify(v, predicate)) {
+    fprintf(stderr, "inplace_merge(%zu, %zu) is not stable\n", n1, n2);
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  constexpr size_t SIZES[] = { 0, 1, 2, 7, 64, 1001 };
+
+  for (size_t n1 : SIZES) {
+    for (size_t n2 : SIZES) {
+      if (!test(n1, n2, _namespace(std)::less<elem>())) return 1;
+      if (!test(n1, n2, key_greater())) return 1;
+    }
+  }
+  fprintf(stderr, "merge and inplace_merge are stable  %s\n", "\\o/");
+}
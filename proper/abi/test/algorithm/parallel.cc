@@ -0,0 +1,172 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <execution>
+#include <functional>
+#include <numeric>
+#include <thread>
+#include <vector>
+#include <stdimpl/parallel.h>
+
+using _namespace(std)::ptrdiff_t;
+using _namespace(std)::size_t;
+using _namespace(std)::uint32_t;
+using _namespace(std)::vector;
+namespace execution = _namespace(std)::execution;
+
+/*
+ * Test: algorithms with a parallel execution policy.
+ *
+ * A backend reporting 4 CPUs is installed, so ranges are split into
+ * multiple chunks.  The backend runs the chunks last to first, to catch
+ * algorithms depending on the order in which chunks complete.
+ * Each result is compared against the sequential algorithm.
+ */
+class reverse_backend
+: public _namespace(std)::impl::parallel_backend
+{
+ public:
+  auto concurrency() const noexcept -> unsigned int override { return 4; }
+
+  void run(size_t n, job_fn fn, void* arg) noexcept override {
+    if (n > max_chunks) max_chunks = n;
+    while (n-- > 0) fn(arg, n);
+  }
+
+  size_t max_chunks = 0;
+};
+
+constexpr size_t SIZES[] = { 0, 1, 17, 2048, 4 * 2048 + 3, 100003 };
+
+/* Deterministic pseudo random sequence. */
+uint32_t next_rand(uint32_t& state) noexcept {
+  state = state * 1103515245U + 12345U;
+  return state >> 8;
+}
+
+/* Span [lo, hi), combined only if adjacent, to detect reordering. */
+struct span {
+  size_t lo, hi;
+  bool ok;
+};
+
+span combine(span x, span y) noexcept {
+  return span{ x.lo, y.hi, x.ok && y.ok && x.hi == y.lo };
+}
+
+bool test(size_t n) {
+  vector<uint32_t> v(n), expect(n);
+
+  _namespace(std)::fill(execution::par, v.begin(), v.end(), 7U);
+  if (_namespace(std)::count(v.begin(), v.end(), 7U) != ptrdiff_t(n)) {
+    fprintf(stderr, "size %zu: fill\n", n);
+    return false;
+  }
+
+  for (size_t i = 0; i < n; ++i) v[i] = i;
+  _namespace(std)::for_each(execution::par, v.begin(), v.end(),
+                            [](uint32_t& x) { x *= 3U; });
+  for (size_t i = 0; i < n; ++i) {
+    if (v[i] != 3U * i) {
+      fprintf(stderr, "size %zu: for_each at %zu\n", n, i);
+      return false;
+    }
+  }
+
+  vector<uint32_t> out(n);
+  auto out_e = _namespace(std)::transform(execution::par_unseq,
+                                          v.begin(), v.end(), out.begin(),
+                                          [](uint32_t x) { return x + 1U; });
+  if (out_e != out.end()) {
+    fprintf(stderr, "size %zu: transform return value\n", n);
+    return false;
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (out[i] != 3U * i + 1U) {
+      fprintf(stderr, "size %zu: transform at %zu\n", n, i);
+      return false;
+    }
+  }
+
+  uint32_t state = n;
+  for (size_t i = 0; i < n; ++i) v[i] = next_rand(state) % (n / 4U + 1U);
+  expect = v;
+  _namespace(std)::sort(expect.begin(), expect.end());
+  _namespace(std)::sort(execution::par, v.begin(), v.end());
+  if (v != expect) {
+    fprintf(stderr, "size %zu: sort\n", n);
+    return false;
+  }
+
+  for (size_t i = 0; i < n; ++i) v[i] = next_rand(state);
+  expect = v;
+  _namespace(std)::sort(expect.begin(), expect.end(),
+                        _namespace(std)::greater<uint32_t>());
+  _namespace(std)::sort(execution::par, v.begin(), v.end(),
+                        _namespace(std)::greater<uint32_t>());
+  if (v != expect) {
+    fprintf(stderr, "size %zu: sort with predicate\n", n);
+    return false;
+  }
+
+  const unsigned long long sum =
+      _namespace(std)::accumulate(v.begin(), v.end(), 0ULL);
+  if (_namespace(std)::reduce(execution::par, v.begin(), v.end(), 0ULL) !=
+      sum) {
+    fprintf(stderr, "size %zu: reduce\n", n);
+    return false;
+  }
+
+  vector<span> spans(n);
+  for (size_t i = 0; i < n; ++i) spans[i] = span{ i, i + 1U, true };
+  const span s = _namespace(std)::reduce(execution::par,
+                                         spans.begin(), spans.end(),
+                                         span{ 0, 0, true }, &combine);
+  if (!s.ok || s.lo != 0 || s.hi != n) {
+    fprintf(stderr, "size %zu: reduce combined chunks out of order\n", n);
+    return false;
+  }
+
+  return true;
+}
+
+int main() {
+  reverse_backend be;
+  _namespace(std)::impl::set_parallel_backend(&be);
+
+  if (_namespace(std)::thread::hardware_concurrency() != 4U) {
+    fprintf(stderr, "hardware_concurrency doesn't report the backend\n");
+    return 1;
+  }
+
+  for (size_t n : SIZES) {
+    fprintf(stderr, "Testing size %zu...", n);
+    if (!test(n)) return 1;
+    fprintf(stderr, "  %s\n", "\\o/");
+  }
+
+  _namespace(std)::impl::set_parallel_backend(nullptr);
+
+  if (be.max_chunks <= 1U) {
+    fprintf(stderr, "no range was split into multiple chunks\n");
+    return 1;
+  }
+  if (_namespace(std)::thread::hardware_concurrency() != 1U) {
+    fprintf(stderr, "hardware_concurrency without a backend isn't 1\n");
+    return 1;
+  }
+
+  /* Without a backend, the recorded CPU count is reported. */
+  _namespace(std)::impl::set_cpu_count(6);
+  if (_namespace(std)::thread::hardware_concurrency() != 6U) {
+    fprintf(stderr, "hardware_concurrency doesn't report the CPU count\n");
+    return 1;
+  }
+  _namespace(std)::impl::set_parallel_backend(&be);
+  if (_namespace(std)::thread::hardware_concurrency() != 4U) {
+    fprintf(stderr, "hardware_concurrency doesn't prefer the backend\n");
+    return 1;
+  }
+  _namespace(std)::impl::set_parallel_backend(nullptr);
+}
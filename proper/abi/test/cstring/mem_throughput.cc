@@ -0,0 +1,109 @@
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint8_t;
+
+/*
+ * Benchmark: throughput of memcpy, memmove and memset.
+ *
+ * Every power of 2 size from MIN_SIZE to MAX_SIZE is tested with
+ * each source and destination misalignment modulo MAX_ALIGN,
+ * as well as each misalignment between source and destination.
+ * The result of each call is verified against a simple byte loop.
+ */
+constexpr size_t MIN_SIZE = 8;
+constexpr size_t MAX_SIZE = 1 << 20;
+constexpr size_t MAX_ALIGN = 64;
+constexpr size_t BYTES_PER_RUN = 1 << 18;  // Bytes moved per alignment.
+
+alignas(MAX_ALIGN) uint8_t src[MAX_SIZE + 2 * MAX_ALIGN];
+alignas(MAX_ALIGN) uint8_t dst[MAX_SIZE + 2 * MAX_ALIGN];
+
+inline unsigned long long cycles() noexcept {
+  return __builtin_ia32_rdtsc();
+}
+
+void reset(uint8_t* d, size_t sz) noexcept {
+  for (size_t i = 0; i < sz + 2U; ++i) d[i - 1U] = 0xff;
+}
+
+bool verify_copy(const uint8_t* d, const uint8_t* s, size_t sz) noexcept {
+  for (size_t i = 0; i < sz; ++i)
+    if (d[i] != s[i]) return false;
+  return d[-1] == 0xff && d[sz] == 0xff;
+}
+
+bool verify_set(const uint8_t* d, uint8_t c, size_t sz) noexcept {
+  for (size_t i = 0; i < sz; ++i)
+    if (d[i] != c) return false;
+  return d[-1] == 0xff && d[sz] == 0xff;
+}
+
+/*
+ * Run fn for all alignments of size sz.
+ * Returns bytes per 1000 cycles, or 0 if verification failed.
+ */
+template<typename Fn, typename Verify>
+unsigned long long run(size_t sz, Fn fn, Verify verify) noexcept {
+  const size_t reps = (sz >= BYTES_PER_RUN ? 1U : BYTES_PER_RUN / sz);
+  unsigned long long t = 0;
+  unsigned long long bytes = 0;
+
+  for (size_t off = 0; off < MAX_ALIGN; ++off) {
+    const size_t offsets[3][2] = {
+      { off, 0 },
+      { 0, off },
+      { off, off }
+    };
+
+    for (const auto& o : offsets) {
+      const uint8_t* s = src + o[0];
+      uint8_t* d = dst + MAX_ALIGN + o[1];
+
+      reset(d, sz);
+      fn(d, s, sz);
+      if (!verify(d, s, sz)) {
+        fprintf(stderr, "size %zu, src offset %zu, dst offset %zu: "
+                        "verification failed\n", sz, o[0], o[1]);
+        return 0;
+      }
+
+      const unsigned long long t0 = cycles();
+      for (size_t i = 0; i < reps; ++i) fn(d, s, sz);
+      t += cycles() - t0;
+      bytes += reps * sz;
+    }
+  }
+  return bytes * 1000U / (t == 0 ? 1U : t);
+}
+
+int main() {
+  for (size_t i = 0; i < sizeof(src); ++i) src[i] = uint8_t(i * 7U + 1U);
+
+  for (size_t sz = MIN_SIZE; sz <= MAX_SIZE; sz *= 2) {
+    const unsigned long long cpy = run(sz,
+        [](uint8_t* d, const uint8_t* s, size_t n) {
+          ::test_std::memcpy(d, s, n);
+        },
+        &verify_copy);
+    const unsigned long long mov = run(sz,
+        [](uint8_t* d, const uint8_t* s, size_t n) {
+          ::test_std::memmove(d, s, n);
+        },
+        &verify_copy);
+    const unsigned long long set = run(sz,
+        [](uint8_t* d, const uint8_t*, size_t n) {
+          ::test_std::memset(d, 0x5a, n);
+        },
+        [](const uint8_t* d, const uint8_t*, size_t n) {
+          return verify_set(d, 0x5a, n);
+        });
+    if (cpy == 0 || mov == 0 || set == 0) return 1;
+
+    fprintf(stderr, "%8zu bytes: memcpy %6llu, memmove %6llu, memset %6llu "
+                    "bytes per 1000 cycles\n",
+            sz, cpy, mov, set);
+  }
+}
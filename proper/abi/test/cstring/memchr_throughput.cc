@@ -0,0 +1,80 @@
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+
+using _namespace(std)::size_t;
+
+/*
+ * Benchmark: throughput of memchr and memrchr.
+ *
+ * Every power of 2 size from MIN_SIZE to MAX_SIZE is tested at each
+ * start misalignment modulo MAX_ALIGN, with the searched byte
+ * at the far end of the range.
+ * The result of each call is verified.
+ */
+constexpr size_t MIN_SIZE = 1;
+constexpr size_t MAX_SIZE = 1 << 16;
+constexpr size_t MAX_ALIGN = 64;
+constexpr size_t BYTES_PER_RUN = 1 << 16;  // Bytes scanned per alignment.
+
+alignas(MAX_ALIGN) char buf[MAX_ALIGN + MAX_SIZE];
+const char* volatile sink;  // Keeps the benchmarked calls from being elided.
+
+inline unsigned long long cycles() noexcept {
+  return __builtin_ia32_rdtsc();
+}
+
+/*
+ * Run fn for all alignments of size sz, with c placed at index pos.
+ * Returns bytes per 1000 cycles, or 0 if verification failed.
+ */
+template<typename Fn>
+unsigned long long run(const char* name, size_t sz, size_t pos, Fn fn)
+    noexcept {
+  const size_t reps = (sz >= BYTES_PER_RUN ? 1U : BYTES_PER_RUN / sz);
+  unsigned long long t = 0;
+  unsigned long long bytes = 0;
+
+  for (size_t off = 0; off < MAX_ALIGN; ++off) {
+    char* p = buf + off;
+    for (size_t i = 0; i < sizeof(buf) - off; ++i) p[i] = 'x';
+    p[pos] = 'y';
+    if (off > 0) p[-1] = 'y';  // Must not be found.
+    if (off + sz < sizeof(buf)) p[sz] = 'y';  // Must not be found.
+
+    if (fn(p, sz) != p + pos) {
+      fprintf(stderr, "%s: size %zu, offset %zu: "
+                      "verification failed\n", name, sz, off);
+      return 0;
+    }
+    if (fn(p + (pos == 0 ? 1U : 0U), sz - 1U) != nullptr) {
+      fprintf(stderr, "%s: size %zu, offset %zu: "
+                      "found byte outside range\n", name, sz - 1U, off);
+      return 0;
+    }
+
+    const unsigned long long t0 = cycles();
+    for (size_t i = 0; i < reps; ++i) sink = fn(p, sz);
+    t += cycles() - t0;
+    bytes += reps * sz;
+  }
+  return bytes * 1000U / (t == 0 ? 1U : t);
+}
+
+int main() {
+  for (size_t sz = MIN_SIZE; sz <= MAX_SIZE; sz *= 2) {
+    const unsigned long long chr = run("memchr", sz, sz - 1U,
+        [](const char* p, size_t n) {
+          return static_cast<const char*>(::test_std::memchr(p, 'y', n));
+        });
+    const unsigned long long rchr = run("memrchr", sz, 0,
+        [](const char* p, size_t n) {
+          return static_cast<const char*>(::test_std::memrchr(p, 'y', n));
+        });
+    if (chr == 0 || rchr == 0) return 1;
+
+    fprintf(stderr, "%6zu bytes: memchr %6llu, memrchr %6llu "
+                    "bytes per 1000 cycles\n",
+            sz, chr, rchr);
+  }
+}
@@ -0,0 +1,103 @@
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+
+using _namespace(std)::ptrdiff_t;
+using _namespace(std)::size_t;
+using _namespace(std)::uint8_t;
+
+_namespace_begin(std)
+size_t memmove_test_kernels(void* (**)(void*, const void*, size_t),
+                            const char**) noexcept;
+_namespace_end(std)
+
+/*
+ * Test: memmove of overlapping ranges, for each kernel this cpu can run.
+ *
+ * Sizes are chosen around the thresholds of the kernels: the small
+ * copy cases (below 16 and 32 bytes), one and two vectors (16, 32 and
+ * 64 bytes), the unrolled loop (4 vectors) and the ERMS threshold
+ * (2048 bytes).  Each size is moved both forward and backward over
+ * distances that are odd, vector sized, and close to the size itself,
+ * with the source at odd offsets from an aligned address.
+ * The whole buffer is compared against a byte by byte reference.
+ */
+using move_fn = void* (*)(void*, const void*, size_t);
+
+constexpr size_t SIZES[] = {
+  0, 1, 2, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 32, 33, 47, 63, 64, 65,
+  95, 127, 128, 129, 255, 257, 511, 1023, 2047, 2048, 2049, 4095, 4097
+};
+constexpr size_t DISTANCES[] = {
+  1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 129
+};
+constexpr size_t OFFSETS[] = { 0, 1, 5, 13 };
+constexpr size_t MAX_SIZE = 4097;
+constexpr size_t MARGIN = 64;
+constexpr size_t BUF_SIZE = 2 * MAX_SIZE + 2 * MARGIN;
+
+alignas(64) uint8_t buf[BUF_SIZE];
+alignas(64) uint8_t expect[BUF_SIZE];
+
+/* Reference memmove. */
+void ref_memmove(uint8_t* d, const uint8_t* s, size_t len) noexcept {
+  if (d < s) {
+    for (size_t i = 0; i < len; ++i) d[i] = s[i];
+  } else {
+    while (len-- > 0) d[len] = s[len];
+  }
+}
+
+/*
+ * Move len bytes from src_off to dst_off in buf.
+ * Returns false if the result differs from the reference.
+ */
+bool test(move_fn fn, size_t len, size_t src_off, size_t dst_off) noexcept {
+  for (size_t i = 0; i < BUF_SIZE; ++i)
+    buf[i] = expect[i] = uint8_t(i * 7U + (i >> 8) + 1U);
+  ref_memmove(expect + dst_off, expect + src_off, len);
+
+  if (fn(buf + dst_off, buf + src_off, len) != buf + dst_off) {
+    fprintf(stderr, "return value is not dst\n");
+    return false;
+  }
+  for (size_t i = 0; i < BUF_SIZE; ++i) {
+    if (buf[i] != expect[i]) {
+      fprintf(stderr, "byte %zd (relative to dst) differs\n",
+              ptrdiff_t(i) - ptrdiff_t(dst_off));
+      return false;
+    }
+  }
+  return true;
+}
+
+int main() {
+  move_fn kernels[5];
+  const char* names[5];
+  const size_t n_kernels =
+      _namespace(std)::memmove_test_kernels(kernels, names);
+
+  for (size_t k = 0; k < n_kernels; ++k) {
+    fprintf(stderr, "Testing %s kernel...", names[k]);
+    for (size_t len : SIZES) {
+      for (size_t dist : DISTANCES) {
+        const size_t d[] = { dist, len / 2U, len - 1U };
+        for (size_t delta : d) {
+          if (delta == 0 || delta >= len) continue;  // No overlap.
+
+          for (size_t off : OFFSETS) {
+            const size_t lo = MARGIN + off;
+            if (!test(kernels[k], len, lo, lo + delta) ||
+                !test(kernels[k], len, lo + delta, lo)) {
+              fprintf(stderr, "\n%s: len %zu, distance %zu, offset %zu\n",
+                      names[k], len, delta, off);
+              return 1;
+            }
+          }
+        }
+      }
+    }
+    fprintf(stderr, "  %s\n", "\\o/");
+  }
+}
@@ -0,0 +1,77 @@
+#include <cstring>
+#include <cstdio>
+#include <cstdint>
+
+using _namespace(std)::size_t;
+
+/*
+ * Benchmark: throughput of strlen, strnlen and strchr.
+ *
+ * Every power of 2 string length from MIN_SIZE to MAX_SIZE is tested
+ * at each start misalignment modulo MAX_ALIGN.
+ * The result of each call is verified.
+ */
+constexpr size_t MIN_SIZE = 1;
+constexpr size_t MAX_SIZE = 1 << 16;
+constexpr size_t MAX_ALIGN = 64;
+constexpr size_t BYTES_PER_RUN = 1 << 16;  // Bytes scanned per alignment.
+
+alignas(MAX_ALIGN) char buf[MAX_ALIGN + MAX_SIZE + 1];
+volatile size_t sink;  // Keeps the benchmarked calls from being elided.
+
+inline unsigned long long cycles() noexcept {
+  return __builtin_ia32_rdtsc();
+}
+
+/*
+ * Run fn for all alignments of strings of length sz.
+ * Returns bytes per 1000 cycles, or 0 if verification failed.
+ */
+template<typename Fn>
+unsigned long long run(const char* name, size_t sz, Fn fn) noexcept {
+  const size_t reps = (sz >= BYTES_PER_RUN ? 1U : BYTES_PER_RUN / sz);
+  unsigned long long t = 0;
+  unsigned long long bytes = 0;
+
+  for (size_t off = 0; off < MAX_ALIGN; ++off) {
+    char* s = buf + off;
+    for (size_t i = 0; i < sz; ++i) s[i] = 'x';
+    s[sz] = '\0';
+
+    if (fn(s) != sz) {
+      fprintf(stderr, "%s: length %zu, offset %zu: "
+                      "verification failed\n", name, sz, off);
+      return 0;
+    }
+
+    const unsigned long long t0 = cycles();
+    for (size_t i = 0; i < reps; ++i) sink = fn(s);
+    t += cycles() - t0;
+    bytes += reps * sz;
+  }
+  return bytes * 1000U / (t == 0 ? 1U : t);
+}
+
+int main() {
+  for (size_t sz = MIN_SIZE; sz <= MAX_SIZE; sz *= 2) {
+    const unsigned long long len = run("strlen", sz,
+        [](const char* s) -> size_t {
+          return ::test_std::strlen(s);
+        });
+    const unsigned long long nlen = run("strnlen", sz,
+        [](const char* s) -> size_t {
+          return ::test_std::strnlen(s, MAX_SIZE + 1U);
+        });
+    const unsigned long long chr = run("strchr", sz,
+        [](const char* s) -> size_t {
+          return ::test_std::strchr(s, 'y') == nullptr ?
+                 ::test_std::strchr(s, '\0') - s :
+                 0;
+        });
+    if (len == 0 || nlen == 0 || chr == 0) return 1;
+
+    fprintf(stderr, "%6zu bytes: strlen %6llu, strnlen %6llu, strchr %6llu "
+                    "bytes per 1000 cycles\n",
+            sz, len, nlen, chr);
+  }
+}
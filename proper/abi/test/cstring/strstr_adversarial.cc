@@ -0,0 +1,74 @@
+#include <cstring>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+
+/*
+ * Benchmark: strstr on adversarial input.
+ *
+ * The needle "aaa...ab" is searched for in a haystack of "aaa...a",
+ * which takes quadratic time with a naive search.
+ * The haystack is then terminated with a "b", which must be found
+ * at the end.  Finally a "b" is placed so the needle matches at the
+ * start: that search must not depend on the length of the haystack.
+ */
+constexpr size_t HAYSTACK_SIZE = 1 << 20;
+constexpr size_t MAX_NEEDLE = 1 << 12;
+
+char haystack[HAYSTACK_SIZE + 1];
+char needle[MAX_NEEDLE + 1];
+
+inline unsigned long long cycles() noexcept {
+  return __builtin_ia32_rdtsc();
+}
+
+int main() {
+  for (size_t n_len = 2; n_len <= MAX_NEEDLE; n_len *= 2) {
+    for (size_t i = 0; i < n_len - 1U; ++i) needle[i] = 'a';
+    needle[n_len - 1U] = 'b';
+    needle[n_len] = '\0';
+
+    for (size_t i = 0; i < HAYSTACK_SIZE; ++i) haystack[i] = 'a';
+    haystack[HAYSTACK_SIZE] = '\0';
+
+    unsigned long long t0 = cycles();
+    const char* rv = ::test_std::strstr(haystack, needle);
+    const unsigned long long t_miss = cycles() - t0;
+    if (rv != nullptr) {
+      fprintf(stderr, "needle of %zu bytes: found at %td, expected none\n",
+              n_len, rv - haystack);
+      return 1;
+    }
+
+    haystack[HAYSTACK_SIZE - 1U] = 'b';
+    t0 = cycles();
+    rv = ::test_std::strstr(haystack, needle);
+    const unsigned long long t_hit = cycles() - t0;
+    const char* expect = &haystack[HAYSTACK_SIZE - n_len];
+    if (rv != expect) {
+      fprintf(stderr, "needle of %zu bytes: found at %td, expected %td\n",
+              n_len, (rv == nullptr ? -1 : rv - haystack),
+              expect - haystack);
+      return 2;
+    }
+
+    haystack[n_len - 1U] = 'b';
+    t0 = cycles();
+    rv = ::test_std::strstr(haystack, needle);
+    const unsigned long long t_start = cycles() - t0;
+    if (rv != haystack) {
+      fprintf(stderr, "needle of %zu bytes: found at %td, expected 0\n",
+              n_len, (rv == nullptr ? -1 : rv - haystack));
+      return 3;
+    }
+
+    fprintf(stderr, "needle of %4zu bytes: "
+                    "%llu cycles (no match), %llu cycles (match at end), "
+                    "per 1000 haystack bytes; "
+                    "%llu cycles (match at start)\n",
+            n_len,
+            t_miss * 1000U / HAYSTACK_SIZE,
+            t_hit * 1000U / HAYSTACK_SIZE,
+            t_start);
+  }
+}
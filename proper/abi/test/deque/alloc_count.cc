@@ -0,0 +1,86 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <new>
+
+using _namespace(std)::size_t;
+
+/*
+ * Benchmark: heap allocations performed by a deque used as a queue.
+ *
+ * Plain operator new and operator delete are replaced, to count the
+ * number of allocations performed.  For each block size, a deque is
+ * filled to DEPTH elements, then REPS elements are pushed at the back
+ * and popped from the front.  Once the deque has reached its peak size,
+ * emptied blocks are recycled, so the steady state must not allocate.
+ */
+constexpr size_t DEPTH = 10000;
+constexpr size_t REPS = 1000000;
+
+size_t allocs = 0;
+size_t frees = 0;
+
+void* operator new(size_t sz) {
+  ++allocs;
+  void* p = ::test_std::malloc(sz == 0 ? 1 : sz);
+  if (p == nullptr) throw ::test_std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  if (p != nullptr) ++frees;
+  ::test_std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  if (p != nullptr) ++frees;
+  ::test_std::free(p);
+}
+
+template<size_t BlockSize>
+bool run() {
+  using deque = _namespace(std)::deque<int, _namespace(std)::allocator<int>,
+                                       BlockSize>;
+
+  const size_t start = allocs;
+  deque q;
+  for (size_t i = 0; i < DEPTH; ++i) q.push_back(i);
+  const size_t fill = allocs - start;
+
+  for (size_t i = 0; i < REPS; ++i) {
+    if (q.front() != static_cast<int>(i)) return false;
+    q.pop_front();
+    q.push_back(DEPTH + i);
+  }
+  const size_t steady = allocs - start - fill;
+
+  /* Drain the queue; shrink_to_fit must release the spare blocks. */
+  q.clear();
+  const size_t frees_start = frees;
+  q.shrink_to_fit();
+  const size_t released = frees - frees_start;
+
+  fprintf(stderr, "%10zu %8zu %8zu %10zu\n",
+          BlockSize, fill, steady, released);
+  if (steady != 0) {
+    fprintf(stderr, "block size %zu: steady state allocates\n", BlockSize);
+    return false;
+  }
+  if (released == 0) {
+    fprintf(stderr, "block size %zu: shrink_to_fit released nothing\n",
+            BlockSize);
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  fprintf(stderr, "%10s %8s %8s %10s\n",
+          "block size", "fill", "steady", "released");
+  if (!run<512>() || !run<4096>() || !run<8192>() || !run<65536>()) {
+    fprintf(stderr, "verification failed\n");
+    return 1;
+  }
+  fprintf(stderr, "(allocations, except released: frees by shrink_to_fit)\n");
+}
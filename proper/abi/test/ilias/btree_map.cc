@@ -0,0 +1,102 @@
+#include <ilias/btree_map.h>
+#include <map>
+#include <cstdint>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint64_t;
+
+/*
+ * Benchmark: btree_map against map.
+ *
+ * For each size, measures building the map from sorted input,
+ * looking up every key in scrambled order, iterating over all
+ * elements in order, and erasing every key in scrambled order.
+ */
+constexpr size_t MIN_SIZE = 1000;
+constexpr size_t MAX_SIZE = 1000000;
+
+inline unsigned long long cycles() noexcept {
+  return __builtin_ia32_rdtsc();
+}
+
+/* Permutation of [0, n): multiply by a prime larger than n. */
+inline uint64_t scramble(uint64_t i, uint64_t n) noexcept {
+  return (i * 2654435761ULL) % n;
+}
+
+struct result {
+  unsigned long long build, lookup, iterate, erase;
+};
+
+template<typename Map>
+bool run(size_t n, result& r) {
+  using value_type = typename Map::value_type;
+
+  struct counting_iter {
+    using iterator_category = _namespace(std)::input_iterator_tag;
+    using value_type = typename Map::value_type;
+    using difference_type = ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = value_type;
+
+    value_type operator*() const { return value_type(i, i); }
+    counting_iter& operator++() { ++i; return *this; }
+    bool operator!=(const counting_iter& o) const { return i != o.i; }
+    bool operator==(const counting_iter& o) const { return i == o.i; }
+
+    uint64_t i;
+  };
+
+  unsigned long long t0 = cycles();
+  Map m(counting_iter{ 0 }, counting_iter{ n });
+  r.build = (cycles() - t0) / n;
+  if (m.size() != n) return false;
+
+  uint64_t sum = 0;
+  t0 = cycles();
+  for (size_t i = 0; i < n; ++i) {
+    auto f = m.find(scramble(i, n));
+    if (f == m.end()) return false;
+    sum += f->second;
+  }
+  r.lookup = (cycles() - t0) / n;
+  if (sum != uint64_t(n) * (n - 1U) / 2U) return false;
+
+  uint64_t expect = 0;
+  t0 = cycles();
+  for (const value_type& v : m) {
+    if (v.first != expect++) return false;
+  }
+  r.iterate = (cycles() - t0) * 1000U / n;
+  if (expect != n) return false;
+
+  t0 = cycles();
+  for (size_t i = 0; i < n; ++i) {
+    if (m.erase(scramble(i, n)) != 1U) return false;
+  }
+  r.erase = (cycles() - t0) / n;
+  return m.empty();
+}
+
+int main() {
+  using btree = _namespace(ilias)::btree_map<uint64_t, uint64_t>;
+  using rbtree = _namespace(std)::map<uint64_t, uint64_t>;
+
+  fprintf(stderr, "%8s %-10s %8s %8s %12s %8s\n",
+          "size", "container", "build", "lookup", "iterate/1000", "erase");
+  for (size_t n = MIN_SIZE; n <= MAX_SIZE; n *= 10) {
+    result b, m;
+    if (!run<btree>(n, b) || !run<rbtree>(n, m)) {
+      fprintf(stderr, "size %zu: verification failed\n", n);
+      return 1;
+    }
+
+    fprintf(stderr, "%8zu %-10s %8llu %8llu %12llu %8llu\n",
+            n, "btree_map", b.build, b.lookup, b.iterate, b.erase);
+    fprintf(stderr, "%8zu %-10s %8llu %8llu %12llu %8llu\n",
+            n, "map", m.build, m.lookup, m.iterate, m.erase);
+  }
+  fprintf(stderr, "(cycles per operation; iterate in cycles per 1000 "
+                  "elements)\n");
+}
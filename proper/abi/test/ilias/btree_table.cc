@@ -0,0 +1,214 @@
+#include <ilias/btree_map.h>
+#include <ilias/btree_set.h>
+#include <algorithm>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint64_t;
+using _namespace(std)::vector;
+
+/*
+ * Test: btree_map and btree_set behaviour.
+ *
+ * Contents are compared against map and set, iterating forward and
+ * backward, after bulk construction (sorted, reverse sorted and
+ * scrambled input, with duplicates), hinted inserts (with good and bad
+ * hints), and range erases starting and ending at various positions.
+ * Sizes are large enough for the trees to have several levels.
+ */
+using map_type = _namespace(ilias)::btree_map<uint64_t, uint64_t>;
+using set_type = _namespace(ilias)::btree_set<uint64_t>;
+using ref_map = _namespace(std)::map<uint64_t, uint64_t>;
+using ref_set = _namespace(std)::set<uint64_t>;
+using pair_type = _namespace(std)::pair<uint64_t, uint64_t>;
+
+constexpr size_t SIZES[] = { 0, 1, 2, 63, 64, 65, 1000, 20000 };
+
+/* Permutation of [0, n): multiply by a prime larger than n. */
+inline uint64_t scramble(uint64_t i, uint64_t n) noexcept {
+  return (i * 2654435761ULL) % n;
+}
+
+bool contains(const map_type& m, const ref_map::value_type& v) {
+  const auto f = m.find(v.first);
+  return f != m.end() && f->first == v.first && f->second == v.second;
+}
+
+bool contains(const set_type& s, uint64_t v) {
+  const auto f = s.find(v);
+  return f != s.end() && *f == v && s.count(v) == 1U;
+}
+
+/* Verify m equals ref, by lookup and by forward and reverse iteration. */
+template<typename Tree, typename Ref>
+bool verify(const char* what, size_t n, const Tree& m, const Ref& ref) {
+  if (m.size() != ref.size() || m.empty() != ref.empty()) {
+    fprintf(stderr, "%s (%zu): size %zu, expected %zu\n",
+            what, n, m.size(), ref.size());
+    return false;
+  }
+  if (!_namespace(std)::equal(m.begin(), m.end(), ref.begin(), ref.end())) {
+    fprintf(stderr, "%s (%zu): forward iteration differs\n", what, n);
+    return false;
+  }
+  if (!_namespace(std)::equal(m.rbegin(), m.rend(),
+                              ref.rbegin(), ref.rend())) {
+    fprintf(stderr, "%s (%zu): reverse iteration differs\n", what, n);
+    return false;
+  }
+
+  /* Decrementing from end() must visit the same elements. */
+  auto r = ref.end();
+  for (auto i = m.end(); i != m.begin(); ) {
+    if (*--i != *--r) {
+      fprintf(stderr, "%s (%zu): decrement from end() differs\n", what, n);
+      return false;
+    }
+  }
+
+  for (const auto& v : ref) {
+    if (!contains(m, v)) {
+      fprintf(stderr, "%s (%zu): lookup failed\n", what, n);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool test_bulk(size_t n) {
+  vector<pair_type> sorted, reversed, scrambled;
+  for (uint64_t i = 0; i < n; ++i) {
+    sorted.emplace_back(2U * i, i);
+    reversed.emplace_back(2U * (n - 1U - i), i);
+    scrambled.emplace_back(2U * (scramble(i, n) / 2U), i);  // Duplicates.
+  }
+
+  for (const vector<pair_type>* v : { &sorted, &reversed, &scrambled }) {
+    const map_type m(v->begin(), v->end());
+    const ref_map ref(v->begin(), v->end());
+    if (!verify("bulk construction", n, m, ref)) return false;
+
+    map_type inserted;
+    inserted.emplace(1, 1);  // Odd key, sorts between the others.
+    inserted.insert(v->begin(), v->end());
+    ref_map ref_inserted = ref;
+    ref_inserted.emplace(1, 1);
+    if (!verify("range insert", n, inserted, ref_inserted)) return false;
+  }
+
+  vector<uint64_t> keys;
+  for (uint64_t i = 0; i < n; ++i) keys.push_back(scramble(i, n) % 100U);
+  const set_type s(keys.begin(), keys.end());
+  const ref_set ref(keys.begin(), keys.end());
+  return verify("set bulk construction", n, s, ref);
+}
+
+bool test_hint(size_t n) {
+  map_type m;
+  ref_map ref;
+
+  for (uint64_t i = 0; i < n; ++i) {
+    const uint64_t k = 3U * scramble(i, n);
+
+    /* Alternate exact hints, hints just before, and bad hints. */
+    map_type::const_iterator hint;
+    switch (i % 4U) {
+    case 0:
+      hint = m.lower_bound(k);
+      break;
+    case 1:
+      hint = m.upper_bound(k);
+      if (hint != m.begin()) --hint;
+      break;
+    case 2:
+      hint = m.begin();
+      break;
+    case 3:
+      hint = m.end();
+      break;
+    }
+
+    const auto expect = ref.emplace(k, i).first;
+    auto r = m.emplace_hint(hint, k, i);
+    if (r == m.end() || *r != *expect) {
+      fprintf(stderr, "emplace_hint (%zu): wrong iterator returned\n", n);
+      return false;
+    }
+
+    /* Inserting an existing key returns it, unmodified. */
+    r = m.insert(m.end(), pair_type(k, i + 1U));
+    if (*r != *expect) {
+      fprintf(stderr, "insert hint (%zu): duplicate modified map\n", n);
+      return false;
+    }
+  }
+  if (!verify("hinted insert", n, m, ref)) return false;
+
+  set_type s;
+  ref_set s_ref;
+  for (uint64_t i = 0; i < n; ++i) {
+    s.insert(s.end(), i);  // Ascending, hint always at end.
+    s.insert(s.begin(), 2U * n - i);  // Descending, hint always at begin.
+    s_ref.insert(i);
+    s_ref.insert(2U * n - i);
+  }
+  return verify("set hinted insert", n, s, s_ref);
+}
+
+bool test_range_erase(size_t n) {
+  vector<pair_type> v;
+  for (uint64_t i = 0; i < n; ++i) v.emplace_back(i, i);
+  const size_t cuts[] = { 0, 1, n / 3U, n / 2U, n - n / 3U, n - 1U, n };
+
+  for (size_t b : cuts) {
+    for (size_t e : cuts) {
+      if (b > e || e > n) continue;
+
+      map_type m(v.begin(), v.end());
+      ref_map ref(v.begin(), v.end());
+      auto r = m.erase(m.find(b), (e == n ? m.end() : m.find(e)));
+      ref.erase(ref.find(b), (e == n ? ref.end() : ref.find(e)));
+
+      if ((e == n ? r != m.end() : r == m.end() || r->first != e)) {
+        fprintf(stderr, "erase [%zu, %zu) (%zu): wrong iterator returned\n",
+                b, e, n);
+        return false;
+      }
+      if (!verify("range erase", n, m, ref)) return false;
+
+      /* The tree must remain usable after the erase. */
+      for (uint64_t i = 0; i < n; i += 7) {
+        m.emplace(i, i);
+        ref.emplace(i, i);
+      }
+      if (!verify("insert after range erase", n, m, ref)) return false;
+    }
+  }
+
+  /* Erase every other element by iterator. */
+  set_type s;
+  ref_set s_ref;
+  for (uint64_t i = 0; i < n; ++i) {
+    s.insert(i);
+    s_ref.insert(i);
+  }
+  for (auto i = s.begin(); i != s.end(); ) {
+    s_ref.erase(*i);
+    i = s.erase(i);
+    if (i != s.end()) ++i;
+  }
+  return verify("set erase", n, s, s_ref);
+}
+
+int main() {
+  for (size_t n : SIZES) {
+    fprintf(stderr, "Testing size %zu...", n);
+    if (!test_bulk(n) || !test_hint(n) || !test_range_erase(n)) return 1;
+    fprintf(stderr, "  %s\n", "\\o/");
+  }
+}
@@ -0,0 +1,85 @@
+#include <ilias/flat_hash_map.h>
+#include <unordered_map>
+#include <cstdint>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint64_t;
+
+/*
+ * Benchmark: flat_hash_map against unordered_map.
+ *
+ * For each table size, measures inserting N distinct keys, looking up
+ * each of them (hits), looking up N absent keys (misses), and an erase
+ * heavy workload that erases each key and inserts a new one.
+ * Keys are scrambled, so neither table benefits from sequential keys
+ * landing in sequential buckets.
+ */
+constexpr size_t MIN_SIZE = 1000;
+constexpr size_t MAX_SIZE = 1000000;
+
+inline unsigned long long cycles() noexcept {
+  return __builtin_ia32_rdtsc();
+}
+
+inline uint64_t key(uint64_t i) noexcept {
+  i *= 0x9e3779b97f4a7c15ULL;
+  i ^= i >> 29;
+  i *= 0xbf58476d1ce4e5b9ULL;
+  return i ^ (i >> 32);
+}
+
+struct result {
+  unsigned long long insert, hit, miss, erase;
+};
+
+template<typename Map>
+bool run(size_t n, result& r) {
+  Map m;
+  unsigned long long t0 = cycles();
+  for (size_t i = 0; i < n; ++i) m.emplace(key(i), i);
+  r.insert = (cycles() - t0) / n;
+
+  uint64_t sum = 0;
+  t0 = cycles();
+  for (size_t i = 0; i < n; ++i) {
+    auto f = m.find(key(i));
+    if (f == m.end()) return false;
+    sum += f->second;
+  }
+  r.hit = (cycles() - t0) / n;
+  if (sum != uint64_t(n) * (n - 1U) / 2U) return false;
+
+  t0 = cycles();
+  for (size_t i = n; i < 2U * n; ++i)
+    if (m.find(key(i)) != m.end()) return false;
+  r.miss = (cycles() - t0) / n;
+
+  t0 = cycles();
+  for (size_t i = 0; i < n; ++i) {
+    if (m.erase(key(i)) != 1U) return false;
+    m.emplace(key(i + 2U * n), i);
+  }
+  r.erase = (cycles() - t0) / n;
+  return m.size() == n;
+}
+
+int main() {
+  using flat = _namespace(ilias)::flat_hash_map<uint64_t, uint64_t>;
+  using chained = _namespace(std)::unordered_map<uint64_t, uint64_t>;
+
+  fprintf(stderr, "%8s %-14s %8s %8s %8s %8s  (cycles per operation)\n",
+          "size", "container", "insert", "hit", "miss", "erase");
+  for (size_t n = MIN_SIZE; n <= MAX_SIZE; n *= 10) {
+    result f, c;
+    if (!run<flat>(n, f) || !run<chained>(n, c)) {
+      fprintf(stderr, "size %zu: verification failed\n", n);
+      return 1;
+    }
+
+    fprintf(stderr, "%8zu %-14s %8llu %8llu %8llu %8llu\n",
+            n, "flat_hash_map", f.insert, f.hit, f.miss, f.erase);
+    fprintf(stderr, "%8zu %-14s %8llu %8llu %8llu %8llu\n",
+            n, "unordered_map", c.insert, c.hit, c.miss, c.erase);
+  }
+}
@@ -0,0 +1,296 @@
+#include <ilias/flat_hash_map.h>
+#include <ilias/flat_hash_set.h>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <cstdint>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint64_t;
+using _namespace(std)::string;
+
+/*
+ * Test: flat_hash_map and flat_hash_set behaviour.
+ *
+ * Contents are compared against map and set after inserts, erases,
+ * rehashes, copies and moves.  Mapped values own a heap allocated
+ * string and count live instances, so elements that are leaked,
+ * destroyed twice, or lost while moving slots around are detected.
+ *
+ * An erase heavy workload at constant size checks that slots of erased
+ * elements are reused, instead of the table growing without bound.
+ */
+long live = 0;  // Number of live tracked instances.
+
+struct tracked {
+  explicit tracked(uint64_t v) : v(v), s(40, char('a' + v % 26U)) { ++live; }
+  tracked(const tracked& o) : v(o.v), s(o.s) { ++live; }
+  tracked(tracked&& o) : v(o.v), s(_namespace(std)::move(o.s)) { ++live; }
+  ~tracked() noexcept { --live; }
+
+  tracked& operator=(const tracked&) = default;
+  tracked& operator=(tracked&&) = default;
+
+  bool valid() const noexcept {
+    return s.size() == 40U && s[0] == char('a' + v % 26U) && s[39] == s[0];
+  }
+
+  uint64_t v;
+  string s;
+};
+
+bool operator==(const tracked& x, const tracked& y) noexcept {
+  return x.v == y.v && x.s == y.s;
+}
+
+using map_type = _namespace(ilias)::flat_hash_map<uint64_t, tracked>;
+using set_type = _namespace(ilias)::flat_hash_set<string>;
+using ref_map = _namespace(std)::map<uint64_t, uint64_t>;
+using ref_set = _namespace(std)::set<string>;
+
+inline uint64_t key(uint64_t i) noexcept {
+  i *= 0x9e3779b97f4a7c15ULL;
+  return i ^ (i >> 29);
+}
+
+/*
+ * Verify m holds exactly the elements of ref, both by lookup and by
+ * iteration (each element must be visited once).
+ */
+bool verify(const char* what, const map_type& m, const ref_map& ref) {
+  if (m.size() != ref.size() || m.empty() != ref.empty()) {
+    fprintf(stderr, "%s: size %zu, expected %zu\n",
+            what, m.size(), ref.size());
+    return false;
+  }
+
+  for (const auto& r : ref) {
+    auto f = m.find(r.first);
+    if (f == m.end() || f->first != r.first || f->second.v != r.second ||
+        !f->second.valid() || m.count(r.first) != 1U) {
+      fprintf(stderr, "%s: key %llu missing or wrong\n",
+              what, static_cast<unsigned long long>(r.first));
+      return false;
+    }
+  }
+
+  size_t n = 0;
+  ref_map seen;
+  for (map_type::const_iterator i = m.begin(); i != m.end(); ++i, ++n) {
+    if (!seen.emplace(i->first, i->second.v).second) {
+      fprintf(stderr, "%s: iteration visits key %llu twice\n",
+              what, static_cast<unsigned long long>(i->first));
+      return false;
+    }
+  }
+  if (n != m.size() || seen != ref) {
+    fprintf(stderr, "%s: iteration visits %zu elements, expected %zu\n",
+            what, n, ref.size());
+    return false;
+  }
+  return true;
+}
+
+bool test_insert_erase() {
+  map_type m;
+  ref_map ref;
+
+  for (uint64_t i = 0; i < 1000; ++i) {
+    auto r = m.emplace(key(i), tracked(i));
+    if (!r.second || r.first->first != key(i)) {
+      fprintf(stderr, "emplace of new key failed\n");
+      return false;
+    }
+    ref.emplace(key(i), i);
+  }
+  if (!verify("insert", m, ref)) return false;
+
+  /* Duplicates are not inserted and don't replace the mapped value. */
+  for (uint64_t i = 0; i < 1000; i += 7) {
+    auto r = m.emplace(key(i), tracked(i + 1U));
+    if (r.second || r.first->second.v != i) {
+      fprintf(stderr, "emplace of duplicate key modified the map\n");
+      return false;
+    }
+  }
+
+  /* Erase by key, including absent keys. */
+  for (uint64_t i = 0; i < 1000; i += 3) {
+    if (m.erase(key(i)) != 1U || m.erase(key(i)) != 0U) {
+      fprintf(stderr, "erase by key failed\n");
+      return false;
+    }
+    ref.erase(key(i));
+  }
+  if (!verify("erase by key", m, ref)) return false;
+
+  /* Erase while iterating, using the returned iterator. */
+  for (map_type::iterator i = m.begin(); i != m.end(); ) {
+    if (i->second.v % 2U == 0U) {
+      ref.erase(i->first);
+      i = m.erase(i);
+    } else {
+      ++i;
+    }
+  }
+  if (!verify("erase while iterating", m, ref)) return false;
+
+  /* Reinsert erased keys, then grow through several rehashes. */
+  for (uint64_t i = 0; i < 5000; ++i) {
+    m.insert_or_assign(key(i), tracked(i));
+    ref[key(i)] = i;
+  }
+  if (!verify("reinsert", m, ref)) return false;
+
+  m.erase(m.begin(), m.end());
+  ref.clear();
+  return verify("erase range", m, ref);
+}
+
+bool test_tombstone_reuse() {
+  constexpr uint64_t N = 64;
+  map_type m;
+  ref_map ref;
+
+  for (uint64_t i = 0; i < N; ++i) {
+    m.emplace(key(i), tracked(i));
+    ref.emplace(key(i), i);
+  }
+  const size_t cap = m.capacity();
+
+  /* Keep the size constant, while every slot is erased many times. */
+  for (uint64_t i = 0; i < 100U * cap; ++i) {
+    if (m.erase(key(i)) != 1U) {
+      fprintf(stderr, "churn: key %llu missing\n",
+              static_cast<unsigned long long>(i));
+      return false;
+    }
+    ref.erase(key(i));
+    m.emplace(key(i + N), tracked(i + N));
+    ref.emplace(key(i + N), i + N);
+
+    if (i % 997U == 0U && !verify("churn", m, ref)) return false;
+  }
+  if (!verify("churn", m, ref)) return false;
+
+  if (m.capacity() != cap) {
+    fprintf(stderr, "churn at size %llu grew capacity from %zu to %zu\n",
+            static_cast<unsigned long long>(N), cap, m.capacity());
+    return false;
+  }
+  return true;
+}
+
+bool test_copy_move() {
+  map_type m;
+  ref_map ref;
+  for (uint64_t i = 0; i < 300; ++i) {
+    m.emplace(key(i), tracked(i));
+    ref.emplace(key(i), i);
+  }
+
+  map_type copy = m;
+  if (!(copy == m) || !verify("copy", copy, ref)) return false;
+  copy.erase(key(0));
+  copy.insert_or_assign(key(1000), tracked(1000));
+  if (copy == m || !verify("original after modifying copy", m, ref))
+    return false;
+
+  map_type assigned;
+  assigned.emplace(key(5000), tracked(5000));
+  assigned = m;
+  if (!verify("copy assignment", assigned, ref)) return false;
+
+  map_type moved = _namespace(std)::move(assigned);
+  if (!assigned.empty() || !verify("move", moved, ref)) return false;
+
+  map_type move_assigned;
+  move_assigned.emplace(key(5000), tracked(5000));
+  move_assigned = _namespace(std)::move(moved);
+  if (!moved.empty() || !verify("move assignment", move_assigned, ref))
+    return false;
+
+  /* The moved-from map must be usable. */
+  moved.emplace(key(1), tracked(1));
+  if (!verify("reuse after move", moved, ref_map{ { key(1), 1 } }))
+    return false;
+
+  swap(moved, move_assigned);
+  if (!verify("swap", moved, ref) ||
+      !verify("swap", move_assigned, ref_map{ { key(1), 1 } }))
+    return false;
+
+  return true;
+}
+
+bool test_set() {
+  set_type s;
+  ref_set ref;
+
+  for (unsigned int i = 0; i < 2000; ++i) {
+    string v(i % 50U, 'x');
+    v += char('a' + i % 26U);
+    v += char('a' + i / 26U % 26U);
+    v += char('a' + i / 676U);
+    if (!s.insert(v).second || s.insert(v).second) {
+      fprintf(stderr, "set: insert of \"%s\" failed\n", v.c_str());
+      return false;
+    }
+    ref.insert(v);
+  }
+  for (unsigned int i = 0; i < 2000; i += 3) {
+    const string v = *_namespace(std)::next(ref.begin(), i / 3U);
+    if (s.erase(v) != 1U) {
+      fprintf(stderr, "set: erase of \"%s\" failed\n", v.c_str());
+      return false;
+    }
+    ref.erase(v);
+  }
+
+  const set_type copy = s;
+  for (const set_type* t : { &s, &copy }) {
+    if (t->size() != ref.size()) {
+      fprintf(stderr, "set: size %zu, expected %zu\n", t->size(), ref.size());
+      return false;
+    }
+    ref_set seen;
+    for (const string& v : *t) {
+      if (ref.count(v) != 1U || !seen.insert(v).second) {
+        fprintf(stderr, "set: iteration yields \"%s\"\n", v.c_str());
+        return false;
+      }
+    }
+    for (const string& v : ref) {
+      if (t->count(v) != 1U) {
+        fprintf(stderr, "set: \"%s\" missing\n", v.c_str());
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main() {
+  fprintf(stderr, "Testing flat_hash_map insert and erase...");
+  if (!test_insert_erase()) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  fprintf(stderr, "Testing flat_hash_map reuse of erased slots...");
+  if (!test_tombstone_reuse()) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  fprintf(stderr, "Testing flat_hash_map copy and move...");
+  if (!test_copy_move()) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  fprintf(stderr, "Testing flat_hash_set...");
+  if (!test_set()) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  if (live != 0) {
+    fprintf(stderr, "%ld tracked values leaked (or destroyed twice)\n", live);
+    return 1;
+  }
+}
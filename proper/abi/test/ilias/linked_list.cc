@@ -0,0 +1,135 @@
+#include <ilias/linked_list.h>
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint64_t;
+using _namespace(std)::vector;
+
+/*
+ * Test: linked_list merge and sort.
+ *
+ * Two sorted lists are merged, as vmmap_shard::merge merges the free
+ * lists of two shards (ordered by free size): with every element of
+ * the second list sorting after the first, sorting before it, and
+ * interleaved with it.  Equal elements of the first list must remain
+ * in front of those of the second.
+ */
+struct elem
+: _namespace(ilias)::linked_list_element<>
+{
+  elem() noexcept = default;
+  elem(uint64_t v, size_t id) noexcept : v(v), id(id) {}
+
+  uint64_t v = 0;  // Sort key.
+  size_t id = 0;  // Position in the merge result.
+};
+
+using list_type = _namespace(ilias)::linked_list<elem>;
+
+struct elem_less {
+  bool operator()(const elem& x, const elem& y) const noexcept {
+    return x.v < y.v;
+  }
+};
+
+/* Verify l holds the n elements with id [0, n), in order. */
+bool verify(const char* what, const list_type& l, size_t n) {
+  size_t id = 0;
+  for (const elem& x : l) {
+    if (x.id != id++) {
+      fprintf(stderr, "%s: element %zu out of order\n", what, id - 1U);
+      return false;
+    }
+  }
+  if (id != n) {
+    fprintf(stderr, "%s: %zu elements, expected %zu\n", what, id, n);
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Merge lists holding the keys in lhs and rhs (both sorted).
+ * The expected order of the merged elements is computed up front.
+ */
+bool test_merge(const char* what,
+                const vector<uint64_t>& lhs, const vector<uint64_t>& rhs) {
+  vector<elem> v;
+  v.reserve(lhs.size() + rhs.size());
+
+  size_t i = 0, j = 0;
+  size_t id = 0;
+  vector<size_t> lhs_id(lhs.size()), rhs_id(rhs.size());
+  while (i != lhs.size() || j != rhs.size()) {
+    if (j == rhs.size() || (i != lhs.size() && !(rhs[j] < lhs[i])))
+      lhs_id[i++] = id++;
+    else
+      rhs_id[j++] = id++;
+  }
+
+  list_type l1, l2;
+  for (i = 0; i < lhs.size(); ++i) v.emplace_back(lhs[i], lhs_id[i]);
+  for (j = 0; j < rhs.size(); ++j) v.emplace_back(rhs[j], rhs_id[j]);
+  for (i = 0; i < lhs.size(); ++i) l1.link_back(&v[i]);
+  for (j = 0; j < rhs.size(); ++j) l2.link_back(&v[lhs.size() + j]);
+
+  list_type::merge(l1.begin(), l1.end(), l2.begin(), l2.end(), elem_less());
+  if (!l2.empty()) {
+    fprintf(stderr, "%s: elements left behind in merged list\n", what);
+    return false;
+  }
+  return verify(what, l1, v.size());
+}
+
+bool test_sort(size_t n) {
+  vector<elem> v;
+  v.reserve(n);
+  for (size_t i = 0; i < n; ++i)
+    v.emplace_back((i * 2654435761ULL) % 97U, 0);
+
+  list_type l;
+  for (elem& x : v) l.link_back(&x);
+  list_type::sort(l.begin(), l.end(), elem_less());
+
+  size_t count = 0;
+  const elem* pred = nullptr;
+  for (const elem& x : l) {
+    if (pred != nullptr && x.v < pred->v) {
+      fprintf(stderr, "sort (%zu): out of order\n", n);
+      return false;
+    }
+    pred = &x;
+    ++count;
+  }
+  if (count != n) {
+    fprintf(stderr, "sort (%zu): %zu elements\n", n, count);
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  fprintf(stderr, "Testing merge...");
+  const vector<uint64_t> small = { 1, 2, 2, 3, 5 };
+  const vector<uint64_t> large = { 8, 13, 21, 21, 34 };
+  const vector<uint64_t> mixed = { 0, 2, 4, 13, 40 };
+  if (!test_merge("rhs after lhs", small, large) ||
+      !test_merge("rhs before lhs", large, small) ||
+      !test_merge("rhs single, after lhs", small, { 100 }) ||
+      !test_merge("rhs single, before lhs", small, { 0 }) ||
+      !test_merge("interleaved", small, mixed) ||
+      !test_merge("interleaved, rhs ends first", mixed, small) ||
+      !test_merge("equal keys", small, small) ||
+      !test_merge("empty lhs", {}, small) ||
+      !test_merge("empty rhs", small, {}))
+    return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  fprintf(stderr, "Testing sort...");
+  for (size_t n : { 0, 1, 2, 3, 17, 1000 })
+    if (!test_sort(n)) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+}
@@ -0,0 +1,249 @@
+#include <ilias/linked_set.h>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint64_t;
+
+/*
+ * Benchmark: bulk operations on linked_set against per-element operations.
+ *
+ * For each size, measures building the set from sorted elements,
+ * using link() versus link_sorted(), and unlinking the middle half of
+ * the set, using unlink() per element versus range unlink().
+ * Split and join are verified to round trip.
+ *
+ * Before the benchmark, the red-black invariants and augmented values
+ * of an augmented set are verified after every link, unlink,
+ * link_sorted, split, join and range unlink, for a range of sizes and
+ * positions.
+ */
+constexpr size_t MIN_SIZE = 1000;
+constexpr size_t MAX_SIZE = 1000000;
+
+inline unsigned long long cycles() noexcept {
+  return __builtin_ia32_rdtsc();
+}
+
+struct elem
+: _namespace(ilias)::linked_set_element<elem>
+{
+  elem() noexcept = default;
+  explicit elem(uint64_t v) noexcept : v(v) {}
+
+  using linked_set_element::left;
+  using linked_set_element::right;
+
+  uint64_t v;
+  size_t count = 0;  // Augmented: number of elements in subtree.
+};
+
+struct elem_less {
+  bool operator()(const elem& x, const elem& y) const noexcept {
+    return x.v < y.v;
+  }
+};
+
+struct count_augment {
+  void operator()(elem* x) const noexcept {
+    x->count = 1U + (x->left() ? x->left()->count : 0U) +
+               (x->right() ? x->right()->count : 0U);
+  }
+};
+
+using set_type = _namespace(ilias)::linked_set<elem, void, elem_less>;
+using aug_set_type =
+    _namespace(ilias)::linked_set<elem, void, elem_less, count_augment>;
+
+/* Verify the set holds elements [b, e) of v, in order. */
+template<typename Set>
+bool verify(const Set& s, const _namespace(std)::vector<elem>& v,
+            size_t b, size_t e) {
+  if (!s.verify()) return false;
+  for (const elem& x : s) {
+    if (b == e || &x != &v[b]) return false;
+    ++b;
+  }
+  return b == e;
+}
+
+/* Verify the augmented count of each element in subtree x. */
+bool verify_count(const elem* x) {
+  if (x == nullptr) return true;
+  const size_t expect = 1U + (x->left() ? x->left()->count : 0U) +
+                        (x->right() ? x->right()->count : 0U);
+  return x->count == expect &&
+         verify_count(x->left()) && verify_count(x->right());
+}
+
+/*
+ * Verify an augmented set holds elements [b, e) of v, in order,
+ * with valid red-black invariants and augmented values.
+ */
+bool check(const aug_set_type& s, const _namespace(std)::vector<elem>& v,
+           size_t b, size_t e) {
+  if (!verify(s, v, b, e)) return false;
+  if (s.empty()) return true;
+  return verify_count(&*s.root()) && s.root()->count == e - b;
+}
+
+/* Deterministic pseudo random sequence. */
+size_t next_rand(uint64_t& state) noexcept {
+  state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+  return state >> 33;
+}
+
+/* Verify invariants after each operation on sets of n elements. */
+bool check_ops(size_t n) {
+  _namespace(std)::vector<elem> v;
+  v.reserve(n);
+  for (size_t i = 0; i < n; ++i) v.emplace_back(i);
+  uint64_t state = n;
+
+  /* Per-element link and unlink, in pseudo random order. */
+  {
+    _namespace(std)::vector<size_t> order(n);
+    for (size_t i = 0; i < n; ++i) order[i] = i;
+    for (size_t i = n; i > 1U; --i)
+      _namespace(std)::swap(order[i - 1U], order[next_rand(state) % i]);
+
+    aug_set_type s;
+    for (size_t i = 0; i < n; ++i) {
+      s.link(&v[order[i]], false);
+      if (!s.verify() || !verify_count(&*s.root())) return false;
+    }
+    if (!check(s, v, 0, n)) return false;
+
+    for (size_t i = 0; i < n; ++i) {
+      s.unlink(&v[order[i]]);
+      if (!s.verify() || (!s.empty() && !verify_count(&*s.root())))
+        return false;
+    }
+    if (!s.empty()) return false;
+  }
+
+  /* Split at each position, join back. */
+  for (size_t pos = 0; pos <= n; pos += (n < 64U ? 1U : n / 37U + 1U)) {
+    aug_set_type s;
+    s.link_sorted(v.begin(), v.end());
+    if (!check(s, v, 0, n)) return false;
+
+    aug_set_type tail = s.split(pos == n ? s.end() : s.find(v[pos]));
+    if (!check(s, v, 0, pos) || !check(tail, v, pos, n)) return false;
+
+    /* Split the tail again, so joins see trees of unequal height. */
+    const size_t pos2 = pos + (n - pos) / 3U;
+    aug_set_type tail2 =
+        tail.split(pos2 == n ? tail.end() : tail.find(v[pos2]));
+    if (!check(tail, v, pos, pos2) || !check(tail2, v, pos2, n)) return false;
+
+    s.join(_namespace(std)::move(tail));
+    if (!tail.empty() || !check(s, v, 0, pos2)) return false;
+    s.join(_namespace(std)::move(tail2));
+    if (!tail2.empty() || !check(s, v, 0, n)) return false;
+
+    s.unlink_all();
+  }
+
+  /* Range unlink of [b, e), for a selection of ranges. */
+  for (size_t b = 0; b <= n; b += (n < 16U ? 1U : n / 7U + 1U)) {
+    for (size_t e = b; e <= n; e += (n < 16U ? 1U : n / 5U + 1U)) {
+      aug_set_type s;
+      s.link_sorted(v.begin(), v.end());
+
+      size_t visited = 0;
+      s.unlink(b == n ? s.end() : s.find(v[b]),
+               e == n ? s.end() : s.find(v[e]),
+               [&visited](elem*) { ++visited; });
+      if (visited != e - b) return false;
+      if (!s.verify() || (!s.empty() && !verify_count(&*s.root())))
+        return false;
+
+      /* Relink the range, to check the set is still usable. */
+      for (size_t i = b; i < e; ++i) s.link(&v[i], false);
+      if (!check(s, v, 0, n)) return false;
+
+      s.unlink_all();
+    }
+  }
+  return true;
+}
+
+struct result {
+  unsigned long long link, link_sorted, unlink, unlink_range;
+};
+
+bool run(size_t n, result& r) {
+  _namespace(std)::vector<elem> v;
+  v.reserve(n);
+  for (size_t i = 0; i < n; ++i) v.emplace_back(i);
+  const size_t q = n / 4U;
+
+  /* Per-element operations. */
+  {
+    set_type s;
+    unsigned long long t0 = cycles();
+    for (elem& x : v) s.link(&x, false);
+    r.link = (cycles() - t0) / n;
+    if (!verify(s, v, 0, n)) return false;
+
+    t0 = cycles();
+    for (size_t i = q; i < n - q; ++i) s.unlink(&v[i]);
+    r.unlink = (cycles() - t0) / (n - 2U * q);
+
+    s.unlink_all();
+  }
+
+  /* Bulk operations. */
+  {
+    set_type s;
+    unsigned long long t0 = cycles();
+    s.link_sorted(v.begin(), v.end());
+    r.link_sorted = (cycles() - t0) / n;
+    if (!verify(s, v, 0, n)) return false;
+
+    set_type tail = s.split(s.find(v[n / 2U]));
+    if (!verify(s, v, 0, n / 2U) || !verify(tail, v, n / 2U, n))
+      return false;
+    s.join(_namespace(std)::move(tail));
+    if (!tail.empty() || !verify(s, v, 0, n)) return false;
+
+    size_t visited = 0;
+    t0 = cycles();
+    s.unlink(s.find(v[q]), s.find(v[n - q]),
+             [&visited](elem*) { ++visited; });
+    r.unlink_range = (cycles() - t0) / (n - 2U * q);
+    if (visited != n - 2U * q) return false;
+
+    /* Relink the middle, to check the set is still usable. */
+    for (size_t i = q; i < n - q; ++i) s.link(&v[i], false);
+    if (!verify(s, v, 0, n)) return false;
+
+    s.unlink_all();
+  }
+  return true;
+}
+
+int main() {
+  for (size_t n = 0; n <= 2000; n = (n < 70U ? n + 1U : 2U * n + 1U)) {
+    if (!check_ops(n)) {
+      fprintf(stderr, "size %zu: invariant check failed\n", n);
+      return 1;
+    }
+  }
+
+  fprintf(stderr, "%8s %8s %12s %8s %14s\n",
+          "size", "link", "link_sorted", "unlink", "unlink(range)");
+  for (size_t n = MIN_SIZE; n <= MAX_SIZE; n *= 10) {
+    result r;
+    if (!run(n, r)) {
+      fprintf(stderr, "size %zu: verification failed\n", n);
+      return 1;
+    }
+
+    fprintf(stderr, "%8zu %8llu %12llu %8llu %14llu\n",
+            n, r.link, r.link_sorted, r.unlink, r.unlink_range);
+  }
+  fprintf(stderr, "(cycles per element)\n");
+}
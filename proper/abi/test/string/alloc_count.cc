@@ -0,0 +1,83 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <locale>
+#include <new>
+#include <string>
+#include <ilias/stats.h>
+
+using _namespace(std)::size_t;
+
+/*
+ * Benchmark: heap allocations performed by string-heavy code paths.
+ *
+ * Plain operator new and operator delete are replaced, to count the
+ * number of allocations performed.  Each path is run REPS times and
+ * the average number of allocations per iteration is printed.
+ */
+constexpr unsigned int REPS = 1000;
+
+size_t allocs = 0;
+
+void* operator new(size_t sz) {
+  ++allocs;
+  void* p = ::test_std::malloc(sz == 0 ? 1 : sz);
+  if (p == nullptr) throw ::test_std::bad_alloc();
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  ::test_std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  ::test_std::free(p);
+}
+
+template<typename Fn>
+void run(const char* name, Fn fn) {
+  fn();  // Warm up lazily initialized state.
+
+  const size_t start = allocs;
+  for (unsigned int i = 0; i < REPS; ++i) fn();
+  const size_t n = allocs - start;
+
+  fprintf(stderr, "%-32s %4zu.%03zu allocations per iteration\n",
+          name, n / REPS, (n % REPS) * 1000U / REPS);
+}
+
+int main() {
+  using ::test_std::string;
+  using ::test_std::locale;
+  using ::test_std::numpunct;
+  using ::test_std::use_facet;
+
+  const char text[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+  for (size_t len = 0; len <= 32; len += 8) {
+    char name[32];
+    snprintf(name, sizeof(name), "string(%zu chars)", len);
+    run(name, [&]() { string s(text, len); });
+  }
+  run("string append 1 char x 64", []() {
+        string s;
+        for (int i = 0; i < 64; ++i) s += 'x';
+      });
+
+  run("locale::name()", []() { locale().name(); });
+  run("numpunct<char>::truename()", []() {
+        use_facet<numpunct<char>>(locale()).truename();
+      });
+  run("numpunct<char>::grouping()", []() {
+        use_facet<numpunct<char>>(locale()).grouping();
+      });
+
+  run("strerror x 32", []() {
+        for (int e = 0; e < 32; ++e) ::test_std::strerror(e);
+      });
+
+  _namespace(ilias)::stats_group root{ "alloc_count" };
+  _namespace(ilias)::stats_group group{ root, "string" };
+  _namespace(ilias)::stats_counter counter{ group, "counter" };
+  run("stats_leaf::path()", [&counter]() { counter.path(); });
+}
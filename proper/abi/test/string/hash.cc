@@ -0,0 +1,100 @@
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+using _namespace(std)::size_t;
+
+/*
+ * Test: correctness of the string hashes.
+ *
+ * For every key length up to MAX_LEN (which covers each code path of
+ * the hash: short keys, 16 byte keys and multiple 48 byte rounds),
+ * equal strings must hash equal, regardless of their alignment and of
+ * whether they are hashed as basic_string or as basic_string_ref.
+ * Changing any character, in either its low or its high byte, or
+ * dropping the last character, must change the hash.
+ *
+ * This is checked for char, char16_t, char32_t and wchar_t strings.
+ */
+constexpr size_t MAX_LEN = 200;
+constexpr size_t MAX_ALIGN = 16;
+
+template<typename Char>
+bool test(const char* name) {
+  using string = _namespace(std)::basic_string<Char>;
+  using string_ref = _namespace(std)::basic_string_ref<Char>;
+  const _namespace(std)::hash<string> h_str;
+  const _namespace(std)::hash<string_ref> h_ref;
+
+  alignas(MAX_ALIGN) Char buf[MAX_LEN + MAX_ALIGN];
+
+  for (size_t len = 0; len <= MAX_LEN; ++len) {
+    string key;
+    for (size_t i = 0; i < len; ++i)
+      key.push_back(Char((i * 37U + len) % 127U + 1U));
+
+    const size_t expect = h_str(key);
+    if (h_str(key) != expect || h_str(string(key)) != expect) {
+      fprintf(stderr, "%s: hash of length %zu is not stable\n", name, len);
+      return false;
+    }
+    if (h_ref(string_ref(key)) != expect) {
+      fprintf(stderr, "%s: string and string_ref hash differ "
+              "at length %zu\n", name, len);
+      return false;
+    }
+
+    /* Equal contents at any alignment hash equal. */
+    for (size_t off = 0; off < MAX_ALIGN; ++off) {
+      key.copy(buf + off, len);
+      if (h_ref(string_ref(buf + off, len)) != expect) {
+        fprintf(stderr, "%s: hash of length %zu differs at offset %zu\n",
+                name, len, off);
+        return false;
+      }
+    }
+
+    /* Changing a character changes the hash. */
+    for (size_t i = 0; i < len; ++i) {
+      const Char saved = key[i];
+      key[i] = Char(saved ^ 0x01U);
+      const size_t low = h_str(key);
+      key[i] = (sizeof(Char) > 1U ? Char(saved ^ 0x0100U) : saved);
+      const size_t high = h_str(key);
+      key[i] = saved;
+
+      if (low == expect || (sizeof(Char) > 1U && high == expect)) {
+        fprintf(stderr, "%s: changing char %zu of %zu keeps the hash\n",
+                name, i, len);
+        return false;
+      }
+    }
+
+    /* A key and its prefix hash differently. */
+    if (len > 0U &&
+        h_ref(string_ref(key.data(), len - 1U)) == expect) {
+      fprintf(stderr, "%s: length %zu and its prefix hash equal\n",
+              name, len);
+      return false;
+    }
+  }
+
+  /* Trailing nul characters are part of the key. */
+  const Char nuls[2] = { Char(0), Char(0) };
+  if (h_ref(string_ref(nuls, 1)) == h_ref(string_ref(nuls, 2)) ||
+      h_ref(string_ref(nuls, 0)) == h_ref(string_ref(nuls, 1))) {
+    fprintf(stderr, "%s: keys of nul characters collide\n", name);
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  fprintf(stderr, "Testing string hashes...");
+  if (!test<char>("string") ||
+      !test<char16_t>("u16string") ||
+      !test<char32_t>("u32string") ||
+      !test<wchar_t>("wstring"))
+    return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+}
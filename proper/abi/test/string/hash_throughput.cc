@@ -0,0 +1,94 @@
+#include <string>
+#include <cstdio>
+#include <cstdint>
+
+using _namespace(std)::size_t;
+using _namespace(std)::uint8_t;
+
+/*
+ * Benchmark: throughput of hash<string_ref> and hash<u16string_ref>.
+ *
+ * Each key length is hashed at every misalignment modulo MAX_ALIGN.
+ * Before timing, the hash of a string is checked against the hash of
+ * a string_ref to the same characters, and flipping any single bit of
+ * the key must change the hash.
+ */
+constexpr size_t LENGTHS[] = {
+  0, 1, 3, 4, 7, 8, 15, 16, 17, 24, 32, 33, 48, 49, 64, 100,
+  128, 256, 1024, 4096, 65536
+};
+constexpr size_t MAX_LEN = 65536;
+constexpr size_t MAX_ALIGN = 16;
+constexpr size_t BYTES_PER_RUN = 1 << 20;  // Bytes hashed per alignment.
+
+alignas(MAX_ALIGN) char src[MAX_LEN + MAX_ALIGN];
+alignas(MAX_ALIGN) char16_t src16[MAX_LEN + MAX_ALIGN];
+
+inline unsigned long long cycles() noexcept {
+  return __builtin_ia32_rdtsc();
+}
+
+bool verify(size_t len) noexcept {
+  using _namespace(std)::string;
+  using _namespace(std)::string_ref;
+  const _namespace(std)::hash<string_ref> h;
+
+  if (_namespace(std)::hash<string>()(string(src, len)) !=
+      h(string_ref(src, len)))
+    return false;
+
+  const size_t ref = h(string_ref(src, len));
+  for (size_t bit = 0; bit < len * 8U && bit < 512U; ++bit) {
+    src[bit / 8U] ^= char(1U << (bit % 8U));
+    const size_t flipped = h(string_ref(src, len));
+    src[bit / 8U] ^= char(1U << (bit % 8U));
+    if (flipped == ref) return false;
+  }
+  return true;
+}
+
+/*
+ * Hash keys of length len, at all alignments.
+ * Returns cycles per 1000 hashes.
+ */
+template<typename Char>
+unsigned long long run(const Char* s, size_t len) noexcept {
+  using ref = _namespace(std)::basic_string_ref<Char>;
+  const _namespace(std)::hash<ref> h;
+  const size_t sz = len * sizeof(Char);
+  const size_t reps = (sz >= BYTES_PER_RUN / 16U ?
+                       16U :
+                       BYTES_PER_RUN / (sz + 1U));
+  unsigned long long t = 0;
+  size_t acc = 0;
+
+  for (size_t off = 0; off < MAX_ALIGN; ++off) {
+    const unsigned long long t0 = cycles();
+    for (size_t i = 0; i < reps; ++i) acc += h(ref(s + off, len));
+    t += cycles() - t0;
+  }
+  __asm__ __volatile__("" : : "r"(acc));  // Keep the hashes alive.
+  return t * 1000U / (reps * MAX_ALIGN);
+}
+
+int main() {
+  for (size_t i = 0; i < sizeof(src); ++i) src[i] = char(i * 7U + 1U);
+  for (size_t i = 0; i < MAX_LEN + MAX_ALIGN; ++i)
+    src16[i] = char16_t(i * 7U + 1U);
+
+  for (size_t len : LENGTHS) {
+    if (!verify(len)) {
+      fprintf(stderr, "length %zu: verification failed\n", len);
+      return 1;
+    }
+
+    const unsigned long long c8 = run(src, len);
+    const unsigned long long c16 = run(src16, len);
+    fprintf(stderr, "%6zu chars: string %10llu, u16string %10llu "
+                    "cycles per 1000 hashes "
+                    "(%llu, %llu bytes per 1000 cycles)\n",
+            len, c8, c16,
+            len * 1000000ULL / (c8 == 0 ? 1U : c8),
+            2U * len * 1000000ULL / (c16 == 0 ? 1U : c16));
+  }
+}
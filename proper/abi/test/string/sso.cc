@@ -0,0 +1,259 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+using _namespace(std)::size_t;
+
+/*
+ * Test: basic_string immediate (small string) storage.
+ *
+ * Strings of up to IMMED_CAP chars are stored inside the string object;
+ * longer strings use an allocated buffer.  The checks cover the sizes
+ * around that boundary, swapping between the two modes, shrink_to_fit
+ * switching back to immediate storage, empty() and reserve().
+ *
+ * The allocator records every live allocation, so deallocating with a
+ * length other than the allocated one is detected.
+ */
+constexpr size_t IMMED_CAP = 3U * sizeof(void*) - 1U;
+
+struct live_alloc {
+  void* p;
+  size_t n;
+};
+
+live_alloc live[16];
+bool alloc_error = false;
+
+template<typename T>
+struct checked_alloc {
+  using value_type = T;
+
+  checked_alloc() = default;
+  template<typename U> checked_alloc(const checked_alloc<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    T* p = static_cast<T*>(::test_std::malloc(n * sizeof(T)));
+    if (p == nullptr) throw ::test_std::bad_alloc();
+    for (live_alloc& a : live) {
+      if (a.p == nullptr) {
+        a = live_alloc{ p, n };
+        return p;
+      }
+    }
+    ::test_std::free(p);
+    fprintf(stderr, "too many live allocations\n");
+    throw ::test_std::bad_alloc();
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    for (live_alloc& a : live) {
+      if (a.p == p) {
+        if (a.n != n) {
+          fprintf(stderr, "deallocate(%p, %zu), allocated with length %zu\n",
+                  static_cast<void*>(p), n, a.n);
+          alloc_error = true;
+        }
+        a.p = nullptr;
+        ::test_std::free(p);
+        return;
+      }
+    }
+    fprintf(stderr, "deallocate(%p, %zu) of unknown pointer\n",
+            static_cast<void*>(p), n);
+    alloc_error = true;
+  }
+};
+
+template<typename T, typename U>
+bool operator==(const checked_alloc<T>&, const checked_alloc<U>&) noexcept {
+  return true;
+}
+
+template<typename T, typename U>
+bool operator!=(const checked_alloc<T>&, const checked_alloc<U>&) noexcept {
+  return false;
+}
+
+using string = ::test_std::basic_string<char, ::test_std::char_traits<char>,
+                                        checked_alloc<char>>;
+
+const char text[] = "0123456789abcdefghijklmnopqrstuvwxyz"
+                    "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+bool is_immediate(const string& s) noexcept {
+  const char* d = s.data();
+  return d >= reinterpret_cast<const char*>(&s) &&
+         d < reinterpret_cast<const char*>(&s + 1);
+}
+
+size_t n_live() noexcept {
+  size_t n = 0;
+  for (const live_alloc& a : live)
+    if (a.p != nullptr) ++n;
+  return n;
+}
+
+/* Verify s holds the first len chars of text. */
+bool check(const char* what, const string& s, size_t len) {
+  if (s.size() != len || s.length() != len) {
+    fprintf(stderr, "%s: size %zu, expected %zu\n", what, s.size(), len);
+    return false;
+  }
+  if (s.empty() != (len == 0U)) {
+    fprintf(stderr, "%s: empty() is %d for size %zu\n",
+            what, int(s.empty()), len);
+    return false;
+  }
+  if (s.capacity() < len) {
+    fprintf(stderr, "%s: capacity %zu below size %zu\n",
+            what, s.capacity(), len);
+    return false;
+  }
+  if (::test_std::memcmp(s.data(), text, len) != 0 ||
+      s.c_str()[len] != '\0') {
+    fprintf(stderr, "%s: contents differ (size %zu)\n", what, len);
+    return false;
+  }
+  if (alloc_error) {
+    fprintf(stderr, "%s: allocator misuse (size %zu)\n", what, len);
+    return false;
+  }
+  return true;
+}
+
+bool test_sizes() {
+  for (size_t len = 0; len <= IMMED_CAP + 8U; ++len) {
+    string s(text, len);
+    if (!check("construct", s, len)) return false;
+    if (is_immediate(s) != (len <= IMMED_CAP)) {
+      fprintf(stderr, "string of %zu chars is %s\n",
+              len, (is_immediate(s) ? "immediate" : "external"));
+      return false;
+    }
+    if (is_immediate(s) && s.capacity() != IMMED_CAP) {
+      fprintf(stderr, "immediate capacity %zu, expected %zu\n",
+              s.capacity(), IMMED_CAP);
+      return false;
+    }
+  }
+
+  /* Grow one char at a time across the boundary. */
+  string s;
+  for (size_t len = 0; len <= 2U * IMMED_CAP; ++len) {
+    if (!check("push_back", s, len)) return false;
+    s.push_back(text[len]);
+  }
+  return true;
+}
+
+bool test_swap() {
+  const size_t sizes[] = {
+    0, 1, IMMED_CAP - 1U, IMMED_CAP, IMMED_CAP + 1U, 2U * IMMED_CAP
+  };
+
+  for (size_t x : sizes) {
+    for (size_t y : sizes) {
+      string a(text, x), b(text, y);
+      a.swap(b);
+      if (!check("swap", a, y) || !check("swap", b, x)) return false;
+      if (is_immediate(a) != (y <= IMMED_CAP) ||
+          is_immediate(b) != (x <= IMMED_CAP)) {
+        fprintf(stderr, "swap(%zu, %zu): storage mode not swapped\n", x, y);
+        return false;
+      }
+
+      swap(a, b);
+      if (!check("swap back", a, x) || !check("swap back", b, y))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool test_shrink_to_fit() {
+  const size_t sizes[] = { 0, 1, IMMED_CAP - 1U, IMMED_CAP, IMMED_CAP + 1U };
+
+  for (size_t len : sizes) {
+    string s(text, 2U * IMMED_CAP + 8U);
+    s.resize(len);
+    s.shrink_to_fit();
+    if (!check("shrink_to_fit", s, len)) return false;
+
+    if (len <= IMMED_CAP) {
+      if (!is_immediate(s) || n_live() != 0U) {
+        fprintf(stderr, "shrink_to_fit to %zu chars kept its buffer\n", len);
+        return false;
+      }
+      if (s.capacity() != IMMED_CAP) {
+        fprintf(stderr, "shrink_to_fit to %zu chars: capacity %zu\n",
+                len, s.capacity());
+        return false;
+      }
+    } else if (s.capacity() != len) {
+      fprintf(stderr, "shrink_to_fit to %zu chars: capacity %zu\n",
+              len, s.capacity());
+      return false;
+    }
+
+    /* The string must remain usable in its new storage mode. */
+    s.append(text + len, IMMED_CAP + 1U);
+    if (!check("append after shrink_to_fit", s, len + IMMED_CAP + 1U))
+      return false;
+  }
+  return true;
+}
+
+bool test_reserve() {
+  string s(text, 5);
+  s.reserve(IMMED_CAP);
+  if (!is_immediate(s) || !check("reserve within immediate", s, 5))
+    return false;
+
+  s.reserve(IMMED_CAP + 1U);
+  if (is_immediate(s) || s.capacity() < IMMED_CAP + 1U ||
+      !check("reserve to external", s, 5))
+    return false;
+
+  /* Each reallocation must free the old buffer with its length. */
+  for (size_t i = 0; i < 8; ++i) {
+    const size_t cap = s.capacity();
+    s.reserve(cap + 1U);
+    if (s.capacity() < 2U * (cap + 1U) - 1U) {
+      fprintf(stderr, "reserve(%zu) grew capacity to %zu only\n",
+              cap + 1U, s.capacity());
+      return false;
+    }
+    if (n_live() != 1U || !check("reserve", s, 5)) return false;
+  }
+
+  s.clear();
+  if (!s.empty() || !check("clear", s, 0)) return false;
+  return true;
+}
+
+int main() {
+  fprintf(stderr, "Testing sizes around %zu chars...", IMMED_CAP);
+  if (!test_sizes()) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  fprintf(stderr, "Testing swap...");
+  if (!test_swap()) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  fprintf(stderr, "Testing shrink_to_fit...");
+  if (!test_shrink_to_fit()) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  fprintf(stderr, "Testing reserve...");
+  if (!test_reserve()) return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+
+  if (n_live() != 0U) {
+    fprintf(stderr, "%zu allocations leaked\n", n_live());
+    return 1;
+  }
+}
@@ -1,7 +1,10 @@
 #ifndef _ILIAS_ARCH_CPUID_H_
 #define _ILIAS_ARCH_CPUID_H_
 
+#include <cdecl.h>
+
 #include <cassert>
+#include <cstdint>
 #include <initializer_list>
 #include <string>
 #include <tuple>
@@ -17,14 +20,39 @@ constexpr bool has_cpuid() noexcept { return false; }
 
 #if defined(__i386__) || defined(__amd64__) || defined(__x86_64__)
 inline auto __attribute__((const)) cpuid(uint32_t function) noexcept ->
-    std::tuple<uint32_t, uint32_t, uint32_t, uint32_t> {
+    _namespace(std)::tuple<uint32_t, uint32_t, uint32_t, uint32_t> {
   assert(has_cpuid());
 
   uint32_t a, b, c, d;
   asm ("cpuid"
   : "=a"(a), "=b"(b), "=c"(c), "=d"(d)
   : "a"(function), "b"(0), "c"(0), "d"(0));
-  return std::make_tuple(a, b, c, d);
+  return _namespace(std)::make_tuple(a, b, c, d);
+}
+
+/* Invoke a cpuid function that takes a sub-leaf in ecx. */
+inline auto __attribute__((const)) cpuid(uint32_t function,
+                                         uint32_t subleaf) noexcept ->
+    _namespace(std)::tuple<uint32_t, uint32_t, uint32_t, uint32_t> {
+  assert(has_cpuid());
+
+  uint32_t a, b, c, d;
+  asm ("cpuid"
+  : "=a"(a), "=b"(b), "=c"(c), "=d"(d)
+  : "a"(function), "b"(0), "c"(subleaf), "d"(0));
+  return _namespace(std)::make_tuple(a, b, c, d);
+}
+
+/*
+ * Read an extended control register.
+ * Only valid if the OSXSAVE feature is present.
+ */
+inline auto xgetbv(uint32_t xcr) noexcept -> uint64_t {
+  uint32_t lo, hi;
+  asm volatile ("xgetbv"
+  : "=a"(lo), "=d"(hi)
+  : "c"(xcr));
+  return (uint64_t(hi) << 32) | lo;
 }
 #endif
 
@@ -32,14 +60,14 @@ inline auto __attribute__((const)) cpuid(uint32_t function) noexcept ->
  * Returns the cpu vendor from the cpu.
  * If cpuid is not supported, returns an empty string.
  */
-std::string cpu_vendor();
+_namespace(std)::string cpu_vendor();
 
 /*
  * Find the highest supported cpuid function.
  * Returns 0 if cpuid is not supported.
  */
 inline auto __attribute__((const)) cpuid_max_fn() noexcept -> uint32_t {
-  return (has_cpuid() ? std::get<0>(cpuid(0)) : 0);
+  return (has_cpuid() ? _namespace(std)::get<0>(cpuid(0)) : 0);
 }
 
 /*
@@ -47,34 +75,43 @@ inline auto __attribute__((const)) cpuid_max_fn() noexcept -> uint32_t {
  * Returns 0 if cpuid is not supported.
  */
 inline auto __attribute__((const)) cpuid_max_ext_fn() noexcept -> uint32_t {
-  return (has_cpuid() ? std::get<0>(cpuid(0x80000000)) : 0);
+  return (has_cpuid() ? _namespace(std)::get<0>(cpuid(0x80000000)) : 0);
 }
 
+/*
+ * Number of logical CPUs in the package we're running on.
+ * Returns 1 if cpuid doesn't describe the topology.
+ */
+unsigned int cpu_count() noexcept __attribute__((const));
+
 /* Tag, used on tuples to identify as cpuid feature tests. */
 struct cpuid_feature_tag {};
 using cpuid_feature_result =
-    std::tuple<uint32_t, uint32_t, uint32_t, uint32_t,
-               cpuid_feature_tag>;
+    _namespace(std)::tuple<uint32_t, uint32_t, uint32_t, uint32_t,
+                           cpuid_feature_tag>;
 
 inline auto __attribute__((pure)) cpuid_features() noexcept ->
     cpuid_feature_result {
   if (_predict_false(cpuid_max_fn() <= 1))
-    return std::make_tuple(0U, 0U, 0U, 0U, cpuid_feature_tag());
-  return std::tuple_cat(cpuid(1), std::make_tuple(cpuid_feature_tag()));
+    return _namespace(std)::make_tuple(0U, 0U, 0U, 0U, cpuid_feature_tag());
+  return _namespace(std)::tuple_cat(
+      cpuid(1), _namespace(std)::make_tuple(cpuid_feature_tag()));
 }
 
 /* Tag, used on tuples to identify as cpuid extended feature tests. */
 struct cpuid_extfeature_tag {};
 using cpuid_extfeature_result =
-    std::tuple<uint32_t, uint32_t, uint32_t, uint32_t,
-               cpuid_extfeature_tag>;
+    _namespace(std)::tuple<uint32_t, uint32_t, uint32_t, uint32_t,
+                           cpuid_extfeature_tag>;
 
 inline auto __attribute__((pure)) cpuid_extfeatures() noexcept ->
     cpuid_extfeature_result {
   if (_predict_false(cpuid_max_ext_fn() <= 0x80000001U))
-    return std::make_tuple(0U, 0U, 0U, 0U, cpuid_extfeature_tag());
-  return std::tuple_cat(cpuid(0x80000001),
-                        std::make_tuple(cpuid_extfeature_tag()));
+    return _namespace(std)::make_tuple(0U, 0U, 0U, 0U,
+                                       cpuid_extfeature_tag());
+  return _namespace(std)::tuple_cat(
+      cpuid(0x80000001),
+      _namespace(std)::make_tuple(cpuid_extfeature_tag()));
 }
 
 /*
@@ -82,58 +119,60 @@ inline auto __attribute__((pure)) cpuid_extfeatures() noexcept ->
  * - get<field>(cpuid(...)) & mask
  *   implies the feature is present.
  */
-using cpuid_feature = std::tuple<uint32_t, int, cpuid_feature_tag>;
-using cpuid_extfeature = std::tuple<uint32_t, int, cpuid_extfeature_tag>;
+using cpuid_feature =
+    _namespace(std)::tuple<uint32_t, int, cpuid_feature_tag>;
+using cpuid_extfeature =
+    _namespace(std)::tuple<uint32_t, int, cpuid_extfeature_tag>;
 
 inline bool cpuid_feature_present(cpuid_feature f,
                                   cpuid_feature_result r = cpuid_features()) {
   uint32_t flags;
-  switch (std::get<1>(f)) {
+  switch (_namespace(std)::get<1>(f)) {
   default:
     assert_msg(false, "cpuid feature test invalid");
   case 0:
-    flags = std::get<0>(r);
+    flags = _namespace(std)::get<0>(r);
     break;
   case 1:
-    flags = std::get<1>(r);
+    flags = _namespace(std)::get<1>(r);
     break;
   case 2:
-    flags = std::get<2>(r);
+    flags = _namespace(std)::get<2>(r);
     break;
   case 3:
-    flags = std::get<3>(r);
+    flags = _namespace(std)::get<3>(r);
     break;
   }
 
-  return (flags & std::get<0>(f)) != 0;
+  return (flags & _namespace(std)::get<0>(f)) != 0;
 }
 
 inline bool cpuid_feature_present(
     cpuid_extfeature f, cpuid_extfeature_result r = cpuid_extfeatures()) {
   uint32_t flags;
-  switch (std::get<1>(f)) {
+  switch (_namespace(std)::get<1>(f)) {
   default:
     assert_msg(false, "cpuid extfeature test invalid");
   case 0:
-    flags = std::get<0>(r);
+    flags = _namespace(std)::get<0>(r);
     break;
   case 1:
-    flags = std::get<1>(r);
+    flags = _namespace(std)::get<1>(r);
     break;
   case 2:
-    flags = std::get<2>(r);
+    flags = _namespace(std)::get<2>(r);
     break;
   case 3:
-    flags = std::get<3>(r);
+    flags = _namespace(std)::get<3>(r);
     break;
   }
 
-  return (flags & std::get<0>(f)) != 0;
+  return (flags & _namespace(std)::get<0>(f)) != 0;
 }
 
 /* Generate a comma-separated list of features in argument. */
-std::string to_string(cpuid_feature_result);
-std::string to_string(cpuid_extfeature_result);
+_namespace(std)::string to_string(cpuid_feature_result);
+_namespace(std)::string to_string(cpuid_extfeature_result);
 
 /*
  * cpuid feature constants.
@@ -201,7 +240,7 @@ constexpr cpuid_feature tm1      = cpuid_feature(1UL << 29, 3, cpuid_feature_tag
 constexpr cpuid_feature ia64     = cpuid_feature(1UL << 30, 3, cpuid_feature_tag());
 constexpr cpuid_feature pbe      = cpuid_feature(1UL << 31, 3, cpuid_feature_tag());
 
-constexpr std::initializer_list<std::pair<cpuid_feature, const char*>>
+constexpr _namespace(std)::initializer_list<_namespace(std)::pair<cpuid_feature, const char*>>
     all_features = {
   { sse3     , "SSE3"    },
   { pclmul   , "PCLMUL"  },
@@ -316,7 +355,7 @@ constexpr cpuid_extfeature lm             = cpuid_extfeature(1 << 29, 3, cpuid_e
 constexpr cpuid_extfeature _3dnowext      = cpuid_extfeature(1 << 30, 3, cpuid_extfeature_tag());
 constexpr cpuid_extfeature _3dnow         = cpuid_extfeature(1 << 31, 3, cpuid_extfeature_tag());
 
-constexpr std::initializer_list<std::pair<cpuid_extfeature, const char*>>
+constexpr _namespace(std)::initializer_list<_namespace(std)::pair<cpuid_extfeature, const char*>>
     all_extfeatures = {
   { lahfsahf        , "LAHF/SAHF"      },
   { cmplegacy       , "CmpLegacy"      },
@@ -31,12 +31,12 @@ bool __attribute__((const)) has_cpuid() noexcept {
 #endif
 
 #if defined(__i386__) || defined(__amd64__) || defined(__x86_64__)
-std::string cpu_vendor() {
-  std::string out;
+_namespace(std)::string cpu_vendor() {
+  _namespace(std)::string out;
   if (!has_cpuid()) return out;
 
   unsigned long b, c, d;
-  std::tie(std::ignore, b, c, d) = cpuid(0);
+  _namespace(std)::tie(_namespace(std)::ignore, b, c, d) = cpuid(0);
   out.resize(12);
 
   auto writer = out.begin();
@@ -55,33 +55,62 @@ std::string cpu_vendor() {
   return out;
 }
 #else
-std::string cpu_vendor() { return ""; }
+_namespace(std)::string cpu_vendor() { return ""; }
 #endif
 
-std::string to_string(cpuid_feature_result features) {
-  std::ostringstream out;
+#if defined(__i386__) || defined(__amd64__) || defined(__x86_64__)
+unsigned int __attribute__((const)) cpu_count() noexcept {
+  /*
+   * Extended topology: walk the levels until the core level,
+   * which holds the number of logical CPUs in the package.
+   */
+  if (cpuid_max_fn() >= 0xbU) {
+    for (uint32_t level = 0; level < 8U; ++level) {
+      uint32_t b, c;
+      _namespace(std)::tie(_namespace(std)::ignore, b, c,
+                           _namespace(std)::ignore) = cpuid(0xb, level);
+      const uint32_t type = (c >> 8) & 0xffU;
+      if (type == 0U) break;  // No more levels.
+      if (type == 2U && (b & 0xffffU) != 0U) return b & 0xffffU;
+    }
+  }
+
+  /* Legacy: logical CPU count is only valid if HTT is set. */
+  const auto features = cpuid_features();
+  if (cpuid_feature_present(cpuid_feature_const::htt, features)) {
+    const unsigned int n = (_namespace(std)::get<1>(features) >> 16) & 0xffU;
+    if (n != 0U) return n;
+  }
+  return 1;
+}
+#else
+unsigned int cpu_count() noexcept { return 1; }
+#endif
+
+_namespace(std)::string to_string(cpuid_feature_result features) {
+  _namespace(std)::ostringstream out;
 
   bool first = true;
   for (const auto& f : cpuid_feature_const::all_features) {
-    if (cpuid_feature_present(std::get<0>(f), features)) {
-      if (!std::exchange(first, false))
+    if (cpuid_feature_present(_namespace(std)::get<0>(f), features)) {
+      if (!_namespace(std)::exchange(first, false))
         out << ", ";
-      out << std::get<1>(f);
+      out << _namespace(std)::get<1>(f);
     }
   }
 
   return out.str();
 }
 
-std::string to_string(cpuid_extfeature_result features) {
-  std::ostringstream out;
+_namespace(std)::string to_string(cpuid_extfeature_result features) {
+  _namespace(std)::ostringstream out;
 
   bool first = true;
   for (const auto& f : cpuid_extfeature_const::all_extfeatures) {
-    if (cpuid_feature_present(std::get<0>(f), features)) {
-      if (!std::exchange(first, false))
+    if (cpuid_feature_present(_namespace(std)::get<0>(f), features)) {
+      if (!_namespace(std)::exchange(first, false))
         out << ", ";
-      out << std::get<1>(f);
+      out << _namespace(std)::get<1>(f);
     }
   }
 
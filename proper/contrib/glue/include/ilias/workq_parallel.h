@@ -0,0 +1,100 @@
+#ifndef ILIAS_WORKQ_PARALLEL_H
+#define ILIAS_WORKQ_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <thread>
+#include <stdimpl/parallel.h>
+#include <ilias/future.h>
+#include <ilias/workq.h>
+
+namespace ilias {
+
+
+/*
+ * Backend for parallel algorithms, running chunks on a workq.
+ *
+ * Install using std::impl::set_parallel_backend().
+ *
+ * The calling thread processes chunks as well, so run() completes
+ * even if none of the helper jobs get to run.
+ */
+class workq_parallel_backend
+: public std::impl::parallel_backend
+{
+ private:
+  struct state {
+    state(size_t n, job_fn fn, void* arg) noexcept
+    : n(n),
+      fn(fn),
+      arg(arg)
+    {}
+
+    /* Claim and run chunks, until none are left. */
+    void work() noexcept {
+      for (size_t i = next.fetch_add(1U, std::memory_order_relaxed);
+           i < n;
+           i = next.fetch_add(1U, std::memory_order_relaxed)) {
+        fn(arg, i);
+        done.fetch_add(1U, std::memory_order_release);
+      }
+    }
+
+    const size_t n;
+    const job_fn fn;
+    void*const arg;
+    std::atomic<size_t> next{ 0U };
+    std::atomic<size_t> done{ 0U };
+  };
+
+ public:
+  workq_parallel_backend(workq_service& wqs, unsigned int concurrency)
+  : wq_(wqs.new_workq()),
+    concurrency_(concurrency)
+  {}
+
+  auto concurrency() const noexcept -> unsigned int override {
+    return concurrency_;
+  }
+
+  void run(size_t, job_fn, void*) noexcept override;
+
+ private:
+  workq_ptr wq_;
+  const unsigned int concurrency_;
+};
+
+
+inline void workq_parallel_backend::run(size_t n, job_fn fn, void* arg)
+    noexcept {
+  std::shared_ptr<state> st;
+  try {
+    st = std::make_shared<state>(n, fn, arg);
+  } catch (const std::bad_alloc&) {
+    for (size_t i = 0; i < n; ++i) fn(arg, i);
+    return;
+  }
+
+  /* Helper jobs hold on to st, since they may run after we return. */
+  const size_t helpers = std::min(size_t(concurrency_), n) - 1U;
+  for (size_t h = 0; h < helpers; ++h) {
+    try {
+      async(wq_,
+            [](std::shared_ptr<state> st) { st->work(); },
+            st);
+    } catch (const std::bad_alloc&) {
+      break;
+    }
+  }
+
+  st->work();
+  while (st->done.load(std::memory_order_acquire) != n)
+    std::this_thread::yield();
+}
+
+
+} /* namespace ilias */
+
+#endif /* ILIAS_WORKQ_PARALLEL_H */
@@ -20,6 +20,7 @@ namespace tags {
 struct page_cache {};
 struct page_list {};
 struct page_alloc {};
+struct page_alloc_index {};
 
 } /* namespace ilias::vm::tags */
 
@@ -54,12 +55,14 @@ class page_busy_lock {
 class page
 : public linked_list_element<tags::page_list>,
   public ll_list_hook<tags::page_cache>,
-  public linked_set_element<page, tags::page_alloc>,
+  public linked_list_element<tags::page_alloc>,
+  public linked_set_element<page, tags::page_alloc_index>,
   public refcount_base<page>,
   public pmap_page
 {
   friend page_list;
   friend page_alloc;
+  friend default_page_alloc;
 
  public:
   using release_functor = function<page_ptr(page_ptr, bool)>;  // XXX return promise, bool argument = delayed-ok
@@ -108,11 +111,15 @@ class page
 
   void set_page_owner(page_owner&, page_owner::offset_type = 0) noexcept;
   void clear_page_owner() noexcept;
+  tuple<page_owner*, page_owner::offset_type> get_page_owner() const noexcept;
 
   page_count<native_arch> nfree_;  // Number of free pages starting at this
                                    // page (only has meaning if the page is
                                    // actually free).
                                    // Public, so allocators can mess with it.
+                                   // default_page_alloc keeps it zero,
+                                   // except on the first page of a free
+                                   // buddy block.
 
   /*
    * Protects:
@@ -125,6 +132,9 @@ class page
   page_count<native_arch> npgl_;  // Number of pages starting at this page
                                   // (only has meaning if the page is on a
                                   // page_list).
+  uint8_t index_align_ = 0;  // Largest log2 alignment of the free blocks
+                             // in this subtree of the default_page_alloc
+                             // index.
 
   mutable atomic<size_t> refcnt_{ 0 };
 
@@ -3,9 +3,15 @@
 
 #include <ilias/vm/page.h>
 #include <ilias/vm/page_cache.h>
+#include <ilias/pmap/pmap.h>
+#include <array>
+#include <atomic>
 #include <type_traits>
 #include <mutex>
+#include <vector>
+#include <ilias/linked_list.h>
 #include <ilias/linked_set.h>
+#include <ilias/stats.h>
 #include <ilias/future.h>
 #include <ilias/workq.h>
 
@@ -25,6 +31,7 @@ class page_alloc
     fail_ok = 0x00,
     fail_ok_nothrow = 0x01,
     fail_not_ok = 0x02,
+    zero = 0x04,  // Pages must be zeroed.
   };
 
   struct spec;
@@ -83,7 +90,8 @@ constexpr page_alloc::alloc_style operator~(const page_alloc::alloc_style& x)
   return static_cast<page_alloc::alloc_style>(~static_cast<int_type>(x)) &
          (page_alloc::alloc_style::fail_ok_nothrow |
           page_alloc::alloc_style::fail_ok |
-          page_alloc::alloc_style::fail_not_ok);
+          page_alloc::alloc_style::fail_not_ok |
+          page_alloc::alloc_style::zero);
 }
 
 constexpr page_alloc::alloc_style alloc_fail_ok =
@@ -92,8 +100,17 @@ constexpr page_alloc::alloc_style alloc_fail_not_ok =
     page_alloc::alloc_style::fail_not_ok;
 constexpr page_alloc::alloc_style alloc_fail_ok_nothrow =
     page_alloc::alloc_style::fail_ok_nothrow;
+constexpr page_alloc::alloc_style alloc_zero =
+    page_alloc::alloc_style::zero;
 
 
+/*
+ * Constraints on a contiguous allocation.
+ *
+ * The first page number of the allocation, modulo align, equals offset.
+ * If boundary is non-zero, the allocation does not cross a multiple of
+ * boundary pages.  align and boundary must be zero or a power of 2.
+ */
 struct page_alloc::spec {
   page_count<native_arch> align = page_count<native_arch>(0);
   page_count<native_arch> offset = page_count<native_arch>(0);
@@ -102,34 +119,132 @@ struct page_alloc::spec {
 };
 
 
+/*
+ * Default page allocator.
+ *
+ * Free pages are kept in a binary buddy allocator: each free block is
+ * 2^order pages, starting at a page number that is a multiple of its
+ * size, and is kept on the free list for its order.  A freed block is
+ * merged with its buddy (the other half of the block twice its size)
+ * for as long as the buddy is free, so coalescing is O(max_order).
+ *
+ * In front of the buddy allocator sits an array of magazines,
+ * each caching a few single pages.  Each thread is assigned one of
+ * the magazines; single page allocations and deallocations operate on
+ * that magazine and only take the allocator lock to refill or drain it
+ * in batches.  A magazine that is in use by another thread is bypassed
+ * instead of waited for.
+ *
+ * Blocks of at least 2^index_min_order pages are additionally kept in
+ * an address ordered index per order, augmented with the largest
+ * alignment of the blocks in each subtree.  Constrained allocations
+ * use it to find the lowest block of a given order that starts at an
+ * aligned page number, in logarithmic time.  They take the smallest
+ * block that fits, and return its unused head and tail to the
+ * freelist, so large blocks are only split if nothing smaller fits.
+ *
+ * An asynchronous allocation that finds too few free pages is parked
+ * on a queue of waiters, and a job is started to reclaim pages from
+ * the page cache.  Parked allocations are completed, in order, as
+ * pages are freed or reclaimed; only the allocation at the front of
+ * the queue collects pages, so multi page allocations can't starve
+ * each other while each holds part of its pages.  Pages handed to the
+ * page cache restart the job while allocations are parked.
+ *
+ * A background job, on its own workq, takes free pages a batch at a
+ * time and zeroes them, using non-temporal stores where available,
+ * into a pool of up to zero_pool_max pages.  Single page allocations
+ * that request zeroed pages are served from this pool, so the zeroing
+ * is not on their path.  Like free pages, zeroed pages are cached in
+ * the magazines, which take them from the pool magazine_zero_max at a
+ * time, so the allocator lock is only taken to refill them.
+ * The job leaves free pages alone while
+ * allocations are parked, and the pool is handed back to the freelist
+ * if allocations run out of free pages.
+ */
 class default_page_alloc
 : public page_alloc
 {
  private:
-  struct ranges_cmp {
+  /* Largest block: 2^max_order pages (1 GiB, using 4 KiB pages). */
+  static constexpr unsigned int max_order = 18;
+  static constexpr unsigned int n_magazines = 16;
+  static constexpr unsigned int magazine_max = 32;
+  static constexpr unsigned int magazine_batch = magazine_max / 2U;
+  static constexpr unsigned int magazine_zero_max = 8;
+  static constexpr unsigned int reclaim_batch = 32;
+  static constexpr unsigned int index_min_order = 4;
+  static constexpr unsigned int zero_pool_max = 256;
+  static constexpr unsigned int zero_batch = 16;
+
+  class reclaim_wqjob;
+  class zero_wqjob;
+
+  using freelist_type = linked_list<page, tags::page_alloc>;
+
+  struct index_cmp {
     bool operator()(const page& x, const page& y) const noexcept {
-      return x.nfree_ < y.nfree_;
+      return x.address() < y.address();
     }
   };
 
-  using ranges_type = linked_set<page, tags::page_alloc, ranges_cmp>;
+  struct index_augment {
+    void operator()(page*) const noexcept;
+  };
+
+  using index_type = linked_set<page, tags::page_alloc_index, index_cmp,
+                                index_augment>;
+
+  /* Range of page structures, with consecutive page numbers. */
+  struct zone {
+    page* base;
+    page_no<native_arch> start;
+    page_count<native_arch> npg;
+  };
+
+  struct magazine {
+    mutex mtx;
+    unsigned int n = 0;
+    unsigned int nzero = 0;
+    array<page*, magazine_max> pages;
+    array<page*, magazine_zero_max> zeroed;  // Taken from zero_pool_.
+  };
+
+  /*
+   * Parked allocation, of a single page (completing prom)
+   * or of npg pages (completing list_prom).
+   */
+  struct waiter
+  : public linked_list_element<>
+  {
+    waiter(alloc_style style, page_count<native_arch> npg, bool multi)
+        noexcept
+    : npg(npg),
+      style(style),
+      multi(multi)
+    {}
+
+    cb_promise<page_ptr> prom;
+    cb_promise<page_list> list_prom;
+    page_list pgs;  // Pages to complete the allocation with.
+    page_count<native_arch> npg;  // Number of pages wanted.
+    alloc_style style;
+    bool multi;
+  };
+
+  using waiter_list = linked_list<waiter>;
 
  public:
-  default_page_alloc(stats_group&, workq_service&) noexcept;
+  default_page_alloc(stats_group&, workq_service&,
+                     pmap_support<native_arch>&) noexcept;
   ~default_page_alloc() noexcept override;
 
-  cb_future<page_ptr> allocate(alloc_style) override;
- private:
-  page_ptr allocate_prom_(alloc_style);
+  void add_range(page*, page_count<native_arch>);
 
- public:
+  cb_future<page_ptr> allocate(alloc_style) override;
   page_ptr allocate_urgent(alloc_style);
 
   cb_future<page_list> allocate(page_count<native_arch>, alloc_style) override;
- private:
-  page_list allocate_prom_(page_count<native_arch>, alloc_style);
-
- public:
   page_list allocate_urgent(page_count<native_arch>, alloc_style);
 
   cb_future<page_list> allocate(page_count<native_arch>, spec) override;
@@ -137,17 +252,78 @@ class default_page_alloc
 
   void deallocate(page*) noexcept override;
 
+  void manage(const page_ptr&, bool) noexcept;
+
  private:
+  static page_count<native_arch> order_npg_(unsigned int) noexcept;
+  static unsigned int align_log2_(const page*) noexcept;
+
+  magazine& magazine_() noexcept;
+  page_ptr fetch_from_magazine_() noexcept;
+  bool store_in_magazine_(page*) noexcept;
+  void drain_magazine_(magazine&, unsigned int) noexcept;
+  void drain_magazines_() noexcept;
+
   page_ptr fetch_from_freelist_() noexcept;
   page_range fetch_from_freelist_(page_count<native_arch>) noexcept;
+  void fill_from_freelist_(page_list&, page_count<native_arch>) noexcept;
   void add_to_freelist_(page*, page_count<native_arch>) noexcept;
+  void mark_free_(page*, page_count<native_arch>) noexcept;
+
+  const zone& zone_of_(const page*) const noexcept;
+  page* buddy_(const zone&, page*, unsigned int) const noexcept;
+  void link_block_(page*, unsigned int) noexcept;
+  void unlink_block_(page*, unsigned int) noexcept;
+  page* alloc_block_(unsigned int) noexcept;
+  void free_block_(const zone&, page*, unsigned int) noexcept;
+  void free_range_(page*, page_count<native_arch>) noexcept;
+
+  page* find_aligned_(unsigned int, unsigned int) const noexcept;
+  page_range fetch_constrained_(page_count<native_arch>, const spec&)
+      noexcept;
+
+  page_ptr fetch_zeroed_() noexcept;
+  void release_zero_pool_() noexcept;
+  void fill_zero_pool_() noexcept;
+  void zero_page_(const page&);
+  void zero_pages_(const page_list&);
+  static uint64_t stat_zero_pool_(const void*) noexcept;
+
+  waiter_list take_ready_waiters_() noexcept;
+  void complete_(waiter_list) noexcept;
+  void wake_waiters_(unique_lock<mutex>&) noexcept;
+  void reclaim_() noexcept;
 
   stats_group cache_group_;
+  stats_group alloc_group_;
   mutex mtx_;
-  ranges_type ranges_;
+  array<freelist_type, max_order + 1U> freelist_;
+  array<index_type, max_order + 1U - index_min_order> index_;
+  vector<zone> zones_;  // Ordered by start.
+  array<magazine, n_magazines> magazines_;
+  waiter_list waiters_;
+  atomic<bool> have_waiters_{ false };  // Hint: waiters_ is not empty.
+  freelist_type zero_pool_;
+  atomic<unsigned int> zero_pool_n_{ 0 };  // Size of zero_pool_.
+  pmap_support<native_arch>& support_;
   page_cache cache_;
+  workq_job_ptr reclaim_job_;
+  workq_job_ptr zero_job_;
   page_count<native_arch> size_ = page_count<native_arch>(0);
-  page_count<native_arch> free_ = page_count<native_arch>(0);
+  page_count<native_arch> free_ = page_count<native_arch>(0);  // In freelist_.
+
+  stats_counter magazine_hit_,
+                magazine_miss_,
+                magazine_flush_,
+                split_,
+                merge_,
+                wait_,
+                reclaim_pages_,
+                wait_fail_,
+                constrained_,
+                zero_hit_,
+                zero_miss_;
+  stats_gauge zero_pool_stat_;
 };
 
 
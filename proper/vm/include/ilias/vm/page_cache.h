@@ -3,7 +3,9 @@
 
 #include <ilias/vm/page.h>
 #include <ilias/stats.h>
+#include <array>
 #include <atomic>
+#include <cstdint>
 #include <mutex>
 #include <ilias/linked_list.h>
 #include <ilias/future.h>
@@ -15,6 +17,28 @@ namespace ilias {
 namespace vm {
 
 
+/*
+ * Page cache, using CLOCK with adaptive replacement (CAR).
+ *
+ * Cached pages are kept in three zones:
+ * - spec_zone: speculative pages, that have not been used yet,
+ * - cold_zone: pages that were used once since they were cached,
+ * - hot_zone: pages that were used repeatedly.
+ * Each zone is a clock: pages are examined at the head of the zone,
+ * and a page that was accessed since it was last examined moves to the
+ * tail of the next zone (the hot zone for hot pages) instead of being
+ * released.
+ *
+ * Released cold and hot pages leave a ghost entry, identifying their
+ * owner and offset.  A page that is cached again while its ghost is
+ * remembered goes straight to the hot zone, and adapts cold_target_,
+ * the number of cold pages kept before hot pages are released:
+ * a ghost of a cold page grows it, a ghost of a hot page shrinks it.
+ * Pages touched once, as by a sequential scan, never leave the cold
+ * zone, so a scan releases its own pages instead of the hot pages.
+ *
+ * Unused speculative pages are released first, and leave no ghost.
+ */
 class page_cache {
  private:
   using list_type = ll_smartptr_list<page, tags::page_cache,
@@ -28,12 +52,19 @@ class page_cache {
     page::fl_cache_speculative, page::fl_cache_cold, page::fl_cache_hot
   }};
 
-  class hot_cold_rebalance_wqjob;
-  class spec_need_rebalance_wqjob;
+  /* Pages examined before the zone to release from is chosen again. */
+  static constexpr intptr_t sweep_batch = 32;
+  static constexpr unsigned int ghost_slots = 2048;
+
+  /* Released page. */
+  struct ghost {
+    uint64_t key = 0;  // Hash of owner and offset, zero if unused.
+    uint64_t seq = 0;  // Value of ghost_seq_ when the page was released.
+    unsigned int zone = 0;  // Zone the page was released from.
+  };
 
  public:
-  page_cache(stats_group&, workq_ptr);
-  page_cache(stats_group&, workq_service&);
+  explicit page_cache(stats_group&);
   page_cache(const page_cache&) = delete;
   page_cache(page_cache&&) = delete;
   page_cache& operator=(const page_cache&) = delete;
@@ -51,28 +82,35 @@ class page_cache {
  private:
   bool unlink_zone_(unsigned int, page&) noexcept;
   bool link_zone_(unsigned int, page&) noexcept;
-  bool promote_(unsigned int, page&) noexcept;
-  bool demote_(unsigned int, page&) noexcept;
+  bool move_(unsigned int, unsigned int, page&) noexcept;
+
+  unsigned int victim_zone_() const noexcept;
+  page_list sweep_(unsigned int, page_count<native_arch>, page_list,
+                   intptr_t) noexcept;
 
-  page_list try_release_urgent_zone_(unsigned int zone,
-                                     page_count<native_arch> npg,
-                                     page_list pgl) noexcept;
-  cb_future<page_list> try_release_zone_(unsigned int,
-                                         page_count<native_arch> npg) noexcept;
+  static uint64_t ghost_key_(const page&) noexcept;
+  void add_ghost_(unsigned int, uint64_t) noexcept;
+  unsigned int take_ghost_(uint64_t) noexcept;
+  void adapt_cold_target_(intptr_t) noexcept;
+  static uint64_t stat_cold_target_(const void*) noexcept;
 
-  atomic<intptr_t> hot_cold_diff_{ 0 };  // #hot - (#cold + #speculative).
-  atomic<intptr_t> spec_need_diff_{ 0 };  // #speculative - min(#speculative)
   array<list_type, n_zones> data_;
+  array<atomic<intptr_t>, n_zones> size_;
+  atomic<intptr_t> cold_target_{ 0 };
 
-  workq_job_ptr hot_cold_rebalance_job_;
-  workq_job_ptr spec_need_rebalance_job_;
+  mutex ghost_mtx_;  // Protects ghost_seq_ and ghosts_.
+  uint64_t ghost_seq_ = 0;
+  array<ghost, ghost_slots> ghosts_;
 
   stats_counter manage_,
                 unmanage_,
-                hot_cold_rebalance_,
-                spec_need_rebalance_,
+                promote_,
+                release_,
                 speculative_hit_,
-                speculative_miss_;
+                speculative_miss_,
+                ghost_cold_hit_,
+                ghost_hot_hit_;
+  stats_gauge cold_target_stat_;
 };
 
 
@@ -0,0 +1,21 @@
+#ifndef _ILIAS_VM_PARALLEL_H_
+#define _ILIAS_VM_PARALLEL_H_
+
+#include <ilias/workq.h>
+
+namespace ilias {
+namespace vm {
+
+
+/*
+ * Record the number of CPUs and, if there is more than one,
+ * install a backend running parallel algorithms on wqs.
+ *
+ * Called once during startup, before any parallel algorithm is used.
+ */
+void init_parallel(workq_service& wqs);
+
+
+}} /* namespace ilias::vm */
+
+#endif /* _ILIAS_VM_PARALLEL_H_ */
@@ -443,65 +443,80 @@ auto vmmap_shard<Arch>::mincore(vpage_no<Arch> b_addr, vpage_no<Arch> e_addr)
 
 template<arch Arch>
 auto vmmap_shard<Arch>::merge(vmmap_shard&& rhs) noexcept -> void {
-  /* Clear all collections in rhs, except for entries_. */
-  while (!rhs.free_list_.empty()) rhs.free_list_.unlink_front();
+  /*
+   * Merge the free space indices.
+   * The free lists are merged in order of free size, after which the
+   * free space tree is built from the merged list in linear time.
+   */
+  free_.unlink_all();
   rhs.free_.unlink_all();
-  rhs.npg_free_ = page_count<Arch>(0);
-
-  /* Relink all entries from rhs into this. */
-  rhs.entries_.unlink_all([this](entry* e) {
-#ifndef NDEBUG
-                            /* Verify there is no overlap. */
-                            auto r = entries_.equal_range(
-                                isect_(e->get_addr_used(), e->get_addr_end()));
-                            assert(get<0>(r) == get<1>(r));
-#endif
-
-                            /* Link. */
-                            auto inserted =
-                                this->link_(unique_ptr<entry>(e));
-
-                            /* Merge free space before. */
-                            if (inserted->unused() &&
-                                inserted != entries_.begin()) {
-                              auto pred = prev(inserted);
-                              this->free_update_(*pred,
-                                                 [this, &pred, &inserted]() {
-                                                   auto i =
-                                                       this->unlink_(inserted);
-                                                   pred->update_end(
-                                                       i->get_addr_end());
-                                                   inserted = pred;
-                                                 });
-                            }
-
-                            /* Merge free space after. */
-                            if (inserted != entries_.end()) {
-                              auto succ = next(inserted);
-                              if (succ != entries_.end() && succ->unused()) {
-                                this->free_update_(*inserted,
-                                                   [this, &succ, &inserted]() {
-                                                     auto i =
-                                                         this->unlink_(succ);
-                                                     inserted->update_end(
-                                                         i->get_addr_end());
-                                                   });
-                              }
-                            }
-                          });
+  free_list::merge(free_list_.begin(), free_list_.end(),
+                   rhs.free_list_.begin(), rhs.free_list_.end(),
+                   free_before_());
+  free_.link_sorted(free_list_.begin(), free_list_.end());
+  npg_free_ += exchange(rhs.npg_free_, page_count<Arch>(0));
+
+  /* Merge the free space of an unused entry into its predecessor. */
+  auto merge_into_pred = [this](const entry& x) {
+                           auto i = entries_.find(x);
+                           if (!i->unused() || i == entries_.begin()) return;
+                           auto pred = prev(i);
+                           this->free_update_(*pred,
+                                              [this, &pred, &i]() {
+                                                auto u = this->unlink_(i);
+                                                pred->update_end(
+                                                    u->get_addr_end());
+                                              });
+                         };
+
+  /*
+   * Join runs of entries from rhs into the address tree.
+   * Each run of rhs entries that falls between two consecutive entries
+   * of this shard is split off rhs and joined in as a whole,
+   * so merging shards that don't interleave takes a single pass.
+   * Only the entries at the seams may need their free space merged.
+   */
+  while (!rhs.entries_.empty()) {
+    const entry& run_first = *rhs.entries_.begin();
+    const auto pos = entries_.upper_bound(run_first);
+    const entry* after = (pos == entries_.end() ? nullptr : &*pos);
+
+    entries_type rhs_tail;
+    if (after != nullptr)
+      rhs_tail = rhs.entries_.split(rhs.entries_.lower_bound(*after));
+
+    /* Verify there is no overlap. */
+    assert(pos == entries_.begin() ||
+           prev(pos)->get_addr_end() <= run_first.get_addr_used());
+    assert(after == nullptr ||
+           prev(rhs.entries_.end())->get_addr_end() <=
+           after->get_addr_used());
+
+    entries_type tail = entries_.split(pos);
+    entries_.join(move(rhs.entries_));
+    entries_.join(move(tail));
+    rhs.entries_.swap(rhs_tail);
+
+    if (after != nullptr) merge_into_pred(*after);
+    merge_into_pred(run_first);
+  }
 }
 
 template<arch Arch>
 template<typename Iter>
 auto vmmap_shard<Arch>::fanout(Iter b, Iter e) noexcept -> void {
+  assert(&*b == this);
+
   const page_count<Arch> npg_per_shard =
       max(free_size() / size_t(distance(b, e)),
           page_count<Arch>(1));
   const page_count<Arch> max_npg_per_shard =
       2 * npg_per_shard;
 
+  Iter filled_e = next(b);  // Shards [next(b), filled_e) received entries.
   typename entries_type::iterator i = entries_.begin();
   for (Iter out = b; i != entries_.end() && next(out) != e; ++out) {
+    const typename entries_type::iterator first = i;
     page_count<Arch> c = page_count<Arch>(0);
     while (i != entries_.end() && c < npg_per_shard) {
       auto i_free = get<1>(i->get_range_free());
@@ -517,17 +532,57 @@ auto vmmap_shard<Arch>::fanout(Iter b, Iter e) noexcept -> void {
         i_free = get<1>(i->get_range_free());
       }
 
-      /* Save iterator successor (since i will be invalidated below). */
-      typename entries_type::iterator i_next = next(i);
-
-      /* Move entry to destination. */
-      if (&*out != this) out->link_(unlink_(i));
       c += i_free;
+      ++i;
+    }
 
-      /* Update for next step in while  loop. */
-      i = i_next;
+    /*
+     * Move entries [first, i) to destination.
+     * The range is split off the address tree and joined onto the
+     * destination tree, which holds only lower addresses.
+     */
+    if (&*out != this) {
+      entries_type tail = entries_.split(i);
+      entries_type moved = entries_.split(first);
+      entries_.join(move(tail));
+      out->entries_.join(move(moved));
+      filled_e = next(out);
     }
   }
+  if (filled_e == next(b)) return;
+
+  /*
+   * Move the free space of moved entries to their new shard.
+   * free_list_ is walked in order, so the free list of each shard stays
+   * ordered by free size, and all free space trees are built from their
+   * lists in linear time.
+   * The moved entries lie in [moved_b, moved_e), in shard order.
+   */
+  const vpage_no<Arch> moved_b = next(b)->entries_.begin()->get_addr_used();
+  const vpage_no<Arch> moved_e =
+      prev(prev(filled_e)->entries_.end())->get_addr_end();
+  auto shard_before = [](vpage_no<Arch> addr, const vmmap_shard& s) {
+                        return addr < s.entries_.begin()->get_addr_used();
+                      };
+
+  free_.unlink_all();
+  for (auto x = free_list_.begin(); x != free_list_.end(); ) {
+    entry& xe = *x++;
+    if (xe.get_addr_used() < moved_b || xe.get_addr_used() >= moved_e)
+      continue;
+
+    const Iter dst = prev(upper_bound(next(b), filled_e,
+                                      xe.get_addr_used(), shard_before));
+    const page_count<Arch> npg = get<1>(xe.get_range_free());
+    free_list_.unlink(&xe);
+    npg_free_ -= npg;
+    dst->free_list_.link_back(&xe);
+    dst->npg_free_ += npg;
+  }
+
+  free_.link_sorted(free_list_.begin(), free_list_.end());
+  for (Iter out = next(b); out != filled_e; ++out)
+    out->free_.link_sorted(out->free_list_.begin(), out->free_list_.end());
 }
 
 template<arch Arch>
@@ -611,33 +666,20 @@ auto vmmap_shard<Arch>::link_(unique_ptr<entry>&& ptr) noexcept ->
 
   tie(rv, link_succes) = entries_.link(ptr.get(), false);
   assert(link_succes);
-
-  typename free_type::const_iterator free_pos;
-  tie(free_pos, link_succes) = free_.link(ptr.get(), true);
-  assert(link_succes);
-
-  free_list_.link(free_list::iterator_to(*next(free_pos)), ptr.get());
-
-  npg_free_ += get<1>(ptr->get_range_free());
-
-  ptr.release();
+  free_link_(*ptr.release());
   return rv;
 }
 
 template<arch Arch>
 auto vmmap_shard<Arch>::unlink_(entry* e) noexcept -> unique_ptr<entry> {
-  npg_free_ -= get<1>(e->get().get_range_free());
-  free_list_.unlink(e);
-  free_.unlink(e);
+  free_unlink_(*e);
   return unique_ptr<entry>(entries_.unlink(e));
 }
 
 template<arch Arch>
 auto vmmap_shard<Arch>::unlink_(typename entries_type::const_iterator i)
     noexcept -> unique_ptr<entry> {
-  npg_free_ -= get<1>(i->get_range_free());
-  free_list_.unlink(&*i);
-  free_.unlink(&*i);
+  free_unlink_(*entries_type::nonconst_iterator(i));
   return unique_ptr<entry>(entries_.unlink(i));
 }
 
@@ -645,12 +687,17 @@ template<arch Arch>
 template<typename Fn, typename... Args>
 auto vmmap_shard<Arch>::free_update_(entry& e, Fn fn, Args&&... args)
     noexcept -> void {
-  npg_free_ -= get<1>(e.get_range_free());
-  free_list_.unlink(&e);
-  free_.unlink(&e);
-
+  free_unlink_(e);
   fn(forward<Args>(args)...);
+  free_link_(e);
+}
 
+/*
+ * Add an entry, that is already linked in entries_, to the free space
+ * indices.
+ */
+template<arch Arch>
+auto vmmap_shard<Arch>::free_link_(entry& e) noexcept -> void {
   typename free_type::const_iterator free_pos;
   bool link_succes;
   tie(free_pos, link_succes) = free_.link(&e, true);
@@ -660,6 +707,14 @@ auto vmmap_shard<Arch>::free_update_(entry& e, Fn fn, Args&&... args)
   npg_free_ += get<1>(e.get_range_free());
 }
 
+/* Remove an entry from the free space indices. */
+template<arch Arch>
+auto vmmap_shard<Arch>::free_unlink_(entry& e) noexcept -> void {
+  npg_free_ -= get<1>(e.get_range_free());
+  free_list_.unlink(&e);
+  free_.unlink(&e);
+}
+
 /*
  * Test that a given range has no gaps.
  */
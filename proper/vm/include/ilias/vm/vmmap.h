@@ -271,6 +271,8 @@ class vmmap_shard {
   template<typename Fn, typename... Args> void free_update_(entry&, Fn,
                                                             Args&&...)
       noexcept;
+  void free_link_(entry&) noexcept;
+  void free_unlink_(entry&) noexcept;
 
   void ensure_no_gaps_(tuple<typename entries_type::iterator,
                              typename entries_type::iterator>) const;
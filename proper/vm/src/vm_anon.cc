@@ -45,7 +45,7 @@ auto anon_vme::entry::fault(monitor_token /*mt*/,
                                     this, _1, _2),
                                mt.upgrade_to_write(),
                                pga->allocate(
-                                   alloc_fail_not_ok)));
+                                   alloc_fail_not_ok | alloc_zero)));
                      }
                    }),
                guard_.queue(monitor_access::upgrade), wq);
@@ -131,6 +131,12 @@ auto page::clear_page_owner() noexcept -> void {
   pgo_ = make_tuple(nullptr, 0);
 }
 
+auto page::get_page_owner() const noexcept ->
+    tuple<page_owner*, page_owner::offset_type> {
+  lock_guard<mutex> l{ guard_ };
+  return pgo_;
+}
+
 
 page_range::page_range(page* p, size_type n, bool do_acquire) noexcept
 : pg_(p),
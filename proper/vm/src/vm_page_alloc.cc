@@ -1,6 +1,14 @@
 #include <ilias/vm/page_alloc.h>
 #include <cdecl.h>
+#include <ilias/pmap/page_alloc_support.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
 #include <new>
+#include <abi/ext/log2.h>
 #include <abi/panic.h>
 
 namespace ilias {
@@ -11,12 +19,103 @@ constexpr auto fail_mask = page_alloc::alloc_style::fail_ok |
                            page_alloc::alloc_style::fail_ok_nothrow |
                            page_alloc::alloc_style::fail_not_ok;
 
+/* Index of the magazine used by the calling thread. */
+auto thread_slot() noexcept -> unsigned int {
+  static atomic<unsigned int> seq{ 0 };
+  static thread_local unsigned int slot =
+      seq.fetch_add(1U, memory_order_relaxed);
+  return slot;
+}
+
+/* Contents of a page, for mapping it. */
+struct page_data {
+  uint64_t words[page_size(native_arch) / sizeof(uint64_t)];
+};
+
+/*
+ * Zero a page.
+ *
+ * On amd64, non-temporal stores are used, so zeroing a page does not
+ * evict the working set from the cache.
+ */
+auto zero_page_data(page_data* d) noexcept -> void {
+#if defined(__amd64__) || defined(__x86_64__)
+  const uint64_t zero = 0;
+  for (uint64_t* w = begin(d->words); w != end(d->words); w += 4) {
+    asm volatile("movnti %1, 0(%0)\n\t"
+                 "movnti %1, 8(%0)\n\t"
+                 "movnti %1, 16(%0)\n\t"
+                 "movnti %1, 24(%0)"
+                 :
+                 : "r"(w), "r"(zero)
+                 : "memory");
+  }
+  asm volatile("sfence" ::: "memory");
+#else
+  memset(d, 0, sizeof(*d));
+#endif
+}
+
 } /* namespace ilias::vm::<unnamed> */
 
 
 using abi::panic;
 
 
+class default_page_alloc::reclaim_wqjob
+: public workq_job
+{
+ public:
+  reclaim_wqjob(workq_ptr, default_page_alloc&);
+  ~reclaim_wqjob() noexcept override;
+
+  void run() noexcept override;
+
+ private:
+  default_page_alloc& self_;
+};
+
+
+default_page_alloc::reclaim_wqjob::reclaim_wqjob(workq_ptr wq,
+                                                 default_page_alloc& self)
+: workq_job(wq),
+  self_(self)
+{}
+
+default_page_alloc::reclaim_wqjob::~reclaim_wqjob() noexcept {}
+
+auto default_page_alloc::reclaim_wqjob::run() noexcept -> void {
+  self_.reclaim_();
+}
+
+
+class default_page_alloc::zero_wqjob
+: public workq_job
+{
+ public:
+  zero_wqjob(workq_ptr, default_page_alloc&);
+  ~zero_wqjob() noexcept override;
+
+  void run() noexcept override;
+
+ private:
+  default_page_alloc& self_;
+};
+
+
+default_page_alloc::zero_wqjob::zero_wqjob(workq_ptr wq,
+                                           default_page_alloc& self)
+: workq_job(wq),
+  self_(self)
+{}
+
+default_page_alloc::zero_wqjob::~zero_wqjob() noexcept {}
+
+auto default_page_alloc::zero_wqjob::run() noexcept -> void {
+  self_.fill_zero_pool_();
+}
+
+
 page_alloc::page_alloc(workq_service& wqs) noexcept
 : wq_(wqs.new_workq())
 {}
@@ -24,45 +123,96 @@ page_alloc::page_alloc(workq_service& wqs) noexcept
 page_alloc::~page_alloc() noexcept {}
 
 
+constexpr unsigned int default_page_alloc::max_order;
+constexpr unsigned int default_page_alloc::n_magazines;
+constexpr unsigned int default_page_alloc::magazine_max;
+constexpr unsigned int default_page_alloc::magazine_batch;
+constexpr unsigned int default_page_alloc::magazine_zero_max;
+constexpr unsigned int default_page_alloc::reclaim_batch;
+constexpr unsigned int default_page_alloc::index_min_order;
+constexpr unsigned int default_page_alloc::zero_pool_max;
+constexpr unsigned int default_page_alloc::zero_batch;
+
+
 default_page_alloc::default_page_alloc(stats_group& parent_group,
-                                       workq_service& wqs) noexcept
+                                       workq_service& wqs,
+                                       pmap_support<native_arch>& support)
+    noexcept
 : page_alloc(wqs),
   cache_group_(parent_group, "page_cache"),
-  cache_(this->cache_group_, wqs)
+  alloc_group_(parent_group, "page_alloc"),
+  support_(support),
+  cache_(this->cache_group_),
+  reclaim_job_(new_workq_job<reclaim_wqjob>(this->get_workq(), *this)),
+  zero_job_(new_workq_job<zero_wqjob>(wqs.new_workq(), *this)),
+  magazine_hit_(alloc_group_, "magazine_hit"),
+  magazine_miss_(alloc_group_, "magazine_miss"),
+  magazine_flush_(alloc_group_, "magazine_flush"),
+  split_(alloc_group_, "split"),
+  merge_(alloc_group_, "merge"),
+  wait_(alloc_group_, "wait"),
+  reclaim_pages_(alloc_group_, "reclaim_pages"),
+  wait_fail_(alloc_group_, "wait_fail"),
+  constrained_(alloc_group_, "constrained"),
+  zero_hit_(alloc_group_, "zero_hit"),
+  zero_miss_(alloc_group_, "zero_miss"),
+  zero_pool_stat_(alloc_group_, "zero_pool", &stat_zero_pool_, this)
 {}
 
 default_page_alloc::~default_page_alloc() noexcept {
-  ranges_.unlink_all();
+  workq_deactivate(reclaim_job_);
+  reclaim_job_ = nullptr;
+  workq_deactivate(zero_job_);
+  zero_job_ = nullptr;
+
+  /* Parked allocations are abandoned. */
+  while (!waiters_.empty()) delete waiters_.unlink_front();
+
+  for (index_type& idx : index_) idx.unlink_all();
+  while (!zero_pool_.empty()) zero_pool_.unlink_front();
+  for (freelist_type& fl : freelist_)
+    while (!fl.empty()) fl.unlink_front();
 }
 
-auto default_page_alloc::allocate(alloc_style style) -> cb_future<page_ptr> {
-  using alloc_style::fail_not_ok;
-  using alloc_style::fail_ok;
-  using alloc_style::fail_ok_nothrow;
-  using std::placeholders::_1;
+/*
+ * Hand a range of page structures to the allocator.
+ *
+ * The pages must have consecutive page numbers and be laid out
+ * consecutively in memory.  All pages in the range start out free.
+ * Only pages handed over this way may be deallocated; deallocating
+ * any other page panics.
+ */
+auto default_page_alloc::add_range(page* pg, page_count<native_arch> npg) ->
+    void {
+  if (npg == page_count<native_arch>(0)) return;
 
-  /* Verify arguments. */
-  switch (style & fail_mask) {
-  default:
-    assert_msg(false, "alloc style failure mode not recognized");
-    break;
-  case fail_not_ok:
-  case fail_ok:
-  case fail_ok_nothrow:
-    break;
-  }
+  unique_lock<mutex> l{ mtx_ };
+  const zone z{ pg, pg->address(), npg };
+  zones_.insert(upper_bound(zones_.begin(), zones_.end(), z,
+                            [](const zone& x, const zone& y) {
+                              return x.start < y.start;
+                            }),
+                z);
+  size_ += npg;
+
+  add_to_freelist_(pg, npg);
+  wake_waiters_(l);
+  l.unlock();
 
-  auto self_ptr =
-      static_pointer_cast<default_page_alloc>(this->shared_from_this());
-  return async(this->get_workq(),
-               [](shared_ptr<default_page_alloc> p,
-                  alloc_style style) -> page_ptr {
-                 return p->allocate_prom_(style);
-               },
-               move(self_ptr), style);
+  workq_activate(zero_job_);
 }
 
-auto default_page_alloc::allocate_prom_(alloc_style style) -> page_ptr {
+/*
+ * Allocate a page, or park the allocation until a page is available.
+ *
+ * Parked allocations are completed when pages are freed, or reclaimed
+ * from the page cache by the reclaim job.  If the page cache has
+ * nothing left to reclaim, allocations using fail_ok_nothrow complete
+ * with a nullptr; other allocations stay parked until pages are freed,
+ * or handed to the page cache through manage(), which restarts the
+ * reclaim job.
+ */
+auto default_page_alloc::allocate(alloc_style style) -> cb_future<page_ptr> {
   using alloc_style::fail_not_ok;
   using alloc_style::fail_ok;
   using alloc_style::fail_ok_nothrow;
@@ -78,26 +228,44 @@ auto default_page_alloc::allocate_prom_(alloc_style style) -> page_ptr {
     break;
   }
 
-  lock_guard<mutex> l{ mtx_ };
-
-  page_ptr rv = fetch_from_freelist_();
-  if (_predict_true(rv)) return rv;
+  const bool zero = ((style & alloc_style::zero) == alloc_style::zero);
+  cb_promise<page_ptr> rv;
+  page_ptr pg;
+  if (zero) {
+    pg = fetch_zeroed_();
+    if (_predict_true(pg)) {
+      rv.set_value(move(pg));
+      return rv.get_future();
+    }
+  }
 
-  assert_msg(false, "XXX implement");  // XXX implement, return promise that may or may not be complete.
+  pg = fetch_from_magazine_();
+  if (_predict_true(pg)) {
+    if (zero) zero_page_(*pg);
+    rv.set_value(move(pg));
+    return rv.get_future();
+  }
 
-  switch (style & fail_mask) {
-  case fail_not_ok:
-    panic("Failed to allocate page.");
-    break;
-  case fail_ok:
-    __throw_bad_alloc();
-    break;
-  case fail_ok_nothrow:
-    return nullptr;
+  unique_lock<mutex> l{ mtx_ };
+  pg = fetch_from_freelist_();
+  if (_predict_true(pg)) {
+    l.unlock();
+    if (zero) zero_page_(*pg);
+    rv.set_value(move(pg));
+    return rv.get_future();
   }
 
-  __builtin_unreachable();
-  for (;;);
+  /* Park the allocation. */
+  waiter* w = new waiter(style, page_count<native_arch>(1), false);
+  w->prom = move(rv);
+  cb_future<page_ptr> f = w->prom.get_future();
+  waiters_.link_back(w);
+  have_waiters_.store(true, memory_order_relaxed);
+  wait_.add();
+  l.unlock();
+
+  workq_activate(reclaim_job_);
+  return f;
 }
 
 auto default_page_alloc::allocate_urgent(alloc_style style) -> page_ptr {
@@ -116,17 +284,40 @@ auto default_page_alloc::allocate_urgent(alloc_style style) -> page_ptr {
     break;
   }
 
+  /* Zeroed pages come from the zero pool, or are zeroed here. */
+  if ((style & alloc_style::zero) == alloc_style::zero) {
+    page_ptr rv = fetch_zeroed_();
+    if (_predict_true(rv)) return rv;
+
+    rv = allocate_urgent(style ^ alloc_style::zero);
+    if (rv) zero_page_(*rv);
+    return rv;
+  }
+
+  /* Try the magazine of this thread, without taking the lock. */
+  page_ptr rv = fetch_from_magazine_();
+  if (_predict_true(rv)) return rv;
+
   unique_lock<mutex> l{ mtx_ };
 
   /* Try normal allocation. */
-  page_ptr rv = fetch_from_freelist_();
+  rv = fetch_from_freelist_();
   if (_predict_true(rv)) return rv;
 
-  /* Try poking the cache to release a page. */
-  page_list pgl = cache_.try_release_urgent(page_count<native_arch>(1));
-  assert(pgl.size() == page_count<native_arch>(1) || pgl.empty());
+  /* Try reclaiming pages held in the magazines of other threads. */
+  l.unlock();
+  drain_magazines_();
+  l.lock();
+  rv = fetch_from_freelist_();
+  if (_predict_true(rv)) return rv;
 
+  /*
+   * Try poking the cache to release a page.
+   * The cache may write back dirty pages, so mtx_ is not held.
+   */
   l.unlock();
+  page_list pgl = cache_.try_release_urgent(page_count<native_arch>(1));
+  assert(pgl.size() == page_count<native_arch>(1) || pgl.empty());
 
   if (!pgl.empty()) {
     rv = pgl.pop_front();
@@ -151,12 +342,20 @@ auto default_page_alloc::allocate_urgent(alloc_style style) -> page_ptr {
   for (;;);
 }
 
+/*
+ * Allocate npg pages, or park the allocation until enough pages are
+ * available.
+ *
+ * Parked allocations share the queue of single page allocations, and
+ * complete under the same rules.  A parked allocation that reaches the
+ * front of the queue collects pages as they are freed or reclaimed,
+ * until it has all npg pages.
+ */
 auto default_page_alloc::allocate(page_count<native_arch> npg,
                                   alloc_style style) -> cb_future<page_list> {
   using alloc_style::fail_not_ok;
   using alloc_style::fail_ok;
   using alloc_style::fail_ok_nothrow;
-  using std::placeholders::_1;
 
   /* Verify arguments. */
   switch (style & fail_mask) {
@@ -169,6 +368,75 @@ auto default_page_alloc::allocate(page_count<native_arch> npg,
     break;
   }
 
+  cb_promise<page_list> rv;
+  if (_predict_false(npg == page_count<native_arch>(0))) {
+    rv.set_value(page_list());
+    return rv.get_future();
+  }
+  assert(npg > page_count<native_arch>(0));
+
+  unique_lock<mutex> l{ mtx_ };
+  page_list pgl;
+  fill_from_freelist_(pgl, npg);
+  if (_predict_false(pgl.size() < npg)) {
+    /* Try to reclaim pages held in magazines and the zero pool. */
+    l.unlock();
+    drain_magazines_();
+    l.lock();
+    release_zero_pool_();
+    fill_from_freelist_(pgl, npg);
+  }
+
+  if (_predict_true(pgl.size() == npg)) {
+    l.unlock();
+    if ((style & alloc_style::zero) == alloc_style::zero) zero_pages_(pgl);
+    rv.set_value(move(pgl));
+    return rv.get_future();
+  }
+
+  /*
+   * Park the allocation.
+   * Only the front of the queue holds pages: if other allocations
+   * are parked, the pages taken so far are released to them,
+   * via deallocate().
+   */
+  waiter* w = new waiter(style, npg, true);
+  w->list_prom = move(rv);
+  cb_future<page_list> f = w->list_prom.get_future();
+  if (waiters_.empty()) w->pgs = move(pgl);
+  waiters_.link_back(w);
+  have_waiters_.store(true, memory_order_relaxed);
+  wait_.add();
+  l.unlock();
+
+  pgl.clear();
+  workq_activate(reclaim_job_);
+  return f;
+}
+
+auto default_page_alloc::allocate_urgent(page_count<native_arch>,
+                                         alloc_style) -> page_list {
+  assert_msg(false, "XXX: implement");  // XXX implement
+  for (;;);
+}
+
+auto default_page_alloc::allocate(page_count<native_arch> npg, spec s) ->
+    cb_future<page_list> {
+  using alloc_style::fail_not_ok;
+  using alloc_style::fail_ok;
+  using alloc_style::fail_ok_nothrow;
+
+  /* Verify arguments. */
+  switch (s.style & fail_mask) {
+  default:
+    assert_msg(false, "alloc style failure mode not recognized");
+    break;
+  case fail_not_ok:
+  case fail_ok:
+  case fail_ok_nothrow:
+    break;
+  }
+
   if (_predict_false(npg == page_count<native_arch>(0))) {
     cb_promise<page_list> rv;
     rv.set_value(page_list());
@@ -181,20 +449,26 @@ auto default_page_alloc::allocate(page_count<native_arch> npg,
   return async(this->get_workq(),
                [](shared_ptr<default_page_alloc> p,
                   page_count<native_arch> npg,
-                  alloc_style style) -> page_list {
-                 return p->allocate_prom_(npg, style);
+                  spec s) -> page_list {
+                 return p->allocate_urgent(npg, s);
                },
-               move(self_ptr), npg, style);
+               move(self_ptr), npg, s);
 }
 
-auto default_page_alloc::allocate_prom_(page_count<native_arch> npg,
-                                        alloc_style style) -> page_list {
+/*
+ * Allocate npg contiguous pages, placed according to the spec.
+ *
+ * Pages in the page cache are not reclaimed: a constrained allocation
+ * needs specific pages, which the cache cannot be asked for.
+ */
+auto default_page_alloc::allocate_urgent(page_count<native_arch> npg,
+                                         spec s) -> page_list {
   using alloc_style::fail_not_ok;
   using alloc_style::fail_ok;
   using alloc_style::fail_ok_nothrow;
 
   /* Verify arguments. */
-  switch (style & fail_mask) {
+  switch (s.style & fail_mask) {
   default:
     assert_msg(false, "alloc style failure mode not recognized");
     break;
@@ -204,38 +478,37 @@ auto default_page_alloc::allocate_prom_(page_count<native_arch> npg,
     break;
   }
 
+  if (_predict_false(npg == page_count<native_arch>(0))) return page_list();
+  assert(npg > page_count<native_arch>(0));
+
   unique_lock<mutex> l{ mtx_ };
-  page_list rv;
+  page_range pgs = fetch_constrained_(npg, s);
+  if (_predict_false(pgs.empty())) {
+    /* Pages held in magazines and the zero pool may complete a block. */
+    l.unlock();
+    drain_magazines_();
+    l.lock();
+    release_zero_pool_();
+    pgs = fetch_constrained_(npg, s);
+  }
+  l.unlock();
 
-  while (rv.size() < npg) {
-    page_range pgs = fetch_from_freelist_(npg - rv.size());
-    if (_predict_false(pgs.empty())) break;  // GUARD
+  if (_predict_true(!pgs.empty())) {
+    page_list rv;
     rv.push_pages_back(move(pgs));
+    if ((s.style & alloc_style::zero) == alloc_style::zero) zero_pages_(rv);
+    return rv;
   }
-  if (rv.size() == npg) return rv;
 
-  /*
-   * Try to reclaim from page cache.
-   */
-  rv.merge(move(cache_.try_release(npg - rv.size()).get()));  // XXX: may throw, may fail, may block
-
-  if (_predict_true(rv.size() == npg)) return rv;
-
-  /*
-   * Failed to allocate.
-   *
-   * Unlock and perform failure.
-   * (Unlock must happen before end-of-function,
-   * so page_list can free its contents.)
-   */
-  l.unlock();
-
-  switch (style & fail_mask) {
+  /* Complete failure, handle failure style. */
+  switch (s.style & fail_mask) {
+  default:
   case fail_not_ok:
     panic("Failed to allocate pages.");
     break;
   case fail_ok:
     __throw_bad_alloc();
+    break;
   case fail_ok_nothrow:
     return page_list();
   }
@@ -244,89 +517,183 @@ auto default_page_alloc::allocate_prom_(page_count<native_arch> npg,
   for (;;);
 }
 
-auto default_page_alloc::allocate_urgent(page_count<native_arch>,
-                                         alloc_style) -> page_list {
-  assert_msg(false, "XXX: implement");  // XXX implement
-  for (;;);
+auto default_page_alloc::deallocate(page* pg) noexcept -> void {
+  mark_free_(pg, page_count<native_arch>(1));
+  if (_predict_true(!have_waiters_.load(memory_order_relaxed)) &&
+      _predict_true(store_in_magazine_(pg)))
+    return;
+
+  unique_lock<mutex> l{ mtx_ };
+  free_block_(zone_of_(pg), pg, 0);
+  wake_waiters_(l);
 }
 
-auto default_page_alloc::allocate(page_count<native_arch>, spec) ->
-    cb_future<page_list> {
-  assert_msg(false, "XXX: implement");  // XXX implement
-  for (;;);
+/*
+ * Hand a page to the page cache.
+ *
+ * Once the reclaim job finds nothing to release, parked allocations wait
+ * for pages to be freed; pages entering the cache restart it instead.
+ */
+auto default_page_alloc::manage(const page_ptr& pg, bool speculative)
+    noexcept -> void {
+  cache_.manage(pg, speculative);
+  if (have_waiters_.load(memory_order_relaxed)) workq_activate(reclaim_job_);
 }
 
-auto default_page_alloc::allocate_urgent(page_count<native_arch>, spec) ->
-    page_list {
-  assert_msg(false, "XXX: implement");  // XXX implement
-  for (;;);
+auto default_page_alloc::order_npg_(unsigned int order) noexcept ->
+    page_count<native_arch> {
+  using type = page_count<native_arch>::type;
+
+  assert(order <= max_order);
+  return page_count<native_arch>(type(1) << order);
 }
 
-auto default_page_alloc::deallocate(page* pg) noexcept -> void {
-  lock_guard<mutex> l{ mtx_ };
-  add_to_freelist_(pg, page_count<native_arch>(1));
+/* Log2 of the largest power of 2 that divides the page number. */
+auto default_page_alloc::align_log2_(const page* pg) noexcept ->
+    unsigned int {
+  const auto pgno = pg->address().get();
+  if (pgno == 0) return 63U;
+  return __builtin_ctzll(pgno);
 }
 
-auto default_page_alloc::fetch_from_freelist_() noexcept -> page_ptr {
-  const auto i = ranges_.root();
+auto default_page_alloc::magazine_() noexcept -> magazine& {
+  return magazines_[thread_slot() % n_magazines];
+}
+
+/*
+ * Allocate a single page from the magazine of this thread,
+ * refilling it from the freelist if it is empty.
+ *
+ * Returns nullptr if the magazine is in use by another thread,
+ * or if the freelist is empty.
+ */
+auto default_page_alloc::fetch_from_magazine_() noexcept -> page_ptr {
+  magazine& m = magazine_();
+  unique_lock<mutex> ml{ m.mtx, try_to_lock };
   page_ptr rv;
-  if (_predict_false(i == ranges_.end()))
-    return rv;
+  if (_predict_false(!ml.owns_lock())) return rv;
+
+  if (_predict_false(m.n == 0)) {
+    magazine_miss_.add();
 
-  const auto i_pred = (i == ranges_.begin() ? ranges_.end() : prev(i));
-  if (_predict_true(i->nfree_ > page_count<native_arch>(1) &&
-                    (i_pred == ranges_.end() || i->nfree_ > i_pred->nfree_))) {
-    auto off = --i->nfree_;
-    rv = &*i + off.get();
-  } else if (i->nfree_ == page_count<native_arch>(1)) {
-    rv = ranges_.unlink(i);
+    lock_guard<mutex> l{ mtx_ };
+    while (m.n < magazine_batch) {
+      page* pg = alloc_block_(0);
+      if (pg == nullptr) break;
+      m.pages[m.n++] = pg;
+    }
+    if (m.n == 0) return rv;
   } else {
-    assert(i->nfree_ > page_count<native_arch>(1));
-    page* r = ranges_.unlink(i);
-    auto off = --r->nfree_;
+    magazine_hit_.add();
+  }
 
-    bool link_succes;
-    tie(ignore, link_succes) = ranges_.link(r, true);
-    assert(link_succes);
-    rv = r + off.get();
+  rv = m.pages[--m.n];
+  auto old_flags = rv->clear_flag(page::fl_free);
+  assert(old_flags & page::fl_free);
+  return rv;
+}
+
+/*
+ * Store a freed page in the magazine of this thread,
+ * draining the magazine if it is full.
+ *
+ * Returns false if the magazine is in use by another thread.
+ */
+auto default_page_alloc::store_in_magazine_(page* pg) noexcept -> bool {
+  magazine& m = magazine_();
+  unique_lock<mutex> ml{ m.mtx, try_to_lock };
+  if (_predict_false(!ml.owns_lock())) return false;
+
+  if (_predict_false(m.n == magazine_max)) drain_magazine_(m, magazine_batch);
+  m.pages[m.n++] = pg;
+  return true;
+}
+
+/* Hand back the n least recently freed pages to the freelist. */
+auto default_page_alloc::drain_magazine_(magazine& m, unsigned int n)
+    noexcept -> void {
+  assert(n <= m.n);
+  if (n == 0) return;
+
+  magazine_flush_.add();
+  {
+    lock_guard<mutex> l{ mtx_ };
+    for_each(m.pages.begin(), m.pages.begin() + n,
+             [this](page* pg) { free_block_(zone_of_(pg), pg, 0); });
+  }
+  copy(m.pages.begin() + n, m.pages.begin() + m.n, m.pages.begin());
+  m.n -= n;
+
+  if (zero_pool_n_.load(memory_order_relaxed) < zero_pool_max)
+    workq_activate(zero_job_);
+}
+
+/*
+ * Hand back all pages in all magazines to the freelist,
+ * and their zeroed pages to the zero pool.
+ * Must be called without holding mtx_.
+ */
+auto default_page_alloc::drain_magazines_() noexcept -> void {
+  for (magazine& m : magazines_) {
+    lock_guard<mutex> ml{ m.mtx };
+    drain_magazine_(m, m.n);
+
+    if (m.nzero != 0) {
+      lock_guard<mutex> l{ mtx_ };
+      for_each(m.zeroed.begin(), m.zeroed.begin() + m.nzero,
+               [this](page* pg) { zero_pool_.link_back(pg); });
+      zero_pool_n_.fetch_add(m.nzero, memory_order_relaxed);
+      m.nzero = 0;
+    }
+  }
+
+  if (have_waiters_.load(memory_order_relaxed)) {
+    unique_lock<mutex> l{ mtx_ };
+    wake_waiters_(l);
+  }
+}
+
+/*
+ * Allocate a single page from the freelist.
+ * If the freelist is empty, a page is taken from the zero pool instead.
+ */
+auto default_page_alloc::fetch_from_freelist_() noexcept -> page_ptr {
+  page_ptr rv;
+  page* pg = alloc_block_(0);
+  if (_predict_false(pg == nullptr)) {
+    if (zero_pool_.empty()) return rv;
+    pg = zero_pool_.unlink_front();
+    zero_pool_n_.fetch_sub(1U, memory_order_relaxed);
   }
 
-  --free_;
+  rv = pg;
   auto old_flags = rv->clear_flag(page::fl_free);
   assert(old_flags & page::fl_free);
   return rv;
 }
 
+/*
+ * Allocate up to n pages, as a single block.
+ *
+ * Returns the largest block of at most n pages that can be allocated,
+ * or an empty range if the freelist is empty.
+ */
 auto default_page_alloc::fetch_from_freelist_(page_count<native_arch> n)
     noexcept -> page_range {
-  const auto i = ranges_.root();
-  if (_predict_false(i == ranges_.end()))
-    return page_range();
+  using abi::ext::log2_down;
 
-  page* rv_ptr;
-  page_count<native_arch> rv_npg;
-  const auto i_pred = (i == ranges_.begin() ? ranges_.end() : prev(i));
-  if (_predict_true(i->nfree_ > n && i->nfree_ - n >= i_pred->nfree_)) {
-    auto off = (i->nfree_ -= n);
-    rv_ptr = &*i + off.get();
-    rv_npg = n;
-  } else if (i->nfree_ <= n) {
-    rv_ptr = ranges_.unlink(i);
-    rv_npg = exchange(rv_ptr->nfree_, page_count<native_arch>(0));
-  } else {
-    assert(i->nfree_ > n);
-    page* r = ranges_.unlink(i);
-    auto off = (i->nfree_ -= n);
+  assert(n > page_count<native_arch>(0));
+  unsigned int order = min(log2_down(n.get()), max_order);
 
-    bool link_succes;
-    tie(ignore, link_succes) = ranges_.link(r, true);
-    assert(link_succes);
-    rv_ptr = r + off.get();
-    rv_npg = n;
+  page* rv_ptr = alloc_block_(order);
+  while (rv_ptr == nullptr && order > 0) {
+    /* No block of at least this order: use the largest smaller block. */
+    if (!freelist_[--order].empty()) rv_ptr = alloc_block_(order);
   }
+  if (_predict_false(rv_ptr == nullptr)) return page_range();
 
-  free_ -= rv_npg;
-  for_each(&*rv_ptr, &*rv_ptr + rv_npg.get(),
+  const page_count<native_arch> rv_npg = order_npg_(order);
+  for_each(rv_ptr, rv_ptr + rv_npg.get(),
            [](page& pg) {
              auto old_flags = pg.clear_flag(page::fl_free);
              assert(old_flags & page::fl_free);
@@ -334,51 +701,561 @@ auto default_page_alloc::fetch_from_freelist_(page_count<native_arch> n)
   return page_range(rv_ptr, rv_npg.get());
 }
 
+/* Add pages from the freelist to pgl, until it holds npg pages. */
+auto default_page_alloc::fill_from_freelist_(page_list& pgl,
+                                             page_count<native_arch> npg)
+    noexcept -> void {
+  while (pgl.size() < npg) {
+    page_range pgs = fetch_from_freelist_(npg - pgl.size());
+    if (_predict_false(pgs.empty())) break;  // GUARD
+    pgl.push_pages_back(move(pgs));
+  }
+}
+
+/*
+ * Add pages to the freelist.
+ *
+ * The pages are split in the largest aligned blocks that fit,
+ * which are then merged with their buddies.
+ */
 auto default_page_alloc::add_to_freelist_(page* pg,
                                           page_count<native_arch> n)
     noexcept -> void {
-  assert(pg->nfree_ != page_count<native_arch>(0));
+  mark_free_(pg, n);
+  free_range_(pg, n);
+}
 
-  /* Remove freeed pages from cache, mark as free. */
-  {
-    page* pgi = pg;
+/*
+ * Put a range of free pages on the freelist,
+ * split in the largest aligned blocks that fit.
+ */
+auto default_page_alloc::free_range_(page* pg, page_count<native_arch> n)
+    noexcept -> void {
+  using abi::ext::log2_down;
+
+  if (n == page_count<native_arch>(0)) return;
+
+  const zone& z = zone_of_(pg);
+  while (n != page_count<native_arch>(0)) {
+    unsigned int order = min(log2_down(n.get()), max_order);
+    while (order > 0 &&
+           (pg->address().get() & (order_npg_(order).get() - 1)) != 0)
+      --order;
+
+    free_block_(z, pg, order);
+    pg += order_npg_(order).get();
+    n -= order_npg_(order);
+  }
+}
+
+/* Remove freed pages from cache, mark as free. */
+auto default_page_alloc::mark_free_(page* pg, page_count<native_arch> n)
+    noexcept -> void {
+  for (page_count<native_arch> i = page_count<native_arch>(0);
+       i != n;
+       ++i, ++pg) {
+    assert(refcnt_is_zero(*pg));
+
+    cache_.unmanage(pg);
+    pg->nfree_ = page_count<native_arch>(0);
+    const auto old_flags = pg->set_flag(page::fl_free);
+    assert(!(old_flags & page::fl_free));
+  }
+}
+
+/* Find the zone containing the page. */
+auto default_page_alloc::zone_of_(const page* pg) const noexcept ->
+    const zone& {
+  const auto pgno = pg->address();
+  auto z = upper_bound(zones_.begin(), zones_.end(), pgno,
+                       [](page_no<native_arch> x, const zone& y) {
+                         return x < y.start;
+                       });
+  if (_predict_false(z == zones_.begin() ||
+                     pg < prev(z)->base ||
+                     pg >= prev(z)->base + prev(z)->npg.get())) {
+    panic("page_alloc: page %p was never handed to the allocator "
+          "using add_range()", static_cast<const void*>(pg));
+  }
+  return *prev(z);
+}
+
+/*
+ * Find the buddy of the block of 2^order pages starting at pg.
+ * Returns nullptr if the buddy does not lie in the zone.
+ */
+auto default_page_alloc::buddy_(const zone& z, page* pg, unsigned int order)
+    const noexcept -> page* {
+  using type = page_no<native_arch>::type;
+
+  const type size = order_npg_(order).get();
+  const type first = z.start.get();
+  const type buddy_no = pg->address().get() ^ size;
+  if (buddy_no < first || buddy_no - first + size > type(z.npg.get()))
+    return nullptr;
+  return z.base + (buddy_no - first);
+}
+
+/* Put the head of a free block on the freelist of its order. */
+auto default_page_alloc::link_block_(page* pg, unsigned int order) noexcept ->
+    void {
+  freelist_[order].link_front(pg);
+  if (order >= index_min_order)
+    index_[order - index_min_order].link(pg, false);
+}
+
+/* Take the head of a free block off the freelist of its order. */
+auto default_page_alloc::unlink_block_(page* pg, unsigned int order)
+    noexcept -> void {
+  freelist_[order].unlink(pg);
+  if (order >= index_min_order)
+    index_[order - index_min_order].unlink(pg);
+}
+
+/*
+ * Take a block of 2^order pages from the freelist.
+ *
+ * If no block of this order is free, a larger block is split,
+ * the unused halves going back on the freelist.
+ * The returned pages are still marked free.
+ */
+auto default_page_alloc::alloc_block_(unsigned int order) noexcept -> page* {
+  assert(order <= max_order);
+
+  unsigned int o = order;
+  while (freelist_[o].empty()) {
+    if (++o > max_order) return nullptr;
+  }
+
+  page* pg = &freelist_[o].front();
+  unlink_block_(pg, o);
+  assert(pg->nfree_ == order_npg_(o));
+  while (o > order) {
+    --o;
+    page* upper = pg + order_npg_(o).get();
+    upper->nfree_ = order_npg_(o);
+    link_block_(upper, o);
+    split_.add();
+  }
+
+  pg->nfree_ = page_count<native_arch>(0);
+  free_ -= order_npg_(order);
+  return pg;
+}
+
+/*
+ * Put a block of 2^order free pages on the freelist,
+ * merging it with its buddy while the buddy is free.
+ *
+ * Only the first page of a free block has a non-zero nfree_,
+ * so a buddy is free if its first page is marked free and
+ * its nfree_ equals the size of the block.
+ * (Pages in magazines are marked free, but have a zero nfree_.)
+ */
+auto default_page_alloc::free_block_(const zone& z, page* pg,
+                                     unsigned int order) noexcept -> void {
+  assert(pg->get_flags() & page::fl_free);
+  assert((pg->address().get() & (order_npg_(order).get() - 1)) == 0);
+
+  free_ += order_npg_(order);
+  pg->nfree_ = page_count<native_arch>(0);
+  while (order < max_order) {
+    page* buddy = buddy_(z, pg, order);
+    if (buddy == nullptr ||
+        !(buddy->get_flags() & page::fl_free) ||
+        buddy->nfree_ != order_npg_(order))
+      break;
+
+    unlink_block_(buddy, order);
+    buddy->nfree_ = page_count<native_arch>(0);
+    pg = min(pg, buddy);
+    ++order;
+    merge_.add();
+  }
+
+  pg->nfree_ = order_npg_(order);
+  link_block_(pg, order);
+}
+
+/* Maintain the largest alignment of the blocks in a subtree of an index. */
+auto default_page_alloc::index_augment::operator()(page* pg) const noexcept ->
+    void {
+  unsigned int a = align_log2_(pg);
+  if (const page* l = pg->left()) a = max(a, unsigned(l->index_align_));
+  if (const page* r = pg->right()) a = max(a, unsigned(r->index_align_));
+  pg->index_align_ = a;
+}
+
+/*
+ * Find the lowest free block of 2^order pages,
+ * with a page number that is a multiple of 2^align.
+ * Returns nullptr if there is no such block.
+ */
+auto default_page_alloc::find_aligned_(unsigned int order,
+                                       unsigned int align) const noexcept ->
+    page* {
+  assert(order >= index_min_order && order <= max_order);
+
+  const index_type& idx = index_[order - index_min_order];
+  if (idx.empty()) return nullptr;
+  const page* pg = &*idx.root();
+  if (pg->index_align_ < align) return nullptr;
+
+  for (;;) {
+    const page* l = pg->left();
+    if (l != nullptr && l->index_align_ >= align) {
+      pg = l;
+    } else if (align_log2_(pg) >= align) {
+      return const_cast<page*>(pg);
+    } else {
+      pg = pg->right();
+      assert(pg != nullptr && pg->index_align_ >= align);
+    }
+  }
+}
+
+/*
+ * Allocate npg contiguous pages, placed according to the spec.
+ *
+ * Blocks are tried from the smallest order that can hold npg pages
+ * upwards.  If the alignment is at most the block size, the placement
+ * within a block is the same for each block of that order, so any
+ * block will do.  Otherwise, only blocks that start at an aligned page
+ * number can hold the allocation; these are found using the index.
+ * (Blocks below index_min_order are not indexed, and neither can
+ * blocks be found by an offset larger than the block size;
+ * such allocations are served from a larger order.)
+ *
+ * The pages of the block in front of and behind the allocation
+ * are returned to the freelist.
+ * Returns an empty range if no block can hold the allocation.
+ */
+auto default_page_alloc::fetch_constrained_(page_count<native_arch> npg,
+                                            const spec& s) noexcept ->
+    page_range {
+  using abi::ext::log2_down;
+  using abi::ext::log2_up;
+  using type = page_no<native_arch>::type;
+
+  const type n = npg.get();
+  const type align = (s.align > page_count<native_arch>(0) ?
+                      type(s.align.get()) :
+                      type(1));
+  const type offset = type(s.offset.get()) & (align - 1U);
+  const type boundary = s.boundary.get();
+  assert((align & (align - 1U)) == 0);
+  assert((boundary & (boundary - 1U)) == 0);
+
+  /* The offset within a boundary is fixed by the alignment. */
+  if (boundary != 0 &&
+      (offset & (min(align, boundary) - 1U)) + n > boundary)
+    return page_range();
+
+  /*
+   * First page number at or after start,
+   * that has the requested offset and does not cross a boundary.
+   */
+  auto place = [n, align, offset, boundary](type start) -> type {
+    type p = start + ((offset - start) & (align - 1U));
+    if (boundary != 0 &&
+        (p & ~(boundary - 1U)) != ((p + n - 1U) & ~(boundary - 1U))) {
+      const type q = (p | (boundary - 1U)) + 1U;
+      p = q + ((offset - q) & (align - 1U));
+    }
+    return p;
+  };
+
+  const unsigned int align_log2 = log2_down(align);
+  for (unsigned int order = log2_up(n); order <= max_order; ++order) {
+    const type size = order_npg_(order).get();
+
+    page* blk;
+    if (align <= size) {
+      if (freelist_[order].empty()) continue;
+      blk = &freelist_[order].front();
+    } else if (order >= index_min_order && (offset & ~(size - 1U)) == 0) {
+      blk = find_aligned_(order, align_log2);
+      if (blk == nullptr) continue;
+    } else {
+      continue;
+    }
+
+    const type start = blk->address().get();
+    const type p = place(start);
+    if (p + n > start + size) continue;
+
+    /* Take the block, return the pages around the allocation. */
+    unlink_block_(blk, order);
+    blk->nfree_ = page_count<native_arch>(0);
+    free_ -= order_npg_(order);
+    page* rv_ptr = blk + (p - start);
+    free_range_(blk, page_count<native_arch>(p - start));
+    free_range_(rv_ptr + n, page_count<native_arch>(start + size - p - n));
+
+    for_each(rv_ptr, rv_ptr + n,
+             [](page& pg) {
+               auto old_flags = pg.clear_flag(page::fl_free);
+               assert(old_flags & page::fl_free);
+             });
+    constrained_.add();
+    return page_range(rv_ptr, n);
+  }
+  return page_range();
+}
+
+
+/*
+ * Assign free pages to parked allocations, in the order they were parked.
+ * Returns the waiters that were assigned all their pages.
+ */
+auto default_page_alloc::take_ready_waiters_() noexcept -> waiter_list {
+  waiter_list ready;
+  while (!waiters_.empty()) {
+    waiter& w = waiters_.front();
+    fill_from_freelist_(w.pgs, w.npg);
+    if (w.pgs.size() < w.npg) break;
+
+    ready.link_back(waiters_.unlink_front());
+  }
+  if (waiters_.empty()) have_waiters_.store(false, memory_order_relaxed);
+  return ready;
+}
+
+/*
+ * Complete parked allocations, zeroing their pages if requested.
+ * Allocations that didn't get all their pages failed: they release the
+ * pages they hold and complete with a nullptr, or an empty page list.
+ * Must be called without holding mtx_.
+ */
+auto default_page_alloc::complete_(waiter_list ready) noexcept -> void {
+  while (!ready.empty()) {
+    unique_ptr<waiter> w{ ready.unlink_front() };
+    if (w->pgs.size() < w->npg) {
+      w->pgs.clear();
+      if (w->multi)
+        w->list_prom.set_value(page_list());
+      else
+        w->prom.set_value(page_ptr());
+      continue;
+    }
+
+    if ((w->style & alloc_style::zero) == alloc_style::zero) {
+      try {
+        zero_pages_(w->pgs);
+      } catch (...) {
+        if (w->multi)
+          w->list_prom.set_exception(current_exception());
+        else
+          w->prom.set_exception(current_exception());
+        continue;
+      }
+    }
+    if (w->multi)
+      w->list_prom.set_value(move(w->pgs));
+    else
+      w->prom.set_value(w->pgs.pop_front());
+  }
+}
+
+/*
+ * Hand free pages to parked allocations.
+ * The lock is released while the allocations are completed.
+ */
+auto default_page_alloc::wake_waiters_(unique_lock<mutex>& l) noexcept ->
+    void {
+  assert(l.owns_lock());
+  if (waiters_.empty()) return;
+
+  waiter_list ready = take_ready_waiters_();
+  if (ready.empty()) return;
+
+  l.unlock();
+  complete_(move(ready));
+  l.lock();
+}
+
+/*
+ * Reclaim pages for parked allocations.
+ *
+ * Pages are released from the page cache in batches of at most
+ * reclaim_batch pages and handed directly to the parked allocations.
+ * Once the cache has nothing left to release, allocations that may
+ * fail without throwing are completed with a nullptr (or an empty
+ * page list).
+ */
+auto default_page_alloc::reclaim_() noexcept -> void {
+  using alloc_style::fail_ok_nothrow;
 
-    for (page_count<native_arch> i = page_count<native_arch>(0);
-         i != n;
-         ++i, ++pgi) {
-      assert(refcnt_is_zero(*pgi));
+  /* Pages may be stranded in magazines. */
+  drain_magazines_();
 
-      cache_.unmanage(pgi);
-      const auto old_flags = pgi->set_flag(page::fl_free);
-      assert(!(old_flags & page::fl_free));
+  unique_lock<mutex> l{ mtx_ };
+  for (;;) {
+    size_t want = 0;
+    for (auto w = waiters_.begin();
+         w != waiters_.end() && want < reclaim_batch;
+         ++w)
+      want += (w->npg - w->pgs.size()).get();
+    want = min(want, size_t(reclaim_batch));
+    if (want == 0) break;
+
+    l.unlock();
+    page_list pgl = cache_.try_release_urgent(page_count<native_arch>(want));
+    reclaim_pages_.add(pgl.size().get());
+    if (pgl.empty()) {
+      l.lock();
+      break;
+    }
+
+    /* Surplus pages go back to the freelist, via deallocate(). */
+    waiter_list ready;
+    l.lock();
+    while (!pgl.empty() && !waiters_.empty()) {
+      waiter& w = waiters_.front();
+      while (!pgl.empty() && w.pgs.size() < w.npg)
+        w.pgs.push_back(pgl.pop_front());
+      if (w.pgs.size() < w.npg) break;
+
+      ready.link_back(waiters_.unlink_front());
+    }
+    if (waiters_.empty()) have_waiters_.store(false, memory_order_relaxed);
+    l.unlock();
+
+    complete_(move(ready));
+    pgl.clear();
+    l.lock();
+  }
+
+  /* Nothing left to reclaim. */
+  waiter_list failed;
+  for (auto w = waiters_.begin(); w != waiters_.end(); ) {
+    waiter& w_ref = *w++;
+    if ((w_ref.style & fail_mask) == fail_ok_nothrow) {
+      waiters_.unlink(&w_ref);
+      failed.link_back(&w_ref);
+      wait_fail_.add();
     }
   }
+  if (waiters_.empty()) have_waiters_.store(false, memory_order_relaxed);
+  l.unlock();
 
-  pg->nfree_ = n;
-  bool link_succes;
-  ranges_type::iterator pgi;
-  tie(pgi, link_succes) = ranges_.link(pg, true);
-  assert(link_succes);
+  complete_(move(failed));
+}
 
-  /* Merge range forward. */
-  ranges_type::iterator pg_succ = next(pgi);
-  assert(pg_succ->address() >= pgi->address() + n);
-  if (pg_succ->address() == pgi->address() + n &&
-      &*pg_succ == &*pgi + n.get()) {
-    pgi->nfree_ += exchange(pg_succ->nfree_, page_count<native_arch>(0));
-    ranges_.unlink(pg_succ);
+
+
+/*
+ * Allocate a zeroed page from the magazine of this thread,
+ * refilling it from the zero pool if it has none.
+ *
+ * Returns nullptr if the magazine is in use by another thread,
+ * or if the zero pool is empty.
+ */
+auto default_page_alloc::fetch_zeroed_() noexcept -> page_ptr {
+  magazine& m = magazine_();
+  unique_lock<mutex> ml{ m.mtx, try_to_lock };
+  page_ptr rv;
+  if (_predict_false(!ml.owns_lock())) return rv;
+
+  if (_predict_false(m.nzero == 0)) {
+    unsigned int pool_n;
+    {
+      lock_guard<mutex> l{ mtx_ };
+      while (m.nzero < magazine_zero_max && !zero_pool_.empty())
+        m.zeroed[m.nzero++] = zero_pool_.unlink_front();
+      pool_n = zero_pool_n_.fetch_sub(m.nzero, memory_order_relaxed) -
+               m.nzero;
+    }
+
+    if (pool_n <= zero_pool_max / 2U) workq_activate(zero_job_);
+    if (m.nzero == 0) {
+      zero_miss_.add();
+      return rv;
+    }
   }
 
-  /* Merge range backward. */
-  ranges_type::iterator pg_pred = prev(pgi);
-  assert(pg_pred->address() + pg_pred->nfree_ <= pgi->address());
-  if (pg_pred->address() + pg_pred->nfree_ == pgi->address() &&
-      &*pgi == &*pg_pred + pg_pred->nfree_.get()) {
-    pg_pred->nfree_ += exchange(pgi->nfree_, page_count<native_arch>(0));
-    ranges_.unlink(pgi);
+  zero_hit_.add();
+  rv = m.zeroed[--m.nzero];
+  auto old_flags = rv->clear_flag(page::fl_free);
+  assert(old_flags & page::fl_free);
+  return rv;
+}
+
+/*
+ * Hand back all pages in the zero pool to the freelist.
+ * Must be called with mtx_ held.
+ */
+auto default_page_alloc::release_zero_pool_() noexcept -> void {
+  while (!zero_pool_.empty()) {
+    page* pg = zero_pool_.unlink_front();
+    zero_pool_n_.fetch_sub(1U, memory_order_relaxed);
+    free_block_(zone_of_(pg), pg, 0);
+  }
+}
+
+/*
+ * Zero a batch of free pages and add them to the zero pool.
+ *
+ * The job reschedules itself until the pool is full, so it never holds
+ * its workq for more than a batch.  Nothing is taken from the freelist
+ * while allocations are parked.
+ */
+auto default_page_alloc::fill_zero_pool_() noexcept -> void {
+  array<page*, zero_batch> batch;
+  unsigned int n = 0;
+
+  {
+    lock_guard<mutex> l{ mtx_ };
+    if (have_waiters_.load(memory_order_relaxed)) return;
+
+    const unsigned int pool_n = zero_pool_n_.load(memory_order_relaxed);
+    while (n < zero_batch && pool_n + n < zero_pool_max) {
+      page* pg = alloc_block_(0);
+      if (pg == nullptr) break;
+      batch[n++] = pg;
+    }
+  }
+  if (n == 0) return;
+
+  /* Pages stay marked free while they are zeroed. */
+  unsigned int nzeroed = 0;
+  try {
+    for (; nzeroed < n; ++nzeroed) zero_page_(*batch[nzeroed]);
+  } catch (...) {
+    /* Failed to map the page, the remaining pages are freed. */
   }
 
-  free_ += n;
+  bool more;
+  {
+    lock_guard<mutex> l{ mtx_ };
+    for_each(batch.begin(), batch.begin() + nzeroed,
+             [this](page* pg) { zero_pool_.link_back(pg); });
+    for_each(batch.begin() + nzeroed, batch.begin() + n,
+             [this](page* pg) { free_block_(zone_of_(pg), pg, 0); });
+    const unsigned int pool_n =
+        zero_pool_n_.fetch_add(nzeroed, memory_order_relaxed) + nzeroed;
+    more = (nzeroed == n && pool_n < zero_pool_max);
+  }
+
+  if (more) workq_activate(zero_job_);
+}
+
+/* Zero the contents of a page. */
+auto default_page_alloc::zero_page_(const page& pg) -> void {
+  auto data = pmap_map_page<page_data, native_arch>(pg.address(), support_);
+  zero_page_data(data.get());
+}
+
+/* Zero the contents of all pages in a page list. */
+auto default_page_alloc::zero_pages_(const page_list& pgl) -> void {
+  for (const page_range& r : pgl)
+    for (const page& pg : r) zero_page_(pg);
+}
+
+auto default_page_alloc::stat_zero_pool_(const void* self) noexcept ->
+    uint64_t {
+  return static_cast<const default_page_alloc*>(self)->
+      zero_pool_n_.load(memory_order_relaxed);
 }
 
 
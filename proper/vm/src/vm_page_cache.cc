@@ -1,4 +1,5 @@
 #include <ilias/vm/page_cache.h>
+#include <algorithm>
 #include <tuple>
 
 namespace ilias {
@@ -65,144 +66,31 @@ class cache_page_lock {
 } /* namespace ilias::vm::<unnamed> */
 
 
-class page_cache::hot_cold_rebalance_wqjob
-: public workq_job
-{
- public:
-  hot_cold_rebalance_wqjob(workq_ptr, page_cache&);
-  ~hot_cold_rebalance_wqjob() noexcept override;
-
-  void run() noexcept override;
-
- private:
-  page_cache& self_;
-};
-
-class page_cache::spec_need_rebalance_wqjob
-: public workq_job {
- public:
-  spec_need_rebalance_wqjob(workq_ptr, page_cache&);
-  ~spec_need_rebalance_wqjob() noexcept;
-
-  void run() noexcept override;
-
- private:
-  page_cache& self_;
-};
-
-
-page_cache::hot_cold_rebalance_wqjob::hot_cold_rebalance_wqjob(
-    workq_ptr wq, page_cache& self)
-: workq_job(wq),
-  self_(self)
-{}
-
-page_cache::hot_cold_rebalance_wqjob::~hot_cold_rebalance_wqjob() noexcept {}
-
-auto page_cache::hot_cold_rebalance_wqjob::run() noexcept -> void {
-  auto hc_diff = self_.hot_cold_diff_.load(memory_order_relaxed);
-  if (hc_diff >= -1 && hc_diff <= 1) return;
-  const unsigned int scan_zone = (hc_diff < 0 ? cold_zone : hot_zone);
-  const bool demote_break = (hc_diff > 0);
-  const bool promote_break = (hc_diff < 0);
-
-  page* stop = nullptr;
-  for (list_type::iterator i_next, i = self_.data_[scan_zone].begin();
-       i != self_.data_[scan_zone].end() && &*i != stop;
-       i = i_next) {
-    i_next = next(i);
-
-    cache_page_lock l{ *i, try_to_lock };
-    if (!l) continue;
-
-    i->update_accessed_dirty();
-    if (i->clear_flag(page::fl_accessed) & page::fl_accessed) {
-      page& i_ref = *i;
-      if (self_.promote_(scan_zone, *i)) {
-        if (stop == nullptr) stop = &i_ref;
-        if (promote_break) break;
-      }
-      continue;
-    }
-
-    if (self_.demote_(scan_zone, *i) && demote_break) break;
-  }
-}
-
-
-page_cache::spec_need_rebalance_wqjob::spec_need_rebalance_wqjob(
-    workq_ptr wq, page_cache& self)
-: workq_job(wq),
-  self_(self)
-{}
-
-page_cache::spec_need_rebalance_wqjob::~spec_need_rebalance_wqjob() noexcept {}
-
-auto page_cache::spec_need_rebalance_wqjob::run() noexcept -> void {
-  auto cn_diff = self_.spec_need_diff_.load(memory_order_relaxed);
-  if (cn_diff >= 0) return;
-
-  for (list_type::iterator i_next, i = self_.data_[cold_zone].begin();
-       i != self_.data_[cold_zone].end();
-       i = i_next) {
-    i_next = next(i);
-
-    cache_page_lock l{ *i, try_to_lock };
-    if (!l) continue;
-
-    i->update_accessed_dirty();
-    if (i->clear_flag(page::fl_accessed) & page::fl_accessed) {
-      self_.promote_(cold_zone, *i);
-      continue;
-    }
-
-    if (i->get_flags() & page::fl_dirty) {
-      i->undirty();
-      continue;
-    }
-
-    page_busy_lock busy_lock = i->map_ro_and_update_accessed_dirty();
-    if (i->get_flags() & (page::fl_accessed | page::fl_dirty))
-      continue;
-
-    if (self_.demote_(cold_zone, *i))
-      break;
-  }
-}
-
-
 constexpr unsigned int page_cache::n_zones;
 constexpr unsigned int page_cache::spec_zone;
 constexpr unsigned int page_cache::cold_zone;
 constexpr unsigned int page_cache::hot_zone;
 constexpr array<page::flags_type, page_cache::n_zones> page_cache::pg_flags;
+constexpr intptr_t page_cache::sweep_batch;
+constexpr unsigned int page_cache::ghost_slots;
 
 
-page_cache::page_cache(stats_group& group, workq_ptr wq)
-: hot_cold_rebalance_job_(new_workq_job<hot_cold_rebalance_wqjob>(wq,
-                                                                  *this)),
-  spec_need_rebalance_job_(new_workq_job<spec_need_rebalance_wqjob>(wq,
-                                                                    *this)),
-  manage_(group, "manage"),
+page_cache::page_cache(stats_group& group)
+: manage_(group, "manage"),
   unmanage_(group, "unmanage"),
-  hot_cold_rebalance_(group, "hot_cold_rebalance"),
-  spec_need_rebalance_(group, "spec_need_rebalance"),
+  promote_(group, "promote"),
+  release_(group, "release"),
   speculative_hit_(group, "speculative_hit"),
-  speculative_miss_(group, "speculative_miss")
-{}
-
-page_cache::page_cache(stats_group& group, workq_service& wqs)
-: page_cache(group, wqs.new_workq())
-{}
+  speculative_miss_(group, "speculative_miss"),
+  ghost_cold_hit_(group, "ghost_cold_hit"),
+  ghost_hot_hit_(group, "ghost_hot_hit"),
+  cold_target_stat_(group, "cold_target", &stat_cold_target_, this)
+{
+  for (atomic<intptr_t>& sz : size_) sz.store(0, memory_order_relaxed);
+}
 
 page_cache::~page_cache() noexcept {
   assert(empty());
-
-  workq_deactivate(hot_cold_rebalance_job_);
-  hot_cold_rebalance_job_ = nullptr;
-
-  workq_deactivate(spec_need_rebalance_job_);
-  spec_need_rebalance_job_ = nullptr;
 }
 
 auto page_cache::empty() const noexcept -> bool {
@@ -211,18 +99,47 @@ auto page_cache::empty() const noexcept -> bool {
   return true;
 }
 
+/*
+ * Start caching a page.
+ *
+ * A page whose ghost is remembered was released recently:
+ * it is cached as a hot page.
+ *
+ * The accessed bit is cleared, so the access that brought the page in
+ * doesn't count: a cold page needs a second reference to be promoted.
+ */
 auto page_cache::manage(const page_ptr& pg, bool speculative) noexcept ->
     void {
   cache_page_lock l{ *pg };
   assert(!(l.flags() & page::fl_cache_present));
 
-  if (link_zone_((speculative ? spec_zone : cold_zone), *pg))
+  pg->update_accessed_dirty();
+  pg->clear_flag(page::fl_accessed);
+
+  unsigned int zone = (speculative ? spec_zone : cold_zone);
+  if (!speculative) {
+    switch (take_ghost_(ghost_key_(*pg))) {
+    case cold_zone:
+      ghost_cold_hit_.add();
+      adapt_cold_target_(1);
+      zone = hot_zone;
+      break;
+    case hot_zone:
+      ghost_hot_hit_.add();
+      adapt_cold_target_(-1);
+      zone = hot_zone;
+      break;
+    }
+  }
+
+  if (link_zone_(zone, *pg))
     manage_.add();
 }
 
+/* Stop caching a page.  Pages that are not cached are ignored. */
 auto page_cache::unmanage(const page_ptr& pg) noexcept -> void {
   cache_page_lock l{ *pg };
-  assert(!(l.flags() & page::fl_cache_present));
+  if (!(l.flags() & page::fl_cache_present)) return;
 
   bool unlinked;
   switch (pg->get_flags() & page::fl_cache_mask) {
@@ -244,14 +161,36 @@ auto page_cache::unmanage(const page_ptr& pg) noexcept -> void {
     unmanage_.add();
 }
 
+/*
+ * Release up to npg pages.
+ *
+ * Unused speculative pages are released first.  After that, pages are
+ * released from the cold zone while it holds at least cold_target_
+ * pages, and from the hot zone otherwise.  Each cold and hot page is
+ * examined at most twice (on average), which bounds the work if few
+ * pages can be released.
+ */
 auto page_cache::try_release_urgent(page_count<native_arch> npg) noexcept ->
     page_list {
-  return try_release_urgent_zone_(spec_zone, npg, page_list());
+  page_list pgl = sweep_(spec_zone, npg, page_list(),
+                         size_[spec_zone].load(memory_order_relaxed));
+
+  intptr_t budget = 2 * (size_[cold_zone].load(memory_order_relaxed) +
+                         size_[hot_zone].load(memory_order_relaxed));
+  while (pgl.size() < npg && budget > 0) {
+    const intptr_t n = min(budget, sweep_batch);
+    budget -= n;
+    pgl = sweep_(victim_zone_(), npg, move(pgl), n);
+  }
+
+  return pgl;
 }
 
 auto page_cache::try_release(page_count<native_arch> npg) noexcept ->
     cb_future<page_list> {
-  return try_release_zone_(spec_zone, npg);
+  return async_lazy([this, npg]() -> page_list {
+                      return try_release_urgent(npg);
+                    });
 }
 
 auto page_cache::unlink_zone_(unsigned int zone, page& pg) noexcept -> bool {
@@ -270,18 +209,7 @@ auto page_cache::unlink_zone_(unsigned int zone, page& pg) noexcept -> bool {
       });
   if (!result) return false;
 
-  if (zone == hot_zone) {
-    if (hot_cold_diff_.fetch_sub(1, memory_order_relaxed) < 0)
-      workq_activate(hot_cold_rebalance_job_);
-  } else {
-    if (hot_cold_diff_.fetch_add(1, memory_order_relaxed) > 0)
-      workq_activate(hot_cold_rebalance_job_);
-  }
-
-  if (zone == spec_zone &&
-      spec_need_diff_.fetch_sub(1, memory_order_relaxed) <= 0)
-    workq_activate(spec_need_rebalance_job_);
-
+  size_[zone].fetch_sub(1, memory_order_relaxed);
   return true;
 }
 
@@ -295,105 +223,184 @@ auto page_cache::link_zone_(unsigned int zone, page& pg) noexcept -> bool {
   pg.assign_masked_flags(page::fl_cache_present | pg_flags[zone],
                          page::fl_cache_present | page::fl_cache_mask);
 
-  if (zone == hot_zone) {
-    if (hot_cold_diff_.fetch_add(1, memory_order_relaxed) > 0)
-      workq_activate(hot_cold_rebalance_job_);
-  } else {
-    if (hot_cold_diff_.fetch_sub(1, memory_order_relaxed) < 0)
-      workq_activate(hot_cold_rebalance_job_);
-  }
-
-  if (zone == spec_zone)
-    spec_need_diff_.fetch_add(1, memory_order_relaxed);
-
+  size_[zone].fetch_add(1, memory_order_relaxed);
   return true;
 }
 
-auto page_cache::promote_(unsigned int zone, page& i) noexcept ->
-    bool {
+/*
+ * Move a page to the tail of dst_zone.
+ * If dst_zone is the zone of the page, the page moves behind the
+ * clock hand of its zone.
+ */
+auto page_cache::move_(unsigned int zone, unsigned int dst_zone, page& i)
+    noexcept -> bool {
   assert(i.get_flags() & page::fl_cache_modify);
   assert((i.get_flags() & page::fl_cache_mask) == pg_flags[zone]);
 
-  const auto dst_zone = (zone == hot_zone ? hot_zone : zone + 1U);
   page* pg = nullptr;
   data_[zone].erase_and_dispose(data_[zone].iterator_to(&i),
                                 [&pg](page* p) { pg = p; });
   if (!pg) return false;
   data_[dst_zone].push_back(pg);
+  if (dst_zone == zone) return true;
 
-  if (zone == cold_zone) {
-    if (hot_cold_diff_.fetch_add(2, memory_order_relaxed) >= 0)
-      workq_activate(hot_cold_rebalance_job_);
-  } else if (zone == spec_zone) {
-    if (spec_need_diff_.fetch_sub(1, memory_order_relaxed) <= 0)
-      workq_activate(spec_need_rebalance_job_);
-  }
-
-  if (zone == spec_zone)
-    speculative_hit_.add();
-
+  pg->assign_masked_flags(pg_flags[dst_zone], page::fl_cache_mask);
+  size_[zone].fetch_sub(1, memory_order_relaxed);
+  size_[dst_zone].fetch_add(1, memory_order_relaxed);
   return true;
 }
 
-auto page_cache::demote_(unsigned int zone, page& i) noexcept ->
-    bool {
-  assert(i.get_flags() & page::fl_cache_modify);
-  assert((i.get_flags() & page::fl_cache_mask) == pg_flags[zone]);
-  if (zone == spec_zone) return false;
+/* Select the zone to release pages from: cold or hot. */
+auto page_cache::victim_zone_() const noexcept -> unsigned int {
+  const intptr_t cold = size_[cold_zone].load(memory_order_relaxed);
+  const intptr_t hot = size_[hot_zone].load(memory_order_relaxed);
+  const intptr_t target = cold_target_.load(memory_order_relaxed);
 
-  const auto dst_zone = zone - 1U;
-  page* pg = nullptr;
-  data_[zone].erase_and_dispose(data_[zone].iterator_to(&i),
-                                [&pg](page* p) { pg = p; });
-  if (!pg) return false;
-  data_[dst_zone].push_back(pg);
-
-  if (zone == hot_zone) {
-    if (hot_cold_diff_.fetch_sub(2, memory_order_relaxed) <= 0)
-      workq_activate(hot_cold_rebalance_job_);
-  } else if (zone == cold_zone) {
-    if (spec_need_diff_.fetch_add(1, memory_order_relaxed) < -1)
-      workq_activate(spec_need_rebalance_job_);
-  }
-
-  return true;
+  if (hot == 0) return cold_zone;
+  if (cold == 0) return hot_zone;
+  return (cold >= max(intptr_t(1), target) ? cold_zone : hot_zone);
 }
 
-auto page_cache::try_release_urgent_zone_(unsigned int zone,
-                                          page_count<native_arch> npg,
-                                          page_list pgl)
-    noexcept -> page_list {
-  page* stop = nullptr;
-
+/*
+ * Advance the clock hand of a zone by up to n pages,
+ * releasing unreferenced pages until pgl holds npg pages.
+ *
+ * Referenced pages move to the next zone.  Pages that cannot be
+ * released are skipped over; dirty pages are written back first.
+ */
+auto page_cache::sweep_(unsigned int zone, page_count<native_arch> npg,
+                        page_list pgl, intptr_t n) noexcept -> page_list {
   for (list_type::iterator i_next, i = data_[zone].begin();
-       i != data_[zone].end() && &*i != stop && pgl.size() < npg;
-       i = i_next) {
+       i != data_[zone].end() && n > 0 && pgl.size() < npg;
+       i = i_next, --n) {
     i_next = next(i);
 
-    cache_page_lock l{ *i };
-    i->update_accessed_dirty();
-    page::flags_type pgfl = i->clear_flag(page::fl_accessed);
+    page& pg = *i;
+    cache_page_lock l{ pg };
+    if ((l.flags() & (page::fl_cache_present | page::fl_cache_mask)) !=
+        (page::fl_cache_present | pg_flags[zone]))
+      continue;  // Raced with unmanage() or move_().
+
+    pg.update_accessed_dirty();
+    const page::flags_type pgfl = pg.clear_flag(page::fl_accessed);
     if (pgfl & page::fl_accessed) {
-      page& i_ref = *i;
-      if (promote_(zone, *i) && stop == nullptr) stop = &i_ref;
+      switch (zone) {
+      case spec_zone:
+        if (move_(zone, cold_zone, pg)) speculative_hit_.add();
+        break;
+      case cold_zone:
+        if (move_(zone, hot_zone, pg)) promote_.add();
+        break;
+      case hot_zone:
+        move_(zone, hot_zone, pg);
+        break;
+      }
+      continue;
+    }
+
+    if (pgfl & page::fl_cannot_free_mask) {
+      move_(zone, zone, pg);
+      continue;
+    }
+    if (pgfl & page::fl_dirty) {
+      try {
+        pg.undirty();
+      } catch (...) {
+        /* SKIP: retried on the next pass. */
+      }
+      move_(zone, zone, pg);
+      continue;
+    }
+
+    /* The owner is cleared when the page is released. */
+    const uint64_t key = ghost_key_(pg);
+    page_ptr released = pg.try_release_urgent();
+    if (released == nullptr) {
+      move_(zone, zone, pg);
       continue;
     }
-    if (pgfl & page::fl_cannot_free_mask) continue;
 
-    page_ptr pg = i->try_release_urgent();
-    const bool unlinked_succes = unlink_zone_(zone, *pg);
-    assert(unlinked_succes);  // XXX can this fail?
-    pgl.push_back(move(pg));
+    const bool unlinked = unlink_zone_(zone, pg);
+    assert(unlinked);
+    if (zone == spec_zone)
+      speculative_miss_.add();
+    else
+      add_ghost_(zone, key);
+    release_.add();
+    pgl.push_back(move(released));
   }
 
   return pgl;
 }
 
-auto page_cache::try_release_zone_(unsigned int /*zone*/,
-                                   page_count<native_arch> /*npg*/) noexcept ->
-    cb_future<page_list> {
-  assert_msg(false, "XXX implement this");
-  return async_lazy([]() -> page_list { return page_list(); });  // XXX implement
+/*
+ * Identify the contents of a page by its owner and offset.
+ * Returns zero if the page has no owner.
+ */
+auto page_cache::ghost_key_(const page& pg) noexcept -> uint64_t {
+  page_owner* pgo;
+  page_owner::offset_type off;
+  tie(pgo, off) = pg.get_page_owner();
+  if (pgo == nullptr) return 0;
+
+  uint64_t key = reinterpret_cast<uintptr_t>(pgo) ^
+                 (uint64_t(off) * UINT64_C(0x9e3779b97f4a7c15));
+  key ^= key >> 33;
+  key *= UINT64_C(0xff51afd7ed558ccd);
+  key ^= key >> 33;
+  return (key == 0 ? 1U : key);
+}
+
+/* Remember a released page. */
+auto page_cache::add_ghost_(unsigned int zone, uint64_t key) noexcept ->
+    void {
+  if (key == 0) return;
+
+  lock_guard<mutex> l{ ghost_mtx_ };
+  ghost& g = ghosts_[key % ghost_slots];
+  g.key = key;
+  g.seq = ++ghost_seq_;
+  g.zone = zone;
+}
+
+/*
+ * Look up and forget the ghost of a page.
+ *
+ * Ghosts are remembered for as many releases as there are cold and hot
+ * pages, or until their slot is reused.
+ * Returns the zone the page was released from, or n_zones if the page
+ * has no ghost.
+ */
+auto page_cache::take_ghost_(uint64_t key) noexcept -> unsigned int {
+  if (key == 0) return n_zones;
+
+  const uint64_t window =
+      size_[cold_zone].load(memory_order_relaxed) +
+      size_[hot_zone].load(memory_order_relaxed);
+
+  lock_guard<mutex> l{ ghost_mtx_ };
+  ghost& g = ghosts_[key % ghost_slots];
+  if (g.key != key) return n_zones;
+
+  g.key = 0;
+  if (ghost_seq_ - g.seq > window) return n_zones;
+  return g.zone;
+}
+
+/* Grow or shrink cold_target_, limited to the number of cached pages. */
+auto page_cache::adapt_cold_target_(intptr_t delta) noexcept -> void {
+  const intptr_t limit = size_[cold_zone].load(memory_order_relaxed) +
+                         size_[hot_zone].load(memory_order_relaxed);
+
+  intptr_t target = cold_target_.load(memory_order_relaxed);
+  while (!cold_target_.compare_exchange_weak(
+             target, min(max(target + delta, intptr_t(0)), limit),
+             memory_order_relaxed, memory_order_relaxed));
+}
+
+auto page_cache::stat_cold_target_(const void* self) noexcept -> uint64_t {
+  return static_cast<const page_cache*>(self)->
+      cold_target_.load(memory_order_relaxed);
 }
 
 
@@ -0,0 +1,23 @@
+#include <ilias/vm/parallel.h>
+#include <ilias/cpuid.h>
+#include <ilias/workq_parallel.h>
+#include <stdimpl/parallel.h>
+#include <abi/panic.h>
+
+namespace ilias {
+namespace vm {
+
+
+void init_parallel(workq_service& wqs) {
+  const unsigned int ncpu = cpu_count();
+  std::impl::set_cpu_count(ncpu);
+  if (ncpu <= 1U) return;  // Nothing to gain from splitting work.
+
+  /* The backend lives as long as the kernel does. */
+  auto be = new workq_parallel_backend(wqs, ncpu);
+  if (std::impl::set_parallel_backend(be) != nullptr)
+    panic("vm: parallel backend installed twice");
+}
+
+
+}} /* namespace ilias::vm */
@@ -0,0 +1,242 @@
+#include <ilias/vm/page_alloc.h>
+#include <ilias/workq.h>
+#include <ilias/stats.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
+
+using namespace ilias;
+using namespace ilias::vm;
+using namespace ilias::pmap;
+
+/*
+ * Test: default_page_alloc over a fake range of pages.
+ *
+ * The pages are backed by a static buffer, and their page numbers are
+ * the virtual page numbers of that buffer, so the fake pmap support
+ * maps a page by returning its own number.
+ *
+ * Checks that all pages can be allocated, exactly once, by single page,
+ * multi page and constrained allocations, that freed pages can be
+ * allocated again, and that zeroed allocations are zeroed.
+ * No allocation in this test waits for pages, so the workq never runs.
+ */
+constexpr size_t NPG = 256;
+
+alignas(NPG * PAGE_SIZE) uint8_t mem[NPG * PAGE_SIZE];
+alignas(page) uint8_t page_storage[NPG * sizeof(page)];
+page*const pages = reinterpret_cast<page*>(page_storage);
+
+class fake_support
+: public pmap_support<native_arch>
+{
+ public:
+  fake_support() noexcept : pmap_support<native_arch>(false) {}
+
+  vpage_no<native_arch> map_page(page_no<native_arch> pg) override {
+    return vpage_no<native_arch>(pg.get());
+  }
+  void unmap_page(vpage_no<native_arch>) noexcept override {}
+  page_no<native_arch> allocate_page() override { abort(); }
+  void deallocate_page(page_no<native_arch>) noexcept override { abort(); }
+  pmap_page& lookup_pmap_page(page_no<native_arch>) noexcept override {
+    abort();
+  }
+};
+
+/* Index of pg in pages, or NPG if it is not one of the fake pages. */
+size_t index_of(const page& pg) noexcept {
+  if (&pg < pages || &pg >= pages + NPG) return NPG;
+  return size_t(&pg - pages);
+}
+
+/*
+ * Mark the pages in pgl as in use.
+ * Fails if a page is not a fake page, or is already in use.
+ */
+bool mark(const char* what, vector<bool>& used, const page_list& pgl) {
+  for (const page_range& r : pgl) {
+    for (const page& pg : r) {
+      const size_t i = index_of(pg);
+      if (i == NPG || used[i]) {
+        fprintf(stderr, "%s: page %zu handed out twice or out of range\n",
+                what, i);
+        return false;
+      }
+      used[i] = true;
+    }
+  }
+  return true;
+}
+
+/* Allocate single pages until the allocator runs out. */
+bool test_single(default_page_alloc& pga) {
+  for (int round = 0; round < 2; ++round) {
+    vector<bool> used(NPG, false);
+    vector<page_ptr> held;
+
+    for (;;) {
+      page_ptr pg = pga.allocate_urgent(alloc_fail_ok_nothrow);
+      if (pg == nullptr) break;
+
+      const size_t i = index_of(*pg);
+      if (i == NPG || used[i]) {
+        fprintf(stderr, "single: page %zu handed out twice or out of range\n",
+                i);
+        return false;
+      }
+      used[i] = true;
+      held.push_back(move(pg));
+    }
+
+    if (held.size() != NPG) {
+      fprintf(stderr, "single: round %d allocated %zu of %zu pages\n",
+              round, held.size(), NPG);
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Allocate page lists of various sizes, until all pages are used. */
+bool test_multi(default_page_alloc& pga) {
+  const size_t sizes[] = { 1, 3, 16, 100, 7 };
+  vector<bool> used(NPG, false);
+  vector<page_list> held;
+  size_t total = 0;
+
+  for (size_t i = 0; total < NPG; ++i) {
+    const size_t n = min(sizes[i % 5U], NPG - total);
+    page_list pgl =
+        pga.allocate(page_count<native_arch>(n), alloc_fail_ok).get();
+    if (pgl.size() != page_count<native_arch>(n)) {
+      fprintf(stderr, "multi: asked for %zu pages, got %zu\n",
+              n, size_t(pgl.size().get()));
+      return false;
+    }
+    if (!mark("multi", used, pgl)) return false;
+    total += n;
+    held.push_back(move(pgl));
+  }
+
+  if (pga.allocate_urgent(alloc_fail_ok_nothrow) != nullptr) {
+    fprintf(stderr, "multi: allocation succeeded with all pages in use\n");
+    return false;
+  }
+
+  /* Freed lists must be available again, as single pages. */
+  held.clear();
+  return test_single(pga);
+}
+
+/* Allocate contiguous pages at constrained positions. */
+bool test_constrained(default_page_alloc& pga) {
+  const page_no<native_arch>::type base = pages[0].address().get();
+  vector<bool> used(NPG, false);
+  vector<page_list> held;
+
+  for (size_t npg : { 1, 5, 13, 32 }) {
+    page_alloc::spec s;
+    s.align = page_count<native_arch>(16);
+    s.offset = page_count<native_arch>(3);
+    s.boundary = page_count<native_arch>(npg <= 13 ? 32 : 0);
+    s.style = alloc_fail_ok_nothrow;
+
+    page_list pgl = pga.allocate_urgent(page_count<native_arch>(npg), s);
+    if (pgl.size() != page_count<native_arch>(npg) || pgl.n_blocks() != 1U) {
+      fprintf(stderr, "constrained: %zu pages not allocated contiguously\n",
+              npg);
+      return false;
+    }
+    if (!mark("constrained", used, pgl)) return false;
+
+    const auto first = (*pgl.begin()).front().address().get() - base;
+    const auto last = first + npg - 1U;
+    if (first % 16U != 3U ||
+        (s.boundary.get() != 0 && first / 32U != last / 32U)) {
+      fprintf(stderr, "constrained: %zu pages at page %zu violate spec\n",
+              npg, size_t(first));
+      return false;
+    }
+    held.push_back(move(pgl));
+  }
+
+  /* A spec that can't be met fails, without taking pages. */
+  page_alloc::spec s;
+  s.align = page_count<native_arch>(2 * NPG);
+  s.offset = page_count<native_arch>(1);
+  s.style = alloc_fail_ok_nothrow;
+  if (!pga.allocate_urgent(page_count<native_arch>(NPG), s).empty()) {
+    fprintf(stderr, "constrained: impossible spec was met\n");
+    return false;
+  }
+
+  held.clear();
+  return test_single(pga);
+}
+
+/* Zeroed allocations must be zeroed, regardless of the page contents. */
+bool test_zero(default_page_alloc& pga) {
+  memset(mem, 0xa5, sizeof(mem));
+
+  page_ptr pg = pga.allocate(alloc_fail_ok | alloc_zero).get();
+  page_list pgl =
+      pga.allocate(page_count<native_arch>(4), alloc_fail_ok | alloc_zero)
+      .get();
+  if (pg == nullptr || pgl.size() != page_count<native_arch>(4)) {
+    fprintf(stderr, "zero: allocation failed\n");
+    return false;
+  }
+
+  vector<const page*> zeroed = { pg.get() };
+  for (const page_range& r : pgl)
+    for (const page& p : r) zeroed.push_back(&p);
+
+  for (const page* p : zeroed) {
+    const uint8_t* data = mem + index_of(*p) * PAGE_SIZE;
+    for (size_t i = 0; i < PAGE_SIZE; ++i) {
+      if (data[i] != 0) {
+        fprintf(stderr, "zero: page %zu not zeroed at byte %zu\n",
+                index_of(*p), i);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main() {
+  const uintptr_t base = reinterpret_cast<uintptr_t>(mem) >> PAGE_SHIFT;
+  for (size_t i = 0; i < NPG; ++i)
+    new (&pages[i]) page(page_no<native_arch>(base + i));
+
+  stats_group group{ "page_alloc_test" };
+  workq_service wqs;
+  fake_support support;
+  {
+    auto pga = make_shared<default_page_alloc>(group, wqs, support);
+    pga->add_range(pages, page_count<native_arch>(NPG));
+
+    fprintf(stderr, "Testing single page allocation...");
+    if (!test_single(*pga)) return 1;
+    fprintf(stderr, "  %s\n", "\\o/");
+
+    fprintf(stderr, "Testing multi page allocation...");
+    if (!test_multi(*pga)) return 1;
+    fprintf(stderr, "  %s\n", "\\o/");
+
+    fprintf(stderr, "Testing constrained allocation...");
+    if (!test_constrained(*pga)) return 1;
+    fprintf(stderr, "  %s\n", "\\o/");
+
+    fprintf(stderr, "Testing zeroed allocation...");
+    if (!test_zero(*pga)) return 1;
+    fprintf(stderr, "  %s\n", "\\o/");
+  }
+
+  for (size_t i = 0; i < NPG; ++i) pages[i].~page();
+}
@@ -0,0 +1,74 @@
+#include <ilias/vm/vmmap.h>
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+
+using namespace ilias;
+using namespace ilias::vm;
+using namespace ilias::pmap;
+
+/*
+ * Test: merging vmmap shards.
+ *
+ * vmmap_shard::merge merges the free lists of both shards, which are
+ * ordered by free size.  Shards are merged where every free range of
+ * rhs sorts after those of lhs, where every one sorts before them, and
+ * where they interleave.  Afterwards the merged shard must account for
+ * all free pages, and rhs must be empty.
+ */
+using shard = vmmap_shard<native_arch>;
+using npg = page_count<native_arch>;
+
+/*
+ * Add adjacent free ranges with the given sizes to a shard.
+ * (Filled in place: moving a shard doesn't move its free lists.)
+ */
+void fill_shard(shard& s, vpage_no<native_arch> b,
+                initializer_list<size_t> sizes) {
+  for (size_t sz : sizes) {
+    s.manage(b, npg(sz));
+    b += npg(sz);
+  }
+}
+
+bool test(const char* what, initializer_list<size_t> lhs_sizes,
+          initializer_list<size_t> rhs_sizes) {
+  size_t total = 0, largest = 0;
+  for (size_t sz : lhs_sizes) total += sz;
+  const size_t lhs_total = total;
+  for (size_t sz : lhs_sizes) largest = max(largest, sz);
+  for (size_t sz : rhs_sizes) {
+    total += sz;
+    largest = max(largest, sz);
+  }
+
+  shard lhs, rhs;
+  fill_shard(lhs, vpage_no<native_arch>(0x1000), lhs_sizes);
+  fill_shard(rhs, vpage_no<native_arch>(0x1000) + npg(lhs_total), rhs_sizes);
+  lhs.merge(move(rhs));
+
+  if (lhs.free_size() != npg(total) || rhs.free_size() != npg(0)) {
+    fprintf(stderr, "%s: %zu pages free after merge, expected %zu\n",
+            what, size_t(lhs.free_size().get()), total);
+    return false;
+  }
+  if (lhs.largest_free_size() < npg(largest) ||
+      lhs.largest_free_size() > npg(total)) {
+    fprintf(stderr, "%s: largest free range of %zu pages\n",
+            what, size_t(lhs.largest_free_size().get()));
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  fprintf(stderr, "Testing vmmap_shard merge...");
+  if (!test("rhs after lhs", { 1, 2, 3 }, { 10, 20 }) ||
+      !test("rhs before lhs", { 10, 20 }, { 1, 2, 3 }) ||
+      !test("interleaved", { 1, 8, 30 }, { 4, 16 }) ||
+      !test("single rhs range before lhs", { 5, 6 }, { 1 }) ||
+      !test("empty rhs", { 5, 6 }, {}) ||
+      !test("empty lhs", {}, { 5, 6 }))
+    return 1;
+  fprintf(stderr, "  %s\n", "\\o/");
+}